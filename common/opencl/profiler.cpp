@@ -0,0 +1,295 @@
+/*
+ * profiler.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include <cstdlib>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include "atto/opencl/opencl.hpp"
+using namespace atto;
+#include "profiler.hpp"
+
+namespace common {
+
+/** ---------------------------------------------------------------------------
+ * @brief Create a command queue on the specified device with the specified
+ * properties, and with profiling enabled if the profiler is enabled.
+ */
+cl_command_queue CreateQueue(
+    const cl_context &context,
+    const cl_device_id &device,
+    const cl_command_queue_properties properties)
+{
+    cl_command_queue_properties queue_properties = properties;
+    if (Profiler::enabled()) {
+        queue_properties |= CL_QUEUE_PROFILING_ENABLE;
+    }
+
+    cl_int err;
+    cl_command_queue queue = clCreateCommandQueue(
+        context, device, queue_properties, &err);
+    core_assert(err == CL_SUCCESS, "failed to create command queue");
+    return queue;
+}
+
+/** ---------------------------------------------------------------------------
+ * Profiler::Profiler
+ * @brief Create a profiler, enabled and configured by the environment.
+ */
+Profiler::Profiler()
+{
+    m_enabled = enabled();
+    if (!m_enabled) {
+        return;
+    }
+
+    const char *window = std::getenv("CL_PROFILE_WINDOW");
+    if (window != NULL && std::atol(window) > 0) {
+        m_window = std::atol(window);
+    }
+
+    const char *trace = std::getenv("CL_PROFILE_TRACE");
+    if (trace != NULL && *trace != '\0') {
+        m_trace.open(trace, std::ios::out);
+        core_assert(m_trace, "failed to open profiler trace file");
+        m_trace << "[\n";
+    }
+}
+
+/**
+ * Profiler::~Profiler
+ * @brief Release the pending events and close the trace file.
+ */
+Profiler::~Profiler()
+{
+    for (auto &it : m_pending) {
+        if (it.event != NULL) {
+            clReleaseEvent(it.event);
+        }
+    }
+    if (m_trace.is_open()) {
+        m_trace << "{}]\n";
+    }
+}
+
+/**
+ * Profiler::enabled
+ * @brief Return true if the environment variable CL_PROFILE is set to a
+ * value other than 0.
+ */
+bool Profiler::enabled(void)
+{
+    const char *value = std::getenv("CL_PROFILE");
+    return (value != NULL && *value != '\0' && std::string(value) != "0");
+}
+
+/** ---------------------------------------------------------------------------
+ * Profiler::event
+ * @brief Return an event slot for the next enqueue of the specified kernel,
+ * or NULL if profiling is disabled. Completed commands are collected before
+ * the slot is created, so the number of pending events stays bounded.
+ */
+cl_event *Profiler::event(const cl_kernel &kernel)
+{
+    if (!m_enabled) {
+        return NULL;
+    }
+    return event(kernel_name(kernel));
+}
+
+cl_event *Profiler::event(const std::string &name)
+{
+    if (!m_enabled) {
+        return NULL;
+    }
+    collect(false);
+    m_pending.push_back({name, NULL});
+    return &m_pending.back().event;
+}
+
+/**
+ * Profiler::record
+ * @brief Profile an event owned by the caller. The event is retained, so the
+ * caller may release it at any time.
+ */
+void Profiler::record(const cl_kernel &kernel, const cl_event &event)
+{
+    if (!m_enabled || event == NULL) {
+        return;
+    }
+    collect(false);
+    clRetainEvent(event);
+    m_pending.push_back({kernel_name(kernel), event});
+}
+
+/**
+ * Profiler::flush
+ * @brief Wait for all pending commands, print the statistics of the current
+ * window and start a new one.
+ */
+void Profiler::flush(void)
+{
+    if (!m_enabled) {
+        return;
+    }
+    collect(true);
+    if (!m_stats.empty()) {
+        std::cout << to_string();
+    }
+    m_stats.clear();
+    m_n_commands = 0;
+}
+
+/** ---------------------------------------------------------------------------
+ * Profiler::kernel_name
+ * @brief Return the function name of the specified kernel.
+ */
+const std::string &Profiler::kernel_name(const cl_kernel &kernel)
+{
+    auto it = m_names.find(kernel);
+    if (it != m_names.end()) {
+        return it->second;
+    }
+
+    size_t size = 0;
+    clGetKernelInfo(kernel, CL_KERNEL_FUNCTION_NAME, 0, NULL, &size);
+    std::vector<char> name(size + 1, '\0');
+    clGetKernelInfo(kernel, CL_KERNEL_FUNCTION_NAME, size, name.data(), NULL);
+    return m_names.emplace(kernel, std::string(name.data())).first->second;
+}
+
+/**
+ * Profiler::collect
+ * @brief Aggregate the completed commands in enqueue order. If wait is true,
+ * wait for all pending commands. Otherwise, wait only for the oldest commands
+ * once the pending queue grows beyond one window.
+ */
+void Profiler::collect(const bool wait)
+{
+    while (!m_pending.empty()) {
+        Pending &pending = m_pending.front();
+        if (pending.event != NULL) {
+            cl_int status = CL_COMPLETE;
+            clGetEventInfo(
+                pending.event,
+                CL_EVENT_COMMAND_EXECUTION_STATUS,
+                sizeof(status),
+                &status,
+                NULL);
+            if (status > CL_COMPLETE && !wait && m_pending.size() < m_window) {
+                break;
+            }
+            clWaitForEvents(1, &pending.event);
+            aggregate(pending);
+            clReleaseEvent(pending.event);
+        }
+        m_pending.pop_front();
+
+        if (++m_n_commands >= m_window) {
+            std::cout << to_string();
+            m_stats.clear();
+            m_n_commands = 0;
+        }
+    }
+}
+
+/**
+ * Profiler::aggregate
+ * @brief Add the profiling times of a completed command to the statistics
+ * of its kernel, and write the command to the trace file.
+ */
+void Profiler::aggregate(const Pending &pending)
+{
+    cl_ulong queued = 0, submit = 0, start = 0, end = 0;
+    cl_int err = CL_SUCCESS;
+    err |= clGetEventProfilingInfo(
+        pending.event, CL_PROFILING_COMMAND_QUEUED, sizeof(cl_ulong), &queued, NULL);
+    err |= clGetEventProfilingInfo(
+        pending.event, CL_PROFILING_COMMAND_SUBMIT, sizeof(cl_ulong), &submit, NULL);
+    err |= clGetEventProfilingInfo(
+        pending.event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &start, NULL);
+    err |= clGetEventProfilingInfo(
+        pending.event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &end, NULL);
+    if (err != CL_SUCCESS) {
+        return;     /* queue created without profiling */
+    }
+
+    Stats &stats = m_stats[pending.name];
+    cl_ulong exec = end - start;
+    stats.exec_min = (stats.count == 0) ? exec : std::min(stats.exec_min, exec);
+    stats.exec_max = (stats.count == 0) ? exec : std::max(stats.exec_max, exec);
+    stats.queued += submit - queued;
+    stats.submit += start - submit;
+    stats.exec += exec;
+    stats.count++;
+
+    if (m_trace.is_open()) {
+        if (m_trace_origin == 0) {
+            m_trace_origin = start;
+        }
+        m_trace << "{\"name\": \"" << pending.name << "\", \"ph\": \"X\", "
+                << "\"pid\": 0, \"tid\": 0, "
+                << "\"ts\": " << 1.0e-3 * (start - m_trace_origin) << ", "
+                << "\"dur\": " << 1.0e-3 * exec << "},\n";
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * Profiler::to_string
+ * @brief Return the statistics table of the current window, sorted by total
+ * execution time. Times are in microseconds.
+ */
+std::string Profiler::to_string(void) const
+{
+    std::vector<std::pair<std::string, Stats>> rows(m_stats.begin(), m_stats.end());
+    std::sort(rows.begin(), rows.end(),
+        [] (const std::pair<std::string, Stats> &a,
+            const std::pair<std::string, Stats> &b) {
+            return a.second.exec > b.second.exec;
+        });
+
+    cl_ulong total = 0;
+    for (auto &it : rows) {
+        total += it.second.exec;
+    }
+
+    std::ostringstream ss;
+    ss << std::left << std::setw(28) << "kernel" << std::right
+       << std::setw(10) << "calls"
+       << std::setw(12) << "total"
+       << std::setw(10) << "mean"
+       << std::setw(10) << "min"
+       << std::setw(10) << "max"
+       << std::setw(10) << "queued"
+       << std::setw(10) << "submit"
+       << std::setw(8) << "%" << "\n";
+
+    ss << std::fixed << std::setprecision(2);
+    for (auto &it : rows) {
+        const Stats &stats = it.second;
+        const double count = static_cast<double>(stats.count);
+        ss << std::left << std::setw(28) << it.first << std::right
+           << std::setw(10) << stats.count
+           << std::setw(12) << 1.0e-3 * stats.exec
+           << std::setw(10) << 1.0e-3 * stats.exec / count
+           << std::setw(10) << 1.0e-3 * stats.exec_min
+           << std::setw(10) << 1.0e-3 * stats.exec_max
+           << std::setw(10) << 1.0e-3 * stats.queued / count
+           << std::setw(10) << 1.0e-3 * stats.submit / count
+           << std::setw(8) << 100.0 * stats.exec / std::max(total, (cl_ulong) 1)
+           << "\n";
+    }
+    return ss.str();
+}
+
+} /* common */
@@ -0,0 +1,107 @@
+/*
+ * profiler.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef COMMON_OPENCL_PROFILER_H_
+#define COMMON_OPENCL_PROFILER_H_
+
+#include <deque>
+#include <map>
+#include <string>
+#include <fstream>
+#include "atto/opencl/opencl.hpp"
+
+namespace common {
+
+/**
+ * @brief Create a command queue on the specified device with the specified
+ * properties. Profiling is enabled on the queue if the profiler is enabled.
+ */
+cl_command_queue CreateQueue(
+    const cl_context &context,
+    const cl_device_id &device,
+    const cl_command_queue_properties properties = 0);
+
+/**
+ * Profiler
+ * @brief Per-kernel OpenCL profiler. Profiling is opt-in, enabled by setting
+ * the environment variable CL_PROFILE=1, and requires the command queue to
+ * be created with CreateQueue.
+ *
+ * Each profiled enqueue passes an event slot from Profiler::event. Completed
+ * events are aggregated by kernel name - queued to submit, submit to start
+ * and start to end times - and a table is printed every CL_PROFILE_WINDOW
+ * commands (default 10000) and on teardown. If CL_PROFILE_TRACE is set,
+ * each command is also written to that path as a chrome://tracing event.
+ *
+ * When profiling is disabled, Profiler::event returns NULL and the enqueues
+ * create no events.
+ */
+struct Profiler {
+    /* Per-kernel profiling statistics over a window. */
+    struct Stats {
+        size_t count = 0;               /* number of commands */
+        cl_ulong queued = 0;            /* total queued to submit time (ns) */
+        cl_ulong submit = 0;            /* total submit to start time (ns) */
+        cl_ulong exec = 0;              /* total start to end time (ns) */
+        cl_ulong exec_min = 0;          /* minimum execution time (ns) */
+        cl_ulong exec_max = 0;          /* maximum execution time (ns) */
+    };
+
+    /* A profiled command waiting for completion. */
+    struct Pending {
+        std::string name;
+        cl_event event;
+    };
+
+    /* Profiler member variables. */
+    bool m_enabled = false;
+    size_t m_window = 10000;
+    size_t m_n_commands = 0;
+    std::deque<Pending> m_pending;
+    std::map<std::string, Stats> m_stats;
+    std::map<cl_kernel, std::string> m_names;
+    std::ofstream m_trace;
+    cl_ulong m_trace_origin = 0;
+
+    /**
+     * Return an event slot for the next enqueue of the specified kernel, or
+     * NULL if profiling is disabled. The profiler owns the event.
+     */
+    cl_event *event(const cl_kernel &kernel);
+    cl_event *event(const std::string &name);
+
+    /** Profile an event owned by the caller, e.g. an event in a wait list. */
+    void record(const cl_kernel &kernel, const cl_event &event);
+
+    /** Wait for all pending commands and print the statistics table. */
+    void flush(void);
+
+    /** Return the statistics table of the current window. */
+    std::string to_string(void) const;
+
+    /** Return true if profiling is enabled by the environment. */
+    static bool enabled(void);
+
+    /* Constructor/destructor. */
+    Profiler();
+    ~Profiler();
+    Profiler(const Profiler &) = delete;
+    Profiler &operator=(const Profiler &) = delete;
+
+private:
+    const std::string &kernel_name(const cl_kernel &kernel);
+    void collect(const bool wait);
+    void aggregate(const Pending &pending);
+};
+
+} /* common */
+
+#endif /* COMMON_OPENCL_PROFILER_H_ */
@@ -0,0 +1,283 @@
+/*
+ * program.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "atto/opencl/opencl.hpp"
+using namespace atto;
+#include "program.hpp"
+
+namespace common {
+
+/** ---------------------------------------------------------------------------
+ * @brief Return a device info string parameter.
+ */
+static std::string DeviceString(
+    const cl_device_id &device,
+    const cl_device_info param)
+{
+    size_t size = 0;
+    if (clGetDeviceInfo(device, param, 0, NULL, &size) != CL_SUCCESS) {
+        return std::string();
+    }
+    std::vector<char> value(size + 1, '\0');
+    clGetDeviceInfo(device, param, size, value.data(), NULL);
+    return std::string(value.data());
+}
+
+/**
+ * @brief Return a platform info string parameter.
+ */
+static std::string PlatformString(
+    const cl_platform_id &platform,
+    const cl_platform_info param)
+{
+    size_t size = 0;
+    if (clGetPlatformInfo(platform, param, 0, NULL, &size) != CL_SUCCESS) {
+        return std::string();
+    }
+    std::vector<char> value(size + 1, '\0');
+    clGetPlatformInfo(platform, param, size, value.data(), NULL);
+    return std::string(value.data());
+}
+
+/**
+ * @brief Return the cache key of a program, the concatenation of the device
+ * identity, the build options and the program source. The full key is stored
+ * with the binary, so a hash collision never loads the wrong binary.
+ */
+static std::string CacheKey(
+    const cl_device_id &device,
+    const std::string &source,
+    const std::string &options)
+{
+    cl_platform_id platform = NULL;
+    clGetDeviceInfo(
+        device, CL_DEVICE_PLATFORM, sizeof(platform), &platform, NULL);
+
+    std::ostringstream ss;
+    ss << DeviceString(device, CL_DEVICE_NAME) << "\n"
+       << DeviceString(device, CL_DEVICE_VENDOR) << "\n"
+       << DeviceString(device, CL_DEVICE_VERSION) << "\n"
+       << DeviceString(device, CL_DRIVER_VERSION) << "\n"
+       << PlatformString(platform, CL_PLATFORM_NAME) << "\n"
+       << PlatformString(platform, CL_PLATFORM_VERSION) << "\n"
+       << options << "\n"
+       << source;
+    return ss.str();
+}
+
+/**
+ * @brief Return the path of the cache file of the specified key, named by
+ * the 64-bit FNV-1a hash of the key.
+ */
+static std::string CachePath(const std::string &key)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (const char &c : key) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ull;
+    }
+
+    const char *dirname = std::getenv("CL_CACHE_DIR");
+    std::string dir(dirname != NULL ? dirname : "/tmp/cl-cache");
+    mkdir(dir.c_str(), 0755);
+
+    std::ostringstream ss;
+    ss << dir << "/" << std::hex << std::setw(16) << std::setfill('0')
+       << hash << ".bin";
+    return ss.str();
+}
+
+/** ---------------------------------------------------------------------------
+ * @brief Cache file layout: magic, key size, key, binary size, binary.
+ */
+static const char kCacheMagic[8] = {'c', 'l', 'c', 'a', 'c', 'h', 'e', '1'};
+
+/**
+ * @brief Load the cached binary of the specified key. Return false if there
+ * is no cache file or if it holds a different key.
+ */
+static bool LoadBinary(
+    const std::string &path,
+    const std::string &key,
+    std::vector<unsigned char> &binary)
+{
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    char magic[sizeof(kCacheMagic)];
+    uint64_t key_size = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char *>(&key_size), sizeof(key_size));
+    if (!file ||
+        !std::equal(magic, magic + sizeof(magic), kCacheMagic) ||
+        key_size != key.size()) {
+        return false;
+    }
+
+    std::string stored(key_size, '\0');
+    file.read(&stored[0], key_size);
+    if (!file || stored != key) {
+        return false;
+    }
+
+    uint64_t binary_size = 0;
+    file.read(reinterpret_cast<char *>(&binary_size), sizeof(binary_size));
+    if (!file || binary_size == 0) {
+        return false;
+    }
+    binary.resize(binary_size);
+    file.read(reinterpret_cast<char *>(binary.data()), binary_size);
+    return static_cast<bool>(file);
+}
+
+/**
+ * @brief Store the binary of the specified key. The file is written to a
+ * temporary path and renamed, so concurrent runs never read a partial file.
+ */
+static void StoreBinary(
+    const std::string &path,
+    const std::string &key,
+    const std::vector<unsigned char> &binary)
+{
+    std::string tmppath = path + "." + std::to_string(getpid());
+    {
+        std::ofstream file(tmppath, std::ios::out | std::ios::binary);
+        if (!file) {
+            return;
+        }
+
+        const uint64_t key_size = key.size();
+        const uint64_t binary_size = binary.size();
+        file.write(kCacheMagic, sizeof(kCacheMagic));
+        file.write(reinterpret_cast<const char *>(&key_size), sizeof(key_size));
+        file.write(key.data(), key_size);
+        file.write(reinterpret_cast<const char *>(&binary_size), sizeof(binary_size));
+        file.write(reinterpret_cast<const char *>(binary.data()), binary_size);
+        if (!file) {
+            file.close();
+            std::remove(tmppath.c_str());
+            return;
+        }
+    }
+    std::rename(tmppath.c_str(), path.c_str());
+}
+
+/**
+ * @brief Get the binary of a program built for the specified device.
+ */
+static bool GetBinary(
+    const cl_program &program,
+    const cl_device_id &device,
+    std::vector<unsigned char> &binary)
+{
+    cl_uint n_devices = 0;
+    clGetProgramInfo(
+        program, CL_PROGRAM_NUM_DEVICES, sizeof(n_devices), &n_devices, NULL);
+    if (n_devices == 0) {
+        return false;
+    }
+
+    std::vector<cl_device_id> devices(n_devices);
+    std::vector<size_t> sizes(n_devices, 0);
+    clGetProgramInfo(
+        program,
+        CL_PROGRAM_DEVICES,
+        n_devices * sizeof(cl_device_id),
+        devices.data(),
+        NULL);
+    clGetProgramInfo(
+        program,
+        CL_PROGRAM_BINARY_SIZES,
+        n_devices * sizeof(size_t),
+        sizes.data(),
+        NULL);
+
+    /* Only retrieve the binary of the specified device. */
+    size_t ix = std::find(devices.begin(), devices.end(), device) - devices.begin();
+    if (ix == n_devices || sizes[ix] == 0) {
+        return false;
+    }
+
+    binary.resize(sizes[ix]);
+    std::vector<unsigned char *> binaries(n_devices, NULL);
+    binaries[ix] = binary.data();
+    cl_int err = clGetProgramInfo(
+        program,
+        CL_PROGRAM_BINARIES,
+        n_devices * sizeof(unsigned char *),
+        binaries.data(),
+        NULL);
+    return (err == CL_SUCCESS);
+}
+
+/** ---------------------------------------------------------------------------
+ * @brief Create and build an OpenCL program on the specified device, loading
+ * the program binary from the cache if available.
+ */
+cl_program BuildProgram(
+    const cl_context &context,
+    const cl_device_id &device,
+    const std::string &source,
+    const std::string &options)
+{
+    const std::string key = CacheKey(device, source, options);
+    const std::string path = CachePath(key);
+
+    /*
+     * Create the program from the cached binary. The binary still needs to
+     * be built, which is fast. Fall back to the source if the driver does
+     * not accept the binary.
+     */
+    std::vector<unsigned char> binary;
+    if (LoadBinary(path, key, binary)) {
+        const unsigned char *data = binary.data();
+        const size_t size = binary.size();
+        cl_int status = CL_SUCCESS;
+        cl_int err = CL_SUCCESS;
+        cl_program program = clCreateProgramWithBinary(
+            context, 1, &device, &size, &data, &status, &err);
+        if (err == CL_SUCCESS && status == CL_SUCCESS) {
+            err = clBuildProgram(program, 1, &device, options.c_str(), NULL, NULL);
+            if (err == CL_SUCCESS) {
+                return program;
+            }
+        }
+        if (program != NULL) {
+            clReleaseProgram(program);
+        }
+        std::cerr << "discarding program cache entry " << path << "\n";
+    }
+
+    /*
+     * Create and build the program from source, and cache its binary.
+     */
+    cl_program program = cl::Program::create_from_source(context, source);
+    cl::Program::build(program, device, options);
+    if (GetBinary(program, device, binary)) {
+        StoreBinary(path, key, binary);
+    }
+    return program;
+}
+
+} /* common */
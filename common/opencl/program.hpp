@@ -0,0 +1,43 @@
+/*
+ * program.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef COMMON_OPENCL_PROGRAM_H_
+#define COMMON_OPENCL_PROGRAM_H_
+
+#include <string>
+#include "atto/opencl/opencl.hpp"
+
+namespace common {
+
+/**
+ * @brief Create and build an OpenCL program on the specified device.
+ *
+ * The program binary is cached on disk, keyed by the program source, the
+ * build options and the device identity - device, vendor, driver and
+ * platform versions. Subsequent runs load the cached binary instead of
+ * compiling the source. Any change in the source, options or driver yields
+ * a different key, so stale binaries are never loaded. If the cached binary
+ * is rejected by the driver, the program is rebuilt from source and the
+ * cache entry is overwritten.
+ *
+ * The cache directory is given by the environment variable CL_CACHE_DIR,
+ * or /tmp/cl-cache if unset. Files included by the source via -I options
+ * are not part of the key.
+ */
+cl_program BuildProgram(
+    const cl_context &context,
+    const cl_device_id &device,
+    const std::string &source,
+    const std::string &options);
+
+} /* common */
+
+#endif /* COMMON_OPENCL_PROGRAM_H_ */
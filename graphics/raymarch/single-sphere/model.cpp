@@ -11,6 +11,7 @@
 
 #include "atto/opencl/opencl.hpp"
 #include "model.hpp"
+#include "program.hpp"
 #include <cfloat>
 using namespace atto;
 
@@ -85,7 +86,7 @@ Model::Model()
         core_assert(Params::device_index < devices.size(), "device index overflow");
         m_device = devices[Params::device_index];
         m_context = cl::Context::create_cl_gl_shared(m_device);
-        m_queue = cl::Queue::create(m_context, m_device);
+        m_queue = common::CreateQueue(m_context, m_device);
         std::cout << cl::Device::get_info_string(m_device) << "\n";
 
         /*
@@ -95,9 +96,8 @@ Model::Model()
         source.append(cl::Program::load_source_from_file("data/base.cl"));
         source.append(cl::Program::load_source_from_file("data/raymarch.cl"));
 
-        m_program = cl::Program::create_from_source(m_context, source);
-        cl::Program::build(m_program, m_device, "");
-        std::cout << cl::Program::get_source(m_program) << "\n";
+        m_program = common::BuildProgram(m_context, m_device, source, "");
+        std::cout << source << "\n";
 
         /*
          * Create engine kernels.
@@ -157,6 +157,7 @@ Model::~Model()
 
     /* Teardown OpenCL data. */
     {
+        m_profiler.flush();
         for (auto &it : m_images) {
             cl::Memory::release(it);
         }
@@ -257,7 +258,7 @@ void Model::execute(void)
             global_ws,
             local_ws,
             NULL,
-            NULL);
+            m_profiler.event(m_kernels[KernelRaymarch]));
 
         /* Wait for OpenCL to finish and release the gl objects. */
         cl::gl::enqueue_release_gl_objects(m_queue, &m_images, NULL, NULL);
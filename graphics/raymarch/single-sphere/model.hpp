@@ -14,6 +14,7 @@
 
 #include <vector>
 #include "base.hpp"
+#include "profiler.hpp"
 #include "generate.hpp"
 
 struct Model : atto::gl::Drawable {
@@ -25,6 +26,7 @@ struct Model : atto::gl::Drawable {
     cl_device_id m_device = NULL;
     cl_command_queue m_queue = NULL;
     cl_program m_program = NULL;
+    common::Profiler m_profiler;
 
     /* Model kernels. */
     enum {
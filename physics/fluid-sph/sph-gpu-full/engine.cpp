@@ -12,6 +12,7 @@
 #include <random>
 #include "atto/opencl/opencl.hpp"
 #include "engine.hpp"
+#include "program.hpp"
 using namespace atto;
 
 /** ---------------------------------------------------------------------------
@@ -118,9 +119,8 @@ void Engine::setup(
         source.append(cl::Program::load_source_from_file("data/integrate.cl"));
         source.append(cl::Program::load_source_from_file("data/particles.cl"));
 
-        m_program = cl::Program::create_from_source(m_context, source);
-        cl::Program::build(m_program, m_device, "");
-        std::cout << cl::Program::get_source(m_program) << "\n";
+        m_program = common::BuildProgram(m_context, m_device, source, "");
+        std::cout << source << "\n";
 
         /* Create engine kernels. */
         m_kernels.resize(NumKernels, NULL);
@@ -181,6 +181,7 @@ void Engine::teardown(void)
 
     /* Teardown OpenCL data. */
     {
+        m_profiler.flush();
         for (auto &it : m_images) {
             cl::Memory::release(it);
         }
@@ -220,7 +221,7 @@ void Engine::execute(void)
             cl::NDRange::Make(Params::n_particles, Params::work_group_size),
             cl::NDRange(Params::work_group_size),
             NULL,
-            NULL);
+            m_profiler.event(m_kernels[KernelCopyVertexData]));
 
         /* Wait for OpenCL to finish and release the gl objects. */
         cl::gl::enqueue_release_gl_objects(
@@ -244,7 +245,7 @@ void Engine::execute(void)
             cl::NDRange::Make(Params::n_particles, Params::work_group_size),
             cl::NDRange(Params::work_group_size),
             NULL,
-            NULL);
+            m_profiler.event(m_kernels[KernelUpdateBoundaries]));
     }
 
     /*
@@ -262,7 +263,7 @@ void Engine::execute(void)
             cl::NDRange::Make(Params::n_particles, Params::work_group_size),
             cl::NDRange(Params::work_group_size),
             NULL,
-            NULL);
+            m_profiler.event(m_kernels[KernelBeginIntegrate]));
     }
 
     /*
@@ -282,7 +283,7 @@ void Engine::execute(void)
             cl::NDRange::Make(Params::n_particles, Params::work_group_size),
             cl::NDRange(Params::work_group_size),
             NULL,
-            NULL);
+            m_profiler.event(m_kernels[KernelComputeDensity]));
 
         /* Compute pressure, viscosity and external forces. */
         cl::Kernel::set_arg(m_kernels[KernelComputeForces], 0, sizeof(cl_uint), (void *) &Params::n_particles);
@@ -297,7 +298,7 @@ void Engine::execute(void)
             cl::NDRange::Make(Params::n_particles, Params::work_group_size),
             cl::NDRange(Params::work_group_size),
             NULL,
-            NULL);
+            m_profiler.event(m_kernels[KernelComputeForces]));
     }
 
     /*
@@ -315,7 +316,7 @@ void Engine::execute(void)
             cl::NDRange::Make(Params::n_particles, Params::work_group_size),
             cl::NDRange(Params::work_group_size),
             NULL,
-            NULL);
+            m_profiler.event(m_kernels[KernelEndIntegrate]));
     }
 
     /*
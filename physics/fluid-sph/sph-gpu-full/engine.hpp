@@ -14,6 +14,7 @@
 
 #include "atto/opencl/opencl.hpp"
 #include "base.hpp"
+#include "profiler.hpp"
 #include "generate.hpp"
 
 /**
@@ -35,6 +36,7 @@ struct Engine {
     cl_device_id m_device = NULL;
     cl_command_queue m_queue = NULL;
     cl_program m_program = NULL;
+    common::Profiler m_profiler;
 
     /* Engine kernels. */
     enum {
@@ -148,7 +148,7 @@ Model::Model()
         core_assert(Params::device_index < devices.size(), "device index overflow");
         m_device = devices[Params::device_index];
         m_context = cl::Context::create_cl_gl_shared(m_device);
-        m_queue = cl::Queue::create(m_context, m_device);
+        m_queue = common::CreateQueue(m_context, m_device);
         // std::cout << cl::Device::get_info_string(m_device) << "\n";
     }
 
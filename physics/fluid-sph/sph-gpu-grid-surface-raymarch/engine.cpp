@@ -12,6 +12,7 @@
 #include <random>
 #include "atto/opencl/opencl.hpp"
 #include "engine.hpp"
+#include "program.hpp"
 using namespace atto;
 
 /** ---------------------------------------------------------------------------
@@ -125,9 +126,8 @@ void Engine::setup(
         source.append(cl::Program::load_source_from_file("data/integrate.cl"));
         source.append(cl::Program::load_source_from_file("data/particles.cl"));
 
-        m_program = cl::Program::create_from_source(m_context, source);
-        cl::Program::build(m_program, m_device, "");
-        std::cout << cl::Program::get_source(m_program) << "\n";
+        m_program = common::BuildProgram(m_context, m_device, source, "");
+        std::cout << source << "\n";
 
         /* Create engine kernels. */
         m_kernels.resize(NumKernels, NULL);
@@ -196,6 +196,7 @@ void Engine::teardown(void)
 
     /* Teardown OpenCL data. */
     {
+        m_profiler.flush();
         for (auto &it : m_images) {
             cl::Memory::release(it);
         }
@@ -234,7 +235,7 @@ void Engine::execute(void)
             cl::NDRange::Make(Params::n_particles, Params::work_group_size),
             cl::NDRange(Params::work_group_size),
             NULL,
-            NULL);
+            m_profiler.event(m_kernels[KernelCopyVertexData]));
 
         /* Wait for OpenCL to finish and release the gl objects. */
         cl::gl::enqueue_release_gl_objects(
@@ -258,7 +259,7 @@ void Engine::execute(void)
             cl::NDRange::Make(Params::n_particles, Params::work_group_size),
             cl::NDRange(Params::work_group_size),
             NULL,
-            NULL);
+            m_profiler.event(m_kernels[KernelUpdateBoundaries]));
 
         /* Clear the grid map. */
         cl::Kernel::set_arg(m_kernels[KernelClearGrid], 0, sizeof(cl_uint), (void *) &m_grid.capacity);
@@ -270,7 +271,7 @@ void Engine::execute(void)
             cl::NDRange::Make(m_grid.capacity, Params::work_group_size),
             cl::NDRange(Params::work_group_size),
             NULL,
-            NULL);
+            m_profiler.event(m_kernels[KernelClearGrid]));
 
         /* Build the grid map of particle positions. */
         cl::Kernel::set_arg(m_kernels[KernelBuildGrid], 0, sizeof(cl_uint), (void *) &Params::n_particles);
@@ -285,7 +286,7 @@ void Engine::execute(void)
             cl::NDRange::Make(Params::n_particles, Params::work_group_size),
             cl::NDRange(Params::work_group_size),
             NULL,
-            NULL);
+            m_profiler.event(m_kernels[KernelBuildGrid]));
     }
 
     /*
@@ -303,7 +304,7 @@ void Engine::execute(void)
             cl::NDRange::Make(Params::n_particles, Params::work_group_size),
             cl::NDRange(Params::work_group_size),
             NULL,
-            NULL);
+            m_profiler.event(m_kernels[KernelBeginIntegrate]));
     }
 
     /*
@@ -325,7 +326,7 @@ void Engine::execute(void)
             cl::NDRange::Make(Params::n_particles, Params::work_group_size),
             cl::NDRange(Params::work_group_size),
             NULL,
-            NULL);
+            m_profiler.event(m_kernels[KernelComputeDensity]));
 
         /* Compute pressure, viscosity and external forces. */
         cl::Kernel::set_arg(m_kernels[KernelComputeForces], 0, sizeof(cl_uint), (void *) &Params::n_particles);
@@ -342,7 +343,7 @@ void Engine::execute(void)
             cl::NDRange::Make(Params::n_particles, Params::work_group_size),
             cl::NDRange(Params::work_group_size),
             NULL,
-            NULL);
+            m_profiler.event(m_kernels[KernelComputeForces]));
     }
 
     /*
@@ -360,7 +361,7 @@ void Engine::execute(void)
             cl::NDRange::Make(Params::n_particles, Params::work_group_size),
             cl::NDRange(Params::work_group_size),
             NULL,
-            NULL);
+            m_profiler.event(m_kernels[KernelEndIntegrate]));
     }
 
     /*
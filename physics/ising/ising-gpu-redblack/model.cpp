@@ -11,6 +11,7 @@
 
 #include "atto/opencl/opencl.hpp"
 #include "model.hpp"
+#include "program.hpp"
 using namespace atto;
 
 /** ---------------------------------------------------------------------------
@@ -100,7 +101,7 @@ Model::Model()
         core_assert(Params::device_index < devices.size(), "device index overflow");
         m_device = devices[Params::device_index];
         m_context = cl::Context::create_cl_gl_shared(m_device);
-        m_queue = cl::Queue::create(m_context, m_device);
+        m_queue = common::CreateQueue(m_context, m_device);
         // std::cout << cl::Device::get_info_string(m_device) << "\n";
 
         /*
@@ -109,9 +110,8 @@ Model::Model()
         std::string source;
         source.append(cl::Program::load_source_from_file("data/common.cl"));
         source.append(cl::Program::load_source_from_file("data/ising.cl"));
-        m_program = cl::Program::create_from_source(m_context, source);
-        std::cout << cl::Program::get_source(m_program) << "\n";
-        cl::Program::build(m_program, m_device, "");
+        m_program = common::BuildProgram(m_context, m_device, source, "");
+        std::cout << source << "\n";
 
         /*
          * Create OpenCL kernels.
@@ -173,6 +173,7 @@ Model::~Model()
 
     /* Teardown OpenCL data. */
     {
+        m_profiler.flush();
         for (auto &it : m_images) {
             cl::Memory::release(it);
         }
@@ -294,7 +295,7 @@ bool Model::execute(void)
                 cl::NDRange::Roundup(Params::n_sites, Params::work_group_size)),
             cl::NDRange(Params::work_group_size, Params::work_group_size),
             NULL,
-            NULL);
+            m_profiler.event(m_kernels[KernelRandomLattice]));
     }
 
     /*
@@ -314,7 +315,7 @@ bool Model::execute(void)
                 cl::NDRange::Roundup(Params::n_sites, Params::work_group_size)),
             cl::NDRange(Params::work_group_size, Params::work_group_size),
             NULL,
-            NULL);
+            m_profiler.event(m_kernels[KernelInitLattice]));
     }
     if (++m_step == Params::n_steps) {
         m_step = 0;
@@ -341,7 +342,7 @@ bool Model::execute(void)
                 cl::NDRange::Roundup(Params::n_sites, Params::work_group_size)),
             cl::NDRange(Params::work_group_size, Params::work_group_size),
             NULL,
-            NULL);
+            m_profiler.event(m_kernels[KernelFlipLattice]));
     }
 
     /*
@@ -380,7 +381,7 @@ bool Model::execute(void)
                 cl::NDRange::Roundup(Params::image_height, Params::work_group_size)),
             cl::NDRange(Params::work_group_size, Params::work_group_size),
             NULL,
-            NULL);
+            m_profiler.event(m_kernels[KernelImageLattice]));
 
         /* Wait for OpenCL to finish and release the gl objects. */
         cl::gl::enqueue_release_gl_objects(
@@ -16,6 +16,7 @@
 #include <random>
 #include <algorithm>
 #include "base.hpp"
+#include "profiler.hpp"
 
 struct Model : atto::gl::Drawable {
     /* ---- Model data ----------------------------------------------------- */
@@ -33,6 +34,7 @@ struct Model : atto::gl::Drawable {
     cl_device_id m_device = NULL;
     cl_command_queue m_queue = NULL;
     cl_program m_program = NULL;
+    common::Profiler m_profiler;
 
     /* Model kernels. */
     enum {
@@ -10,6 +10,7 @@
  */
 
 #include "model.hpp"
+#include "program.hpp"
 using namespace atto;
 
 /** ---------------------------------------------------------------------------
@@ -88,15 +89,15 @@ Model::Model()
         core_assert(Params::device_index < devices.size(), "device index overflow");
         m_device = devices[Params::device_index];
         m_context = cl::Context::create_cl_gl_shared(m_device);
-        m_queue = cl::Queue::create(m_context, m_device);
+        m_queue = common::CreateQueue(m_context, m_device);
         // std::cout << cl::Device::get_info_string(m_device) << "\n";
 
         /*
          * Create OpenCL program.
          */
-        m_program = cl::Program::create_from_file(m_context, "data/mandelbrot.cl");
-        std::cout << cl::Program::get_source(m_program) << "\n";
-        cl::Program::build(m_program, m_device, "");
+        std::string source = cl::Program::load_source_from_file("data/mandelbrot.cl");
+        m_program = common::BuildProgram(m_context, m_device, source, "");
+        std::cout << source << "\n";
 
         /*
          * Create OpenCL kernel.
@@ -131,6 +132,7 @@ Model::~Model()
 
     /* Teardown OpenCL data. */
     {
+        m_profiler.flush();
         for (auto &it : m_images) {
             cl::Memory::release(it);
         }
@@ -309,7 +311,7 @@ void Model::execute(void)
         global_ws,
         local_ws,
         NULL,
-        NULL);
+        m_profiler.event(m_kernels[KernelMandelbrot]));
 
     /* Wait for OpenCL to finish and release the gl objects. */
     cl::gl::enqueue_release_gl_objects(m_queue, &m_images, NULL, NULL);
@@ -15,6 +15,7 @@
 #include <memory>
 #include <vector>
 #include "base.hpp"
+#include "profiler.hpp"
 
 /**
  * Model
@@ -28,6 +29,7 @@ struct Model : atto::gl::Drawable {
     cl_device_id m_device = NULL;
     cl_command_queue m_queue = NULL;
     cl_program m_program = NULL;
+    common::Profiler m_profiler;
 
     /* Model kernels. */
     enum {
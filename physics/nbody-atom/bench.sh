@@ -0,0 +1,129 @@
+#! /bin/bash
+
+#
+# bench.sh
+#
+# Copyright (c) 2020 Carlos Braga
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the MIT License.
+#
+# See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+#
+
+# -----------------------------------------------------------------------------
+# Benchmark parameters
+#
+N_ATOMS="${N_ATOMS:-1000 10000 100000 1000000}"
+N_FULL_MAX="${N_FULL_MAX:-32768}"      # largest system size for cpu-full
+N_STEPS="${N_STEPS:-10}"
+N_THREADS_MAX="${N_THREADS_MAX:-$(nproc)}"
+FORCE_TOL="${FORCE_TOL:-1.0e-8}"
+OUTPUT="${OUTPUT:-/tmp/out.bench.csv}"
+
+# -----------------------------------------------------------------------------
+# die with message
+#
+die() {
+    echo >&2 "$@"
+    exit 1
+}
+
+#
+# run command and check exit code
+#
+run() {
+    echo >&2 "$@" && "$@"
+    code=$?
+    [[ $code -ne 0 ]] && die "[$@] failed with error code $code"
+    return 0
+}
+
+#
+# thread counts 1, 2, 4, ... up to and including the maximum
+#
+threads() {
+    local n=1
+    while [[ $n -lt ${N_THREADS_MAX} ]]; do
+        echo $n
+        n=$((2 * n))
+    done
+    echo ${N_THREADS_MAX}
+}
+
+#
+# compare two force files, fail if the largest absolute force difference
+# exceeds the tolerance scaled by the largest force magnitude
+#
+compare() {
+    paste -d ' ' "${1}" "${2}" | awk -v tol="${FORCE_TOL}" -v a="${1}" -v b="${2}" '
+        function abs(x) { return x < 0 ? -x : x }
+        {
+            for (i = 1; i <= 3; ++i) {
+                d = abs($i - $(i + 3)); if (d > dmax) dmax = d;
+                f = abs($i); if (f > fmax) fmax = f;
+            }
+        }
+        END {
+            err = dmax / (fmax > 1.0 ? fmax : 1.0);
+            printf "compare %s %s max_error %e\n", a, b, err > "/dev/stderr";
+            exit (err > tol || NR == 0);
+        }'
+}
+
+# -----------------------------------------------------------------------------
+# Build an engine variant once, the system size is set at runtime.
+#
+build() {
+    pushd "nbody-atom-${1}" > /dev/null
+    run make -f ../Makefile clean > /dev/null
+    run make -f ../Makefile -j all > /dev/null
+    popd > /dev/null
+}
+
+#
+# Remove the build products of an engine variant.
+#
+clean() {
+    pushd "nbody-atom-${1}" > /dev/null
+    run make -f ../Makefile clean > /dev/null
+    popd > /dev/null
+}
+
+#
+# Benchmark an engine variant over the thread counts with a given size.
+#
+execute() {
+    pushd "nbody-atom-${1}" > /dev/null
+    for n_threads in $(threads); do
+        OMP_NUM_THREADS=${n_threads} run ./md.out bench ${N_STEPS} \
+            "/tmp/out.bench.${1}.${2}.forces" n_atoms=${2} >> "${OUTPUT}"
+    done
+    popd > /dev/null
+}
+
+for variant in cpu-full cpu-grid cpu-graph; do
+    build ${variant}
+done
+
+echo "variant,n_atoms,n_threads,n_steps,ns_atom_step,pairs_per_s,memory_mb" > "${OUTPUT}"
+for n_atoms in ${N_ATOMS}; do
+    [[ ${n_atoms} -le ${N_FULL_MAX} ]] && execute cpu-full ${n_atoms}
+    execute cpu-grid ${n_atoms}
+    execute cpu-graph ${n_atoms}
+
+    # Validate the forces against the reference variant.
+    ref=cpu-grid
+    [[ ${n_atoms} -le ${N_FULL_MAX} ]] && ref=cpu-full
+    for variant in cpu-grid cpu-graph; do
+        [[ ${variant} == ${ref} ]] && continue
+        compare "/tmp/out.bench.${ref}.${n_atoms}.forces" \
+                "/tmp/out.bench.${variant}.${n_atoms}.forces" ||
+            die "force mismatch ${ref} ${variant} with ${n_atoms} atoms"
+    done
+done
+
+for variant in cpu-full cpu-grid cpu-graph; do
+    clean ${variant}
+done
+cat "${OUTPUT}"
@@ -11,6 +11,7 @@
 
 #include "atto/opencl/opencl.hpp"
 #include "compute.hpp"
+#include "reduce.hpp"
 using namespace atto;
 
 namespace compute {
@@ -21,11 +22,9 @@ namespace compute {
  */
 double com_mass(std::vector<Atom> &atoms)
 {
-    double mass = 0.0;
-    for (auto &atom : atoms) {
-        mass += atom.mass;
-    }
-    return mass;
+    return reduce::sum<double>(atoms.size(), [&atoms] (size_t ix) {
+        return atoms[ix].mass;
+    });
 }
 
 /** ---------------------------------------------------------------------------
@@ -34,12 +33,10 @@ double com_mass(std::vector<Atom> &atoms)
  */
 math::vec3d com_pos(std::vector<Atom> &atoms)
 {
-    double mass = 0.0;
-    math::vec3d pos = math::vec3d{};
-    for (auto &atom : atoms) {
-        mass += atom.mass;
-        pos += atom.pos * atom.mass;
-    }
+    double mass = com_mass(atoms);
+    math::vec3d pos = reduce::sum<math::vec3d>(atoms.size(), [&atoms] (size_t ix) {
+        return atoms[ix].pos * atoms[ix].mass;
+    });
     return pos / mass;
 }
 
@@ -49,12 +46,10 @@ math::vec3d com_pos(std::vector<Atom> &atoms)
  */
 math::vec3d com_upos(std::vector<Atom> &atoms)
 {
-    double mass = 0.0;
-    math::vec3d upos = math::vec3d{};
-    for (auto &atom : atoms) {
-        mass += atom.mass;
-        upos += atom.upos * atom.mass;
-    }
+    double mass = com_mass(atoms);
+    math::vec3d upos = reduce::sum<math::vec3d>(atoms.size(), [&atoms] (size_t ix) {
+        return atoms[ix].upos * atoms[ix].mass;
+    });
     return upos / mass;
 }
 
@@ -64,12 +59,8 @@ math::vec3d com_upos(std::vector<Atom> &atoms)
  */
 math::vec3d com_vel(std::vector<Atom> &atoms)
 {
-    double mass = 0.0;
-    math::vec3d mom = math::vec3d{};
-    for (auto &atom : atoms) {
-        mass += atom.mass;
-        mom += atom.mom;
-    }
+    double mass = com_mass(atoms);
+    math::vec3d mom = com_mom(atoms);
     return mom /= mass;
 }
 
@@ -79,11 +70,9 @@ math::vec3d com_vel(std::vector<Atom> &atoms)
  */
 math::vec3d com_mom(std::vector<Atom> &atoms)
 {
-    math::vec3d mom = math::vec3d{};
-    for (auto &atom : atoms) {
-        mom += atom.mom;
-    }
-    return mom;
+    return reduce::sum<math::vec3d>(atoms.size(), [&atoms] (size_t ix) {
+        return atoms[ix].mom;
+    });
 }
 
 /** ---------------------------------------------------------------------------
@@ -92,11 +81,9 @@ math::vec3d com_mom(std::vector<Atom> &atoms)
  */
 math::vec3d com_force(std::vector<Atom> &atoms)
 {
-    math::vec3d force = math::vec3d{};
-    for (auto &atom : atoms) {
-        force += atom.force;
-    }
-    return force;
+    return reduce::sum<math::vec3d>(atoms.size(), [&atoms] (size_t ix) {
+        return atoms[ix].force;
+    });
 }
 
 /** ---------------------------------------------------------------------------
@@ -118,10 +105,9 @@ double density(std::vector<Atom> &atoms, const Domain &domain)
  */
 double energy_kin(std::vector<Atom> &atoms)
 {
-    double energy = 0.0;
-    for (auto &atom : atoms) {
-        energy += math::dot(atom.mom, atom.mom) * atom.rmass;
-    }
+    double energy = reduce::sum<double>(atoms.size(), [&atoms] (size_t ix) {
+        return math::dot(atoms[ix].mom, atoms[ix].mom) * atoms[ix].rmass;
+    });
     return 0.5 * energy;
 }
 
@@ -131,11 +117,9 @@ double energy_kin(std::vector<Atom> &atoms)
  */
 double energy_pot(std::vector<Atom> &atoms)
 {
-    double energy = 0.0;
-    for (auto &atom : atoms) {
-        energy += atom.energy;
-    }
-    return energy;
+    return reduce::sum<double>(atoms.size(), [&atoms] (size_t ix) {
+        return atoms[ix].energy;
+    });
 }
 
 /** ---------------------------------------------------------------------------
@@ -148,12 +132,10 @@ double temperature_kin(
     double &laplace)
 {
     /* Compute kinetic temperature of the fluid. */
-    grad_sq = 0.0;
-    laplace = 0.0;
-    for (auto &atom : atoms) {
-        grad_sq += math::dot(atom.mom, atom.mom) * atom.rmass;
-        laplace += 3.0;
-    }
+    grad_sq = reduce::sum<double>(atoms.size(), [&atoms] (size_t ix) {
+        return math::dot(atoms[ix].mom, atoms[ix].mom) * atoms[ix].rmass;
+    });
+    laplace = 3.0 * atoms.size();
 
     /*
      * If fluid size is more than one atom, remove the CoM momentum
@@ -181,24 +163,27 @@ double temperature_kin(
 math::mat3d pressure_kin(std::vector<Atom> &atoms, const Domain &domain)
 {
     math::vec3d velocity = compute::com_vel(atoms);
-    math::mat3d pressure = math::mat3d{};
-    for (auto &atom : atoms) {
+    math::mat3d pressure = reduce::sum<math::mat3d>(atoms.size(), [&] (size_t ix) {
+        const Atom &atom = atoms[ix];
+
         /* Atom velocity relative to the fluid CoM. */
         math::vec3d vel = atom.mom * atom.rmass;
         vel -= velocity;
 
-        pressure.xx += atom.mass * vel.x * vel.x;
-        pressure.xy += atom.mass * vel.x * vel.y;
-        pressure.xz += atom.mass * vel.x * vel.z;
+        math::mat3d pres = math::mat3d{};
+        pres.xx += atom.mass * vel.x * vel.x;
+        pres.xy += atom.mass * vel.x * vel.y;
+        pres.xz += atom.mass * vel.x * vel.z;
 
-        pressure.yx += atom.mass * vel.y * vel.x;
-        pressure.yy += atom.mass * vel.y * vel.y;
-        pressure.yz += atom.mass * vel.y * vel.z;
+        pres.yx += atom.mass * vel.y * vel.x;
+        pres.yy += atom.mass * vel.y * vel.y;
+        pres.yz += atom.mass * vel.y * vel.z;
 
-        pressure.zx += atom.mass * vel.z * vel.x;
-        pressure.zx += atom.mass * vel.z * vel.y;
-        pressure.zz += atom.mass * vel.z * vel.z;
-    }
+        pres.zx += atom.mass * vel.z * vel.x;
+        pres.zx += atom.mass * vel.z * vel.y;
+        pres.zz += atom.mass * vel.z * vel.z;
+        return pres;
+    });
 
     double volume = domain.length.x *
                     domain.length.y *
@@ -213,10 +198,9 @@ math::mat3d pressure_kin(std::vector<Atom> &atoms, const Domain &domain)
  */
 math::mat3d pressure_vir(std::vector<Atom> &atoms, const Domain &domain)
 {
-    math::mat3d pressure = math::mat3d{};
-    for (auto &atom : atoms) {
-        pressure += atom.virial;
-    }
+    math::mat3d pressure = reduce::sum<math::mat3d>(atoms.size(), [&atoms] (size_t ix) {
+        return atoms[ix].virial;
+    });
 
     double volume = domain.length.x *
                     domain.length.y *
@@ -261,22 +245,51 @@ math::vec3d pbc(const math::vec3d &r, const Domain &domain)
 }
 
 /** ---------------------------------------------------------------------------
+ * force_shell
+ * @brief Return the weight of a pair interaction in the specified force shell.
+ * The r-RESPA split uses a switching function S(r) that is 1 for pairs closer
+ * than r_inner - r_heal, 0 beyond r_inner, and a smooth cubic in between.
+ * The inner shell force is S(r)*F(r) and the outer shell is (1 - S(r))*F(r).
+ */
+double force_shell(
+    const double r_12_sq,
+    const Field &field,
+    const uint32_t shell)
+{
+    if (shell == ShellFull) {
+        return 1.0;
+    }
+
+    /* Compute the switching function of the inner shell. */
+    const double r_begin = field.r_inner - field.r_heal;
+    double weight = 1.0;
+    if (r_12_sq > field.r_inner * field.r_inner) {
+        weight = 0.0;
+    } else if (r_12_sq > r_begin * r_begin) {
+        double x = (std::sqrt(r_12_sq) - r_begin) / field.r_heal;
+        weight = 1.0 + x * x * (2.0 * x - 3.0);
+    }
+
+    return (shell == ShellInner) ? weight : 1.0 - weight;
+}
+
+/**
  * force_atom
- * @brief Compute the force on the atom with the specified index.
+ * @brief Accumulate the force on the atom with the specified index, weighted
+ * by the pair interaction weights of the specified force shell. Return the
+ * number of pair interactions within the cutoff radius.
  */
-void force_atom(
+size_t force_atom(
     const size_t atom_1,
     const size_t n_atoms,
     const size_t n_neighbours,
     std::vector<Atom> &atoms,
     const Domain &domain,
-    const Field &field)
+    const Field &field,
+    const uint32_t shell)
 {
-    const double r_cut_sq = field.r_cut * field.r_cut;
-
-    atoms[atom_1].force = math::vec3d{};
-    atoms[atom_1].energy = 0.0;
-    atoms[atom_1].virial = math::mat3d{};
+    /* Type pair coefficients of the atom. */
+    const FieldPair *coeff = &field.pairs[atoms[atom_1].type * Field::max_types];
 
     const size_t begin = atom_1 * n_neighbours;
     const size_t end = begin + n_neighbours;
@@ -290,25 +303,34 @@ void force_atom(
         math::vec3d r_12 = atoms[atom_1].pos - atoms[atom_2].pos;
         r_12 = compute::pbc(r_12, domain);
 
-        if (pair_ix < end && dot(r_12, r_12) < r_cut_sq) {
-            Pair pair = force_pair(atom_1, atom_2, r_12, field);
-            atoms[atom_1].force  -= pair.gradient;
-            atoms[atom_1].energy += pair.energy * 0.5;
-            atoms[atom_1].virial += pair.virial * 0.5;
+        const FieldPair &coeff_12 = coeff[atoms[atom_2].type];
+        const double r_12_sq = dot(r_12, r_12);
+        if (pair_ix < end && r_12_sq < coeff_12.r_cut_sq) {
+            double weight = force_shell(r_12_sq, field, shell);
+            if (weight > 0.0) {
+                Pair pair = force_pair(atom_1, atom_2, r_12, coeff_12, field.r_hard);
+                atoms[atom_1].force  -= pair.gradient * weight;
+                atoms[atom_1].energy += pair.energy * (0.5 * weight);
+                atoms[atom_1].virial += pair.virial * (0.5 * weight);
+            }
             pair_ix++;
         }
     }
+
+    return (pair_ix - begin);
 }
 
 /**
  * force_pair
- * @brief Compute pair interaction force.
+ * @brief Compute pair interaction force using the coefficients of the atom
+ * type pair.
  */
 Pair force_pair(
     const size_t atom_1,
     const size_t atom_2,
     const math::vec3d &r_12,
-    const Field &field)
+    const FieldPair &coeff,
+    const double r_hard)
 {
     /* Compute pair attributes - energy, gradient, laplacian and virial. */
     Pair pair;
@@ -323,16 +345,15 @@ Pair force_pair(
     pair.virial = math::mat3d{};
 
     /* Interaction coefficients. */
-    const double epsilon = field.epsilon;
-    const double sigma = field.sigma;
-    const double r_hard = field.r_hard;
+    const double epsilon = coeff.epsilon;
+    const double sigma = coeff.sigma;
 
     const double sigma_sq = sigma * sigma;
     const double r_hard_sq = r_hard * r_hard;
 
     /* Define pair energy and force coefficients */
-    double energy_coeff = 4.0 * field.epsilon;
-    double force_coeff = 24.0 * field.epsilon / sigma_sq;
+    double energy_coeff = 4.0 * epsilon;
+    double force_coeff = 24.0 * epsilon / sigma_sq;
 
     /* Ensure pair distance is larger than the hard sphere radius. */
     double energy_hard_sphere = 0.0;
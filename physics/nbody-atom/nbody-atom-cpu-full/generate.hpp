@@ -15,37 +15,90 @@
 #include "atto/opencl/opencl.hpp"
 #include "base.hpp"
 
+/**
+ * @brief Collection of point generators. The generators run in parallel and
+ * write the points directly into caller storage, points[ix] at byte offset
+ * ix * stride, so the same generator fills an array of positions or the
+ * position member of an array of atoms. The random numbers are a function of
+ * the seed and a counter, and the points depend on the seed alone, not on the
+ * number of threads.
+ */
 namespace generate {
 
+/** Random number streams of the generators. */
+enum : uint64_t {
+    StreamSites = 1,                /* lattice site order */
+    StreamPoints,                   /* random point coordinates */
+    StreamMomenta                   /* atom momenta */
+};
+
+/** Return a random 64-bit integer of the counter in the seed stream. */
+uint64_t random(const uint64_t seed, const uint64_t counter);
+
+/** Return a uniform random number in [0,1) of the counter in the seed stream. */
+double uniform(const uint64_t seed, const uint64_t counter);
+
+/** Return a normal random number of the counter in the seed stream. */
+double gauss(const uint64_t seed, const uint64_t counter);
+
+/** Return the image of ix in a random permutation of [0,n). */
+size_t permute(const size_t ix, const size_t n, const uint64_t seed);
+
 /** Create a set of points uniformly distributed inside a box. */
-std::vector<atto::math::vec3d> points_random(
+void points_random(
     const size_t n_points,
     const double xlo,
     const double ylo,
     const double zlo,
     const double xhi,
     const double yhi,
-    const double zhi);
+    const double zhi,
+    const uint64_t seed,
+    atto::math::vec3d *points,
+    const size_t stride = sizeof(atto::math::vec3d));
 
 /** Create a collection of points inside a simple cubic lattice. */
-std::vector<atto::math::vec3d> points_cubic(
+void points_cubic(
     const size_t n_points,
     const double xlo,
     const double ylo,
     const double zlo,
     const double xhi,
     const double yhi,
-    const double zhi);
+    const double zhi,
+    const uint64_t seed,
+    const bool shuffle,
+    atto::math::vec3d *points,
+    const size_t stride = sizeof(atto::math::vec3d));
 
 /** Create a collection of points inside a face centred cubic lattice. */
-std::vector<atto::math::vec3d> points_fcc(
+void points_fcc(
+    const size_t n_points,
+    const double xlo,
+    const double ylo,
+    const double zlo,
+    const double xhi,
+    const double yhi,
+    const double zhi,
+    const uint64_t seed,
+    const bool shuffle,
+    atto::math::vec3d *points,
+    const size_t stride = sizeof(atto::math::vec3d));
+
+/** Create a Poisson disk set of points with a minimum distance inside a box. */
+void points_poisson(
     const size_t n_points,
     const double xlo,
     const double ylo,
     const double zlo,
     const double xhi,
     const double yhi,
-    const double zhi);
+    const double zhi,
+    const double radius,
+    const uint64_t seed,
+    const bool shuffle,
+    atto::math::vec3d *points,
+    const size_t stride = sizeof(atto::math::vec3d));
 
 } /* generate */
 
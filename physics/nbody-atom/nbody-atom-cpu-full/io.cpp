@@ -79,4 +79,26 @@ void write_xyz(
     }
 }
 
+/**
+ * write_forces
+ * @brief Write fluid atom forces into text file, one atom per line.
+ */
+void write_forces(
+    const std::vector<Atom> &atoms,
+    core::FileOut &file)
+{
+    core_assert(file.is_open(), "file is not open");
+    core_assert(!file.is_binary(), "file is binary");
+    std::string buffer;
+
+    for (auto &atom : atoms) {
+        buffer = core::str_format(
+            "%+.15e %+.15e %+.15e\n",
+            atom.force.x,
+            atom.force.y,
+            atom.force.z);
+        core_assert(file.writeline(buffer), "failed to write atom force");
+    }
+}
+
 } /* io */
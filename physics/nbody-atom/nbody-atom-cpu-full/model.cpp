@@ -24,7 +24,13 @@ Model::Model(void)
     /* Setup engine object. */
     m_engine.setup();
     m_engine.generate();
+
+    /* Relax the initial overlaps with a soft core and reset the engine. */
     m_engine.reset(0.5 * Params::pair_sigma);
+    size_t n_steps = m_engine.minimize(
+        Params::n_min_steps, Params::min_force_tol);
+    std::cout << "minimize " << n_steps << " steps\n";
+    m_engine.reset(Params::pair_r_hard * Params::pair_sigma);
 }
 
 /**
@@ -41,11 +47,6 @@ Model::~Model()
  */
 bool Model::execute(void)
 {
-    /* Model pre-execution. */
-    if (m_step == Params::n_min_steps) {
-        m_engine.reset(Params::pair_r_hard * Params::pair_sigma);
-    }
-
     /* Execute an engine step. */
     m_engine.execute();
 
@@ -0,0 +1,87 @@
+/*
+ * reduce.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef MD_REDUCE_H_
+#define MD_REDUCE_H_
+
+#include <omp.h>
+#include "atto/opencl/opencl.hpp"
+#include "params.hpp"
+
+/**
+ * @brief Collection of parallel reductions.
+ */
+namespace reduce {
+
+/* Number of terms in each chunk of a reproducible reduction. */
+static const size_t chunk_size = 1024;
+
+/**
+ * sum
+ * @brief Return the sum of the terms func(ix), 0 <= ix < n, of a type with a
+ * zero value T{} and an operator +=.
+ *
+ * If Params::reduce_reproducible is set, the terms are summed in index order
+ * over fixed chunks of chunk_size terms, and the chunk sums are combined in a
+ * fixed pairwise tree. The order of the floating point additions depends on n
+ * alone, and the sum is bitwise identical for any number of threads. Otherwise
+ * each thread sums a contiguous block of terms and the thread sums are added
+ * in thread order, reproducible for the same number of threads only.
+ */
+template<typename T, typename Func>
+T sum(const size_t n, Func func)
+{
+    if (Params::reduce_reproducible) {
+        const size_t n_chunks = (n + chunk_size - 1) / chunk_size;
+        std::vector<T> partial(n_chunks, T{});
+
+        core_pragma_omp(parallel for default(none) \
+            shared(partial, func, n, n_chunks) schedule(static))
+        for (size_t chunk = 0; chunk < n_chunks; ++chunk) {
+            const size_t begin = chunk * chunk_size;
+            const size_t end = std::min(begin + chunk_size, n);
+            T value = T{};
+            for (size_t ix = begin; ix < end; ++ix) {
+                value += func(ix);
+            }
+            partial[chunk] = value;
+        }
+
+        /* Combine the chunk sums in a fixed pairwise tree. */
+        for (size_t stride = 1; stride < n_chunks; stride *= 2) {
+            for (size_t ix = 0; ix + stride < n_chunks; ix += 2 * stride) {
+                partial[ix] += partial[ix + stride];
+            }
+        }
+        return (n_chunks > 0) ? partial[0] : T{};
+    }
+
+    std::vector<T> partial(omp_get_max_threads(), T{});
+    core_pragma_omp(parallel default(none) shared(partial, func, n))
+    {
+        T value = T{};
+        core_pragma_omp(for schedule(static) nowait)
+        for (size_t ix = 0; ix < n; ++ix) {
+            value += func(ix);
+        }
+        partial[omp_get_thread_num()] = value;
+    }
+
+    T result = T{};
+    for (auto &value : partial) {
+        result += value;
+    }
+    return result;
+}
+
+} /* reduce */
+
+#endif /* MD_REDUCE_H_ */
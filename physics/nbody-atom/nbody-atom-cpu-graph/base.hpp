@@ -13,31 +13,7 @@
 #define MD_BASE_H_
 
 #include "atto/opencl/opencl.hpp"
-
-/**
- * @brief Model parameters.
- */
-namespace Params {
-/* Simulation parameters. */
-static const double t_step = 0.005;             /* timestep size */
-static const size_t n_min_steps = 1000;         /* minimization steps */
-static const size_t n_run_steps = 1000;         /* number of run steps */
-static const size_t sample_frequency = 10;      /* sample frequency */
-static const size_t sample_block_size = 10;     /* sampler block size */
-
-/* Engine parameters. */
-static const double density = 0.8;              /* fluid density */
-static const double temperature = 2.0;          /* fluid temperature */
-static const size_t n_atoms = 4096;             /* number of atoms */
-static const size_t n_neighbours = 256;         /* neighbours per atom */
-static const double atom_mass = 1.0;            /* atom mass */
-static const double pair_epsilon = 1.0;         /* energy coefficient */
-static const double pair_sigma = 1.0;           /* sigma coefficient */
-static const double pair_r_cut = 2.0;           /* cutoff radius */
-static const double pair_r_skin = 1.0;          /* skin radius */
-static const double pair_r_hard = 0.01;         /* hard sphere radius */
-static const double thermostat_mass = 10.0;     /* thermostat inertial mass */
-}
+#include "params.hpp"
 
 /**
  * @brief Fluid atoms.
@@ -45,6 +21,8 @@ static const double thermostat_mass = 10.0;     /* thermostat inertial mass */
 struct Atom {
     double mass;                    /* atom mass */
     double rmass;                   /* inverse mass */
+    uint32_t type;                  /* atom type */
+    double charge;                  /* atom charge */
     atto::math::vec3d pos;          /* periodic image in primary cell */
     atto::math::vec3d upos;         /* unfolded position */
     atto::math::vec3d mom;          /* momentum */
@@ -75,14 +53,31 @@ struct Domain {
 };
 
 /**
- * @brief Field represents the Lennard-Jones force field.
+ * @brief FieldPair holds the Lennard-Jones coefficients of an atom type pair.
  */
-struct Field {
+struct FieldPair {
     double epsilon;                 /* LJ pair energy */
     double sigma;                   /* LJ pair size */
     double r_cut;                   /* LJ cutoff radius */
+    double r_cut_sq;                /* LJ cutoff radius squared */
+};
+
+/**
+ * @brief Field represents the Lennard-Jones force field of a fluid mixture.
+ * The coefficients of each type pair (i,j) are stored in a small row-major
+ * table at index k = i*max_types + j, compact enough to stay in L1 cache.
+ * Charged atoms add the real space Ewald sum within the largest cutoff radius.
+ */
+struct Field {
+    static const size_t max_types = Params::max_types;
+    FieldPair pairs[max_types * max_types]; /* type pair coefficients */
+    size_t n_types;                 /* number of atom types */
+    double r_cut;                   /* Largest LJ cutoff radius */
     double r_skin;                  /* Neighbour list skin radius */
     double r_hard;                  /* Hard sphere truncation radius */
+    double r_inner;                 /* RESPA inner shell cutoff radius */
+    double r_heal;                  /* RESPA inner shell healing length */
+    double alpha;                   /* Ewald splitting parameter */
 };
 
 /**
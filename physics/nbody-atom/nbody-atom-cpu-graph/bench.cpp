@@ -0,0 +1,89 @@
+/*
+ * bench.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include <chrono>
+#include <omp.h>
+#include <sys/resource.h>
+#include "atto/opencl/opencl.hpp"
+#include "bench.hpp"
+#include "engine.hpp"
+using namespace atto;
+
+/** ---------------------------------------------------------------------------
+ * perturb
+ * @brief Displace the atom positions from the lattice sites by a deterministic
+ * offset, using the counter based generator with a fixed seed. The
+ * configuration depends on the atom index alone and is identical across
+ * engine variants.
+ */
+static void perturb(std::vector<Atom> &atoms, const double amplitude)
+{
+    for (size_t atom_ix = 0; atom_ix < atoms.size(); ++atom_ix) {
+        math::vec3d offset{
+            generate::uniform(0, 3 * atom_ix + 0) - 0.5,
+            generate::uniform(0, 3 * atom_ix + 1) - 0.5,
+            generate::uniform(0, 3 * atom_ix + 2) - 0.5};
+        atoms[atom_ix].pos  += offset * (2.0 * amplitude);
+        atoms[atom_ix].upos += offset * (2.0 * amplitude);
+    }
+}
+
+/**
+ * bench
+ * @brief Benchmark the engine over the specified number of integration steps.
+ * The record holds the engine variant, number of atoms, number of threads,
+ * number of steps, time per atom per step in nanoseconds, pair interactions
+ * per second and peak resident memory in megabytes.
+ */
+void bench(
+    const std::string &variant,
+    const size_t n_steps,
+    const std::string &filename)
+{
+    /* Setup the engine with a perturbed lattice configuration. */
+    Engine engine;
+    engine.setup();
+    engine.generate();
+    engine.reset(Params::pair_r_hard * Params::pair_sigma);
+    perturb(engine.m_atoms, 0.05 * Params::pair_sigma);
+
+    /* Compute and write the reference forces. */
+    engine.update();
+    size_t n_pairs = engine.compute_forces();
+    {
+        core::FileOut fileout;
+        fileout.open(filename);
+        io::write_forces(engine.m_atoms, fileout);
+        fileout.close();
+    }
+
+    /* Time the integration steps. */
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t step = 0; step < n_steps; ++step) {
+        engine.execute();
+    }
+    auto end = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(end - begin).count();
+
+    /* Peak resident memory, in kilobytes on Linux. */
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    double n_atom_steps = (double) Params::n_atoms * n_steps;
+    std::cout << core::str_format("%s,%lu,%d,%lu,%lf,%lf,%lf\n",
+        variant.c_str(),
+        Params::n_atoms,
+        omp_get_max_threads(),
+        n_steps,
+        1.0e9 * elapsed / n_atom_steps,
+        (double) n_pairs * n_steps / elapsed,
+        (double) usage.ru_maxrss / 1024.0);
+}
@@ -0,0 +1,29 @@
+/*
+ * bench.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef MD_BENCH_H_
+#define MD_BENCH_H_
+
+#include "atto/opencl/opencl.hpp"
+#include "base.hpp"
+
+/**
+ * @brief Benchmark the engine over the specified number of integration steps,
+ * and write a CSV record with the engine throughput to the standard output.
+ * The forces of a reference configuration are written to the specified file
+ * for cross-variant equivalence checks.
+ */
+void bench(
+    const std::string &variant,
+    const size_t n_steps,
+    const std::string &filename);
+
+#endif /* MD_BENCH_H_ */
@@ -0,0 +1,168 @@
+/*
+ * correlator.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include "atto/opencl/opencl.hpp"
+#include "correlator.hpp"
+using namespace atto;
+
+/**
+ * Correlator::setup
+ * @brief Setup the correlator with the number of values per sample.
+ */
+void Correlator::setup(const Mode mode, const size_t n_values)
+{
+    m_mode = mode;
+    m_n_values = n_values;
+    m_n_levels = Params::corr_n_levels;
+    m_n_points = Params::corr_n_points;
+    m_n_average = Params::corr_n_average;
+    core_assert(m_n_points % m_n_average == 0, "invalid correlator parameters");
+    reset();
+}
+
+/**
+ * Correlator::reset
+ * @brief Clear the correlator samples.
+ */
+void Correlator::reset(void)
+{
+    m_shift.assign(m_n_levels * m_n_points * m_n_values, 0.0);
+    m_accum.assign(m_n_levels * m_n_values, 0.0);
+    m_n_accum.assign(m_n_levels, 0);
+    m_insert.assign(m_n_levels, 0);
+    m_n_shift.assign(m_n_levels, 0);
+    m_corr.assign(m_n_levels * m_n_points, 0.0);
+    m_count.assign(m_n_levels * m_n_points, 0);
+}
+
+/**
+ * Correlator::add
+ * @brief Add a sample of n_values values.
+ */
+void Correlator::add(const double *values)
+{
+    add_level(0, values);
+}
+
+/**
+ * Correlator::add_level
+ * @brief Add a sample to the specified level, correlate it with the samples
+ * in the level buffer, and average it into the next level. The lags below
+ * n_points/n_average of a level above 0 are covered by the previous level.
+ */
+void Correlator::add_level(const size_t level, const double *values)
+{
+    /* Insert the sample into the level buffer. */
+    const size_t insert = m_insert[level];
+    double *shift = &m_shift[level * m_n_points * m_n_values];
+    std::copy(values, values + m_n_values, &shift[insert * m_n_values]);
+    m_insert[level] = (insert + 1) % m_n_points;
+    m_n_shift[level] = std::min(m_n_shift[level] + 1, m_n_points);
+
+    /* Correlate the sample with the samples in the level buffer. */
+    const size_t lag_begin = (level == 0) ? 0 : m_n_points / m_n_average;
+    for (size_t lag = lag_begin; lag < m_n_shift[level]; ++lag) {
+        const size_t point = (insert + m_n_points - lag) % m_n_points;
+        const double *old = &shift[point * m_n_values];
+
+        double sum = 0.0;
+        if (m_mode == Product) {
+            for (size_t k = 0; k < m_n_values; ++k) {
+                sum += old[k] * values[k];
+            }
+        } else {
+            for (size_t k = 0; k < m_n_values; ++k) {
+                double d = values[k] - old[k];
+                sum += d * d;
+            }
+        }
+        m_corr[level * m_n_points + lag] += sum;
+        m_count[level * m_n_points + lag]++;
+    }
+
+    /* Average the samples into the next level. */
+    if (level + 1 < m_n_levels) {
+        double *accum = &m_accum[level * m_n_values];
+        for (size_t k = 0; k < m_n_values; ++k) {
+            accum[k] += values[k];
+        }
+
+        if (++m_n_accum[level] == m_n_average) {
+            for (size_t k = 0; k < m_n_values; ++k) {
+                accum[k] /= (double) m_n_average;
+            }
+            add_level(level + 1, accum);
+
+            std::fill(accum, accum + m_n_values, 0.0);
+            m_n_accum[level] = 0;
+        }
+    }
+}
+
+/**
+ * Correlator::result
+ * @brief Return the lags, in units of the sample interval, and the average
+ * correlation at each lag with at least one sample, sorted by lag.
+ */
+void Correlator::result(
+    std::vector<double> &lags,
+    std::vector<double> &corr) const
+{
+    lags.clear();
+    corr.clear();
+
+    double scale = 1.0;
+    for (size_t level = 0; level < m_n_levels; ++level) {
+        const size_t lag_begin = (level == 0) ? 0 : m_n_points / m_n_average;
+        for (size_t lag = lag_begin; lag < m_n_points; ++lag) {
+            const size_t ix = level * m_n_points + lag;
+            if (m_count[ix] > 0) {
+                lags.push_back(lag * scale);
+                corr.push_back(m_corr[ix] / (double) m_count[ix]);
+            }
+        }
+        scale *= (double) m_n_average;
+    }
+}
+
+/**
+ * Correlator::to_string
+ * @brief Serialize the scaled correlation at each lag time, and the running
+ * integral with the trapezoidal rule over the logarithmic lag grid.
+ */
+std::string Correlator::to_string(
+    const double t_sample,
+    const double scale,
+    const double integral_scale) const
+{
+    std::vector<double> lags;
+    std::vector<double> corr;
+    result(lags, corr);
+
+    std::ostringstream ss;
+    double integral = 0.0;
+    for (size_t ix = 0; ix < lags.size(); ++ix) {
+        double time = lags[ix] * t_sample;
+        double value = corr[ix] * scale;
+        if (integral_scale == 0.0) {
+            ss << core::str_format("%lf %lf\n", time, value);
+            continue;
+        }
+
+        if (ix > 0) {
+            double dt = (lags[ix] - lags[ix - 1]) * t_sample;
+            integral += 0.5 * dt * (corr[ix] + corr[ix - 1]) * scale;
+        }
+        ss << core::str_format("%lf %lf %lf\n",
+            time, value, integral * integral_scale);
+    }
+    return ss.str();
+}
@@ -0,0 +1,89 @@
+/*
+ * correlator.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef MD_CORRELATOR_H_
+#define MD_CORRELATOR_H_
+
+#include "atto/opencl/opencl.hpp"
+#include "base.hpp"
+
+/**
+ * Correlator
+ * @brief Multi-tau correlator of a set of values sampled at a fixed interval,
+ * Ramirez et al, J Chem Phys 133, 154103 (2010).
+ *
+ * Level 0 holds the last n_points samples in a circular buffer, and each
+ * sample is correlated with all of them, giving the lags 0..n_points-1.
+ * Every n_average samples of a level are averaged into one sample of the next
+ * level, so level l covers the lags n_average^l times longer. The correlator
+ * uses O(n_values n_levels n_points) memory for lags up to
+ * n_points n_average^(n_levels-1) samples, instead of the whole trajectory.
+ *
+ * The correlation is summed over the values, either as the product
+ * A(t).A(t+tau), e.g. the velocity autocorrelation, or as the square distance
+ * |A(t+tau) - A(t)|^2, e.g. the mean square displacement.
+ */
+struct Correlator {
+    /* Correlation operation. */
+    enum Mode {
+        Product = 0,
+        SquareDistance
+    };
+
+    /* Correlator parameters. */
+    Mode m_mode;                        /* correlation operation */
+    size_t m_n_values;                  /* number of values per sample */
+    size_t m_n_levels;                  /* number of levels */
+    size_t m_n_points;                  /* samples per level */
+    size_t m_n_average;                 /* samples averaged into next level */
+
+    /* Correlator state, indexed by level, point and value. */
+    std::vector<double> m_shift;        /* level sample circular buffers */
+    std::vector<double> m_accum;        /* level averaging accumulators */
+    std::vector<size_t> m_n_accum;      /* samples in each accumulator */
+    std::vector<size_t> m_insert;       /* next slot in each buffer */
+    std::vector<size_t> m_n_shift;      /* samples in each buffer */
+    std::vector<double> m_corr;         /* correlation sums */
+    std::vector<uint64_t> m_count;      /* correlation sample counts */
+
+    /** Setup the correlator with the number of values per sample. */
+    void setup(const Mode mode, const size_t n_values);
+
+    /** Clear the correlator samples. */
+    void reset(void);
+
+    /** Add a sample of n_values values. */
+    void add(const double *values);
+
+    /** Add a sample to the specified level. */
+    void add_level(const size_t level, const double *values);
+
+    /**
+     * Return the lags, in units of the sample interval, and the average
+     * correlation at each lag, sorted by lag.
+     */
+    void result(std::vector<double> &lags, std::vector<double> &corr) const;
+
+    /**
+     * Serialize the scaled correlation at each lag time. If the integral
+     * scale is nonzero, append its scaled running integral over lag time.
+     */
+    std::string to_string(
+        const double t_sample,
+        const double scale,
+        const double integral_scale = 0.0) const;
+
+    /* Constructor/destructor. */
+    Correlator() = default;
+    ~Correlator() = default;
+};
+
+#endif /* MD_CORRELATOR_H_ */
@@ -15,10 +15,15 @@
 #include "atto/opencl/opencl.hpp"
 #include "base.hpp"
 #include "compute.hpp"
+#include "fire.hpp"
 #include "sampler.hpp"
 #include "generate.hpp"
 #include "io.hpp"
+#include "profile.hpp"
+#include "structure.hpp"
+#include "correlator.hpp"
 #include "graph.hpp"
+#include "pme.hpp"
 
 /**
  * Engine
@@ -44,14 +49,46 @@ struct Engine {
     Thermostat m_thermostat;            /* fluid thermostat */
     Thermo m_thermo;                    /* fluid thermodynamic properties */
     Sampler m_sampler;                  /* fluid thermodynamic sampler */
+    Structure m_structure;              /* fluid structure sampler */
+    Correlator m_msd;                   /* mean square displacement */
+    Correlator m_vacf;                  /* velocity autocorrelation */
+    Correlator m_sacf;                  /* shear stress autocorrelation */
+    std::vector<double> m_corr_values;  /* correlator sample buffer */
     Graph m_graph;                      /* graph of atom neighbours */
+    Pme m_pme;                          /* particle mesh Ewald solver */
+    std::vector<atto::math::vec3d> m_force_outer; /* RESPA outer shell forces */
+    bool m_force_reset;                 /* atom forces stale after a reset */
+#ifdef MD_PROFILE
+    Profiler m_profiler;                /* engine hot path profiler */
+#endif
 
     /** Execute one integration step. */
     void execute(void);
 
+    /** Execute one r-RESPA multiple time step integration step. */
+    void execute_respa(void);
+
+    /** Apply pbc and update the neighbour data structures. */
+    void update(void);
+
+    /** Compute the forces of the specified shell on all fluid atoms. */
+    size_t compute_forces(const uint32_t shell = compute::ShellFull);
+
+    /** Accumulate the forces of the specified shell on all fluid atoms. */
+    size_t accumulate_forces(const uint32_t shell, const bool sample_rdf = false);
+
+    /** Compute the outer shell and total forces on all fluid atoms. */
+    void compute_forces_respa(void);
+
+    /** Relax the fluid atom positions towards a local energy minimum. */
+    size_t minimize(const size_t n_steps, const double force_tol);
+
     /** Return serialized fluid thermodynamic properties. */
     std::string sample(void);
 
+    /** Add a sample to the transport property correlators. */
+    void correlate(void);
+
     /** Generate atom positions and momenta. */
     void generate(void);
 
@@ -26,12 +26,17 @@ Graph::Graph()
     m_n_neighbours = Params::n_neighbours;
     m_r_cut = Params::pair_r_cut;
     m_r_skin = Params::pair_r_skin;
+    m_r_inner = 0.0;
+    m_valid = false;
+    m_moved_max = Params::graph_moved_max;
 
     /* Setup all vertices in the adjacency list to empty */
     m_data.resize(m_n_vertices * m_n_neighbours, 0xffffffff);
+    m_n_inner.resize(m_n_vertices, 0);
 
-    /* Setup atom cache positions. */
+    /* Setup atom cache positions and moved flags. */
     m_cache.resize(m_n_vertices, math::vec3d{});
+    m_flag.resize(m_n_vertices, FlagNone);
 }
 
 /** ---------------------------------------------------------------------------
@@ -48,23 +53,23 @@ void Graph::clear(void)
 
 /**
  * Graph::compute
- * @brief Compute the adjacency list of the specified atom in the fluid.
+ * @brief Compute the adjacency list of the specified atom in the fluid from
+ * the cached atom positions.
  */
-void Graph::compute(
-    const uint32_t atom_1,
-    const std::vector<Atom> &atoms,
-    const Domain &domain)
+void Graph::compute(const uint32_t atom_1, const Domain &domain)
 {
     const double radius_sq = (m_r_cut + m_r_skin) * (m_r_cut + m_r_skin);
+    const double inner_sq = (m_r_inner + m_r_skin) * (m_r_inner + m_r_skin);
 
     uint32_t start = atom_1 * m_n_neighbours;
     uint32_t count = 0;
-    for (uint32_t atom_2 = 0; atom_2 < atoms.size(); ++atom_2) {
+    uint32_t n_inner = 0;
+    for (uint32_t atom_2 = 0; atom_2 < m_n_vertices; ++atom_2) {
         if (atom_1 == atom_2) {
             continue;
         }
 
-        math::vec3d r_12 = atoms[atom_1].pos - atoms[atom_2].pos;
+        math::vec3d r_12 = m_cache[atom_1] - m_cache[atom_2];
         r_12 = compute::pbc(r_12, domain);
 
         if (math::dot(r_12, r_12) < radius_sq) {
@@ -72,9 +77,25 @@ void Graph::compute(
                 core_debug("adjacency list overflow");
                 break;
             }
-            m_data[start + count++] = atom_2;
+
+            /* Keep the inner shell edges at the front of the list. */
+            if (math::dot(r_12, r_12) < inner_sq) {
+                m_data[start + count++] = m_data[start + n_inner];
+                m_data[start + n_inner++] = atom_2;
+            } else {
+                m_data[start + count++] = atom_2;
+            }
+        }
+    }
+
+    /* Clear the slots of a previous adjacency list past the end. */
+    for (uint32_t slot = start + count; slot < start + m_n_neighbours; ++slot) {
+        if (m_data[slot] == m_empty) {
+            break;
         }
+        m_data[slot] = m_empty;
     }
+    m_n_inner[atom_1] = n_inner;
 }
 
 /**
@@ -85,6 +106,13 @@ void Graph::compute(
  */
 void Graph::compute(const std::vector<Atom> &atoms, const Domain &domain)
 {
+    /* Cache the atom positions until next update */
+    core_pragma_omp(parallel for default(none) \
+        shared(m_cache, atoms) schedule(dynamic))
+    for (uint32_t atom_ix = 0; atom_ix < atoms.size(); ++atom_ix) {
+        m_cache[atom_ix] = atoms[atom_ix].pos;
+    }
+
     /* Clear the graph before computing the adjacency lists. */
     clear();
 
@@ -92,27 +120,163 @@ void Graph::compute(const std::vector<Atom> &atoms, const Domain &domain)
     core_pragma_omp(parallel for default(none)
         shared(atoms, domain) schedule(dynamic))
     for (uint32_t atom_ix = 0; atom_ix < atoms.size(); ++atom_ix) {
-        compute(atom_ix, atoms, domain);
+        compute(atom_ix, domain);
     }
+    m_valid = true;
+}
 
-    /* Cache the atom positions until next update */
-    core_pragma_omp(parallel for default(none) \
-        shared(m_cache, atoms) schedule(dynamic))
+/**
+ * Graph::patch
+ * @brief Patch the adjacency list of an atom that did not move. Remove the
+ * edges to the moved atoms and add the edges to the moved atoms within the
+ * radius of its cached position, keeping the inner shell edges at the front.
+ */
+void Graph::patch(const uint32_t atom_1, const Domain &domain)
+{
+    const double radius_sq = (m_r_cut + m_r_skin) * (m_r_cut + m_r_skin);
+    const double inner_sq = (m_r_inner + m_r_skin) * (m_r_inner + m_r_skin);
+
+    /* Keep the edges to the atoms that did not move. */
+    uint32_t start = atom_1 * m_n_neighbours;
+    uint32_t count = 0;
+    uint32_t n_inner = 0;
+    uint32_t n_edges = 0;
+    for (; n_edges < m_n_neighbours; ++n_edges) {
+        uint32_t atom_2 = m_data[start + n_edges];
+        if (atom_2 == m_empty) {
+            break;
+        }
+        if (m_flag[atom_2] == FlagMoved) {
+            continue;
+        }
+
+        if (n_edges < m_n_inner[atom_1]) {
+            m_data[start + n_inner++] = atom_2;
+            count++;
+        } else {
+            m_data[start + count++] = atom_2;
+        }
+    }
+
+    /* Add the edges to the moved atoms within the radius. */
+    for (auto &atom_2 : m_moved) {
+        math::vec3d r_12 = m_cache[atom_1] - m_cache[atom_2];
+        r_12 = compute::pbc(r_12, domain);
+
+        if (math::dot(r_12, r_12) < radius_sq) {
+            if (count == m_n_neighbours) {
+                core_debug("adjacency list overflow");
+                break;
+            }
+
+            /* Keep the inner shell edges at the front of the list. */
+            if (math::dot(r_12, r_12) < inner_sq) {
+                m_data[start + count++] = m_data[start + n_inner];
+                m_data[start + n_inner++] = atom_2;
+            } else {
+                m_data[start + count++] = atom_2;
+            }
+        }
+    }
+
+    /* Clear the slots past the end of the patched list. */
+    for (uint32_t slot = count; slot < n_edges; ++slot) {
+        m_data[start + slot] = m_empty;
+    }
+    m_n_inner[atom_1] = n_inner;
+}
+
+/**
+ * Graph::update
+ * @brief Update the adjacency lists of the atoms that moved more than half
+ * the skin radius since their cached positions, and patch the lists of their
+ * neighbours before and after the update. Recompute all adjacency lists if the graph was never
+ * computed or the moved fraction exceeds the maximum, where a full update
+ * is cheaper.
+ */
+void Graph::update(const std::vector<Atom> &atoms, const Domain &domain)
+{
+    const double r_half_sq = 0.25 * m_r_skin * m_r_skin;
+
+    /* Find the moved atoms. */
+    m_moved.clear();
     for (uint32_t atom_ix = 0; atom_ix < atoms.size(); ++atom_ix) {
+        math::vec3d pos = atoms[atom_ix].pos - m_cache[atom_ix];
+        pos = compute::pbc(pos, domain);
+        if (math::dot(pos, pos) > r_half_sq) {
+            m_moved.push_back(atom_ix);
+        }
+    }
+
+    if (!m_valid || m_moved.size() > m_moved_max * m_n_vertices) {
+        compute(atoms, domain);
+        return;
+    }
+
+    /* Flag the moved atoms and cache their positions. */
+    for (auto &atom_ix : m_moved) {
         m_cache[atom_ix] = atoms[atom_ix].pos;
+        m_flag[atom_ix] = FlagMoved;
+    }
+
+    /* Flag the neighbours of the moved atoms before the update. */
+    m_patch.clear();
+    auto flag_neighbours = [&] () {
+        for (auto &atom_1 : m_moved) {
+            uint32_t slot = begin(atom_1);
+            while (slot != end()) {
+                uint32_t atom_2 = get(slot);
+                if (m_flag[atom_2] == FlagNone) {
+                    m_flag[atom_2] = FlagPatch;
+                    m_patch.push_back(atom_2);
+                }
+                slot = next(slot);
+            }
+        }
+    };
+    flag_neighbours();
+
+    /* Recompute the adjacency lists of the moved atoms. */
+    core_pragma_omp(parallel for default(none) \
+        shared(m_moved, domain) schedule(dynamic))
+    for (size_t ix = 0; ix < m_moved.size(); ++ix) {
+        compute(m_moved[ix], domain);
+    }
+
+    /* Flag the neighbours after the update and patch their lists. */
+    flag_neighbours();
+
+    core_pragma_omp(parallel for default(none) \
+        shared(m_patch, domain) schedule(dynamic))
+    for (size_t ix = 0; ix < m_patch.size(); ++ix) {
+        patch(m_patch[ix], domain);
+    }
+
+    /* Clear the atom flags. */
+    for (auto &atom_ix : m_moved) {
+        m_flag[atom_ix] = FlagNone;
+    }
+    for (auto &atom_ix : m_patch) {
+        m_flag[atom_ix] = FlagNone;
     }
 }
 
 /**
  * Graph::is_stale
- * @brief Is the graph adjacency stale since last update?
+ * @brief Is the graph adjacency stale since last update? The displacement
+ * of an atom wrapped across the domain boundary is its periodic image.
  */
-bool Graph::is_stale(std::vector<Atom> &atoms)
+bool Graph::is_stale(const std::vector<Atom> &atoms, const Domain &domain)
 {
     const double r_half_sq = 0.25 * m_r_skin * m_r_skin;
 
+    if (!m_valid) {
+        return true;
+    }
+
     for (uint32_t atom_ix = 0; atom_ix < atoms.size(); ++atom_ix) {
         math::vec3d pos = atoms[atom_ix].pos - m_cache[atom_ix];
+        pos = compute::pbc(pos, domain);
         if (math::dot(pos, pos) > r_half_sq) {
             return true;
         }
@@ -195,3 +359,13 @@ std::vector<uint32_t> Graph::neighbours(const uint32_t atom_ix) const
     }
     return adj;
 }
+
+/**
+ * Graph::neighbours_inner
+ * @brief Return the inner shell adjacency list of the specified atom.
+ */
+std::vector<uint32_t> Graph::neighbours_inner(const uint32_t atom_ix) const
+{
+    auto begin = m_data.begin() + atom_ix * m_n_neighbours;
+    return std::vector<uint32_t>(begin, begin + m_n_inner[atom_ix]);
+}
@@ -24,33 +24,63 @@
  * of contiguous adjacency lists for each atom, each with a specfied number
  * of neighbours. The index k in the array of neighbour j in atom i is given
  * by the linear relation k = i*n_neighs + j, 0 <= i < n_vertices.
+ *
+ * Each adjacency list is partitioned with the edges of the inner shell,
+ * those shorter than the inner cutoff radius, at the front of the list.
+ *
+ * The edges are computed from the cached atom positions, and the graph is
+ * valid while every atom is within half the skin radius of its cached
+ * position. When only a few atoms moved past it, the graph is updated
+ * incrementally - the adjacency lists of the moved atoms are recomputed
+ * from their new positions, and the lists of their old and new neighbours
+ * are patched, removing the edges to the moved atoms and adding those within
+ * the radius.
+ * Every edge is computed from the cached positions of its two vertices, so
+ * the adjacency lists remain symmetric.
  */
 struct Graph {
     /* State flag indicating an empty slot. */
     static const uint32_t m_empty = 0xffffffff;
 
+    /* Atom flags of an incremental update. */
+    enum : uint8_t {
+        FlagNone = 0,                   /* unchanged adjacency list */
+        FlagMoved,                      /* recomputed adjacency list */
+        FlagPatch                       /* patched adjacency list */
+    };
+
     /* Graph member variables. */
     uint32_t m_n_vertices;              /* number of vertices in the graph */
     uint32_t m_n_neighbours;            /* neighbour edges per vertex */
     double m_r_cut;                     /* edge cutoff radius */
     double m_r_skin;                    /* edge skin radius */
+    double m_r_inner;                   /* inner shell edge cutoff radius */
     std::vector<uint32_t> m_data;       /* adjacency lists of each vertex */
+    std::vector<uint32_t> m_n_inner;    /* inner shell edges of each vertex */
     std::vector<atto::math::vec3d> m_cache; /* atom cache positions */
+    bool m_valid;                       /* adjacency lists are computed */
+    double m_moved_max;                 /* max moved fraction of an update */
+    std::vector<uint32_t> m_moved;      /* atoms moved since the update */
+    std::vector<uint32_t> m_patch;      /* neighbours of the moved atoms */
+    std::vector<uint8_t> m_flag;        /* update flag of each atom */
 
     /** Clear the graph adjaceny lists. */
     void clear(void);
 
     /** Compute the adjacency list of the specified atom in the fluid. */
-    void compute(
-        const uint32_t atom_1,
-        const std::vector<Atom> &atoms,
-        const Domain &domain);
+    void compute(const uint32_t atom_1, const Domain &domain);
 
     /** Compute the adjacency list of all the atoms in the fluid. */
     void compute(const std::vector<Atom> &atoms, const Domain &domain);
 
+    /** Patch the adjacency list of the specified atom with the moved atoms. */
+    void patch(const uint32_t atom_1, const Domain &domain);
+
+    /** Update the adjacency lists of the atoms that moved, or all of them. */
+    void update(const std::vector<Atom> &atoms, const Domain &domain);
+
     /** Is the graph adjacency stale since last update? */
-    bool is_stale(std::vector<Atom> &atoms);
+    bool is_stale(const std::vector<Atom> &atoms, const Domain &domain);
 
     /** Return the first slot in the adjacency list of the specified atom. */
     uint32_t begin(const uint32_t atom_ix) const;
@@ -67,6 +97,9 @@ struct Graph {
     /** Return neighbour adjacency list of the specified atom. */
     std::vector<uint32_t> neighbours(const uint32_t atom_ix) const;
 
+    /** Return the inner shell adjacency list of the specified atom. */
+    std::vector<uint32_t> neighbours_inner(const uint32_t atom_ix) const;
+
     /* Constructor/destructor. */
     Graph();
     ~Graph() = default;
@@ -29,6 +29,11 @@ void write_xyz(
     const std::string &comment,
     atto::core::FileOut &file);
 
+/** Write fluid atom forces into text file. */
+void write_forces(
+    const std::vector<Atom> &atoms,
+    atto::core::FileOut &file);
+
 } /* io */
 
 #endif /* MD_IO_H_ */
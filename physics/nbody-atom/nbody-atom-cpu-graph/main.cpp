@@ -11,6 +11,7 @@
 
 #include "atto/opencl/opencl.hpp"
 #include "model.hpp"
+#include "bench.hpp"
 using namespace atto;
 
 /**
@@ -18,9 +19,27 @@ using namespace atto;
  */
 int main(int argc, char const *argv[])
 {
+    /*
+     * Load the model parameters from a configuration file and the parameter
+     * overrides of the command line:
+     *  md.out [mode] [--config filename] [name=value...]
+     */
+    std::vector<std::string> args = Params::parse(argc, argv);
+
+    /*
+     * Run the headless benchmark if requested:
+     *  md.out bench [n_steps] [forces filename]
+     */
+    if (args.size() > 1 && args[1] == "bench") {
+        size_t n_steps = args.size() > 2 ? core::str_cast<size_t>(args[2]) : 10;
+        std::string filename = args.size() > 3 ? args[3] : "/tmp/out.bench.forces";
+        bench("cpu-graph", n_steps, filename);
+        return EXIT_SUCCESS;
+    }
+
     /* Execute the model */
     Model model;
     while (model.execute());
 
-    exit(EXIT_SUCCESS);
+    return EXIT_SUCCESS;
 }
@@ -0,0 +1,86 @@
+/*
+ * pme.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef MD_PME_H_
+#define MD_PME_H_
+
+#include <complex>
+#include "atto/opencl/opencl.hpp"
+#include "base.hpp"
+
+/**
+ * Pme
+ * @brief Smooth particle mesh Ewald solver of the reciprocal space part of
+ * the Coulomb interaction, Essmann et al, J. Chem. Phys. 103, 8577 (1995).
+ *
+ * The Coulomb energy is split by the Ewald parameter alpha into a short range
+ * real space sum of q_i q_j erfc(alpha r)/r, computed by the pair force kernel
+ * over the neighbour data structure, and a smooth long range part computed on
+ * a periodic mesh:
+ *  - the atom charges are spread onto the mesh with cardinal B-splines of the
+ *    specified order,
+ *  - the mesh is transformed with a 3d FFT and multiplied by the influence
+ *    function exp(-pi^2 m^2/alpha^2) / (pi V m^2 |b(m)|^2),
+ *  - the inverse transform is the mesh potential, interpolated back onto the
+ *    atoms with the same B-splines and their derivatives.
+ *
+ * The solver adds the reciprocal and self energies, forces and virials onto
+ * the atoms. The mesh size must be a power of two.
+ */
+struct Pme {
+    /* Pme member variables. */
+    size_t m_n_mesh;                    /* mesh points in each direction */
+    size_t m_order;                     /* B-spline interpolation order */
+    double m_alpha;                     /* Ewald splitting parameter */
+    atto::math::vec3d m_length;         /* domain period length */
+    std::vector<std::complex<double>> m_mesh;    /* charge mesh */
+    std::vector<std::complex<double>> m_twiddle; /* FFT twiddle factors */
+    std::vector<size_t> m_reverse;      /* FFT bit reversal permutation */
+    std::vector<double> m_modulus;      /* B-spline moduli |b(m)|^2 */
+    std::vector<double> m_influence;    /* influence function */
+    std::vector<size_t> m_base;         /* atom first mesh point */
+    std::vector<double> m_spline;       /* atom B-spline weights */
+    std::vector<double> m_dspline;      /* atom B-spline derivatives */
+
+    /** Return true if the solver is enabled. */
+    bool enabled(void) const { return !m_mesh.empty(); }
+
+    /** Fill the B-spline weights and derivatives at a fractional offset. */
+    void bspline(const double w, double *spline, double *dspline) const;
+
+    /** In-place FFT of the mesh lines along the specified dimension. */
+    void transform(const size_t dim, const bool inverse);
+
+    /** Spread the atom charges onto the mesh. */
+    void spread(const std::vector<Atom> &atoms);
+
+    /** Multiply the transformed mesh by the influence function. */
+    double convolve(atto::math::mat3d &virial);
+
+    /** Interpolate the mesh potential forces onto the atoms. */
+    void interpolate(std::vector<Atom> &atoms);
+
+    /** Add the reciprocal space energies, forces and virials to the atoms. */
+    double compute(std::vector<Atom> &atoms);
+
+    /** Setup the solver over the specified domain. */
+    void setup(
+        const Domain &domain,
+        const double alpha,
+        const size_t n_mesh,
+        const size_t order);
+
+    /* Constructor/destructor. */
+    Pme() = default;
+    ~Pme() = default;
+};
+
+#endif /* MD_PME_H_ */
@@ -0,0 +1,144 @@
+/*
+ * profile.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include "atto/opencl/opencl.hpp"
+#include "profile.hpp"
+#include <chrono>
+using namespace atto;
+
+#ifdef MD_PROFILE
+
+/** Phase names. */
+static const char *kPhaseName[Profiler::NumPhases] = {
+    "update",
+    "neighbours",
+    "integrate",
+    "thermostat",
+    "force",
+    "sample",
+    "io"
+};
+
+/** ---------------------------------------------------------------------------
+ * Profiler::Profiler
+ * @brief Create a profiler with an empty window and trace.
+ */
+Profiler::Profiler()
+{
+    m_trace.reserve(Params::profile_trace_events);
+    m_origin = now();
+    reset();
+}
+
+/**
+ * Profiler::now
+ * @brief Return the current time in ns.
+ */
+int64_t Profiler::now(void)
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(
+        steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Profiler::record
+ * @brief Record the time interval of the specified phase in the window
+ * and in the trace, up to the trace capacity.
+ */
+void Profiler::record(
+    const uint32_t phase,
+    const int64_t begin,
+    const int64_t end)
+{
+    m_time[phase] += end - begin;
+    m_calls[phase]++;
+    if (m_trace.size() < Params::profile_trace_events) {
+        m_trace.push_back(Event{phase, begin - m_origin, end - begin});
+    }
+}
+
+/**
+ * Profiler::reset
+ * @brief Reset the window timers and counters.
+ */
+void Profiler::reset(void)
+{
+    m_time.fill(0);
+    m_calls.fill(0);
+    m_count.fill(0);
+}
+
+/**
+ * Profiler::to_string
+ * @brief Serialize the window timers and counters. Phase times are given
+ * in ms per step and as a fraction of the total time in the window.
+ */
+std::string Profiler::to_string(void) const
+{
+    double n_steps = std::max(m_count[CounterSteps], (uint64_t) 1);
+    double n_atoms = std::max(m_count[CounterAtoms], (uint64_t) 1);
+
+    int64_t total = 0;
+    for (auto &time : m_time) {
+        total += time;
+    }
+    total = std::max(total, (int64_t) 1);
+
+    std::ostringstream ss;
+    for (size_t phase = 0; phase < NumPhases; ++phase) {
+        std::string name("time_");
+        name.append(kPhaseName[phase]);
+        ss << core::str_format(
+            "%20s %lf %lf\n",
+            name.c_str(),
+            1.0e-6 * m_time[phase] / n_steps,
+            (double) m_time[phase] / total);
+    }
+
+    ss << core::str_format("%20s %lf\n",
+        "steps", (double) m_count[CounterSteps]);
+    ss << core::str_format("%20s %lf\n",
+        "pairs_per_step", m_count[CounterPairs] / n_steps);
+    ss << core::str_format("%20s %lf\n",
+        "neighbours", m_count[CounterPairs] / n_atoms);
+    ss << core::str_format("%20s %lf\n",
+        "rebuilds", (double) m_count[CounterRebuilds]);
+    ss << core::str_format("%20s %lf\n",
+        "overflows", (double) m_count[CounterOverflows]);
+    return ss.str();
+}
+
+/**
+ * Profiler::write_trace
+ * @brief Write the trace events in Chrome trace JSON format, with times
+ * in microseconds.
+ */
+void Profiler::write_trace(core::FileOut &fileout) const
+{
+    core_assert(fileout.writeline("{\"traceEvents\":[\n"),
+        "failed to write trace header");
+    for (size_t ix = 0; ix < m_trace.size(); ++ix) {
+        const Event &event = m_trace[ix];
+        std::string buffer = core::str_format(
+            "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3lf,\"dur\":%.3lf,"
+            "\"pid\":0,\"tid\":0}%s\n",
+            kPhaseName[event.phase],
+            1.0e-3 * event.begin,
+            1.0e-3 * event.duration,
+            (ix + 1 < m_trace.size()) ? "," : "");
+        core_assert(fileout.writeline(buffer), "failed to write trace event");
+    }
+    core_assert(fileout.writeline("],\"displayTimeUnit\":\"ms\"}\n"),
+        "failed to write trace footer");
+}
+
+#endif /* MD_PROFILE */
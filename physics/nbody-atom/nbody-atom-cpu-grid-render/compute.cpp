@@ -261,23 +261,52 @@ math::vec3d pbc(const math::vec3d &r, const Domain &domain)
 }
 
 /** ---------------------------------------------------------------------------
+ * force_shell
+ * @brief Return the weight of a pair interaction in the specified force shell.
+ * The r-RESPA split uses a switching function S(r) that is 1 for pairs closer
+ * than r_inner - r_heal, 0 beyond r_inner, and a smooth cubic in between.
+ * The inner shell force is S(r)*F(r) and the outer shell is (1 - S(r))*F(r).
+ */
+double force_shell(
+    const double r_12_sq,
+    const Field &field,
+    const uint32_t shell)
+{
+    if (shell == ShellFull) {
+        return 1.0;
+    }
+
+    /* Compute the switching function of the inner shell. */
+    const double r_begin = field.r_inner - field.r_heal;
+    double weight = 1.0;
+    if (r_12_sq > field.r_inner * field.r_inner) {
+        weight = 0.0;
+    } else if (r_12_sq > r_begin * r_begin) {
+        double x = (std::sqrt(r_12_sq) - r_begin) / field.r_heal;
+        weight = 1.0 + x * x * (2.0 * x - 3.0);
+    }
+
+    return (shell == ShellInner) ? weight : 1.0 - weight;
+}
+
+/**
  * force_atom
- * @brief Compute the force on the atom with the specified index.
+ * @brief Accumulate the force on the atom with the specified index, weighted
+ * by the pair interaction weights of the specified force shell. Return the
+ * number of pair interactions within the cutoff radius.
  */
-void force_atom(
+size_t force_atom(
     const size_t atom_1,
     const size_t n_atoms,
     const size_t n_neighbours,
     std::vector<Atom> &atoms,
     const Domain &domain,
     const Field &field,
-    const Grid &grid)
+    const Grid &grid,
+    const uint32_t shell)
 {
-    const double r_cut_sq = field.r_cut * field.r_cut;
-
-    atoms[atom_1].force = math::vec3d{};
-    atoms[atom_1].energy = 0.0;
-    atoms[atom_1].virial = math::mat3d{};
+    /* Type pair coefficients of the atom. */
+    const FieldPair *coeff = &field.pairs[atoms[atom_1].type * Field::max_types];
 
     const size_t begin = atom_1 * n_neighbours;
     const size_t end = begin + n_neighbours;
@@ -291,25 +320,34 @@ void force_atom(
         math::vec3d r_12 = atoms[atom_1].pos - atoms[atom_2].pos;
         r_12 = compute::pbc(r_12, domain);
 
-        if (pair_ix < end && dot(r_12, r_12) < r_cut_sq) {
-            Pair pair = force_pair(atom_1, atom_2, r_12, field);
-            atoms[atom_1].force  -= pair.gradient;
-            atoms[atom_1].energy += pair.energy * 0.5;
-            atoms[atom_1].virial += pair.virial * 0.5;
+        const FieldPair &coeff_12 = coeff[atoms[atom_2].type];
+        const double r_12_sq = dot(r_12, r_12);
+        if (pair_ix < end && r_12_sq < coeff_12.r_cut_sq) {
+            double weight = force_shell(r_12_sq, field, shell);
+            if (weight > 0.0) {
+                Pair pair = force_pair(atom_1, atom_2, r_12, coeff_12, field.r_hard);
+                atoms[atom_1].force  -= pair.gradient * weight;
+                atoms[atom_1].energy += pair.energy * (0.5 * weight);
+                atoms[atom_1].virial += pair.virial * (0.5 * weight);
+            }
             pair_ix++;
         }
     }
+
+    return (pair_ix - begin);
 }
 
 /**
  * force_pair
- * @brief Compute pair interaction force.
+ * @brief Compute pair interaction force using the coefficients of the atom
+ * type pair.
  */
 Pair force_pair(
     const size_t atom_1,
     const size_t atom_2,
     const math::vec3d &r_12,
-    const Field &field)
+    const FieldPair &coeff,
+    const double r_hard)
 {
     /* Compute pair attributes - energy, gradient, laplacian and virial. */
     Pair pair;
@@ -324,16 +362,15 @@ Pair force_pair(
     pair.virial = math::mat3d{};
 
     /* Interaction coefficients. */
-    const double epsilon = field.epsilon;
-    const double sigma = field.sigma;
-    const double r_hard = field.r_hard;
+    const double epsilon = coeff.epsilon;
+    const double sigma = coeff.sigma;
 
     const double sigma_sq = sigma * sigma;
     const double r_hard_sq = r_hard * r_hard;
 
     /* Define pair energy and force coefficients */
-    double energy_coeff = 4.0 * field.epsilon;
-    double force_coeff = 24.0 * field.epsilon / sigma_sq;
+    double energy_coeff = 4.0 * epsilon;
+    double force_coeff = 24.0 * epsilon / sigma_sq;
 
     /* Ensure pair distance is larger than the hard sphere radius. */
     double energy_hard_sphere = 0.0;
@@ -63,22 +63,37 @@ atto::math::mat3d pressure_vir(std::vector<Atom> &atoms, const Domain &domain);
 /** Return the periodic image in primary cell of the fluid domain. */
 atto::math::vec3d pbc(const atto::math::vec3d &r, const Domain &domain);
 
-/** Compute the force on the atom with the specified index. */
-void force_atom(
+/** Force shells of the r-RESPA multiple time step pair force split. */
+enum : uint32_t {
+    ShellFull = 0,                  /* all pair interactions */
+    ShellInner,                     /* short range interactions */
+    ShellOuter                      /* long range interactions */
+};
+
+/** Return the weight of a pair interaction in the specified force shell. */
+double force_shell(
+    const double r_12_sq,
+    const Field &field,
+    const uint32_t shell);
+
+/** Accumulate the force on the atom with the specified index. */
+size_t force_atom(
     const size_t atom_1,
     const size_t n_atoms,
     const size_t n_neighbours,
     std::vector<Atom> &atoms,
     const Domain &domain,
     const Field &field,
-    const Grid &grid);
+    const Grid &grid,
+    const uint32_t shell);
 
 /** Compute pair interaction force. */
 Pair force_pair(
     const size_t atom_1,
     const size_t atom_2,
     const atto::math::vec3d &r_12,
-    const Field &field);
+    const FieldPair &coeff,
+    const double r_hard);
 
 } /* compute */
 
@@ -15,9 +15,11 @@
 #include "atto/opencl/opencl.hpp"
 #include "base.hpp"
 #include "compute.hpp"
+#include "fire.hpp"
 #include "sampler.hpp"
 #include "generate.hpp"
 #include "io.hpp"
+#include "profile.hpp"
 
 /**
  * Engine
@@ -44,10 +46,33 @@ struct Engine {
     Thermo m_thermo;                    /* fluid thermodynamic properties */
     Sampler m_sampler;                  /* fluid thermodynamic sampler */
     Grid m_grid;                        /* grid spatial data structure */
+    std::vector<atto::math::vec3d> m_force_outer; /* RESPA outer shell forces */
+    bool m_force_reset;                 /* atom forces stale after a reset */
+#ifdef MD_PROFILE
+    Profiler m_profiler;                /* engine hot path profiler */
+#endif
 
     /** Execute one integration step. */
     void execute(void);
 
+    /** Execute one r-RESPA multiple time step integration step. */
+    void execute_respa(void);
+
+    /** Apply pbc and update the neighbour data structures. */
+    void update(void);
+
+    /** Compute the forces of the specified shell on all fluid atoms. */
+    void compute_forces(const uint32_t shell = compute::ShellFull);
+
+    /** Accumulate the forces of the specified shell on all fluid atoms. */
+    void accumulate_forces(const uint32_t shell);
+
+    /** Compute the outer shell and total forces on all fluid atoms. */
+    void compute_forces_respa(void);
+
+    /** Relax the fluid atom positions towards a local energy minimum. */
+    size_t minimize(const size_t n_steps, const double force_tol);
+
     /** Return serialized fluid thermodynamic properties. */
     std::string sample(void);
 
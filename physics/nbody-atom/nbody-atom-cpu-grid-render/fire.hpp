@@ -0,0 +1,132 @@
+/*
+ * fire.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef MD_FIRE_H_
+#define MD_FIRE_H_
+
+#include "atto/opencl/opencl.hpp"
+#include "base.hpp"
+
+/**
+ * @brief Fast inertial relaxation engine (FIRE) energy minimizer of Bitzek
+ * et al, PRL 97, 170201 (2006).
+ */
+namespace fire {
+
+/**
+ * minimize
+ * @brief Relax the atom positions towards a local energy minimum. Return the
+ * number of steps taken to reduce the largest atom force below the specified
+ * tolerance, and report the largest force if the tolerance is not reached
+ * within the specified number of steps. The function compute_forces() applies
+ * pbc to the atom positions, updates the engine neighbour data structures and
+ * computes the atom forces.
+ *
+ * FIRE integrates a fictitious dynamics where the velocity is continuously
+ * rotated towards the force direction and the timestep adapts to the power
+ * P = F.v. The velocities start at rest, where P = 0, and the first step is
+ * taken as a downhill step. The minimizer uses its own velocities and leaves
+ * the atom momenta untouched.
+ */
+template<typename Func>
+size_t minimize(
+    std::vector<Atom> &atoms,
+    const size_t n_steps,
+    const double force_tol,
+    Func compute_forces)
+{
+    /* FIRE parameters. */
+    const size_t n_delay = 5;           /* steps before timestep increase */
+    const double t_step_inc = 1.1;      /* timestep increase factor */
+    const double t_step_dec = 0.5;      /* timestep decrease factor */
+    const double alpha_start = 0.1;     /* initial velocity mixing */
+    const double alpha_dec = 0.99;      /* velocity mixing decrease factor */
+
+    const double force_tol_sq = force_tol * force_tol;
+    const double r_max_sq = Params::min_r_max * Params::min_r_max;
+
+    double t_step = Params::t_step;
+    double alpha = alpha_start;
+    size_t n_positive = 0;
+    std::vector<atto::math::vec3d> vel(atoms.size(), atto::math::vec3d{});
+
+    size_t step = 0;
+    double force_max_sq = 0.0;
+    while (true) {
+        compute_forces();
+
+        /* Converged if the largest atom force is within tolerance. */
+        double power = 0.0;
+        double vel_sq = 0.0;
+        double force_sq = 0.0;
+        force_max_sq = 0.0;
+        for (size_t ix = 0; ix < atoms.size(); ++ix) {
+            double f_sq = atto::math::dot(atoms[ix].force, atoms[ix].force);
+            force_max_sq = std::max(force_max_sq, f_sq);
+            force_sq += f_sq;
+            vel_sq += atto::math::dot(vel[ix], vel[ix]);
+            power += atto::math::dot(atoms[ix].force, vel[ix]);
+        }
+        if (force_max_sq < force_tol_sq || step == n_steps) {
+            break;
+        }
+        step++;
+
+        /*
+         * Mix the velocities towards the force direction and increase the
+         * timestep while not moving uphill. Otherwise, stop and restart.
+         */
+        if (power >= 0.0) {
+            double scale = alpha * std::sqrt(vel_sq / force_sq);
+            for (size_t ix = 0; ix < atoms.size(); ++ix) {
+                vel[ix] *= (1.0 - alpha);
+                vel[ix] += atoms[ix].force * scale;
+            }
+            if (++n_positive > n_delay) {
+                t_step = std::min(t_step * t_step_inc, Params::min_t_step_max);
+                alpha *= alpha_dec;
+            }
+        } else {
+            n_positive = 0;
+            t_step *= t_step_dec;
+            alpha = alpha_start;
+            for (auto &v : vel) {
+                v = atto::math::vec3d{};
+            }
+        }
+
+        /* Semi-implicit Euler step with a bounded atom displacement. */
+        for (size_t ix = 0; ix < atoms.size(); ++ix) {
+            vel[ix] += atoms[ix].force * atoms[ix].rmass * t_step;
+
+            atto::math::vec3d dr = vel[ix] * t_step;
+            double dr_sq = atto::math::dot(dr, dr);
+            if (dr_sq > r_max_sq) {
+                dr *= std::sqrt(r_max_sq / dr_sq);
+            }
+            atoms[ix].pos += dr;
+            atoms[ix].upos += dr;
+        }
+    }
+
+    /* Report a minimization stopped before reaching the force tolerance. */
+    if (force_max_sq >= force_tol_sq) {
+        std::cout << atto::core::str_format(
+            "minimize not converged after %lu steps, max force %lf > %lf\n",
+            step, std::sqrt(force_max_sq), force_tol);
+    }
+
+    return step;
+}
+
+} /* fire */
+
+#endif /* MD_FIRE_H_ */
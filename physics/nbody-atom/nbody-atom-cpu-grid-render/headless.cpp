@@ -0,0 +1,75 @@
+/*
+ * headless.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include "atto/opencl/opencl.hpp"
+#include "headless.hpp"
+using namespace atto;
+
+/** ---------------------------------------------------------------------------
+ * @brief Setup the engine and start the offline raster.
+ */
+Headless::Headless()
+{
+    /*
+     * Setup Headless data.
+     */
+    {
+        /* Initialize time step. */
+        m_step = 0;
+
+        /* Setup engine object. */
+        m_engine.setup();
+        m_engine.generate();
+
+        /* Relax the initial overlaps with a soft core and reset the engine. */
+        m_engine.reset(0.5 * Params::pair_sigma);
+        size_t n_steps = m_engine.minimize(
+            Params::n_min_steps, Params::min_force_tol);
+        std::cout << "minimize " << n_steps << " steps\n";
+        m_engine.reset(Params::pair_r_hard * Params::pair_sigma);
+    }
+
+    /*
+     * Setup the offline raster.
+     */
+    {
+        m_raster.setup(m_engine.m_domain);
+    }
+}
+
+/**
+ * @brief Write the pending frames and teardown the engine.
+ */
+Headless::~Headless()
+{
+    m_raster.teardown();
+    m_engine.teardown();
+}
+
+/** ---------------------------------------------------------------------------
+ * @brief Execute the model.
+ */
+bool Headless::execute(void)
+{
+    /* Execute an engine step. */
+    m_engine.execute();
+
+    /* Model post-execution. */
+    if (++m_step%Params::sample_frequency == 0) {
+        std::cout << "step " << m_step << "\n" << m_engine.sample() << "\n";
+    }
+
+    if (m_step%Params::render_frequency == 0) {
+        m_raster.submit(m_engine.m_atoms, m_step);
+    }
+
+    return (m_step < Params::n_run_steps);
+}
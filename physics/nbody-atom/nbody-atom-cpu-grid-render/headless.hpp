@@ -0,0 +1,40 @@
+/*
+ * headless.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef MD_HEADLESS_H_
+#define MD_HEADLESS_H_
+
+#include "atto/opencl/opencl.hpp"
+#include "engine.hpp"
+#include "raster.hpp"
+
+/**
+ * Headless
+ * @brief Headless model executing the engine without an OpenGL context, and
+ * rendering the atoms into image files with the offline raster every
+ * Params::render_frequency steps.
+ */
+struct Headless {
+    /* ---- Headless data -------------------------------------------------- */
+    size_t m_step;
+    Engine m_engine;
+    Raster m_raster;
+
+    /* ---- Headless member functions -------------------------------------- */
+    bool execute(void);
+
+    Headless();
+    ~Headless();
+    Headless(const Headless &) = delete;
+    Headless &operator=(const Headless &) = delete;
+};
+
+#endif /* MD_HEADLESS_H_ */
@@ -11,6 +11,7 @@
 
 #include "atto/opencl/opencl.hpp"
 #include "model.hpp"
+#include "headless.hpp"
 using namespace atto;
 
 /**
@@ -18,10 +19,28 @@ using namespace atto;
  */
 int main(int argc, char const *argv[])
 {
+    /*
+     * Load the model parameters from a configuration file and the parameter
+     * overrides of the command line:
+     *  md.out [mode] [--config filename] [name=value...]
+     */
+    std::vector<std::string> args = Params::parse(argc, argv);
+
+    /*
+     * Run the engine headless if requested, without an OpenGL context,
+     * rendering the atoms into image files with the offline raster:
+     *  md.out headless
+     */
+    if (args.size() > 1 && args[1] == "headless") {
+        Headless headless;
+        while (headless.execute());
+        return EXIT_SUCCESS;
+    }
+
     /* Setup renderer OpenGL context and initialize the GLFW library. */
     gl::Renderer::init(
-        Params::window_width,
-        Params::window_height,
+        (int) Params::window_width,
+        (int) Params::window_height,
         Params::window_title);
     gl::Renderer::enable_event(
         gl::Event::FramebufferSize |
@@ -74,5 +93,5 @@ int main(int argc, char const *argv[])
         }
     }
 
-    exit(EXIT_SUCCESS);
+    return EXIT_SUCCESS;
 }
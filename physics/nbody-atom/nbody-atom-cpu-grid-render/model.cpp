@@ -29,7 +29,13 @@ Model::Model(void)
         /* Setup engine object. */
         m_engine.setup();
         m_engine.generate();
+
+        /* Relax the initial overlaps with a soft core and reset the engine. */
         m_engine.reset(0.5 * Params::pair_sigma);
+        size_t n_steps = m_engine.minimize(
+            Params::n_min_steps, Params::min_force_tol);
+        std::cout << "minimize " << n_steps << " steps\n";
+        m_engine.reset(Params::pair_r_hard * Params::pair_sigma);
     }
 
     /*
@@ -298,11 +304,6 @@ void Model::draw(void *data)
  */
 bool Model::execute(void)
 {
-    /* Model pre-execution. */
-    if (m_step == Params::n_min_steps) {
-        m_engine.reset(Params::pair_r_hard * Params::pair_sigma);
-    }
-
     /* Execute an engine step. */
     m_engine.execute();
 
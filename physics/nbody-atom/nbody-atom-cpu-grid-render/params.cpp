@@ -0,0 +1,293 @@
+/*
+ * params.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include <cerrno>
+#include <cctype>
+#include <cstdlib>
+#include <limits>
+#include <sstream>
+#include "atto/opencl/opencl.hpp"
+#include "params.hpp"
+using namespace atto;
+
+/** ---------------------------------------------------------------------------
+ * @brief Model parameters default values.
+ */
+namespace Params {
+/* Simulation parameters. */
+double t_step = 0.005;
+size_t n_min_steps = 1000;
+double min_force_tol = 1.0;
+double min_t_step_max = 0.05;
+double min_r_max = 0.1;
+size_t n_run_steps = 1000;
+size_t sample_frequency = 10;
+size_t sample_block_size = 10;
+
+/* Engine parameters. */
+double density = 0.8;
+double temperature = 2.0;
+size_t n_atoms = 4096;
+size_t n_neighbours = 256;
+double atom_mass = 1.0;
+double pair_epsilon = 1.0;
+double pair_sigma = 1.0;
+double pair_r_cut = 2.0;
+double pair_r_skin = 1.0;
+double pair_r_hard = 0.01;
+double thermostat_mass = 10.0;
+
+/* Multiple time step parameters, radii in units of pair_sigma. */
+size_t respa_n_inner = 1;
+double respa_r_inner = 1.5;
+double respa_r_heal = 0.3;
+
+/* Profiler parameters, used if compiled with MD_PROFILE. */
+size_t profile_trace_events = 1 << 20;
+
+/* Species parameters, in units of atom_mass, pair_epsilon and pair_sigma. */
+size_t n_types = 1;
+double type_fraction[max_types] = {1.0, 0.0, 0.0, 0.0};
+double type_mass[max_types] = {1.0, 1.0, 1.0, 1.0};
+double type_epsilon[max_types] = {1.0, 1.0, 1.0, 1.0};
+double type_sigma[max_types] = {1.0, 1.0, 1.0, 1.0};
+
+/* Offline renderer parameters, used by the headless model. */
+size_t render_frequency = 10;
+size_t render_width = 1024;
+size_t render_height = 1024;
+size_t render_tile_size = 32;
+size_t render_n_threads = 2;
+size_t render_queue_size = 4;
+double render_radius = 0.5;
+double render_fovy = 0.25 * M_PI;
+
+/* OpenGL parameters */
+size_t window_width = 1024;
+size_t window_height = 1024;
+double poll_timeout = 0.01;
+} /* Params */
+
+/** ---------------------------------------------------------------------------
+ * Entry
+ * @brief Parameter table entry, pointing to the values of a real or an
+ * integer parameter.
+ */
+struct Entry {
+    const char *name;               /* parameter name */
+    double *real;                   /* real values, or nullptr */
+    size_t *integer;                /* integer values, or nullptr */
+    size_t n_values;                /* number of values */
+};
+
+static const Entry entries[] = {
+    {"t_step", &Params::t_step, nullptr, 1},
+    {"n_min_steps", nullptr, &Params::n_min_steps, 1},
+    {"min_force_tol", &Params::min_force_tol, nullptr, 1},
+    {"min_t_step_max", &Params::min_t_step_max, nullptr, 1},
+    {"min_r_max", &Params::min_r_max, nullptr, 1},
+    {"n_run_steps", nullptr, &Params::n_run_steps, 1},
+    {"sample_frequency", nullptr, &Params::sample_frequency, 1},
+    {"sample_block_size", nullptr, &Params::sample_block_size, 1},
+    {"density", &Params::density, nullptr, 1},
+    {"temperature", &Params::temperature, nullptr, 1},
+    {"n_atoms", nullptr, &Params::n_atoms, 1},
+    {"n_neighbours", nullptr, &Params::n_neighbours, 1},
+    {"atom_mass", &Params::atom_mass, nullptr, 1},
+    {"pair_epsilon", &Params::pair_epsilon, nullptr, 1},
+    {"pair_sigma", &Params::pair_sigma, nullptr, 1},
+    {"pair_r_cut", &Params::pair_r_cut, nullptr, 1},
+    {"pair_r_skin", &Params::pair_r_skin, nullptr, 1},
+    {"pair_r_hard", &Params::pair_r_hard, nullptr, 1},
+    {"thermostat_mass", &Params::thermostat_mass, nullptr, 1},
+    {"respa_n_inner", nullptr, &Params::respa_n_inner, 1},
+    {"respa_r_inner", &Params::respa_r_inner, nullptr, 1},
+    {"respa_r_heal", &Params::respa_r_heal, nullptr, 1},
+    {"profile_trace_events", nullptr, &Params::profile_trace_events, 1},
+    {"n_types", nullptr, &Params::n_types, 1},
+    {"type_fraction", Params::type_fraction, nullptr, Params::max_types},
+    {"type_mass", Params::type_mass, nullptr, Params::max_types},
+    {"type_epsilon", Params::type_epsilon, nullptr, Params::max_types},
+    {"type_sigma", Params::type_sigma, nullptr, Params::max_types},
+    {"render_frequency", nullptr, &Params::render_frequency, 1},
+    {"render_width", nullptr, &Params::render_width, 1},
+    {"render_height", nullptr, &Params::render_height, 1},
+    {"render_tile_size", nullptr, &Params::render_tile_size, 1},
+    {"render_n_threads", nullptr, &Params::render_n_threads, 1},
+    {"render_queue_size", nullptr, &Params::render_queue_size, 1},
+    {"render_radius", &Params::render_radius, nullptr, 1},
+    {"render_fovy", &Params::render_fovy, nullptr, 1},
+    {"window_width", nullptr, &Params::window_width, 1},
+    {"window_height", nullptr, &Params::window_height, 1},
+    {"poll_timeout", &Params::poll_timeout, nullptr, 1},
+};
+
+/**
+ * trim
+ * @brief Return the string without leading and trailing white space.
+ */
+static std::string trim(const std::string &str)
+{
+    const char *space = " \t\r\n";
+    size_t begin = str.find_first_not_of(space);
+    if (begin == std::string::npos) {
+        return std::string();
+    }
+    size_t end = str.find_last_not_of(space);
+    return str.substr(begin, end - begin + 1);
+}
+
+/** ---------------------------------------------------------------------------
+ * Params::set
+ * @brief Set the parameter with the specified name from a comma separated
+ * list of values. Array parameters keep the values past the end of the list.
+ * Integer parameters are parsed as unsigned decimal integers, not through a
+ * double, so values above 2^53 are exact and out of range values rejected.
+ */
+void Params::set(const std::string &name, const std::string &value)
+{
+    const Entry *entry = nullptr;
+    for (auto &it : entries) {
+        if (name == it.name) {
+            entry = &it;
+            break;
+        }
+    }
+    core_assert(entry != nullptr, "unknown parameter");
+
+    std::istringstream list(value);
+    std::string token;
+    size_t n_values = 0;
+    while (std::getline(list, token, ',')) {
+        core_assert(n_values < entry->n_values, "too many parameter values");
+
+        std::string str = trim(token);
+        if (entry->real != nullptr) {
+            std::istringstream ss(str);
+            double x;
+            core_assert(ss >> x && (ss >> std::ws).eof(), "invalid parameter value");
+            entry->real[n_values] = x;
+        } else {
+            char *end = nullptr;
+            errno = 0;
+            unsigned long long x = std::strtoull(str.c_str(), &end, 10);
+            core_assert(!str.empty() && std::isdigit((unsigned char) str[0]) &&
+                *end == '\0', "invalid integer parameter");
+            core_assert(errno != ERANGE &&
+                x <= std::numeric_limits<size_t>::max(),
+                "integer parameter out of range");
+            entry->integer[n_values] = (size_t) x;
+        }
+        n_values++;
+    }
+    core_assert(n_values > 0, "missing parameter value");
+}
+
+/**
+ * Params::load
+ * @brief Load the parameters from a configuration file of name = value lines.
+ */
+void Params::load(const std::string &filename)
+{
+    core::FileIn file;
+    file.open(filename);
+    core_assert(file.is_open(), "failed to open configuration file");
+
+    std::string buffer;
+    while (file.readline(buffer)) {
+        /* Strip the comment and skip empty lines. */
+        std::string line = trim(buffer.substr(0, buffer.find('#')));
+        if (line.empty()) {
+            continue;
+        }
+
+        size_t pos = line.find('=');
+        core_assert(pos != std::string::npos, "invalid configuration line");
+        set(trim(line.substr(0, pos)), trim(line.substr(pos + 1)));
+    }
+    file.close();
+}
+
+/**
+ * Params::parse
+ * @brief Parse the command line arguments,
+ *      --config filename   load the parameters of a configuration file
+ *      name=value          set a parameter
+ * in order, so later arguments override earlier ones. Check the parameters
+ * and return the remaining arguments, starting with the program name.
+ */
+std::vector<std::string> Params::parse(int argc, char const *argv[])
+{
+    std::vector<std::string> args;
+    for (int ix = 0; ix < argc; ++ix) {
+        std::string arg(argv[ix]);
+        size_t pos = arg.find('=');
+        if (arg == "--config") {
+            core_assert(ix + 1 < argc, "missing configuration filename");
+            load(argv[++ix]);
+        } else if (ix > 0 && pos != std::string::npos) {
+            set(arg.substr(0, pos), arg.substr(pos + 1));
+        } else {
+            args.push_back(arg);
+        }
+    }
+    check();
+    return args;
+}
+
+/**
+ * Params::check
+ * @brief Check the parameters are consistent.
+ */
+void Params::check(void)
+{
+    core_assert(n_atoms > 0, "invalid number of atoms");
+    core_assert(n_types > 0 && n_types <= max_types, "invalid number of types");
+    core_assert(density > 0.0 && temperature > 0.0, "invalid thermodynamic state");
+    core_assert(t_step > 0.0, "invalid timestep");
+    core_assert(sample_frequency > 0 && sample_block_size > 0, "invalid sampler");
+    core_assert(respa_n_inner > 0, "invalid number of RESPA steps");
+    core_assert(render_frequency > 0 && render_width > 0 && render_height > 0,
+        "invalid render frames");
+    core_assert(render_tile_size > 0 && render_n_threads > 0 &&
+        render_queue_size > 0, "invalid renderer");
+
+    double fraction = 0.0;
+    for (size_t type = 0; type < n_types; ++type) {
+        core_assert(type_mass[type] > 0.0, "invalid type mass");
+        fraction += type_fraction[type];
+    }
+    core_assert(std::fabs(fraction - 1.0) < 1.0e-6, "type fractions must add to one");
+}
+
+/**
+ * Params::to_string
+ * @brief Return the parameters in configuration file format, with enough
+ * digits for the values to read back exactly.
+ */
+std::string Params::to_string(void)
+{
+    std::ostringstream ss;
+    ss.precision(std::numeric_limits<double>::max_digits10);
+    for (auto &entry : entries) {
+        ss << entry.name << " =";
+        for (size_t ix = 0; ix < entry.n_values; ++ix) {
+            ss << (ix > 0 ? ", " : " ");
+            if (entry.real != nullptr) {
+                ss << entry.real[ix];
+            } else {
+                ss << entry.integer[ix];
+            }
+        }
+        ss << "\n";
+    }
+    return ss.str();
+}
@@ -0,0 +1,105 @@
+/*
+ * params.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef MD_PARAMS_H_
+#define MD_PARAMS_H_
+
+#include "atto/opencl/opencl.hpp"
+
+/**
+ * @brief Model parameters, set at runtime from a configuration file and the
+ * command line before the engine setup. Each line of a configuration file
+ * holds one parameter,
+ *      name = value
+ * where the atom type parameters take a comma separated list of values, one
+ * per type, and the text after # is a comment. The parameters that size the
+ * force kernel tables and the file and window names remain compile time
+ * constants.
+ */
+namespace Params {
+/* Compile time parameters. */
+static const size_t max_types = 4;              /* max number of atom types */
+static const char render_prefix[] = "/tmp/out.frame"; /* image file prefix */
+static const char window_title[] = "md-cpu-grid-render"; /* window title */
+
+/* Simulation parameters. */
+extern double t_step;                           /* timestep size */
+extern size_t n_min_steps;                      /* max minimization steps */
+extern double min_force_tol;                    /* minimization max force */
+extern double min_t_step_max;                   /* minimization max timestep */
+extern double min_r_max;                        /* max displacement per step */
+extern size_t n_run_steps;                      /* number of run steps */
+extern size_t sample_frequency;                 /* sample frequency */
+extern size_t sample_block_size;                /* sampler block size */
+
+/* Engine parameters. */
+extern double density;                          /* fluid density */
+extern double temperature;                      /* fluid temperature */
+extern size_t n_atoms;                          /* number of atoms */
+extern size_t n_neighbours;                     /* neighbours per atom */
+extern double atom_mass;                        /* atom mass */
+extern double pair_epsilon;                     /* energy coefficient */
+extern double pair_sigma;                       /* sigma coefficient */
+extern double pair_r_cut;                       /* cutoff radius */
+extern double pair_r_skin;                      /* skin radius */
+extern double pair_r_hard;                      /* hard sphere radius */
+extern double thermostat_mass;                  /* thermostat inertial mass */
+
+/* Multiple time step parameters, radii in units of pair_sigma. */
+extern size_t respa_n_inner;                    /* inner steps, 1 disables */
+extern double respa_r_inner;                    /* inner shell cutoff radius */
+extern double respa_r_heal;                     /* inner shell healing length */
+
+/* Profiler parameters, used if compiled with MD_PROFILE. */
+extern size_t profile_trace_events;             /* max trace events */
+
+/* Species parameters, in units of atom_mass, pair_epsilon and pair_sigma. */
+extern size_t n_types;                          /* number of atom types */
+extern double type_fraction[max_types];         /* type number fraction */
+extern double type_mass[max_types];             /* type mass */
+extern double type_epsilon[max_types];          /* type LJ energy */
+extern double type_sigma[max_types];            /* type LJ size */
+
+/* Offline renderer parameters, used by the headless model. */
+extern size_t render_frequency;                 /* steps between frames */
+extern size_t render_width;                     /* image width */
+extern size_t render_height;                    /* image height */
+extern size_t render_tile_size;                 /* image tile size */
+extern size_t render_n_threads;                 /* renderer threads */
+extern size_t render_queue_size;                /* max pending frames */
+extern double render_radius;                    /* sphere radius */
+extern double render_fovy;                      /* camera field of view */
+
+/* OpenGL parameters */
+extern size_t window_width;                     /* window width */
+extern size_t window_height;                    /* window height */
+extern double poll_timeout;                     /* event poll timeout */
+
+/** Set the parameter with the specified name from its string value. */
+void set(const std::string &name, const std::string &value);
+
+/** Load the parameters from the specified configuration file. */
+void load(const std::string &filename);
+
+/**
+ * Load the configuration file and the parameter overrides of the command line
+ * and return the remaining arguments.
+ */
+std::vector<std::string> parse(int argc, char const *argv[]);
+
+/** Check the parameters are consistent. */
+void check(void);
+
+/** Return the parameters in configuration file format. */
+std::string to_string(void);
+} /* Params */
+
+#endif /* MD_PARAMS_H_ */
@@ -0,0 +1,122 @@
+/*
+ * profile.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef MD_PROFILE_H_
+#define MD_PROFILE_H_
+
+#include "atto/opencl/opencl.hpp"
+#include "base.hpp"
+
+#ifdef MD_PROFILE
+
+/**
+ * Profiler
+ * @brief Profiler maintains per-phase timers and counters of the engine hot
+ * path, aggregated over a window of integration steps. Each timed phase is
+ * also recorded as a complete event of a Chrome trace.
+ *
+ * The profiler is compiled only if MD_PROFILE is defined. Otherwise the
+ * md_profile_scope and md_profile_count macros expand to nothing.
+ */
+struct Profiler {
+    /* Engine phases. */
+    enum {
+        PhaseUpdate = 0,
+        PhaseNeighbours,
+        PhaseIntegrate,
+        PhaseThermostat,
+        PhaseForce,
+        PhaseSample,
+        PhaseIO,
+        NumPhases
+    };
+
+    /* Engine counters. */
+    enum {
+        CounterSteps = 0,               /* integration steps */
+        CounterAtoms,                   /* atoms visited by the force loop */
+        CounterPairs,                   /* pair interactions evaluated */
+        CounterRebuilds,                /* neighbour structure rebuilds */
+        CounterOverflows,               /* atoms with full pair capacity */
+        NumCounters
+    };
+
+    /* Trace event of a timed phase. */
+    struct Event {
+        uint32_t phase;                 /* phase index */
+        int64_t begin;                  /* begin time in ns */
+        int64_t duration;               /* duration in ns */
+    };
+
+    /* Profiler member variables. */
+    std::array<int64_t, NumPhases> m_time;      /* phase time in window */
+    std::array<uint64_t, NumPhases> m_calls;    /* phase calls in window */
+    std::array<uint64_t, NumCounters> m_count;  /* counters in window */
+    std::vector<Event> m_trace;                 /* trace events */
+    int64_t m_origin;                           /* trace time origin */
+
+    /** Return the current time in ns. */
+    static int64_t now(void);
+
+    /** Record the time interval of the specified phase. */
+    void record(const uint32_t phase, const int64_t begin, const int64_t end);
+
+    /** Increment the specified counter. */
+    void count(const uint32_t counter, const uint64_t n) {
+        m_count[counter] += n;
+    }
+
+    /** Reset the window timers and counters. */
+    void reset(void);
+
+    /** Serialize the window timers and counters. */
+    std::string to_string(void) const;
+
+    /** Write the trace events in Chrome trace JSON format. */
+    void write_trace(atto::core::FileOut &fileout) const;
+
+    /* Constructor/destructor. */
+    Profiler();
+    ~Profiler() = default;
+};
+
+/**
+ * ProfileScope
+ * @brief Scoped timer recording the enclosing scope duration in a phase.
+ */
+struct ProfileScope {
+    Profiler &m_profiler;
+    uint32_t m_phase;
+    int64_t m_begin;
+
+    ProfileScope(Profiler &profiler, const uint32_t phase)
+        : m_profiler(profiler)
+        , m_phase(phase)
+        , m_begin(Profiler::now()) {}
+    ~ProfileScope() {
+        m_profiler.record(m_phase, m_begin, Profiler::now());
+    }
+};
+
+#define md_profile_concat_(a, b) a##b
+#define md_profile_concat(a, b) md_profile_concat_(a, b)
+#define md_profile_scope(profiler, phase) \
+    ProfileScope md_profile_concat(profile_scope_, __LINE__)(profiler, phase)
+#define md_profile_count(profiler, counter, n) (profiler).count(counter, n)
+
+#else
+
+#define md_profile_scope(profiler, phase)
+#define md_profile_count(profiler, counter, n) ((void) (n))
+
+#endif /* MD_PROFILE */
+
+#endif /* MD_PROFILE_H_ */
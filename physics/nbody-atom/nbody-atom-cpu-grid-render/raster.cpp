@@ -0,0 +1,333 @@
+/*
+ * raster.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include <fstream>
+#include <limits>
+#include "atto/opencl/opencl.hpp"
+#include "raster.hpp"
+using namespace atto;
+
+/** ---------------------------------------------------------------------------
+ * Raster::setup
+ * @brief Setup the image buffers and the camera framing the domain, and start
+ * the background render thread.
+ */
+void Raster::setup(const Domain &domain)
+{
+    /* Setup image tiles and buffers. */
+    m_width = Params::render_width;
+    m_height = Params::render_height;
+    m_tile_size = Params::render_tile_size;
+    m_n_tiles_x = (m_width + m_tile_size - 1) / m_tile_size;
+    m_n_tiles_y = (m_height + m_tile_size - 1) / m_tile_size;
+    m_tile_offset.resize(m_n_tiles_x * m_n_tiles_y + 1);
+    m_depth.resize(m_width * m_height);
+    m_color.resize(3 * m_width * m_height);
+    m_n_frames = 0;
+
+    /*
+     * Setup the camera outside the bounding sphere of the domain, looking at
+     * its centre along an oblique direction, at a distance fitting the sphere
+     * inside the vertical field of view.
+     */
+    m_radius = Params::render_radius * Params::pair_sigma;
+    const float tan_half = std::tan(0.5 * Params::render_fovy);
+    m_scale = 0.5f * (float) m_height / tan_half;
+
+    float radius = std::sqrt(math::dot(domain.length_half, domain.length_half));
+    float distance = 1.05f * (radius + m_radius) * std::sqrt(1.0f + 1.0f / (tan_half * tan_half));
+    math::vec3f dir = math::normalize(math::vec3f{0.4f, 0.3f, 1.0f});
+    lookat(dir * distance,
+        math::vec3f{0.0f, 0.0f, 0.0f},
+        math::vec3f{0.0f, 1.0f, 0.0f});
+
+    /* Start the render thread. */
+    m_done = false;
+    m_thread = std::thread(&Raster::run, this);
+}
+
+/**
+ * Raster::teardown
+ * @brief Render the remaining queued frames and stop the render thread.
+ */
+void Raster::teardown(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_done = true;
+    }
+    m_cond.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * Raster::lookat
+ * @brief Set the camera at the eye position looking at the centre, with an
+ * orthonormal view frame.
+ */
+void Raster::lookat(
+    const math::vec3f &eye,
+    const math::vec3f &ctr,
+    const math::vec3f &up)
+{
+    m_eye = eye;
+    m_front = math::normalize(ctr - eye);
+    m_right = math::normalize(math::cross(m_front, up));
+    m_up = math::cross(m_right, m_front);
+}
+
+/** ---------------------------------------------------------------------------
+ * Raster::submit
+ * @brief Queue a snapshot of the atom positions and types, waiting while the
+ * queue holds Params::render_queue_size frames.
+ */
+void Raster::submit(const std::vector<Atom> &atoms, const size_t step)
+{
+    Frame frame;
+    frame.step = step;
+    frame.pos.resize(atoms.size());
+    frame.type.resize(atoms.size());
+    for (size_t atom_ix = 0; atom_ix < atoms.size(); ++atom_ix) {
+        frame.pos[atom_ix] = math::vec3f{
+            (float) atoms[atom_ix].pos.x,
+            (float) atoms[atom_ix].pos.y,
+            (float) atoms[atom_ix].pos.z};
+        frame.type[atom_ix] = atoms[atom_ix].type;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cond.wait(lock, [this] () {
+            return m_queue.size() < Params::render_queue_size;
+        });
+        m_queue.push_back(std::move(frame));
+    }
+    m_cond.notify_all();
+}
+
+/**
+ * Raster::run
+ * @brief Render the queued frames and write each frame image into the file
+ * Params::render_prefix.<frame>.ppm, until the raster is torn down and the
+ * queue is empty.
+ */
+void Raster::run(void)
+{
+    while (true) {
+        Frame frame;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait(lock, [this] () {
+                return m_done || !m_queue.empty();
+            });
+            if (m_queue.empty()) {
+                break;
+            }
+            frame = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        m_cond.notify_all();
+
+        render(frame);
+        write(core::str_format("%s.%06lu.ppm",
+            Params::render_prefix, m_n_frames++));
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * Raster::render
+ * @brief Render the frame into the colour buffer.
+ */
+void Raster::render(const Frame &frame)
+{
+    /* Atom type colours and background colour. */
+    static const math::vec3f type_color[] = {
+        math::vec3f{0.9f, 0.2f, 0.1f},
+        math::vec3f{0.1f, 0.4f, 0.9f},
+        math::vec3f{0.2f, 0.8f, 0.2f},
+        math::vec3f{0.9f, 0.8f, 0.1f}};
+    static const size_t n_colors = sizeof(type_color) / sizeof(type_color[0]);
+    const uint8_t background = 128;
+
+    /*
+     * Project the spheres in view space. The screen extent of a sphere of
+     * radius r with centre (x,z) along each image direction is bounded by the
+     * slopes of the view rays tangent to the sphere,
+     *  (x z -+ r sqrt(x^2 + z^2 - r^2)) / (z^2 - r^2).
+     * Spheres behind the camera or outside the image are culled.
+     */
+    const float r = m_radius;
+    const float r_sq = r * r;
+    const float half_width = 0.5f * (float) m_width;
+    const float half_height = 0.5f * (float) m_height;
+
+    m_spheres.clear();
+    for (size_t atom_ix = 0; atom_ix < frame.pos.size(); ++atom_ix) {
+        math::vec3f q = frame.pos[atom_ix] - m_eye;
+        math::vec3f c{
+            math::dot(q, m_right),
+            math::dot(q, m_up),
+            math::dot(q, m_front)};
+        if (c.z <= r) {
+            continue;
+        }
+
+        float det = c.z * c.z - r_sq;
+        float root_x = r * std::sqrt(c.x * c.x + det);
+        float root_y = r * std::sqrt(c.y * c.y + det);
+        float xlo = half_width  + m_scale * (c.x * c.z - root_x) / det;
+        float xhi = half_width  + m_scale * (c.x * c.z + root_x) / det;
+        float ylo = half_height - m_scale * (c.y * c.z + root_y) / det;
+        float yhi = half_height - m_scale * (c.y * c.z - root_y) / det;
+        if (xhi < 0.0f || yhi < 0.0f || xlo >= m_width || ylo >= m_height) {
+            continue;
+        }
+
+        Sphere sphere;
+        sphere.centre = c;
+        sphere.type = frame.type[atom_ix];
+        sphere.xlo = std::max((int32_t) std::floor(xlo), 0);
+        sphere.ylo = std::max((int32_t) std::floor(ylo), 0);
+        sphere.xhi = std::min((int32_t) std::ceil(xhi), (int32_t) m_width - 1);
+        sphere.yhi = std::min((int32_t) std::ceil(yhi), (int32_t) m_height - 1);
+        m_spheres.push_back(sphere);
+    }
+
+    /* Bin the spheres into the lists of the tiles they overlap. */
+    std::fill(m_tile_offset.begin(), m_tile_offset.end(), 0);
+    for (auto &sphere : m_spheres) {
+        for (size_t ty = sphere.ylo / m_tile_size; ty <= sphere.yhi / m_tile_size; ++ty) {
+            for (size_t tx = sphere.xlo / m_tile_size; tx <= sphere.xhi / m_tile_size; ++tx) {
+                m_tile_offset[ty * m_n_tiles_x + tx + 1]++;
+            }
+        }
+    }
+    for (size_t tile_ix = 0; tile_ix < m_n_tiles_x * m_n_tiles_y; ++tile_ix) {
+        m_tile_offset[tile_ix + 1] += m_tile_offset[tile_ix];
+    }
+
+    m_tile_spheres.resize(m_tile_offset.back());
+    {
+        std::vector<size_t> count(m_tile_offset.begin(), m_tile_offset.end() - 1);
+        for (size_t sphere_ix = 0; sphere_ix < m_spheres.size(); ++sphere_ix) {
+            const Sphere &sphere = m_spheres[sphere_ix];
+            for (size_t ty = sphere.ylo / m_tile_size; ty <= sphere.yhi / m_tile_size; ++ty) {
+                for (size_t tx = sphere.xlo / m_tile_size; tx <= sphere.xhi / m_tile_size; ++tx) {
+                    m_tile_spheres[count[ty * m_n_tiles_x + tx]++] = sphere_ix;
+                }
+            }
+        }
+    }
+
+    /*
+     * Render the tiles in parallel. Each pixel of a sphere bounding box casts
+     * a view ray d from the eye and intersects the sphere at the distance
+     *  t = d.c - sqrt((d.c)^2 - c.c + r^2),
+     * keeping the nearest hit. The hit is shaded with an ambient term, a
+     * diffuse term and a Blinn-Phong specular term of a directional light.
+     */
+    const math::vec3f light = math::normalize(math::vec3f{-0.5f, 0.6f, -1.0f});
+    const size_t n_tiles = m_n_tiles_x * m_n_tiles_y;
+    const float ambient = 0.2f;
+    const float diffuse = 0.8f;
+    const float specular = 0.4f;
+    const float shininess = 32.0f;
+
+    core_pragma_omp(parallel for default(none) \
+        shared(type_color, n_colors, n_tiles, half_width, half_height, r_sq, \
+        light, ambient, diffuse, specular, shininess, background) \
+        schedule(dynamic) num_threads(Params::render_n_threads))
+    for (size_t tile_ix = 0; tile_ix < n_tiles; ++tile_ix) {
+        const int32_t tile_xlo = (tile_ix % m_n_tiles_x) * m_tile_size;
+        const int32_t tile_ylo = (tile_ix / m_n_tiles_x) * m_tile_size;
+        const int32_t tile_xhi = std::min(tile_xlo + m_tile_size, m_width) - 1;
+        const int32_t tile_yhi = std::min(tile_ylo + m_tile_size, m_height) - 1;
+
+        /* Clear the tile. */
+        for (int32_t y = tile_ylo; y <= tile_yhi; ++y) {
+            for (int32_t x = tile_xlo; x <= tile_xhi; ++x) {
+                size_t pixel = y * m_width + x;
+                m_depth[pixel] = std::numeric_limits<float>::max();
+                m_color[3 * pixel + 0] = background;
+                m_color[3 * pixel + 1] = background;
+                m_color[3 * pixel + 2] = background;
+            }
+        }
+
+        /* Draw the tile spheres. */
+        for (size_t ix = m_tile_offset[tile_ix]; ix < m_tile_offset[tile_ix + 1]; ++ix) {
+            const Sphere &sphere = m_spheres[m_tile_spheres[ix]];
+            const math::vec3f &c = sphere.centre;
+            const math::vec3f &color = type_color[sphere.type % n_colors];
+            const float c_sq = math::dot(c, c) - r_sq;
+
+            int32_t ylo = std::max(sphere.ylo, tile_ylo);
+            int32_t yhi = std::min(sphere.yhi, tile_yhi);
+            int32_t xlo = std::max(sphere.xlo, tile_xlo);
+            int32_t xhi = std::min(sphere.xhi, tile_xhi);
+            for (int32_t y = ylo; y <= yhi; ++y) {
+                for (int32_t x = xlo; x <= xhi; ++x) {
+                    math::vec3f d = math::normalize(math::vec3f{
+                         ((float) x + 0.5f - half_width) / m_scale,
+                        -((float) y + 0.5f - half_height) / m_scale,
+                        1.0f});
+
+                    float b = math::dot(d, c);
+                    float disc = b * b - c_sq;
+                    if (disc < 0.0f) {
+                        continue;
+                    }
+
+                    size_t pixel = y * m_width + x;
+                    float t = b - std::sqrt(disc);
+                    if (t >= m_depth[pixel]) {
+                        continue;
+                    }
+                    m_depth[pixel] = t;
+
+                    /* Shade the sphere surface point. */
+                    math::vec3f n = (d * t - c) / m_radius;
+                    math::vec3f h = math::normalize(light - d);
+                    float n_dot_l = std::max(math::dot(n, light), 0.0f);
+                    float n_dot_h = std::max(math::dot(n, h), 0.0f);
+                    float shade = ambient + diffuse * n_dot_l;
+                    float highlight = n_dot_l > 0.0f
+                        ? specular * std::pow(n_dot_h, shininess) : 0.0f;
+
+                    auto channel = [&] (float value) -> uint8_t {
+                        value = value * shade + highlight;
+                        return (uint8_t) (255.0f * std::min(std::max(value, 0.0f), 1.0f));
+                    };
+                    m_color[3 * pixel + 0] = channel(color.x);
+                    m_color[3 * pixel + 1] = channel(color.y);
+                    m_color[3 * pixel + 2] = channel(color.z);
+                }
+            }
+        }
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * Raster::write
+ * @brief Write the colour buffer into a binary PPM image file.
+ */
+void Raster::write(const std::string &filename) const
+{
+    std::ofstream file(filename, std::ios::out | std::ios::binary);
+    core_assert(file.is_open(), "failed to open image file");
+
+    std::string header = core::str_format("P6\n%lu %lu\n255\n", m_width, m_height);
+    file.write(header.data(), header.size());
+    file.write(reinterpret_cast<const char *>(m_color.data()), m_color.size());
+    core_assert(file.good(), "failed to write image file");
+}
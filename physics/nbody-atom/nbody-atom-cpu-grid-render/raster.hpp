@@ -0,0 +1,107 @@
+/*
+ * raster.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef MD_RASTER_H_
+#define MD_RASTER_H_
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include "atto/opencl/opencl.hpp"
+#include "base.hpp"
+
+/**
+ * Raster
+ * @brief Offline renderer drawing the atoms as shaded spheres into image
+ * files on the CPU, without a display or an OpenGL context.
+ *
+ * Each sphere is drawn as an impostor, covering the screen bounding box of its
+ * projection, where every pixel intersects the view ray with the sphere and
+ * keeps the nearest hit in a depth buffer. The image is divided into square
+ * tiles rendered in parallel, each over the list of spheres overlapping it,
+ * and shaded with a directional light and a specular highlight.
+ *
+ * The engine submits snapshots of the atom positions to a queue, and a
+ * background thread renders the queued frames and writes them as binary PPM
+ * images, so the engine only waits if the queue is full.
+ */
+struct Raster {
+    /* Snapshot of the atom positions and types at an integration step. */
+    struct Frame {
+        size_t step;                            /* integration step */
+        std::vector<atto::math::vec3f> pos;     /* atom positions */
+        std::vector<uint32_t> type;             /* atom types */
+    };
+
+    /* Sphere projection in view space and its pixel bounding box. */
+    struct Sphere {
+        atto::math::vec3f centre;               /* view space centre */
+        uint32_t type;                          /* atom type */
+        int32_t xlo, ylo, xhi, yhi;             /* pixel bounding box */
+    };
+
+    /* Raster member variables. */
+    size_t m_width;                             /* image width */
+    size_t m_height;                            /* image height */
+    size_t m_tile_size;                         /* image tile size */
+    size_t m_n_tiles_x;                         /* tiles along x */
+    size_t m_n_tiles_y;                         /* tiles along y */
+    float m_radius;                             /* sphere radius */
+    float m_scale;                              /* pixels per unit slope */
+    atto::math::vec3f m_eye;                    /* camera position */
+    atto::math::vec3f m_right;                  /* camera right direction */
+    atto::math::vec3f m_up;                     /* camera up direction */
+    atto::math::vec3f m_front;                  /* camera view direction */
+    std::vector<Sphere> m_spheres;              /* visible spheres */
+    std::vector<size_t> m_tile_offset;          /* tile sphere list offsets */
+    std::vector<size_t> m_tile_spheres;         /* tile sphere lists */
+    std::vector<float> m_depth;                 /* depth buffer */
+    std::vector<uint8_t> m_color;               /* rgb colour buffer */
+    size_t m_n_frames;                          /* number of written frames */
+
+    /* Background render thread and queue of pending frames. */
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::deque<Frame> m_queue;
+    bool m_done;
+
+    /** Set the camera at the eye position looking at the centre. */
+    void lookat(
+        const atto::math::vec3f &eye,
+        const atto::math::vec3f &ctr,
+        const atto::math::vec3f &up);
+
+    /** Queue a snapshot of the atoms, waiting while the queue is full. */
+    void submit(const std::vector<Atom> &atoms, const size_t step);
+
+    /** Render the frame into the colour buffer. */
+    void render(const Frame &frame);
+
+    /** Write the colour buffer into a binary PPM image file. */
+    void write(const std::string &filename) const;
+
+    /** Render the queued frames until the raster is torn down. */
+    void run(void);
+
+    /** Setup/teardown raster. */
+    void setup(const Domain &domain);
+    void teardown(void);
+
+    /* Constructor/destructor. */
+    Raster() = default;
+    ~Raster() = default;
+    Raster(const Raster &) = delete;
+    Raster &operator=(const Raster &) = delete;
+};
+
+#endif /* MD_RASTER_H_ */
@@ -11,6 +11,7 @@
 
 #include "atto/opencl/opencl.hpp"
 #include "compute.hpp"
+#include "reduce.hpp"
 using namespace atto;
 
 namespace compute {
@@ -21,11 +22,9 @@ namespace compute {
  */
 double com_mass(std::vector<Atom> &atoms)
 {
-    double mass = 0.0;
-    for (auto &atom : atoms) {
-        mass += atom.mass;
-    }
-    return mass;
+    return reduce::sum<double>(atoms.size(), [&atoms] (size_t ix) {
+        return atoms[ix].mass;
+    });
 }
 
 /** ---------------------------------------------------------------------------
@@ -34,12 +33,10 @@ double com_mass(std::vector<Atom> &atoms)
  */
 math::vec3d com_pos(std::vector<Atom> &atoms)
 {
-    double mass = 0.0;
-    math::vec3d pos = math::vec3d{};
-    for (auto &atom : atoms) {
-        mass += atom.mass;
-        pos += atom.pos * atom.mass;
-    }
+    double mass = com_mass(atoms);
+    math::vec3d pos = reduce::sum<math::vec3d>(atoms.size(), [&atoms] (size_t ix) {
+        return atoms[ix].pos * atoms[ix].mass;
+    });
     return pos / mass;
 }
 
@@ -49,12 +46,10 @@ math::vec3d com_pos(std::vector<Atom> &atoms)
  */
 math::vec3d com_upos(std::vector<Atom> &atoms)
 {
-    double mass = 0.0;
-    math::vec3d upos = math::vec3d{};
-    for (auto &atom : atoms) {
-        mass += atom.mass;
-        upos += atom.upos * atom.mass;
-    }
+    double mass = com_mass(atoms);
+    math::vec3d upos = reduce::sum<math::vec3d>(atoms.size(), [&atoms] (size_t ix) {
+        return atoms[ix].upos * atoms[ix].mass;
+    });
     return upos / mass;
 }
 
@@ -64,12 +59,8 @@ math::vec3d com_upos(std::vector<Atom> &atoms)
  */
 math::vec3d com_vel(std::vector<Atom> &atoms)
 {
-    double mass = 0.0;
-    math::vec3d mom = math::vec3d{};
-    for (auto &atom : atoms) {
-        mass += atom.mass;
-        mom += atom.mom;
-    }
+    double mass = com_mass(atoms);
+    math::vec3d mom = com_mom(atoms);
     return mom /= mass;
 }
 
@@ -79,11 +70,9 @@ math::vec3d com_vel(std::vector<Atom> &atoms)
  */
 math::vec3d com_mom(std::vector<Atom> &atoms)
 {
-    math::vec3d mom = math::vec3d{};
-    for (auto &atom : atoms) {
-        mom += atom.mom;
-    }
-    return mom;
+    return reduce::sum<math::vec3d>(atoms.size(), [&atoms] (size_t ix) {
+        return atoms[ix].mom;
+    });
 }
 
 /** ---------------------------------------------------------------------------
@@ -92,11 +81,9 @@ math::vec3d com_mom(std::vector<Atom> &atoms)
  */
 math::vec3d com_force(std::vector<Atom> &atoms)
 {
-    math::vec3d force = math::vec3d{};
-    for (auto &atom : atoms) {
-        force += atom.force;
-    }
-    return force;
+    return reduce::sum<math::vec3d>(atoms.size(), [&atoms] (size_t ix) {
+        return atoms[ix].force;
+    });
 }
 
 /** ---------------------------------------------------------------------------
@@ -118,10 +105,9 @@ double density(std::vector<Atom> &atoms, const Domain &domain)
  */
 double energy_kin(std::vector<Atom> &atoms)
 {
-    double energy = 0.0;
-    for (auto &atom : atoms) {
-        energy += math::dot(atom.mom, atom.mom) * atom.rmass;
-    }
+    double energy = reduce::sum<double>(atoms.size(), [&atoms] (size_t ix) {
+        return math::dot(atoms[ix].mom, atoms[ix].mom) * atoms[ix].rmass;
+    });
     return 0.5 * energy;
 }
 
@@ -131,11 +117,9 @@ double energy_kin(std::vector<Atom> &atoms)
  */
 double energy_pot(std::vector<Atom> &atoms)
 {
-    double energy = 0.0;
-    for (auto &atom : atoms) {
-        energy += atom.energy;
-    }
-    return energy;
+    return reduce::sum<double>(atoms.size(), [&atoms] (size_t ix) {
+        return atoms[ix].energy;
+    });
 }
 
 /** ---------------------------------------------------------------------------
@@ -146,25 +130,33 @@ double temperature_kin(
     std::vector<Atom> &atoms,
     double &grad_sq,
     double &laplace)
+{
+    return temperature_kin(thermo_sums(atoms, atoms.size()), grad_sq, laplace);
+}
+
+/**
+ * temperature_kin
+ * @brief Compute fluid kinetic temperature from the thermodynamic sums.
+ */
+double temperature_kin(
+    const ThermoSums &sums,
+    double &grad_sq,
+    double &laplace)
 {
     /* Compute kinetic temperature of the fluid. */
-    grad_sq = 0.0;
-    laplace = 0.0;
-    for (auto &atom : atoms) {
-        grad_sq += math::dot(atom.mom, atom.mom) * atom.rmass;
-        laplace += 3.0;
-    }
+    grad_sq = sums.values[ThermoSums::GradSq];
+    laplace = sums.values[ThermoSums::Laplace];
 
     /*
      * If fluid size is more than one atom, remove the CoM momentum
      * contribution to the total kinetic energy and account for the
      * correct number of degrees of freedom.
      */
-    if (atoms.size() > 1) {
-        double mass = compute::com_mass(atoms);
-        math::vec3d mom = compute::com_mom(atoms);
+    if (laplace > 3.0) {
+        const double *mom = &sums.values[ThermoSums::Mom];
+        double mass = sums.values[ThermoSums::Mass];
 
-        double com_grad_sq = math::dot(mom, mom) / mass;
+        double com_grad_sq = (mom[0]*mom[0] + mom[1]*mom[1] + mom[2]*mom[2]) / mass;
         double com_laplace = 3.0;
 
         grad_sq -= com_grad_sq;
@@ -181,24 +173,27 @@ double temperature_kin(
 math::mat3d pressure_kin(std::vector<Atom> &atoms, const Domain &domain)
 {
     math::vec3d velocity = compute::com_vel(atoms);
-    math::mat3d pressure = math::mat3d{};
-    for (auto &atom : atoms) {
+    math::mat3d pressure = reduce::sum<math::mat3d>(atoms.size(), [&] (size_t ix) {
+        const Atom &atom = atoms[ix];
+
         /* Atom velocity relative to the fluid CoM. */
         math::vec3d vel = atom.mom * atom.rmass;
         vel -= velocity;
 
-        pressure.xx += atom.mass * vel.x * vel.x;
-        pressure.xy += atom.mass * vel.x * vel.y;
-        pressure.xz += atom.mass * vel.x * vel.z;
+        math::mat3d pres = math::mat3d{};
+        pres.xx += atom.mass * vel.x * vel.x;
+        pres.xy += atom.mass * vel.x * vel.y;
+        pres.xz += atom.mass * vel.x * vel.z;
 
-        pressure.yx += atom.mass * vel.y * vel.x;
-        pressure.yy += atom.mass * vel.y * vel.y;
-        pressure.yz += atom.mass * vel.y * vel.z;
+        pres.yx += atom.mass * vel.y * vel.x;
+        pres.yy += atom.mass * vel.y * vel.y;
+        pres.yz += atom.mass * vel.y * vel.z;
 
-        pressure.zx += atom.mass * vel.z * vel.x;
-        pressure.zx += atom.mass * vel.z * vel.y;
-        pressure.zz += atom.mass * vel.z * vel.z;
-    }
+        pres.zx += atom.mass * vel.z * vel.x;
+        pres.zy += atom.mass * vel.z * vel.y;
+        pres.zz += atom.mass * vel.z * vel.z;
+        return pres;
+    });
 
     double volume = domain.length.x *
                     domain.length.y *
@@ -213,10 +208,9 @@ math::mat3d pressure_kin(std::vector<Atom> &atoms, const Domain &domain)
  */
 math::mat3d pressure_vir(std::vector<Atom> &atoms, const Domain &domain)
 {
-    math::mat3d pressure = math::mat3d{};
-    for (auto &atom : atoms) {
-        pressure += atom.virial;
-    }
+    math::mat3d pressure = reduce::sum<math::mat3d>(atoms.size(), [&atoms] (size_t ix) {
+        return atoms[ix].virial;
+    });
 
     double volume = domain.length.x *
                     domain.length.y *
@@ -225,6 +219,127 @@ math::mat3d pressure_vir(std::vector<Atom> &atoms, const Domain &domain)
     return pressure;
 }
 
+/** ---------------------------------------------------------------------------
+ * thermo_sums
+ * @brief Compute the thermodynamic sums of the first n atoms of the fluid,
+ * e.g. the owned atoms of a subdomain.
+ */
+ThermoSums thermo_sums(const std::vector<Atom> &atoms, const size_t n_atoms)
+{
+    return reduce::sum<ThermoSums>(n_atoms, [&atoms] (size_t ix) {
+        const Atom &atom = atoms[ix];
+        const math::vec3d &mom = atom.mom;
+
+        ThermoSums sums;
+        double *v = sums.values;
+        v[ThermoSums::Mass] = atom.mass;
+
+        v[ThermoSums::Pos + 0] = atom.mass * atom.pos.x;
+        v[ThermoSums::Pos + 1] = atom.mass * atom.pos.y;
+        v[ThermoSums::Pos + 2] = atom.mass * atom.pos.z;
+
+        v[ThermoSums::Upos + 0] = atom.mass * atom.upos.x;
+        v[ThermoSums::Upos + 1] = atom.mass * atom.upos.y;
+        v[ThermoSums::Upos + 2] = atom.mass * atom.upos.z;
+
+        v[ThermoSums::Mom + 0] = mom.x;
+        v[ThermoSums::Mom + 1] = mom.y;
+        v[ThermoSums::Mom + 2] = mom.z;
+
+        v[ThermoSums::Force + 0] = atom.force.x;
+        v[ThermoSums::Force + 1] = atom.force.y;
+        v[ThermoSums::Force + 2] = atom.force.z;
+
+        v[ThermoSums::GradSq] = math::dot(mom, mom) * atom.rmass;
+        v[ThermoSums::Laplace] = 3.0;
+        v[ThermoSums::Energy] = atom.energy;
+
+        v[ThermoSums::Kinetic + 0] = mom.x * mom.x * atom.rmass;
+        v[ThermoSums::Kinetic + 1] = mom.x * mom.y * atom.rmass;
+        v[ThermoSums::Kinetic + 2] = mom.x * mom.z * atom.rmass;
+        v[ThermoSums::Kinetic + 3] = mom.y * mom.x * atom.rmass;
+        v[ThermoSums::Kinetic + 4] = mom.y * mom.y * atom.rmass;
+        v[ThermoSums::Kinetic + 5] = mom.y * mom.z * atom.rmass;
+        v[ThermoSums::Kinetic + 6] = mom.z * mom.x * atom.rmass;
+        v[ThermoSums::Kinetic + 7] = mom.z * mom.y * atom.rmass;
+        v[ThermoSums::Kinetic + 8] = mom.z * mom.z * atom.rmass;
+
+        v[ThermoSums::Virial + 0] = atom.virial.xx;
+        v[ThermoSums::Virial + 1] = atom.virial.xy;
+        v[ThermoSums::Virial + 2] = atom.virial.xz;
+        v[ThermoSums::Virial + 3] = atom.virial.yx;
+        v[ThermoSums::Virial + 4] = atom.virial.yy;
+        v[ThermoSums::Virial + 5] = atom.virial.yz;
+        v[ThermoSums::Virial + 6] = atom.virial.zx;
+        v[ThermoSums::Virial + 7] = atom.virial.zy;
+        v[ThermoSums::Virial + 8] = atom.virial.zz;
+        return sums;
+    });
+}
+
+/** ---------------------------------------------------------------------------
+ * thermo
+ * @brief Compute the fluid thermodynamic properties from the thermodynamic
+ * sums of all fluid atoms.
+ */
+Thermo thermo(const ThermoSums &sums, const Domain &domain)
+{
+    const double *v = sums.values;
+    const double volume = domain.length.x *
+                          domain.length.y *
+                          domain.length.z;
+    const double mass = v[ThermoSums::Mass];
+    const math::vec3d mom{
+        v[ThermoSums::Mom + 0], v[ThermoSums::Mom + 1], v[ThermoSums::Mom + 2]};
+
+    Thermo thermo;
+    thermo.com_mass = mass;
+    thermo.com_pos = math::vec3d{
+        v[ThermoSums::Pos + 0], v[ThermoSums::Pos + 1], v[ThermoSums::Pos + 2]} / mass;
+    thermo.com_upos = math::vec3d{
+        v[ThermoSums::Upos + 0], v[ThermoSums::Upos + 1], v[ThermoSums::Upos + 2]} / mass;
+    thermo.com_vel = mom / mass;
+    thermo.com_mom = mom;
+    thermo.com_force = math::vec3d{
+        v[ThermoSums::Force + 0], v[ThermoSums::Force + 1], v[ThermoSums::Force + 2]};
+
+    thermo.density = mass / volume;
+    thermo.energy_kin = 0.5 * v[ThermoSums::GradSq];
+    thermo.energy_pot = v[ThermoSums::Energy];
+
+    thermo.temp_kinetic = temperature_kin(
+        sums, thermo.temp_grad_sq, thermo.temp_laplace);
+
+    /*
+     * Kinetic pressure relative to the CoM velocity,
+     *  sum_i m_i (v_i - V) (x) (v_i - V) = sum_i p_i (x) p_i / m_i - P (x) P / M,
+     * and virial pressure.
+     */
+    const double *kin = &v[ThermoSums::Kinetic];
+    thermo.pres_kinetic.xx = (kin[0] - mom.x * mom.x / mass) / volume;
+    thermo.pres_kinetic.xy = (kin[1] - mom.x * mom.y / mass) / volume;
+    thermo.pres_kinetic.xz = (kin[2] - mom.x * mom.z / mass) / volume;
+    thermo.pres_kinetic.yx = (kin[3] - mom.y * mom.x / mass) / volume;
+    thermo.pres_kinetic.yy = (kin[4] - mom.y * mom.y / mass) / volume;
+    thermo.pres_kinetic.yz = (kin[5] - mom.y * mom.z / mass) / volume;
+    thermo.pres_kinetic.zx = (kin[6] - mom.z * mom.x / mass) / volume;
+    thermo.pres_kinetic.zy = (kin[7] - mom.z * mom.y / mass) / volume;
+    thermo.pres_kinetic.zz = (kin[8] - mom.z * mom.z / mass) / volume;
+
+    const double *vir = &v[ThermoSums::Virial];
+    thermo.pres_virial.xx = vir[0] / volume;
+    thermo.pres_virial.xy = vir[1] / volume;
+    thermo.pres_virial.xz = vir[2] / volume;
+    thermo.pres_virial.yx = vir[3] / volume;
+    thermo.pres_virial.yy = vir[4] / volume;
+    thermo.pres_virial.yz = vir[5] / volume;
+    thermo.pres_virial.zx = vir[6] / volume;
+    thermo.pres_virial.zy = vir[7] / volume;
+    thermo.pres_virial.zz = vir[8] / volume;
+
+    return thermo;
+}
+
 /** ---------------------------------------------------------------------------
  * pbc
  * @brief Return the lengthic image in primary cell of the fluid domain.
@@ -261,23 +376,55 @@ math::vec3d pbc(const math::vec3d &r, const Domain &domain)
 }
 
 /** ---------------------------------------------------------------------------
+ * force_shell
+ * @brief Return the weight of a pair interaction in the specified force shell.
+ * The r-RESPA split uses a switching function S(r) that is 1 for pairs closer
+ * than r_inner - r_heal, 0 beyond r_inner, and a smooth cubic in between.
+ * The inner shell force is S(r)*F(r) and the outer shell is (1 - S(r))*F(r).
+ */
+double force_shell(
+    const double r_12_sq,
+    const Field &field,
+    const uint32_t shell)
+{
+    if (shell == ShellFull) {
+        return 1.0;
+    }
+
+    /* Compute the switching function of the inner shell. */
+    const double r_begin = field.r_inner - field.r_heal;
+    double weight = 1.0;
+    if (r_12_sq > field.r_inner * field.r_inner) {
+        weight = 0.0;
+    } else if (r_12_sq > r_begin * r_begin) {
+        double x = (std::sqrt(r_12_sq) - r_begin) / field.r_heal;
+        weight = 1.0 + x * x * (2.0 * x - 3.0);
+    }
+
+    return (shell == ShellInner) ? weight : 1.0 - weight;
+}
+
+/**
  * force_atom
- * @brief Compute the force on the atom with the specified index.
+ * @brief Accumulate the force on the atom with the specified index, weighted
+ * by the pair interaction weights of the specified force shell. Return the
+ * number of pair interactions within the cutoff radius. If the histogram is
+ * not null, add the distances of the pairs within the largest cutoff radius.
+ * Charged pairs within the largest cutoff radius add the real space Ewald sum.
  */
-void force_atom(
+size_t force_atom(
     const size_t atom_1,
     const size_t n_atoms,
     const size_t n_neighbours,
     std::vector<Atom> &atoms,
     const Domain &domain,
     const Field &field,
-    const Grid &grid)
+    const Grid &grid,
+    const uint32_t shell,
+    uint64_t *histogram)
 {
-    const double r_cut_sq = field.r_cut * field.r_cut;
-
-    atoms[atom_1].force = math::vec3d{};
-    atoms[atom_1].energy = 0.0;
-    atoms[atom_1].virial = math::mat3d{};
+    /* Type pair coefficients of the atom. */
+    const FieldPair *coeff = &field.pairs[atoms[atom_1].type * Field::max_types];
 
     const size_t begin = atom_1 * n_neighbours;
     const size_t end = begin + n_neighbours;
@@ -291,25 +438,49 @@ void force_atom(
         math::vec3d r_12 = atoms[atom_1].pos - atoms[atom_2].pos;
         r_12 = compute::pbc(r_12, domain);
 
-        if (pair_ix < end && dot(r_12, r_12) < r_cut_sq) {
-            Pair pair = force_pair(atom_1, atom_2, r_12, field);
-            atoms[atom_1].force  -= pair.gradient;
-            atoms[atom_1].energy += pair.energy * 0.5;
-            atoms[atom_1].virial += pair.virial * 0.5;
+        const FieldPair &coeff_12 = coeff[atoms[atom_2].type];
+        const double r_12_sq = dot(r_12, r_12);
+        if (histogram != nullptr && r_12_sq < field.r_cut * field.r_cut) {
+            size_t bin = (size_t) (std::sqrt(r_12_sq) * Params::rdf_n_bins / field.r_cut);
+            histogram[std::min(bin, Params::rdf_n_bins - 1)]++;
+        }
+        if (pair_ix < end && r_12_sq < coeff_12.r_cut_sq) {
+            double weight = force_shell(r_12_sq, field, shell);
+            if (weight > 0.0) {
+                Pair pair = force_pair(atom_1, atom_2, r_12, coeff_12, field.r_hard);
+                atoms[atom_1].force  -= pair.gradient * weight;
+                atoms[atom_1].energy += pair.energy * (0.5 * weight);
+                atoms[atom_1].virial += pair.virial * (0.5 * weight);
+            }
             pair_ix++;
         }
+
+        const double charge_12 = atoms[atom_1].charge * atoms[atom_2].charge;
+        if (charge_12 != 0.0 && r_12_sq < field.r_cut * field.r_cut) {
+            double weight = force_shell(r_12_sq, field, shell);
+            if (weight > 0.0) {
+                Pair pair = force_coulomb(atom_1, atom_2, r_12, charge_12, field.alpha);
+                atoms[atom_1].force  -= pair.gradient * weight;
+                atoms[atom_1].energy += pair.energy * (0.5 * weight);
+                atoms[atom_1].virial += pair.virial * (0.5 * weight);
+            }
+        }
     }
+
+    return (pair_ix - begin);
 }
 
 /**
  * force_pair
- * @brief Compute pair interaction force.
+ * @brief Compute pair interaction force using the coefficients of the atom
+ * type pair.
  */
 Pair force_pair(
     const size_t atom_1,
     const size_t atom_2,
     const math::vec3d &r_12,
-    const Field &field)
+    const FieldPair &coeff,
+    const double r_hard)
 {
     /* Compute pair attributes - energy, gradient, laplacian and virial. */
     Pair pair;
@@ -324,16 +495,15 @@ Pair force_pair(
     pair.virial = math::mat3d{};
 
     /* Interaction coefficients. */
-    const double epsilon = field.epsilon;
-    const double sigma = field.sigma;
-    const double r_hard = field.r_hard;
+    const double epsilon = coeff.epsilon;
+    const double sigma = coeff.sigma;
 
     const double sigma_sq = sigma * sigma;
     const double r_hard_sq = r_hard * r_hard;
 
     /* Define pair energy and force coefficients */
-    double energy_coeff = 4.0 * field.epsilon;
-    double force_coeff = 24.0 * field.epsilon / sigma_sq;
+    double energy_coeff = 4.0 * epsilon;
+    double force_coeff = 24.0 * epsilon / sigma_sq;
 
     /* Ensure pair distance is larger than the hard sphere radius. */
     double energy_hard_sphere = 0.0;
@@ -392,4 +562,63 @@ Pair force_pair(
     return pair;
 }
 
+/**
+ * force_coulomb
+ * @brief Compute the real space Ewald pair interaction force with energy
+ * q_1 q_2 erfc(alpha r)/r, whose gradient is f(r) r_12 with
+ *  f(r) = -q_1 q_2 [erfc(alpha r)/r^3 + 2 alpha/sqrt(pi) exp(-alpha^2 r^2)/r^2].
+ */
+Pair force_coulomb(
+    const size_t atom_1,
+    const size_t atom_2,
+    const math::vec3d &r_12,
+    const double charge_12,
+    const double alpha)
+{
+    /* Compute pair attributes - energy, gradient, laplacian and virial. */
+    Pair pair;
+
+    pair.atom_1 = atom_1;
+    pair.atom_2 = atom_2;
+    pair.r_12 = r_12;
+
+    const double r_12_sq = math::dot(r_12, r_12);
+    const double r_12_len = std::sqrt(r_12_sq);
+    const double erfc_r = std::erfc(alpha * r_12_len) / r_12_len;
+    const double exp_r = 2.0 * alpha / std::sqrt(M_PI) *
+        std::exp(-alpha * alpha * r_12_sq);
+
+    /* Coulomb energy */
+    pair.energy = charge_12 * erfc_r;
+
+    /* Coulomb gradient, with U'(r) = f(r) r */
+    double force_coeff = -charge_12 * (erfc_r + exp_r) / r_12_sq;
+    pair.gradient = r_12;
+    pair.gradient *= force_coeff;
+
+    /* Coulomb laplacian, d2U/dx2 = f(r) + (U''(r) - f(r)) x^2/r^2 */
+    double d2u = charge_12 * (2.0 * (erfc_r + exp_r) / r_12_sq +
+                              2.0 * alpha * alpha * exp_r);
+    double laplace_c1 = (d2u - force_coeff) / r_12_sq;
+
+    pair.laplace.x = laplace_c1 * r_12.x * r_12.x + force_coeff;
+    pair.laplace.y = laplace_c1 * r_12.y * r_12.y + force_coeff;
+    pair.laplace.z = laplace_c1 * r_12.z * r_12.z + force_coeff;
+
+    /* Coulomb virial */
+    pair.virial.xx = -r_12.x * pair.gradient.x;
+    pair.virial.xy = -r_12.x * pair.gradient.y;
+    pair.virial.xz = -r_12.x * pair.gradient.z;
+
+    pair.virial.yx = -r_12.y * pair.gradient.x;
+    pair.virial.yy = -r_12.y * pair.gradient.y;
+    pair.virial.yz = -r_12.y * pair.gradient.z;
+
+    pair.virial.zx = -r_12.z * pair.gradient.x;
+    pair.virial.zy = -r_12.z * pair.gradient.y;
+    pair.virial.zz = -r_12.z * pair.gradient.z;
+
+    return pair;
+}
+
 } /* compute */
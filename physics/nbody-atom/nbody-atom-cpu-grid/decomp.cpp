@@ -0,0 +1,159 @@
+/*
+ * decomp.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include <omp.h>
+#include <thread>
+#include "atto/opencl/opencl.hpp"
+#include "compute.hpp"
+#include "decomp.hpp"
+#include "engine.hpp"
+#include "io.hpp"
+#include "subdomain.hpp"
+#include "transport.hpp"
+using namespace atto;
+
+/** ---------------------------------------------------------------------------
+ * prepare
+ * @brief Setup the initial configuration with a serial engine.
+ */
+static void prepare(Engine &engine)
+{
+    engine.setup();
+    engine.generate();
+    engine.reset(0.5 * Params::pair_sigma);
+    size_t n_steps = engine.minimize(Params::n_min_steps, Params::min_force_tol);
+    std::cout << "minimize " << n_steps << " steps\n";
+    engine.reset(Params::pair_r_hard * Params::pair_sigma);
+}
+
+/** ---------------------------------------------------------------------------
+ * decomp
+ * @brief Run the model on a spatial domain decomposition. Rank 0 writes the
+ * sampler log, and the gathered xyz snapshot and sampler statistics.
+ */
+void decomp(const size_t n_ranks)
+{
+    core_assert(n_ranks > 0, "invalid number of ranks");
+
+    /* Setup the initial configuration with a serial engine. */
+    Engine engine;
+    prepare(engine);
+
+    /* Run each rank on its own thread, with serial reductions. */
+    Loopback loopback(n_ranks);
+    auto run = [&] (const size_t rank) {
+        omp_set_num_threads(1);
+        LoopbackTransport transport(loopback, rank);
+        Subdomain subdomain;
+        subdomain.setup(&transport, engine);
+
+        for (size_t step = 1; step <= Params::n_run_steps; ++step) {
+            subdomain.execute();
+            if (step % Params::sample_frequency == 0) {
+                std::string log = subdomain.sample();
+                if (rank == 0) {
+                    std::cout << "step " << step << "\n" << log << "\n";
+                }
+            }
+        }
+
+        std::vector<Atom> atoms = subdomain.gather();
+        if (rank == 0) {
+            core::FileOut fileout;
+
+            fileout.open("/tmp/out.xyz");
+            io::write_xyz(atoms, "model", fileout);
+            fileout.close();
+
+            subdomain.m_sampler.statistics();
+            fileout.open("/tmp/out.sampler");
+            fileout.writeline(subdomain.m_sampler.to_string());
+            fileout.close();
+
+            std::cout << subdomain.m_sampler.to_string() << "\n";
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t rank = 0; rank < n_ranks; ++rank) {
+        threads.emplace_back(run, rank);
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * deviation
+ * @brief Return the deviation of two values, relative to the first value and
+ * absolute for values smaller than one.
+ */
+static double deviation(const double a, const double b)
+{
+    return std::fabs(a - b) / std::max(std::fabs(a), 1.0);
+}
+
+/** ---------------------------------------------------------------------------
+ * decomp_check
+ * @brief Run a serial engine and a single rank decomposition from the same
+ * initial configuration, and compare the thermostat and the thermodynamic
+ * properties after each step. The two engines differ in the order of the
+ * pair force sums alone, so the deviation starts at round-off level.
+ */
+double decomp_check(const size_t n_steps)
+{
+    core_assert(Params::respa_n_inner == 1,
+        "domain decomposition does not support multiple time steps");
+
+    /* Setup the serial engine and the single rank subdomain. */
+    Engine engine;
+    prepare(engine);
+
+    Loopback loopback(1);
+    LoopbackTransport transport(loopback, 0);
+    Subdomain subdomain;
+    subdomain.setup(&transport, engine);
+
+    double dev_max = 0.0;
+    for (size_t step = 1; step <= n_steps; ++step) {
+        engine.execute();
+        subdomain.execute();
+
+        Thermo serial = compute::thermo(
+            compute::thermo_sums(engine.m_atoms, engine.m_atoms.size()),
+            engine.m_domain);
+        Thermo single = compute::thermo(
+            compute::thermo_sums(subdomain.m_atoms, subdomain.m_n_owned),
+            subdomain.m_domain);
+
+        const double dev[] = {
+            deviation(engine.m_thermostat.eta, subdomain.m_thermostat.eta),
+            deviation(serial.energy_kin, single.energy_kin),
+            deviation(serial.energy_pot, single.energy_pot),
+            deviation(serial.temp_kinetic, single.temp_kinetic),
+            deviation(serial.com_upos.x, single.com_upos.x),
+            deviation(serial.com_upos.y, single.com_upos.y),
+            deviation(serial.com_upos.z, single.com_upos.z),
+            deviation(serial.pres_virial.xx, single.pres_virial.xx),
+            deviation(serial.pres_virial.yy, single.pres_virial.yy),
+            deviation(serial.pres_virial.zz, single.pres_virial.zz)};
+        double dev_step = *std::max_element(std::begin(dev), std::end(dev));
+        dev_max = std::max(dev_max, dev_step);
+
+        if (step % Params::sample_frequency == 0) {
+            std::cout << core::str_format(
+                "step %lu energy_pot %.12lf %.12lf deviation %le\n",
+                step, serial.energy_pot, single.energy_pot, dev_step);
+        }
+    }
+
+    return dev_max;
+}
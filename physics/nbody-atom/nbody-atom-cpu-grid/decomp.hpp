@@ -0,0 +1,32 @@
+/*
+ * decomp.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef MD_DECOMP_H_
+#define MD_DECOMP_H_
+
+#include "atto/opencl/opencl.hpp"
+#include "base.hpp"
+
+/**
+ * @brief Run the model on a spatial domain decomposition with the specified
+ * number of ranks, each rank running on its own thread over a loopback
+ * transport. The initial configuration is prepared by a serial engine.
+ */
+void decomp(const size_t n_ranks);
+
+/**
+ * @brief Check a single rank decomposition reproduces the serial engine step
+ * for step over the specified number of steps, and return the largest
+ * relative deviation of the thermostat and thermodynamic properties.
+ */
+double decomp_check(const size_t n_steps);
+
+#endif /* MD_DECOMP_H_ */
@@ -9,6 +9,8 @@
  * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
  */
 
+#include <omp.h>
+#include <random>
 #include "atto/opencl/opencl.hpp"
 #include "engine.hpp"
 using namespace atto;
@@ -23,11 +25,37 @@ void Engine::setup(void)
     m_atoms.resize(Params::n_atoms, Atom{
         .mass = Params::atom_mass,          /* atom mass */
         .rmass = 1.0 / Params::atom_mass,   /* inverse mass */
+        .type = 0,                          /* atom type */
+        .charge = 0.0,                      /* atom charge */
         .pos = math::vec3d{},               /* periodic image in primary cell */
         .upos = math::vec3d{},              /* unfolded position */
         .mom = math::vec3d{},               /* momentum */
         .force = math::vec3d{}});           /* force */
 
+    /*
+     * Assign the atom types in contiguous blocks with the specified number
+     * fractions. Atoms are kept sorted by type, so the force kernel reads
+     * the same row of the type pair table along each block.
+     */
+    core_assert(Params::n_types <= Field::max_types, "invalid number of types");
+    {
+        size_t atom_ix = 0;
+        for (uint32_t type = 0; type < Params::n_types; ++type) {
+            size_t count = (size_t) (Params::type_fraction[type] * Params::n_atoms);
+            if (type + 1 == Params::n_types) {
+                count = Params::n_atoms - atom_ix;
+            }
+
+            double mass = Params::atom_mass * Params::type_mass[type];
+            for (size_t end = atom_ix + count; atom_ix < end; ++atom_ix) {
+                m_atoms[atom_ix].mass = mass;
+                m_atoms[atom_ix].rmass = 1.0 / mass;
+                m_atoms[atom_ix].type = type;
+                m_atoms[atom_ix].charge = Params::type_charge[type];
+            }
+        }
+    }
+
     /* Create fluid domain. */
     double volume = (double) Params::n_atoms / Params::density;
     double length = std::pow(volume, 1.0 / 3.0);
@@ -35,13 +63,49 @@ void Engine::setup(void)
         math::vec3d{length, length, length},
         math::vec3d{0.5*length, 0.5*length, 0.5*length}};
 
-    /* Create fluid force field. */
-    m_field = Field{
-        Params::pair_epsilon,
-        Params::pair_sigma,
-        Params::pair_r_cut * Params::pair_sigma,
-        Params::pair_r_skin * Params::pair_sigma,
-        Params::pair_r_hard * Params::pair_sigma};
+    /*
+     * Create fluid force field. Mix the coefficients of each type pair using
+     * Lorentz-Berthelot rules, with a cutoff radius scaled by the pair size.
+     */
+    m_field = Field{};
+    m_field.n_types = Params::n_types;
+    m_field.r_cut = 0.0;
+    m_field.r_skin = Params::pair_r_skin * Params::pair_sigma;
+    m_field.r_hard = Params::pair_r_hard * Params::pair_sigma;
+    m_field.r_inner = Params::respa_r_inner * Params::pair_sigma;
+    m_field.r_heal = Params::respa_r_heal * Params::pair_sigma;
+    core_assert(m_field.r_heal < m_field.r_inner, "invalid RESPA healing length");
+    for (size_t type_1 = 0; type_1 < Params::n_types; ++type_1) {
+        for (size_t type_2 = 0; type_2 < Params::n_types; ++type_2) {
+            double epsilon = Params::pair_epsilon * std::sqrt(
+                Params::type_epsilon[type_1] * Params::type_epsilon[type_2]);
+            double sigma = Params::pair_sigma * 0.5 * (
+                Params::type_sigma[type_1] + Params::type_sigma[type_2]);
+            double r_cut = Params::pair_r_cut * sigma;
+
+            m_field.pairs[type_1 * Field::max_types + type_2] = FieldPair{
+                epsilon, sigma, r_cut, r_cut * r_cut};
+            m_field.r_cut = std::max(m_field.r_cut, r_cut);
+        }
+    }
+
+    /*
+     * Setup the particle mesh Ewald solver if any atom type is charged. The
+     * real space sum is truncated at the largest cutoff radius, with erfc(3)
+     * ~ 2e-5 for the default splitting parameter.
+     */
+    m_field.alpha = Params::ewald_alpha / m_field.r_cut;
+    m_pme = Pme{};
+    for (size_t type = 0; type < Params::n_types; ++type) {
+        if (Params::type_charge[type] != 0.0) {
+            m_pme.setup(
+                m_domain,
+                m_field.alpha,
+                Params::ewald_n_mesh,
+                Params::ewald_order);
+            break;
+        }
+    }
 
     /* Setup thermostat */
     m_thermostat = Thermostat{
@@ -67,8 +131,19 @@ void Engine::setup(void)
         .pres_kinetic = math::mat3d{},      /* Kinetic pressure */
         .pres_virial = math::mat3d{}};      /* Virial pressure */
 
+    /* Setup the g(r) histogram over the largest pair cutoff. */
+    m_structure.setup(m_field.r_cut);
+
+    /* Setup the atom and shear stress correlators. */
+    m_msd.setup(Correlator::SquareDistance, 3 * Params::n_atoms);
+    m_vacf.setup(Correlator::Product, 3 * Params::n_atoms);
+    m_sacf.setup(Correlator::Product, 3);
+
     /* Setup grid. */
-    m_grid = Grid(m_domain.length, Params::pair_r_cut, Params::n_neighbours);
+    m_grid = Grid(m_domain.length, m_field.r_cut, Params::n_neighbours);
+
+    /* The forces are computed by the first integration step. */
+    m_force_reset = true;
 }
 
 /**
@@ -77,17 +152,65 @@ void Engine::setup(void)
  */
 void Engine::teardown(void)
 {
-    /* Write xyz snapshot and sampler statistics. */
+    md_profile_scope(m_profiler, Profiler::PhaseIO);
+
+    /* Write xyz snapshot, model parameters and sampler statistics. */
     core::FileOut fileout;
 
     fileout.open("/tmp/out.xyz");
     io::write_xyz(m_atoms, "model", fileout);
     fileout.close();
 
+    fileout.open("/tmp/out.params");
+    fileout.writeline(Params::to_string());
+    fileout.close();
+
     m_sampler.statistics();
     fileout.open("/tmp/out.sampler");
     fileout.writeline(m_sampler.to_string());
     fileout.close();
+
+    /* Write g(r) and S(k). */
+    fileout.open("/tmp/out.rdf");
+    fileout.writeline(m_structure.rdf_string(m_atoms.size(), m_domain));
+    fileout.close();
+
+    fileout.open("/tmp/out.sk");
+    fileout.writeline(m_structure.sk_string(m_domain));
+    fileout.close();
+
+    /*
+     * Write the MSD and VACF per atom, and the shear stress autocorrelation
+     * averaged over the off-diagonal components with the Green-Kubo viscosity
+     * eta(t) = V/kT int_0^t <P_ab(0) P_ab(s)> ds.
+     */
+    {
+        const double t_sample = Params::corr_frequency * Params::t_step;
+        const double volume = m_domain.length.x *
+                              m_domain.length.y *
+                              m_domain.length.z;
+
+        fileout.open("/tmp/out.msd");
+        fileout.writeline(m_msd.to_string(t_sample, 1.0 / Params::n_atoms));
+        fileout.close();
+
+        fileout.open("/tmp/out.vacf");
+        fileout.writeline(m_vacf.to_string(t_sample, 1.0 / Params::n_atoms));
+        fileout.close();
+
+        fileout.open("/tmp/out.sacf");
+        fileout.writeline(m_sacf.to_string(
+            t_sample, 1.0 / 3.0, volume / m_thermostat.temperature));
+        fileout.close();
+    }
+
+#ifdef MD_PROFILE
+    /* Write profiler trace. */
+    fileout.open("/tmp/out.trace.json");
+    m_profiler.write_trace(fileout);
+    fileout.close();
+#endif
+
     std::cout << m_sampler.to_string() << "\n";
 }
 
@@ -97,19 +220,43 @@ void Engine::teardown(void)
  */
 void Engine::execute(void)
 {
+    md_profile_count(m_profiler, Profiler::CounterSteps, 1);
+
+    /* Integrate with multiple time steps if enabled. */
+    if (Params::respa_n_inner > 1) {
+        execute_respa();
+        return;
+    }
+
     const double half_t_step = 0.5 * Params::t_step;
 
+    /*
+     * Compute the forces if the fluid state was reset. Otherwise the first
+     * half step uses the forces computed at the end of the previous step.
+     */
+    if (m_force_reset) {
+        update();
+        compute_forces();
+        m_force_reset = false;
+    }
+
     /*
      * Update fluid state and associated data structures.
      */
     {
-        /* Apply pbc to the fluid particle positions and reset atom forces. */
+        md_profile_scope(m_profiler, Profiler::PhaseUpdate);
+
+        /* Apply pbc to the fluid particle positions. */
         for (auto &atom : m_atoms) {
             atom.pos = compute::pbc(atom.pos, m_domain);
-            atom.force = math::vec3d{};
         }
+    }
+
+    {
+        md_profile_scope(m_profiler, Profiler::PhaseNeighbours);
 
         /* Insert the atom positions into the grid. */
+        md_profile_count(m_profiler, Profiler::CounterRebuilds, 1);
         m_grid.insert(m_atoms);
     }
 
@@ -117,6 +264,8 @@ void Engine::execute(void)
      * Begin integration - first half of the integration step.
      */
     {
+        md_profile_scope(m_profiler, Profiler::PhaseIntegrate);
+
         /* Integrate the atoms at half time step. */
         double exp_eta = exp(-m_thermostat.eta * half_t_step);
         for (auto &atom : m_atoms) {
@@ -126,6 +275,10 @@ void Engine::execute(void)
             atom.pos += atom.mom * atom.rmass * Params::t_step;
             atom.upos += atom.mom * atom.rmass * Params::t_step;
         }
+    }
+
+    {
+        md_profile_scope(m_profiler, Profiler::PhaseThermostat);
 
         /* Integrate thermostat half time step. */
         double grad_sq;
@@ -139,25 +292,14 @@ void Engine::execute(void)
     /*
      * Compute fluid forces.
      */
-    {
-        core_pragma_omp(parallel for default(none) \
-            shared(m_atoms, m_domain, m_field) schedule(dynamic))
-        for (size_t atom_ix = 0; atom_ix < Params::n_atoms; ++atom_ix) {
-            compute::force_atom(
-                atom_ix,
-                Params::n_atoms,
-                Params::n_neighbours,
-                m_atoms,
-                m_domain,
-                m_field,
-                m_grid);
-        }
-    }
+    compute_forces();
 
     /*
      * End integration - second half of the integration step.
      */
     {
+        md_profile_scope(m_profiler, Profiler::PhaseThermostat);
+
         /* Integrate thermostat half time step. */
         double grad_sq;
         double laplace;
@@ -165,6 +307,10 @@ void Engine::execute(void)
         double force = grad_sq - m_thermostat.temperature * laplace;
         m_thermostat.deta_dt = force / m_thermostat.mass;
         m_thermostat.eta += half_t_step * m_thermostat.deta_dt;
+    }
+
+    {
+        md_profile_scope(m_profiler, Profiler::PhaseIntegrate);
 
         /* Integrate momenta half time step. */
         double exp_eta = exp(-m_thermostat.eta * half_t_step);
@@ -175,14 +321,289 @@ void Engine::execute(void)
     }
 }
 
+/**
+ * Engine::execute_respa
+ * @brief Execute one r-RESPA multiple time step integration step.
+ *
+ * The pair force is split into an inner shell of short range interactions,
+ * integrated with n_inner substeps of size t_step/n_inner, and an outer shell
+ * of long range interactions, integrated at the full time step, Tuckerman et
+ * al, J. Chem. Phys. 97, 1990 (1992). The atom forces hold the total force,
+ * and the inner shell force is the difference to the outer shell force.
+ */
+void Engine::execute_respa(void)
+{
+    const double half_t_step = 0.5 * Params::t_step;
+    const double t_step_inner = Params::t_step / Params::respa_n_inner;
+    const double half_t_step_inner = 0.5 * t_step_inner;
+
+    /*
+     * Compute the shell forces if the fluid state was reset.
+     */
+    if (m_force_reset) {
+        update();
+        compute_forces_respa();
+        m_force_reset = false;
+    }
+
+    /*
+     * Begin integration - outer shell forces at half time step.
+     */
+    {
+        md_profile_scope(m_profiler, Profiler::PhaseIntegrate);
+
+        /* Integrate the atom momenta at half time step. */
+        double exp_eta = exp(-m_thermostat.eta * half_t_step);
+        for (size_t atom_ix = 0; atom_ix < m_atoms.size(); ++atom_ix) {
+            m_atoms[atom_ix].mom += m_force_outer[atom_ix] * half_t_step;
+            m_atoms[atom_ix].mom *= exp_eta;
+        }
+    }
+
+    {
+        md_profile_scope(m_profiler, Profiler::PhaseThermostat);
+
+        /* Integrate thermostat half time step. */
+        double grad_sq;
+        double laplace;
+        compute::temperature_kin(m_atoms, grad_sq, laplace);
+        double force = grad_sq - m_thermostat.temperature * laplace;
+        m_thermostat.deta_dt = force / m_thermostat.mass;
+        m_thermostat.eta += half_t_step * m_thermostat.deta_dt;
+    }
+
+    /*
+     * Integrate the inner shell forces with velocity Verlet substeps.
+     */
+    for (size_t step = 0; step < Params::respa_n_inner; ++step) {
+        {
+            md_profile_scope(m_profiler, Profiler::PhaseIntegrate);
+            for (size_t atom_ix = 0; atom_ix < m_atoms.size(); ++atom_ix) {
+                Atom &atom = m_atoms[atom_ix];
+                atom.mom += (atom.force - m_force_outer[atom_ix]) * half_t_step_inner;
+                atom.pos += atom.mom * atom.rmass * t_step_inner;
+                atom.upos += atom.mom * atom.rmass * t_step_inner;
+            }
+        }
+
+        update();
+        if (step + 1 < Params::respa_n_inner) {
+            /* Keep the outer shell forces and update the inner shell. */
+            for (size_t atom_ix = 0; atom_ix < m_atoms.size(); ++atom_ix) {
+                m_atoms[atom_ix].force = m_force_outer[atom_ix];
+                m_atoms[atom_ix].energy = 0.0;
+                m_atoms[atom_ix].virial = math::mat3d{};
+            }
+            accumulate_forces(compute::ShellInner);
+        } else {
+            /* Update both shells at the end of the step. */
+            compute_forces_respa();
+        }
+
+        {
+            md_profile_scope(m_profiler, Profiler::PhaseIntegrate);
+            for (size_t atom_ix = 0; atom_ix < m_atoms.size(); ++atom_ix) {
+                Atom &atom = m_atoms[atom_ix];
+                atom.mom += (atom.force - m_force_outer[atom_ix]) * half_t_step_inner;
+            }
+        }
+    }
+
+    /*
+     * End integration - outer shell forces at half time step.
+     */
+    {
+        md_profile_scope(m_profiler, Profiler::PhaseThermostat);
+
+        /* Integrate thermostat half time step. */
+        double grad_sq;
+        double laplace;
+        compute::temperature_kin(m_atoms, grad_sq, laplace);
+        double force = grad_sq - m_thermostat.temperature * laplace;
+        m_thermostat.deta_dt = force / m_thermostat.mass;
+        m_thermostat.eta += half_t_step * m_thermostat.deta_dt;
+    }
+
+    {
+        md_profile_scope(m_profiler, Profiler::PhaseIntegrate);
+
+        /* Integrate the atom momenta at half time step. */
+        double exp_eta = exp(-m_thermostat.eta * half_t_step);
+        for (size_t atom_ix = 0; atom_ix < m_atoms.size(); ++atom_ix) {
+            m_atoms[atom_ix].mom *= exp_eta;
+            m_atoms[atom_ix].mom += m_force_outer[atom_ix] * half_t_step;
+        }
+    }
+}
+
+/**
+ * Engine::update
+ * @brief Apply pbc to the atom positions and update the neighbour data
+ * structures.
+ */
+void Engine::update(void)
+{
+    {
+        md_profile_scope(m_profiler, Profiler::PhaseUpdate);
+        for (auto &atom : m_atoms) {
+            atom.pos = compute::pbc(atom.pos, m_domain);
+        }
+    }
+
+    md_profile_scope(m_profiler, Profiler::PhaseNeighbours);
+
+    /* Insert the atom positions into the grid. */
+    md_profile_count(m_profiler, Profiler::CounterRebuilds, 1);
+    m_grid.insert(m_atoms);
+}
+
+/**
+ * Engine::compute_forces
+ * @brief Compute the forces of the specified shell on all fluid atoms.
+ * The reciprocal space Ewald forces belong to the full and outer shells.
+ * Return the number of pair interactions.
+ */
+size_t Engine::compute_forces(const uint32_t shell)
+{
+    for (auto &atom : m_atoms) {
+        atom.force = math::vec3d{};
+        atom.energy = 0.0;
+        atom.virial = math::mat3d{};
+    }
+    size_t n_pairs = accumulate_forces(shell, m_structure.begin_frame());
+
+    /* Add the reciprocal space Ewald sum to the long range forces. */
+    if (m_pme.enabled()) {
+        md_profile_scope(m_profiler, Profiler::PhaseForce);
+        m_pme.compute(m_atoms);
+    }
+
+    return n_pairs;
+}
+
+/**
+ * Engine::accumulate_forces
+ * @brief Accumulate the forces of the specified shell on all fluid atoms,
+ * and the g(r) histogram of each thread if requested. Return the number of
+ * pair interactions.
+ */
+size_t Engine::accumulate_forces(const uint32_t shell, const bool sample_rdf)
+{
+    md_profile_scope(m_profiler, Profiler::PhaseForce);
+
+    const size_t n_atoms = Params::n_atoms;
+    const size_t n_neighbours = Params::n_neighbours;
+    size_t n_pairs = 0;
+    size_t n_overflows = 0;
+    core_pragma_omp(parallel for default(none) \
+        shared(m_atoms, m_domain, m_field, m_structure, shell, sample_rdf, n_atoms, n_neighbours) \
+        reduction(+:n_pairs, n_overflows) schedule(dynamic))
+    for (size_t atom_ix = 0; atom_ix < n_atoms; ++atom_ix) {
+        size_t count = compute::force_atom(
+            atom_ix,
+            n_atoms,
+            n_neighbours,
+            m_atoms,
+            m_domain,
+            m_field,
+            m_grid,
+            shell,
+            sample_rdf ? m_structure.histogram(omp_get_thread_num()) : nullptr);
+        n_pairs += count;
+        n_overflows += (count == n_neighbours) ? 1 : 0;
+    }
+
+    md_profile_count(m_profiler, Profiler::CounterAtoms, n_atoms);
+    md_profile_count(m_profiler, Profiler::CounterPairs, n_pairs);
+    md_profile_count(m_profiler, Profiler::CounterOverflows, n_overflows);
+
+    return n_pairs;
+}
+
+/**
+ * Engine::compute_forces_respa
+ * @brief Compute the outer shell forces, kept fixed over the inner substeps,
+ * and accumulate the inner shell forces onto the total atom forces.
+ */
+void Engine::compute_forces_respa(void)
+{
+    compute_forces(compute::ShellOuter);
+
+    m_force_outer.resize(m_atoms.size());
+    for (size_t atom_ix = 0; atom_ix < m_atoms.size(); ++atom_ix) {
+        m_force_outer[atom_ix] = m_atoms[atom_ix].force;
+    }
+
+    accumulate_forces(compute::ShellInner);
+}
+
+/** ---------------------------------------------------------------------------
+ * Engine::minimize
+ * @brief Relax the fluid atom positions towards a local energy minimum with
+ * the FIRE minimizer, updating the neighbour data structures and computing
+ * the forces at each step. The atom momenta are untouched, so the fluid
+ * temperature is recovered by the next reset.
+ */
+size_t Engine::minimize(const size_t n_steps, const double force_tol)
+{
+    return fire::minimize(m_atoms, n_steps, force_tol, [this] () {
+        update();
+        compute_forces();
+    });
+}
+
 /**
  * Engine::sample
  * @brief Sample fluid thermodynamic properties.
  */
 std::string Engine::sample(void)
 {
+    md_profile_scope(m_profiler, Profiler::PhaseSample);
     m_sampler.sample(m_atoms, m_domain);
+    m_structure.sample_sk(m_atoms, m_domain);
+
+#ifdef MD_PROFILE
+    /* Append the profiler window to the sample and start a new window. */
+    std::string log = m_sampler.log_string() + m_profiler.to_string();
+    m_profiler.reset();
+    return log;
+#else
     return m_sampler.log_string();
+#endif
+}
+
+/**
+ * Engine::correlate
+ * @brief Add the unfolded positions, the velocities and the off-diagonal
+ * pressure tensor components to the MSD, VACF and shear stress correlators.
+ */
+void Engine::correlate(void)
+{
+    md_profile_scope(m_profiler, Profiler::PhaseSample);
+
+    m_corr_values.resize(3 * m_atoms.size());
+    for (size_t ix = 0; ix < m_atoms.size(); ++ix) {
+        m_corr_values[3 * ix + 0] = m_atoms[ix].upos.x;
+        m_corr_values[3 * ix + 1] = m_atoms[ix].upos.y;
+        m_corr_values[3 * ix + 2] = m_atoms[ix].upos.z;
+    }
+    m_msd.add(m_corr_values.data());
+
+    for (size_t ix = 0; ix < m_atoms.size(); ++ix) {
+        math::vec3d vel = m_atoms[ix].mom * m_atoms[ix].rmass;
+        m_corr_values[3 * ix + 0] = vel.x;
+        m_corr_values[3 * ix + 1] = vel.y;
+        m_corr_values[3 * ix + 2] = vel.z;
+    }
+    m_vacf.add(m_corr_values.data());
+
+    math::mat3d pressure_kin = compute::pressure_kin(m_atoms, m_domain);
+    math::mat3d pressure_vir = compute::pressure_vir(m_atoms, m_domain);
+    const double stress[3] = {
+        pressure_kin.xy + pressure_vir.xy,
+        pressure_kin.xz + pressure_vir.xz,
+        pressure_kin.yz + pressure_vir.yz};
+    m_sacf.add(stress);
 }
 
 /** ---------------------------------------------------------------------------
@@ -191,18 +612,33 @@ std::string Engine::sample(void)
  */
 void Engine::generate(void)
 {
-    /* Generate atom positions at the specified density. */
+    /* Draw a random seed unless the seed is specified. */
+    if (Params::generate_seed == 0) {
+        std::random_device device;
+        Params::generate_seed = ((uint64_t) device() << 32) | device();
+        std::cout << core::str_format("generate seed %lu\n",
+            Params::generate_seed);
+    }
+    const uint64_t seed = Params::generate_seed;
+
+    /*
+     * Generate atom positions at the specified density, in the atom storage.
+     * Shuffle the lattice sites to mix the atom type blocks.
+     */
     {
         const double epsilon = 0.9;
         const math::vec3d half = m_domain.length_half * epsilon;
-        std::vector<math::vec3d> positions = generate::points_fcc(
-            Params::n_atoms, -half.x, -half.y, -half.z, half.x, half.y, half.z);
-
-        size_t ix = 0;
-        for (auto &pos : positions) {
-            m_atoms[ix].pos = pos;
-            m_atoms[ix].upos = pos;
-            ix++;
+        const bool shuffle = Params::n_types > 1;
+        if (Params::generate_poisson > 0.0) {
+            double spacing = std::cbrt(8.0 * half.x * half.y * half.z / m_atoms.size());
+            generate::points_poisson(
+                m_atoms.size(), -half.x, -half.y, -half.z, half.x, half.y, half.z,
+                Params::generate_poisson * spacing, seed, shuffle,
+                &m_atoms[0].pos, sizeof(Atom));
+        } else {
+            generate::points_fcc(
+                m_atoms.size(), -half.x, -half.y, -half.z, half.x, half.y, half.z,
+                seed, shuffle, &m_atoms[0].pos, sizeof(Atom));
         }
     }
 
@@ -212,15 +648,19 @@ void Engine::generate(void)
      * temperature.
      */
     {
-        math::rng::Kiss engine(true);       /* rng engine */
-        math::rng::gauss<double> rand;      /* rng sampler */
-
-        for (auto &atom : m_atoms) {
-            double sdev = std::sqrt(Params::temperature * atom.mass);
+        const size_t n_atoms = m_atoms.size();
+        const double temperature = Params::temperature;
+        const uint64_t key = generate::random(seed, generate::StreamMomenta);
+        core_pragma_omp(parallel for default(none) \
+            shared(n_atoms, temperature, key) schedule(static))
+        for (size_t atom_ix = 0; atom_ix < n_atoms; ++atom_ix) {
+            Atom &atom = m_atoms[atom_ix];
+            double sdev = std::sqrt(temperature * atom.mass);
+            atom.upos = atom.pos;
             atom.mom = math::vec3d{
-                rand(engine, 0.0, sdev),
-                rand(engine, 0.0, sdev),
-                rand(engine, 0.0, sdev)};
+                generate::gauss(key, 3 * atom_ix + 0),
+                generate::gauss(key, 3 * atom_ix + 1),
+                generate::gauss(key, 3 * atom_ix + 2)} * sdev;
         }
     }
 }
@@ -236,6 +676,9 @@ void Engine::reset(const double radius)
         m_field.r_hard = radius;
     }
 
+    /* Invalidate the atom forces, recomputed by the next integration step. */
+    m_force_reset = true;
+
     /*
      * Reset the fluid atom positions and momenta to the correct density
      * and temperature.
@@ -279,6 +722,18 @@ void Engine::reset(const double radius)
         }
     }
 
+    /*
+     * Rebuild the grid and the mesh solver for the rescaled domain.
+     */
+    m_grid = Grid(m_domain.length, m_field.r_cut, Params::n_neighbours);
+    if (m_pme.enabled()) {
+        m_pme.setup(
+            m_domain,
+            m_field.alpha,
+            Params::ewald_n_mesh,
+            Params::ewald_order);
+    }
+
     /*
      * Reset thermostat state.
      */
@@ -291,4 +746,8 @@ void Engine::reset(const double radius)
      * Reset sampler properties.
      */
     m_sampler.reset();
+    m_structure.reset();
+    m_msd.reset();
+    m_vacf.reset();
+    m_sacf.reset();
 }
@@ -16,65 +16,120 @@ using namespace atto;
 namespace generate {
 
 /** ---------------------------------------------------------------------------
- * points_random
- * @brief Create a set of points uniformly distributed inside a box with
- * the specified dimensions.
+ * random
+ * @brief Return a random 64-bit integer of the counter in the seed stream,
+ * using the splitmix64 finalizer as a counter based generator.
  */
-std::vector<math::vec3d> points_random(
-    const size_t n_points,
-    const double xlo,
-    const double ylo,
-    const double zlo,
-    const double xhi,
-    const double yhi,
-    const double zhi)
+uint64_t random(const uint64_t seed, const uint64_t counter)
 {
-    core_assert(n_points > 0, "invalid number of points");
-    core_assert(xlo < xhi && ylo < yhi && zlo < zhi, "invalid range");
+    auto mix = [] (uint64_t x) -> uint64_t {
+        x = (x ^ (x >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+        x = (x ^ (x >> 27)) * UINT64_C(0x94d049bb133111eb);
+        return x ^ (x >> 31);
+    };
+    return mix(mix(seed) + counter * UINT64_C(0x9e3779b97f4a7c15));
+}
 
-    math::rng::Kiss engine(true);           /* rng engine */
-    math::rng::uniform<double> rand;        /* rng sampler */
+/**
+ * uniform
+ * @brief Return a uniform random number in [0,1) of the counter in the seed
+ * stream, from the upper 53 bits of the random integer.
+ */
+double uniform(const uint64_t seed, const uint64_t counter)
+{
+    return (double) (random(seed, counter) >> 11) /
+           (double) (UINT64_C(1) << 53);
+}
 
-    std::vector<math::vec3d> points(n_points);
-    for (auto &it : points) {
-        it = math::vec3d{
-            rand(engine, xlo, xhi),
-            rand(engine, ylo, yhi),
-            rand(engine, zlo, zhi)};
+/**
+ * gauss
+ * @brief Return a normal random number with zero mean and unit variance of
+ * the counter in the seed stream, using the Box-Muller transform of the
+ * uniform random numbers of the counters 2*counter and 2*counter+1.
+ */
+double gauss(const uint64_t seed, const uint64_t counter)
+{
+    double u_1 = uniform(seed, 2 * counter);
+    double u_2 = uniform(seed, 2 * counter + 1);
+    return std::sqrt(-2.0 * std::log(1.0 - u_1)) * std::cos(2.0 * M_PI * u_2);
+}
+
+/**
+ * permute
+ * @brief Return the image of ix in a random permutation of [0,n), using a
+ * four round Feistel network over the smallest power of four domain holding
+ * n values. Images outside [0,n) are mapped again until they fall inside, so
+ * the permutation is a bijection of [0,n) computed without storage.
+ */
+size_t permute(const size_t ix, const size_t n, const uint64_t seed)
+{
+    size_t n_bits = 1;
+    while ((UINT64_C(1) << (2 * n_bits)) < n) {
+        ++n_bits;
     }
-    return points;
+    const uint64_t mask = (UINT64_C(1) << n_bits) - 1;
+
+    uint64_t value = ix;
+    do {
+        uint64_t left = value >> n_bits;
+        uint64_t right = value & mask;
+        for (uint64_t round = 0; round < 4; ++round) {
+            uint64_t next = left ^ (random(seed, (round << 32) | right) & mask);
+            left = right;
+            right = next;
+        }
+        value = (left << n_bits) | right;
+    } while (value >= n);
+    return value;
+}
+
+/** ---------------------------------------------------------------------------
+ * store
+ * @brief Return the point at index ix of the caller storage.
+ */
+static inline math::vec3d &store(
+    math::vec3d *points,
+    const size_t stride,
+    const size_t ix)
+{
+    return *reinterpret_cast<math::vec3d *>(
+        reinterpret_cast<char *>(points) + ix * stride);
 }
 
 /**
- * points_cubic
- * @brief Create a collection of points inside a simple cubic lattice with
- * the specified dimensions.
+ * points_lattice
+ * @brief Create a collection of points inside a cubic lattice with the
+ * specified unit cell basis sites, in units of the cell size.
+ *
+ * Compute the minimum number of lattice cells able to accomodate the
+ * specified number of points. A lattice with unit length has a cell size
+ * determined by the total number of cells along each dimension, a = 1.0 /
+ * n_cells. The points take evenly spaced sites, spreading the vacancies over
+ * the lattice, in lattice order or in a random order if shuffle is set.
  */
-std::vector<math::vec3d> points_cubic(
+static void points_lattice(
     const size_t n_points,
     const double xlo,
     const double ylo,
     const double zlo,
     const double xhi,
     const double yhi,
-    const double zhi)
+    const double zhi,
+    const std::vector<math::vec3d> &basis,
+    const uint64_t seed,
+    const bool shuffle,
+    math::vec3d *points,
+    const size_t stride)
 {
     core_assert(n_points > 0, "invalid number of points");
     core_assert(xlo < xhi && ylo < yhi && zlo < zhi, "invalid range");
 
-    /*
-     * Compute the minimum number of lattice cells able to accomodate the
-     * specified number of points. The unit cell of an ssc lattice contains
-     * a single site located at
-     *      r1 = (0, 0, 0)
-     * A scc lattice with unit length has a cell size determined by the
-     * total number of cells along each dimension a = 1.0 / n_cells.
-     */
+    const size_t n_basis = basis.size();
     size_t n_cells = 0;       /* number of unit cells in the lattice */
     size_t n_sites = 0;       /* number of sites in the lattice */
     while (n_sites < n_points) {
         ++n_cells;
-        n_sites = n_cells * n_cells * n_cells;
+        n_sites = n_basis * n_cells * n_cells * n_cells;
     }
 
     /* Specify the unit cell basis vectors. */
@@ -83,137 +138,300 @@ std::vector<math::vec3d> points_cubic(
         (yhi - ylo) / (double) n_cells,
         (zhi - zlo) / (double) n_cells};
 
-    /*
-     * Construct the fcc cubic lattice. Create an array of boolean values
-     * for each existing site. Shuffle the array using Knuth's algorithm.
-     */
-    std::vector<bool> is_valid(n_sites, false); /* is site valid? */
-    {
-        math::rng::Kiss engine(true);           /* rng engine */
-        math::rng::uniform<uint64_t> rand;      /* rng sampler */
+    const uint64_t key = random(seed, StreamSites);
+    core_pragma_omp(parallel for default(none) \
+        shared(n_points, xlo, ylo, zlo, basis, shuffle, points, stride, \
+        n_basis, n_cells, n_sites, cell, key) schedule(static))
+    for (size_t ix = 0; ix < n_points; ++ix) {
+        size_t point_ix = shuffle ? permute(ix, n_points, key) : ix;
+        size_t site_ix = (point_ix * n_sites) / n_points;
 
-        for (size_t i = 0; i < n_points; ++i) {
-            is_valid[i] = true;
-        }
+        size_t l = site_ix % n_basis;
+        site_ix /= n_basis;
+        size_t k = site_ix % n_cells;
+        site_ix /= n_cells;
+        size_t j = site_ix % n_cells;
+        size_t i = site_ix / n_cells;
 
-        for (size_t i = 0; i < n_sites-1; ++i) {
-            size_t j = rand(engine, 0, n_sites-i);
-            std::swap(is_valid[i], is_valid[j]);
-        }
+        store(points, stride, ix) = math::vec3d{
+            xlo + ((double) i + basis[l].x) * cell.x,
+            ylo + ((double) j + basis[l].y) * cell.y,
+            zlo + ((double) k + basis[l].z) * cell.z};
     }
+}
 
-    std::vector<math::vec3d> points;             /* lattice site positions */
-    {
-        size_t site_ix = 0;
-        for (size_t i = 0; i < n_cells; i++) {
-            for (size_t j = 0; j < n_cells; j++) {
-                for (size_t k = 0; k < n_cells; k++) {
-                    /* Store particle position */
-                    if (is_valid[site_ix]) {
-                        math::vec3d pos{
-                            (double) i * cell.x,
-                            (double) j * cell.y,
-                            (double) k * cell.z};
-                        points.push_back(pos);
-                    }
-                    site_ix++;  /* next lattice site */
-                }
-            }
-        }
+/** ---------------------------------------------------------------------------
+ * points_random
+ * @brief Create a set of points uniformly distributed inside a box with
+ * the specified dimensions.
+ */
+void points_random(
+    const size_t n_points,
+    const double xlo,
+    const double ylo,
+    const double zlo,
+    const double xhi,
+    const double yhi,
+    const double zhi,
+    const uint64_t seed,
+    math::vec3d *points,
+    const size_t stride)
+{
+    core_assert(n_points > 0, "invalid number of points");
+    core_assert(xlo < xhi && ylo < yhi && zlo < zhi, "invalid range");
+
+    const uint64_t key = random(seed, StreamPoints);
+    core_pragma_omp(parallel for default(none) \
+        shared(n_points, xlo, ylo, zlo, xhi, yhi, zhi, points, stride, key) \
+        schedule(static))
+    for (size_t ix = 0; ix < n_points; ++ix) {
+        store(points, stride, ix) = math::vec3d{
+            xlo + (xhi - xlo) * uniform(key, 3 * ix + 0),
+            ylo + (yhi - ylo) * uniform(key, 3 * ix + 1),
+            zlo + (zhi - zlo) * uniform(key, 3 * ix + 2)};
     }
-    return points;
+}
+
+/**
+ * points_cubic
+ * @brief Create a collection of points inside a simple cubic lattice with
+ * the specified dimensions. The unit cell of an scc lattice contains a single
+ * site located at
+ *      r1 = (0, 0, 0)
+ */
+void points_cubic(
+    const size_t n_points,
+    const double xlo,
+    const double ylo,
+    const double zlo,
+    const double xhi,
+    const double yhi,
+    const double zhi,
+    const uint64_t seed,
+    const bool shuffle,
+    math::vec3d *points,
+    const size_t stride)
+{
+    const std::vector<math::vec3d> basis{
+        math::vec3d{0.0, 0.0, 0.0}};
+    points_lattice(n_points, xlo, ylo, zlo, xhi, yhi, zhi, basis, seed,
+        shuffle, points, stride);
 }
 
 /**
  * points_fcc
  * @brief Create a collection of points inside a face centred cubic lattice
- * with specified dimensions.
+ * with specified dimensions. The unit cell of an fcc lattice contains four
+ * sites located at:
+ *      r1 = (0,     0,   0)
+ *      r2 = (0,   a/2, a/2)
+ *      r3 = (a/2,   0, a/2)
+ *      r4 = (a/2, a/2,   0)
+ * where a is the size of the unit cell.
  */
-std::vector<math::vec3d> points_fcc(
+void points_fcc(
     const size_t n_points,
     const double xlo,
     const double ylo,
     const double zlo,
     const double xhi,
     const double yhi,
-    const double zhi)
+    const double zhi,
+    const uint64_t seed,
+    const bool shuffle,
+    math::vec3d *points,
+    const size_t stride)
+{
+    const std::vector<math::vec3d> basis{
+        math::vec3d{0.0, 0.0, 0.0},
+        math::vec3d{0.0, 0.5, 0.5},
+        math::vec3d{0.5, 0.0, 0.5},
+        math::vec3d{0.5, 0.5, 0.0}};
+    points_lattice(n_points, xlo, ylo, zlo, xhi, yhi, zhi, basis, seed,
+        shuffle, points, stride);
+}
+
+/**
+ * points_poisson
+ * @brief Create a Poisson disk set of points inside a box, with no two points
+ * closer than the specified radius, by parallel dart throwing.
+ *
+ * The box is divided into cells of size at most radius/sqrt(3), holding at
+ * most one point each. The cells are coloured with a period one larger than
+ * the range of cells within the radius, so that cells of the same colour never
+ * see each other. Each round visits the colours in a random order, and every
+ * empty cell of a colour throws a candidate point at once, accepted if it
+ * keeps the minimum distance to the points of the neighbour cells. A cell
+ * stores the round of its accepted point only, and the point is recomputed
+ * from the seed, the cell and the round. The accepted points are independent
+ * of the number of threads.
+ *
+ * The rounds stop when the box holds the specified number of points, and the
+ * points take evenly spaced accepted points in cell order, in a random order
+ * if shuffle is set. The random sequential addition of points jams at a
+ * packing fraction near 0.38, bounding the radius to about 0.9 times the mean
+ * point spacing.
+ */
+void points_poisson(
+    const size_t n_points,
+    const double xlo,
+    const double ylo,
+    const double zlo,
+    const double xhi,
+    const double yhi,
+    const double zhi,
+    const double radius,
+    const uint64_t seed,
+    const bool shuffle,
+    math::vec3d *points,
+    const size_t stride)
 {
     core_assert(n_points > 0, "invalid number of points");
     core_assert(xlo < xhi && ylo < yhi && zlo < zhi, "invalid range");
+    core_assert(radius > 0.0, "invalid Poisson disk radius");
 
-    /*
-     * Compute the minimum number of lattice cells able to accomodate the
-     * specified number of points. The unit cell of an fcc lattice contains
-     * four sites located at:
-     *      r1 = (0,     0,   0)
-     *      r2 = (0,   a/2, a/2)
-     *      r3 = (a/2,   0, a/2)
-     *      r4 = (a/2, a/2,   0)
-     * where a is the size of the unit cell.
-     * A fcc lattice with unit length has a cell size determined by the
-     * total number of cells along each dimension a = 1.0 / n_cells.
-     */
-    size_t n_cells = 0;       /* number of unit cells in the lattice */
-    size_t n_sites = 0;       /* number of sites in the lattice */
-    while (n_sites < n_points) {
-        ++n_cells;
-        n_sites = 4 * n_cells * n_cells * n_cells;
-    }
-
-    /* Specify the unit cell basis vectors. */
+    /* Cell grid holding at most one point per cell. */
+    const double width = radius / std::sqrt(3.0);
+    const size_t nx = (size_t) std::ceil((xhi - xlo) / width);
+    const size_t ny = (size_t) std::ceil((yhi - ylo) / width);
+    const size_t nz = (size_t) std::ceil((zhi - zlo) / width);
+    const size_t n_cells = nx * ny * nz;
     const math::vec3d cell = math::vec3d{
-        (xhi - xlo) / (double) n_cells,
-        (yhi - ylo) / (double) n_cells,
-        (zhi - zlo) / (double) n_cells};
+        (xhi - xlo) / (double) nx,
+        (yhi - ylo) / (double) ny,
+        (zhi - zlo) / (double) nz};
 
-    std::array<math::vec3d,4> basis{
-        math::vec3d{         0.0,         0.0,         0.0},
-        math::vec3d{         0.0, 0.5f*cell.y, 0.5f*cell.z},
-        math::vec3d{ 0.5f*cell.x,         0.0, 0.5f*cell.z},
-        math::vec3d{ 0.5f*cell.x, 0.5f*cell.y,         0.0}};
+    /* Range of cells within the radius and colour period. */
+    const size_t n_reach = (size_t) std::ceil(
+        radius / std::min(cell.x, std::min(cell.y, cell.z)));
+    const size_t n_period = n_reach + 1;
+    const size_t n_colours = n_period * n_period * n_period;
 
-    /*
-     * Construct the fcc cubic lattice. Create an array of boolean values
-     * for each existing site. Shuffle the array using Knuth's algorithm.
-     */
-    std::vector<bool> is_valid(n_sites, false); /* is site valid? */
-    {
-        math::rng::Kiss engine(true);           /* rng engine */
-        math::rng::uniform<uint64_t> rand;      /* rng sampler */
+    /* Round of the accepted point of each cell, 0 if the cell is empty. */
+    const size_t n_rounds = 255;
+    std::vector<uint8_t> cell_round(n_cells, 0);
 
-        for (size_t i = 0; i < n_points; ++i) {
-            is_valid[i] = true;
-        }
+    const uint64_t key = random(seed, StreamPoints);
+    auto candidate = [&] (const size_t cell_ix, const size_t round) {
+        size_t i = cell_ix % nx;
+        size_t j = (cell_ix / nx) % ny;
+        size_t k = cell_ix / (nx * ny);
+        size_t counter = 3 * (cell_ix * n_rounds + round);
+        return math::vec3d{
+            xlo + ((double) i + uniform(key, counter + 0)) * cell.x,
+            ylo + ((double) j + uniform(key, counter + 1)) * cell.y,
+            zlo + ((double) k + uniform(key, counter + 2)) * cell.z};
+    };
 
-        for (size_t i = 0; i < n_sites-1; ++i) {
-            size_t j = rand(engine, 0, n_sites-i);
-            std::swap(is_valid[i], is_valid[j]);
-        }
-    }
+    /* Throw the candidate points of each colour in parallel. */
+    const double radius_sq = radius * radius;
+    size_t n_filled = 0;
+    for (size_t round = 1; round <= n_rounds && n_filled < n_points; ++round) {
+        const uint64_t order = random(key, round);
+        for (size_t ix = 0; ix < n_colours && n_filled < n_points; ++ix) {
+            size_t colour = permute(ix, n_colours, order);
+            size_t cx = colour % n_period;
+            size_t cy = (colour / n_period) % n_period;
+            size_t cz = colour / (n_period * n_period);
+            if (cx >= nx || cy >= ny || cz >= nz) {
+                continue;
+            }
+
+            size_t mx = (nx - cx + n_period - 1) / n_period;
+            size_t my = (ny - cy + n_period - 1) / n_period;
+            size_t mz = (nz - cz + n_period - 1) / n_period;
+
+            size_t n_accepted = 0;
+            core_pragma_omp(parallel for default(none) \
+                shared(nx, ny, nz, n_reach, n_period, cell_round, candidate, \
+                radius_sq, round, cx, cy, cz, mx, my, mz) \
+                reduction(+:n_accepted) schedule(static))
+            for (size_t colour_ix = 0; colour_ix < mx * my * mz; ++colour_ix) {
+                size_t i = cx + n_period * (colour_ix % mx);
+                size_t j = cy + n_period * ((colour_ix / mx) % my);
+                size_t k = cz + n_period * (colour_ix / (mx * my));
+                size_t cell_ix = i + nx * (j + ny * k);
+                if (cell_round[cell_ix] > 0) {
+                    continue;
+                }
 
-    std::vector<math::vec3d> points;             /* lattice site positions */
-    {
-        size_t site_ix = 0;
-        for (size_t i = 0; i < n_cells; i++) {
-            for (size_t j = 0; j < n_cells; j++) {
-                for (size_t k = 0; k < n_cells; k++) {
-                    for (size_t l = 0; l < 4; l++) {
-                        /* Store particle position */
-                        if (is_valid[site_ix]) {
-                            math::vec3d pos{
-                                (double) i * cell.x,
-                                (double) j * cell.y,
-                                (double) k * cell.z};
-                            pos += basis[l];
-                            points.push_back(pos);
+                math::vec3d pos = candidate(cell_ix, round);
+                bool is_free = true;
+                size_t k_end = std::min(k + n_reach + 1, nz);
+                size_t j_end = std::min(j + n_reach + 1, ny);
+                size_t i_end = std::min(i + n_reach + 1, nx);
+                for (size_t k2 = (k > n_reach ? k - n_reach : 0);
+                     is_free && k2 < k_end; ++k2) {
+                    for (size_t j2 = (j > n_reach ? j - n_reach : 0);
+                         is_free && j2 < j_end; ++j2) {
+                        for (size_t i2 = (i > n_reach ? i - n_reach : 0);
+                             is_free && i2 < i_end; ++i2) {
+                            size_t cell_ix2 = i2 + nx * (j2 + ny * k2);
+                            if (cell_round[cell_ix2] == 0) {
+                                continue;
+                            }
+                            math::vec3d r_12 = pos - candidate(
+                                cell_ix2, cell_round[cell_ix2]);
+                            is_free = math::dot(r_12, r_12) >= radius_sq;
                         }
-                        site_ix++;  /* next lattice site */
                     }
                 }
+
+                if (is_free) {
+                    cell_round[cell_ix] = (uint8_t) round;
+                    ++n_accepted;
+                }
+            }
+            n_filled += n_accepted;
+        }
+    }
+    core_assert(n_filled >= n_points, "Poisson disk radius too large");
+
+    /*
+     * Count the accepted points of each block of cells, and store the points
+     * at the offset of their block. The accepted point of rank r in cell
+     * order is stored if it is the closest rank to an evenly spaced rank
+     * ix * n_filled / n_points.
+     */
+    const size_t block_size = 1 << 16;
+    const size_t n_blocks = (n_cells + block_size - 1) / block_size;
+    std::vector<size_t> offset(n_blocks + 1, 0);
+
+    core_pragma_omp(parallel for default(none) \
+        shared(n_cells, block_size, n_blocks, offset, cell_round) \
+        schedule(static))
+    for (size_t block = 0; block < n_blocks; ++block) {
+        size_t end = std::min((block + 1) * block_size, n_cells);
+        for (size_t cell_ix = block * block_size; cell_ix < end; ++cell_ix) {
+            offset[block + 1] += (cell_round[cell_ix] > 0);
+        }
+    }
+    for (size_t block = 0; block < n_blocks; ++block) {
+        offset[block + 1] += offset[block];
+    }
+
+    const uint64_t order = random(seed, StreamSites);
+    core_pragma_omp(parallel for default(none) \
+        shared(n_points, shuffle, points, stride, n_cells, block_size, \
+        n_blocks, offset, cell_round, candidate, n_filled, order) \
+        schedule(static))
+    for (size_t block = 0; block < n_blocks; ++block) {
+        size_t rank = offset[block];
+        size_t end = std::min((block + 1) * block_size, n_cells);
+        for (size_t cell_ix = block * block_size; cell_ix < end; ++cell_ix) {
+            if (cell_round[cell_ix] == 0) {
+                continue;
+            }
+
+            size_t ix = (rank * n_points + n_filled - 1) / n_filled;
+            if (ix < n_points && (ix * n_filled) / n_points == rank) {
+                size_t point_ix = shuffle ? permute(ix, n_points, order) : ix;
+                store(points, stride, point_ix) = candidate(
+                    cell_ix, cell_round[cell_ix]);
             }
+            ++rank;
         }
     }
-    return points;
 }
 
 } /* generate */
@@ -11,6 +11,8 @@
 
 #include "atto/opencl/opencl.hpp"
 #include "model.hpp"
+#include "bench.hpp"
+#include "decomp.hpp"
 using namespace atto;
 
 /**
@@ -18,9 +20,48 @@ using namespace atto;
  */
 int main(int argc, char const *argv[])
 {
+    /*
+     * Load the model parameters from a configuration file and the parameter
+     * overrides of the command line:
+     *  md.out [mode] [--config filename] [name=value...]
+     */
+    std::vector<std::string> args = Params::parse(argc, argv);
+
+    /*
+     * Run the headless benchmark if requested:
+     *  md.out bench [n_steps] [forces filename]
+     */
+    if (args.size() > 1 && args[1] == "bench") {
+        size_t n_steps = args.size() > 2 ? core::str_cast<size_t>(args[2]) : 10;
+        std::string filename = args.size() > 3 ? args[3] : "/tmp/out.bench.forces";
+        bench("cpu-grid", n_steps, filename);
+        return EXIT_SUCCESS;
+    }
+
+    /*
+     * Check a single rank decomposition against the serial engine:
+     *  md.out decomp check [n_steps]
+     */
+    if (args.size() > 2 && args[1] == "decomp" && args[2] == "check") {
+        size_t n_steps = args.size() > 3 ? core::str_cast<size_t>(args[3]) : 100;
+        double deviation = decomp_check(n_steps);
+        std::cout << core::str_format("decomp check deviation %le\n", deviation);
+        return (deviation < 1.0e-6) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    /*
+     * Run the model on a domain decomposition if requested:
+     *  md.out decomp [n_ranks]
+     */
+    if (args.size() > 1 && args[1] == "decomp") {
+        size_t n_ranks = args.size() > 2 ? core::str_cast<size_t>(args[2]) : 8;
+        decomp(n_ranks);
+        return EXIT_SUCCESS;
+    }
+
     /* Execute the model */
     Model model;
     while (model.execute());
 
-    exit(EXIT_SUCCESS);
+    return EXIT_SUCCESS;
 }
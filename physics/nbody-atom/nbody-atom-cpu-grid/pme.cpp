@@ -0,0 +1,421 @@
+/*
+ * pme.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include "atto/opencl/opencl.hpp"
+#include "pme.hpp"
+#include "reduce.hpp"
+using namespace atto;
+
+/** ---------------------------------------------------------------------------
+ * Pme::bspline
+ * @brief Fill the weights M_p(w + p - 1 - j) of the cardinal B-spline of
+ * order p at the fractional offset w, and their derivatives, using the
+ * recursion M_n(x) = [x M_{n-1}(x) + (n - x) M_{n-1}(x - 1)] / (n - 1) and
+ * M_n'(x) = M_{n-1}(x) - M_{n-1}(x - 1).
+ */
+void Pme::bspline(const double w, double *spline, double *dspline) const
+{
+    const size_t p = m_order;
+
+    /* Order 2 B-spline. */
+    spline[p - 1] = 0.0;
+    spline[1] = w;
+    spline[0] = 1.0 - w;
+
+    /* Raise the B-spline order up to p - 1. */
+    for (size_t n = 3; n < p; ++n) {
+        double div = 1.0 / (double) (n - 1);
+        spline[n - 1] = div * w * spline[n - 2];
+        for (size_t k = 1; k < n - 1; ++k) {
+            spline[n - k - 1] = div * ((w + k) * spline[n - k - 2] +
+                                       (n - k - w) * spline[n - k - 1]);
+        }
+        spline[0] = div * (1.0 - w) * spline[0];
+    }
+
+    /* Differentiate the order p B-spline from the order p - 1 B-spline. */
+    dspline[0] = -spline[0];
+    for (size_t j = 1; j < p; ++j) {
+        dspline[j] = spline[j - 1] - spline[j];
+    }
+
+    /* Raise the B-spline to order p. */
+    double div = 1.0 / (double) (p - 1);
+    spline[p - 1] = div * w * spline[p - 2];
+    for (size_t k = 1; k < p - 1; ++k) {
+        spline[p - k - 1] = div * ((w + k) * spline[p - k - 2] +
+                                   (p - k - w) * spline[p - k - 1]);
+    }
+    spline[0] = div * (1.0 - w) * spline[0];
+}
+
+/**
+ * Pme::transform
+ * @brief In-place radix-2 FFT of the mesh lines along the specified dimension.
+ * The forward transform uses the kernel exp(2 pi i m k/n) and the inverse
+ * transform its conjugate, both unnormalized.
+ */
+void Pme::transform(const size_t dim, const bool inverse)
+{
+    const size_t n = m_n_mesh;
+    const size_t stride = (dim == 0) ? 1 : (dim == 1) ? n : n * n;
+
+    core_pragma_omp(parallel default(none) shared(n, stride, dim, inverse))
+    {
+        std::vector<std::complex<double>> line(n);
+
+        core_pragma_omp(for schedule(static))
+        for (size_t line_ix = 0; line_ix < n * n; ++line_ix) {
+            /* Offset of the first mesh point of the line. */
+            size_t a = line_ix % n;
+            size_t b = line_ix / n;
+            size_t offset = (dim == 0) ? b * n * n + a * n :
+                            (dim == 1) ? b * n * n + a :
+                                         b * n + a;
+
+            /* Load the line in bit reversed order. */
+            for (size_t k = 0; k < n; ++k) {
+                line[m_reverse[k]] = m_mesh[offset + k * stride];
+            }
+
+            /* Butterflies of increasing size. */
+            for (size_t size = 2; size <= n; size *= 2) {
+                size_t half = size / 2;
+                size_t step = n / size;
+                for (size_t start = 0; start < n; start += size) {
+                    for (size_t k = 0; k < half; ++k) {
+                        std::complex<double> w = m_twiddle[k * step];
+                        if (inverse) {
+                            w = std::conj(w);
+                        }
+                        std::complex<double> t = w * line[start + k + half];
+                        line[start + k + half] = line[start + k] - t;
+                        line[start + k] += t;
+                    }
+                }
+            }
+
+            /* Store the transformed line. */
+            for (size_t k = 0; k < n; ++k) {
+                m_mesh[offset + k * stride] = line[k];
+            }
+        }
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * Pme::spread
+ * @brief Compute the B-spline weights of each atom and spread the atom
+ * charges onto the mesh. The weights are kept for the force interpolation.
+ */
+void Pme::spread(const std::vector<Atom> &atoms)
+{
+    const size_t n = m_n_mesh;
+    const size_t p = m_order;
+    const size_t n_atoms = atoms.size();
+
+    m_base.resize(3 * n_atoms);
+    m_spline.resize(3 * n_atoms * p);
+    m_dspline.resize(3 * n_atoms * p);
+
+    /* Compute the B-spline weights along each dimension. */
+    core_pragma_omp(parallel for default(none) \
+        shared(atoms, n, p, n_atoms) schedule(static))
+    for (size_t atom_ix = 0; atom_ix < n_atoms; ++atom_ix) {
+        const double pos[3] = {
+            atoms[atom_ix].pos.x / m_length.x + 0.5,
+            atoms[atom_ix].pos.y / m_length.y + 0.5,
+            atoms[atom_ix].pos.z / m_length.z + 0.5};
+
+        for (size_t dim = 0; dim < 3; ++dim) {
+            /* Scaled fractional coordinate, wrapped into the mesh. */
+            double u = n * (pos[dim] - std::floor(pos[dim]));
+            size_t k0 = std::min((size_t) u, n - 1);
+
+            size_t ix = 3 * atom_ix + dim;
+            m_base[ix] = (k0 + n - p + 1) % n;
+            bspline(u - k0, &m_spline[ix * p], &m_dspline[ix * p]);
+        }
+    }
+
+    /* Spread the atom charges onto the mesh. */
+    std::fill(m_mesh.begin(), m_mesh.end(), std::complex<double>{});
+    for (size_t atom_ix = 0; atom_ix < n_atoms; ++atom_ix) {
+        const double charge = atoms[atom_ix].charge;
+        if (charge == 0.0) {
+            continue;
+        }
+
+        const size_t *base = &m_base[3 * atom_ix];
+        const double *spline_x = &m_spline[(3 * atom_ix + 0) * p];
+        const double *spline_y = &m_spline[(3 * atom_ix + 1) * p];
+        const double *spline_z = &m_spline[(3 * atom_ix + 2) * p];
+        for (size_t iz = 0; iz < p; ++iz) {
+            size_t z = (base[2] + iz) % n;
+            for (size_t iy = 0; iy < p; ++iy) {
+                size_t y = (base[1] + iy) % n;
+                double weight = charge * spline_z[iz] * spline_y[iy];
+                for (size_t ix = 0; ix < p; ++ix) {
+                    size_t x = (base[0] + ix) % n;
+                    m_mesh[(z * n + y) * n + x] += weight * spline_x[ix];
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Pme::convolve
+ * @brief Multiply the transformed charge mesh by the influence function.
+ * Return the reciprocal space energy and its virial,
+ *  W_ab = sum_m E(m) (delta_ab - 2 (1 + pi^2 m^2/alpha^2) m_a m_b / m^2).
+ */
+double Pme::convolve(math::mat3d &virial)
+{
+    const size_t n = m_n_mesh;
+    const size_t n_mesh = n * n * n;
+    const double coeff = M_PI * M_PI / (m_alpha * m_alpha);
+
+    /* Reciprocal vector of a mesh point. */
+    auto wave_vector = [&] (size_t mesh_ix) -> math::vec3d {
+        size_t kx = mesh_ix % n;
+        size_t ky = (mesh_ix / n) % n;
+        size_t kz = mesh_ix / (n * n);
+        return math::vec3d{
+            (kx <= n / 2 ? (double) kx : (double) kx - n) / m_length.x,
+            (ky <= n / 2 ? (double) ky : (double) ky - n) / m_length.y,
+            (kz <= n / 2 ? (double) kz : (double) kz - n) / m_length.z};
+    };
+
+    /* Reciprocal energy and virial, summed before the mesh is convolved. */
+    double energy = reduce::sum<double>(n_mesh, [&] (size_t mesh_ix) {
+        return 0.5 * m_influence[mesh_ix] * std::norm(m_mesh[mesh_ix]);
+    });
+
+    virial = reduce::sum<math::mat3d>(n_mesh, [&] (size_t mesh_ix) {
+        math::mat3d w = math::mat3d{};
+        const double influence = m_influence[mesh_ix];
+        if (influence == 0.0) {
+            return w;
+        }
+
+        math::vec3d m = wave_vector(mesh_ix);
+        double m_sq = math::dot(m, m);
+        double e = 0.5 * influence * std::norm(m_mesh[mesh_ix]);
+        double f = 2.0 * (1.0 + coeff * m_sq) / m_sq;
+        w.xx = e * (1.0 - f * m.x * m.x);
+        w.xy = -e * f * m.x * m.y;
+        w.xz = -e * f * m.x * m.z;
+        w.yy = e * (1.0 - f * m.y * m.y);
+        w.yz = -e * f * m.y * m.z;
+        w.zz = e * (1.0 - f * m.z * m.z);
+        w.yx = w.xy;
+        w.zx = w.xz;
+        w.zy = w.yz;
+        return w;
+    });
+
+    core_pragma_omp(parallel for default(none) shared(n_mesh) schedule(static))
+    for (size_t mesh_ix = 0; mesh_ix < n_mesh; ++mesh_ix) {
+        m_mesh[mesh_ix] *= m_influence[mesh_ix];
+    }
+
+    return energy;
+}
+
+/**
+ * Pme::interpolate
+ * @brief Interpolate the mesh potential onto the atoms. Add the energy
+ * q_i phi_i / 2 and the force -q_i grad phi_i of each atom.
+ */
+void Pme::interpolate(std::vector<Atom> &atoms)
+{
+    const size_t n = m_n_mesh;
+    const size_t p = m_order;
+    const size_t n_atoms = atoms.size();
+
+    core_pragma_omp(parallel for default(none) \
+        shared(atoms, n, p, n_atoms) schedule(static))
+    for (size_t atom_ix = 0; atom_ix < n_atoms; ++atom_ix) {
+        const double charge = atoms[atom_ix].charge;
+        if (charge == 0.0) {
+            continue;
+        }
+
+        const size_t *base = &m_base[3 * atom_ix];
+        const double *spline_x = &m_spline[(3 * atom_ix + 0) * p];
+        const double *spline_y = &m_spline[(3 * atom_ix + 1) * p];
+        const double *spline_z = &m_spline[(3 * atom_ix + 2) * p];
+        const double *dspline_x = &m_dspline[(3 * atom_ix + 0) * p];
+        const double *dspline_y = &m_dspline[(3 * atom_ix + 1) * p];
+        const double *dspline_z = &m_dspline[(3 * atom_ix + 2) * p];
+
+        double phi = 0.0;
+        math::vec3d grad{};
+        for (size_t iz = 0; iz < p; ++iz) {
+            size_t z = (base[2] + iz) % n;
+            for (size_t iy = 0; iy < p; ++iy) {
+                size_t y = (base[1] + iy) % n;
+                for (size_t ix = 0; ix < p; ++ix) {
+                    size_t x = (base[0] + ix) % n;
+                    double value = m_mesh[(z * n + y) * n + x].real();
+                    phi    += value * spline_x[ix] * spline_y[iy] * spline_z[iz];
+                    grad.x += value * dspline_x[ix] * spline_y[iy] * spline_z[iz];
+                    grad.y += value * spline_x[ix] * dspline_y[iy] * spline_z[iz];
+                    grad.z += value * spline_x[ix] * spline_y[iy] * dspline_z[iz];
+                }
+            }
+        }
+
+        /* Scale the gradient from mesh to domain coordinates. */
+        atoms[atom_ix].force.x -= charge * grad.x * n / m_length.x;
+        atoms[atom_ix].force.y -= charge * grad.y * n / m_length.y;
+        atoms[atom_ix].force.z -= charge * grad.z * n / m_length.z;
+        atoms[atom_ix].energy += 0.5 * charge * phi;
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * Pme::compute
+ * @brief Add the reciprocal space energies and forces to the atoms, together
+ * with the self energy -alpha/sqrt(pi) q_i^2 and the energy of a neutralising
+ * background if the net charge is nonzero. The reciprocal space and background
+ * virials are shared evenly over the atoms. Return the total energy.
+ */
+double Pme::compute(std::vector<Atom> &atoms)
+{
+    if (!enabled() || atoms.empty()) {
+        return 0.0;
+    }
+
+    /* Reciprocal space energy and forces. */
+    spread(atoms);
+    transform(0, false);
+    transform(1, false);
+    transform(2, false);
+
+    math::mat3d virial;
+    double energy = convolve(virial);
+
+    transform(0, true);
+    transform(1, true);
+    transform(2, true);
+    interpolate(atoms);
+
+    /* Self energy and net charge. */
+    const double self_coeff = -m_alpha / std::sqrt(M_PI);
+    double charge_sum = 0.0;
+    for (auto &atom : atoms) {
+        double self = self_coeff * atom.charge * atom.charge;
+        atom.energy += self;
+        energy += self;
+        charge_sum += atom.charge;
+    }
+
+    /* Neutralising background energy -pi Q^2 / (2 V alpha^2). */
+    const double volume = m_length.x * m_length.y * m_length.z;
+    const double background = -M_PI * charge_sum * charge_sum /
+        (2.0 * volume * m_alpha * m_alpha);
+    energy += background;
+    virial.xx += background;
+    virial.yy += background;
+    virial.zz += background;
+
+    /* Share the background energy and the virial over the atoms. */
+    const double scale = 1.0 / (double) atoms.size();
+    for (auto &atom : atoms) {
+        atom.energy += background * scale;
+        atom.virial += virial * scale;
+    }
+
+    return energy;
+}
+
+/**
+ * Pme::setup
+ * @brief Setup the mesh, the FFT tables, the B-spline moduli and the influence
+ * function over the specified domain.
+ */
+void Pme::setup(
+    const Domain &domain,
+    const double alpha,
+    const size_t n_mesh,
+    const size_t order)
+{
+    core_assert(n_mesh >= 2 && (n_mesh & (n_mesh - 1)) == 0,
+        "mesh size must be a power of two");
+    core_assert(order >= 3 && order <= n_mesh, "invalid B-spline order");
+    core_assert(alpha > 0.0, "invalid Ewald parameter");
+
+    m_n_mesh = n_mesh;
+    m_order = order;
+    m_alpha = alpha;
+    m_length = domain.length;
+    m_mesh.assign(n_mesh * n_mesh * n_mesh, std::complex<double>{});
+
+    /* FFT twiddle factors and bit reversal permutation. */
+    m_twiddle.resize(n_mesh / 2);
+    for (size_t k = 0; k < n_mesh / 2; ++k) {
+        m_twiddle[k] = std::polar(1.0, 2.0 * M_PI * k / n_mesh);
+    }
+
+    m_reverse.resize(n_mesh);
+    for (size_t k = 0; k < n_mesh; ++k) {
+        size_t rev = 0;
+        for (size_t bit = 1, r_bit = n_mesh / 2; bit < n_mesh; bit *= 2, r_bit /= 2) {
+            if (k & bit) {
+                rev |= r_bit;
+            }
+        }
+        m_reverse[k] = rev;
+    }
+
+    /*
+     * B-spline moduli |b(m)|^2 = 1 / |sum_k M_p(k + 1) exp(2 pi i m k/n)|^2,
+     * with the B-spline values at the integers from the weights at w = 0.
+     */
+    std::vector<double> spline(order);
+    std::vector<double> dspline(order);
+    bspline(0.0, spline.data(), dspline.data());
+
+    m_modulus.resize(n_mesh);
+    for (size_t m = 0; m < n_mesh; ++m) {
+        std::complex<double> sum{};
+        for (size_t k = 0; k + 1 < order; ++k) {
+            sum += spline[order - 2 - k] * std::polar(1.0, 2.0 * M_PI * m * k / n_mesh);
+        }
+        core_assert(std::norm(sum) > 1.0e-10, "singular B-spline modulus");
+        m_modulus[m] = 1.0 / std::norm(sum);
+    }
+
+    /* Influence function exp(-pi^2 m^2/alpha^2) / (pi V m^2) B(m). */
+    const double volume = m_length.x * m_length.y * m_length.z;
+    const double coeff = M_PI * M_PI / (alpha * alpha);
+    m_influence.resize(n_mesh * n_mesh * n_mesh);
+    for (size_t kz = 0; kz < n_mesh; ++kz) {
+        for (size_t ky = 0; ky < n_mesh; ++ky) {
+            for (size_t kx = 0; kx < n_mesh; ++kx) {
+                double mx = (kx <= n_mesh / 2 ? (double) kx : (double) kx - n_mesh) / m_length.x;
+                double my = (ky <= n_mesh / 2 ? (double) ky : (double) ky - n_mesh) / m_length.y;
+                double mz = (kz <= n_mesh / 2 ? (double) kz : (double) kz - n_mesh) / m_length.z;
+                double m_sq = mx * mx + my * my + mz * mz;
+
+                size_t ix = (kz * n_mesh + ky) * n_mesh + kx;
+                if (m_sq == 0.0) {
+                    m_influence[ix] = 0.0;
+                    continue;
+                }
+                m_influence[ix] = std::exp(-coeff * m_sq) / (M_PI * volume * m_sq) *
+                    m_modulus[kx] * m_modulus[ky] * m_modulus[kz];
+            }
+        }
+    }
+}
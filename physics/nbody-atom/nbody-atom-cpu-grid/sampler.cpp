@@ -103,28 +103,37 @@ void Sampler::reset(void)
  * @brief Sample sampler properties.
  */
 void Sampler::sample(std::vector<Atom> &atoms, const Domain &domain)
+{
+    sample(compute::thermo(compute::thermo_sums(atoms, atoms.size()), domain));
+}
+
+/**
+ * Sampler::sample
+ * @brief Sample the specified thermodynamic properties, e.g. computed from
+ * the thermodynamic sums reduced over the ranks of a domain decomposition.
+ */
+void Sampler::sample(const Thermo &thermo)
 {
     /* Sample a new sampler block item */
     {
-        double com_mass = compute::com_mass(atoms);
-        math::vec3d com_pos = compute::com_pos(atoms);
-        math::vec3d com_upos = compute::com_upos(atoms);
-        math::vec3d com_vel = compute::com_vel(atoms);
-        math::vec3d com_mom = compute::com_mom(atoms);
-        math::vec3d com_force = compute::com_force(atoms);
+        const double &com_mass = thermo.com_mass;
+        const math::vec3d &com_pos = thermo.com_pos;
+        const math::vec3d &com_upos = thermo.com_upos;
+        const math::vec3d &com_vel = thermo.com_vel;
+        const math::vec3d &com_mom = thermo.com_mom;
+        const math::vec3d &com_force = thermo.com_force;
 
-        double density = compute::density(atoms, domain);
+        const double &density = thermo.density;
 
-        double energy_kin = compute::energy_kin(atoms);
-        double energy_pot = compute::energy_pot(atoms);
+        const double &energy_kin = thermo.energy_kin;
+        const double &energy_pot = thermo.energy_pot;
 
-        double temp_grad_sq;
-        double temp_laplace;
-        double temperature = compute::temperature_kin(
-                atoms, temp_grad_sq, temp_laplace);
+        const double &temp_grad_sq = thermo.temp_grad_sq;
+        const double &temp_laplace = thermo.temp_laplace;
+        const double &temperature = thermo.temp_kinetic;
 
-        math::mat3d pressure_kin = compute::pressure_kin(atoms, domain);
-        math::mat3d pressure_vir = compute::pressure_vir(atoms, domain);
+        const math::mat3d &pressure_kin = thermo.pres_kinetic;
+        const math::mat3d &pressure_vir = thermo.pres_virial;
 
         /* Fluid mass */
         m_item[COM_MASS] = com_mass;
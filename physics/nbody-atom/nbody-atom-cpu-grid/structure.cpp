@@ -0,0 +1,189 @@
+/*
+ * structure.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include <complex>
+#include <omp.h>
+#include "atto/opencl/opencl.hpp"
+#include "structure.hpp"
+using namespace atto;
+
+/**
+ * Structure::setup
+ * @brief Setup the per-thread g(r) histogram over [0, r_max).
+ */
+void Structure::setup(const double r_max)
+{
+    m_n_bins = Params::rdf_n_bins;
+    m_r_max = r_max;
+    m_n_threads = omp_get_max_threads();
+    reset();
+}
+
+/**
+ * Structure::reset
+ * @brief Clear the accumulated g(r) and S(k) samples.
+ */
+void Structure::reset(void)
+{
+    m_histogram.assign(m_n_threads * m_n_bins, 0);
+    m_n_passes = 0;
+    m_n_frames = 0;
+    m_n_samples = 0;
+    m_sk_sum.clear();
+    m_sk_count.clear();
+}
+
+/**
+ * Structure::begin_frame
+ * @brief Count a force pass and return true if it samples a g(r) frame.
+ */
+bool Structure::begin_frame(void)
+{
+    if (m_n_passes++ % Params::rdf_frequency != 0) {
+        return false;
+    }
+    m_n_frames++;
+    return true;
+}
+
+/** ---------------------------------------------------------------------------
+ * Structure::sample_sk
+ * @brief Sample the structure factor, every sk_frequency calls, over the wave vectors k = 2 pi n / L
+ * with |n| <= sk_n_max in one half space, since S(-k) = S(k). The plane
+ * waves exp(i k.r_j) are products of the per-direction factors exp(i k_x x_j),
+ * computed once per atom by recurrence from the fundamental wave.
+ */
+void Structure::sample_sk(const std::vector<Atom> &atoms, const Domain &domain)
+{
+    if (m_n_samples++ % Params::sk_frequency != 0) {
+        return;
+    }
+
+    typedef std::complex<double> complex;
+    const int32_t n_max = Params::sk_n_max;
+    const size_t n_waves = 2 * n_max + 1;
+    const size_t n_atoms = atoms.size();
+
+    /* Wave vector indices in the half space z > 0, or z = 0 and y > 0, ... */
+    std::vector<math::vec3i> waves;
+    for (int32_t nx = -n_max; nx <= n_max; ++nx) {
+        for (int32_t ny = -n_max; ny <= n_max; ++ny) {
+            for (int32_t nz = 0; nz <= n_max; ++nz) {
+                bool is_half = nz > 0 || ny > 0 || (ny == 0 && nx > 0);
+                if (is_half && nx * nx + ny * ny + nz * nz <= n_max * n_max) {
+                    waves.push_back(math::vec3i{nx, ny, nz});
+                }
+            }
+        }
+    }
+
+    /* Per-direction plane wave factors exp(i 2 pi n x / L) of each atom. */
+    std::vector<complex> factors(3 * n_waves * n_atoms);
+    core_pragma_omp(parallel for default(none) \
+        shared(atoms, domain, factors, n_max, n_waves, n_atoms))
+    for (size_t atom_ix = 0; atom_ix < n_atoms; ++atom_ix) {
+        const double pos[3] = {
+            atoms[atom_ix].pos.x / domain.length.x,
+            atoms[atom_ix].pos.y / domain.length.y,
+            atoms[atom_ix].pos.z / domain.length.z};
+        for (size_t dim = 0; dim < 3; ++dim) {
+            complex *f = &factors[(3 * atom_ix + dim) * n_waves + n_max];
+            complex e = std::polar(1.0, 2.0 * M_PI * pos[dim]);
+            f[0] = complex(1.0, 0.0);
+            for (int32_t n = 1; n <= n_max; ++n) {
+                f[n] = f[n - 1] * e;
+                f[-n] = std::conj(f[n]);
+            }
+        }
+    }
+
+    /* Density modes of each wave vector. */
+    std::vector<double> sk(waves.size());
+    core_pragma_omp(parallel for default(none) \
+        shared(waves, factors, sk, n_max, n_waves, n_atoms) schedule(dynamic))
+    for (size_t wave_ix = 0; wave_ix < waves.size(); ++wave_ix) {
+        const math::vec3i &n = waves[wave_ix];
+        complex rho(0.0, 0.0);
+        for (size_t atom_ix = 0; atom_ix < n_atoms; ++atom_ix) {
+            const complex *f = &factors[3 * atom_ix * n_waves + n_max];
+            rho += f[n.x] * f[n_waves + n.y] * f[2 * n_waves + n.z];
+        }
+        sk[wave_ix] = std::norm(rho) / (double) n_atoms;
+    }
+
+    /* Bin the wave vectors by |k| in units of the smallest wave number. */
+    const double length = std::max(std::max(
+        domain.length.x, domain.length.y), domain.length.z);
+    m_sk_sum.resize(n_max + 1, 0.0);
+    m_sk_count.resize(n_max + 1, 0);
+    for (size_t wave_ix = 0; wave_ix < waves.size(); ++wave_ix) {
+        const math::vec3i &n = waves[wave_ix];
+        math::vec3d k{
+            n.x / domain.length.x,
+            n.y / domain.length.y,
+            n.z / domain.length.z};
+        size_t bin = (size_t) std::lround(length * std::sqrt(math::dot(k, k)));
+        if (bin <= (size_t) n_max) {
+            m_sk_sum[bin] += sk[wave_ix];
+            m_sk_count[bin]++;
+        }
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * Structure::rdf_string
+ * @brief Serialize the radial distribution function, normalised by the
+ * number of pairs of an ideal gas at the same density in each shell.
+ */
+std::string Structure::rdf_string(
+    const size_t n_atoms,
+    const Domain &domain) const
+{
+    const double volume = domain.length.x * domain.length.y * domain.length.z;
+    const double density = (double) n_atoms / volume;
+    const double dr = m_r_max / m_n_bins;
+
+    std::ostringstream ss;
+    for (size_t bin = 0; bin < m_n_bins; ++bin) {
+        uint64_t count = 0;
+        for (size_t thread = 0; thread < m_n_threads; ++thread) {
+            count += m_histogram[thread * m_n_bins + bin];
+        }
+
+        double r_lo = bin * dr;
+        double r_hi = r_lo + dr;
+        double shell = 4.0 / 3.0 * M_PI * (r_hi * r_hi * r_hi - r_lo * r_lo * r_lo);
+        double ideal = (double) m_n_frames * n_atoms * density * shell;
+        double rdf = m_n_frames > 0 ? (double) count / ideal : 0.0;
+        ss << core::str_format("%lf %lf\n", r_lo + 0.5 * dr, rdf);
+    }
+    return ss.str();
+}
+
+/**
+ * Structure::sk_string
+ * @brief Serialize the structure factor averaged over each |k| bin.
+ */
+std::string Structure::sk_string(const Domain &domain) const
+{
+    const double length = std::max(std::max(
+        domain.length.x, domain.length.y), domain.length.z);
+    const double dk = 2.0 * M_PI / length;
+
+    std::ostringstream ss;
+    for (size_t bin = 1; bin < m_sk_sum.size(); ++bin) {
+        if (m_sk_count[bin] > 0) {
+            ss << core::str_format("%lf %lf\n",
+                bin * dk, m_sk_sum[bin] / (double) m_sk_count[bin]);
+        }
+    }
+    return ss.str();
+}
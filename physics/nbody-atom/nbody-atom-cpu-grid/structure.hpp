@@ -0,0 +1,72 @@
+/*
+ * structure.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef MD_STRUCTURE_H_
+#define MD_STRUCTURE_H_
+
+#include "atto/opencl/opencl.hpp"
+#include "base.hpp"
+
+/**
+ * Structure
+ * @brief Fluid structure sampler - radial distribution function g(r) and
+ * static structure factor S(k).
+ *
+ * The g(r) pair distance histogram is accumulated by the force pass, on the
+ * pairs found by the neighbour traversal, every rdf_frequency force passes.
+ * Each thread owns a row of the histogram, and the rows are summed when the
+ * g(r) is written. S(k) is sampled with a direct sum over the wave vectors of
+ * the periodic domain, S(k) = <|sum_j exp(i k.r_j)|^2> / N, binned by |k|,
+ * every sk_frequency samples.
+ */
+struct Structure {
+    /* g(r) histogram. */
+    size_t m_n_bins;                    /* number of histogram bins */
+    double m_r_max;                     /* histogram range */
+    size_t m_n_threads;                 /* number of histogram rows */
+    std::vector<uint64_t> m_histogram;  /* per-thread pair distance histogram */
+    size_t m_n_passes;                  /* number of force passes */
+    size_t m_n_frames;                  /* number of g(r) frames */
+
+    /* S(k) accumulator. */
+    size_t m_n_samples;                 /* number of sample calls */
+    std::vector<double> m_sk_sum;       /* sum of S(k) in each |k| bin */
+    std::vector<uint64_t> m_sk_count;   /* number of samples in each bin */
+
+    /** Setup the histogram over [0, r_max). */
+    void setup(const double r_max);
+
+    /** Clear the accumulated g(r) and S(k) samples. */
+    void reset(void);
+
+    /** Count a force pass and return true if it samples a g(r) frame. */
+    bool begin_frame(void);
+
+    /** Return the histogram row of the specified thread. */
+    uint64_t *histogram(const size_t thread) {
+        return &m_histogram[thread * m_n_bins];
+    }
+
+    /** Sample the structure factor of the atom positions if due. */
+    void sample_sk(const std::vector<Atom> &atoms, const Domain &domain);
+
+    /** Serialize the radial distribution function. */
+    std::string rdf_string(const size_t n_atoms, const Domain &domain) const;
+
+    /** Serialize the structure factor. */
+    std::string sk_string(const Domain &domain) const;
+
+    /* Constructor/destructor. */
+    Structure() = default;
+    ~Structure() = default;
+};
+
+#endif /* MD_STRUCTURE_H_ */
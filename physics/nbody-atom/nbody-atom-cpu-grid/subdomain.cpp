@@ -0,0 +1,434 @@
+/*
+ * subdomain.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include "atto/opencl/opencl.hpp"
+#include "subdomain.hpp"
+using namespace atto;
+
+/** ---------------------------------------------------------------------------
+ * axis
+ * @brief Return the component of a vector along the specified direction.
+ */
+static double &axis(math::vec3d &v, const size_t dim)
+{
+    return dim == 0 ? v.x : (dim == 1 ? v.y : v.z);
+}
+
+static double axis(const math::vec3d &v, const size_t dim)
+{
+    return dim == 0 ? v.x : (dim == 1 ? v.y : v.z);
+}
+
+static int32_t &axis(math::vec3i &v, const size_t dim)
+{
+    return dim == 0 ? v.x : (dim == 1 ? v.y : v.z);
+}
+
+static int32_t axis(const math::vec3i &v, const size_t dim)
+{
+    return dim == 0 ? v.x : (dim == 1 ? v.y : v.z);
+}
+
+/** ---------------------------------------------------------------------------
+ * Subdomain::rank_grid
+ * @brief Return the number of ranks in each direction. The rank grid is the
+ * factorization of the number of ranks with the smallest sum of factors,
+ * giving the most cubic subdomains and the smallest halo.
+ */
+math::vec3i Subdomain::rank_grid(const size_t n_ranks)
+{
+    math::vec3i ranks{(int32_t) n_ranks, 1, 1};
+    size_t sum_min = n_ranks + 2;
+    for (size_t nx = 1; nx <= n_ranks; ++nx) {
+        if (n_ranks % nx != 0) {
+            continue;
+        }
+        for (size_t ny = 1; ny <= n_ranks / nx; ++ny) {
+            if ((n_ranks / nx) % ny != 0) {
+                continue;
+            }
+            size_t nz = n_ranks / (nx * ny);
+            if (nx + ny + nz < sum_min) {
+                sum_min = nx + ny + nz;
+                ranks = math::vec3i{(int32_t) nx, (int32_t) ny, (int32_t) nz};
+            }
+        }
+    }
+    return ranks;
+}
+
+/**
+ * Subdomain::rank_index
+ * @brief Return the rank index of the specified rank coordinates, wrapped
+ * around the periodic rank grid.
+ */
+size_t Subdomain::rank_index(math::vec3i coord) const
+{
+    coord.x = (coord.x + m_ranks.x) % m_ranks.x;
+    coord.y = (coord.y + m_ranks.y) % m_ranks.y;
+    coord.z = (coord.z + m_ranks.z) % m_ranks.z;
+    return (coord.x * m_ranks.y + coord.y) * m_ranks.z + coord.z;
+}
+
+/**
+ * Subdomain::rank_coord
+ * @brief Return the rank coordinates of the subdomain holding the specified
+ * position in the primary cell.
+ */
+math::vec3i Subdomain::rank_coord(const math::vec3d &pos) const
+{
+    math::vec3i coord;
+    for (size_t dim = 0; dim < 3; ++dim) {
+        const int32_t n_ranks = axis(m_ranks, dim);
+        const double length = axis(m_domain.length, dim);
+        const double offset = axis(pos, dim) + 0.5 * length;
+        int32_t c = (int32_t) std::floor(offset * n_ranks / length);
+        axis(coord, dim) = std::min(std::max(c, 0), n_ranks - 1);
+    }
+    return coord;
+}
+
+/** ---------------------------------------------------------------------------
+ * Subdomain::migrate
+ * @brief Send the owned atoms outside the subdomain to the neighbour ranks
+ * along x, y and z in turn, and receive the atoms entering the subdomain.
+ * Atoms crossing the domain boundary are wrapped into the primary cell.
+ */
+void Subdomain::migrate(void)
+{
+    m_atoms.resize(m_n_owned);
+
+    for (size_t dim = 0; dim < 3; ++dim) {
+        const double length = axis(m_domain.length, dim);
+        const double lo = axis(m_lo, dim);
+        const double hi = axis(m_hi, dim);
+        const bool is_first = (axis(m_coord, dim) == 0);
+        const bool is_last = (axis(m_coord, dim) == axis(m_ranks, dim) - 1);
+
+        math::vec3i coord_lo = m_coord;
+        math::vec3i coord_hi = m_coord;
+        axis(coord_lo, dim) -= 1;
+        axis(coord_hi, dim) += 1;
+        const size_t rank_lo = rank_index(coord_lo);
+        const size_t rank_hi = rank_index(coord_hi);
+
+        /* Split the owned atoms into kept and migrating atoms. */
+        std::vector<Atom> send_lo;
+        std::vector<Atom> send_hi;
+        size_t n_kept = 0;
+        for (size_t ix = 0; ix < m_atoms.size(); ++ix) {
+            Atom atom = m_atoms[ix];
+            double &pos = axis(atom.pos, dim);
+            if (pos < lo) {
+                pos += is_first ? length : 0.0;
+                send_lo.push_back(atom);
+            } else if (pos >= hi) {
+                pos -= is_last ? length : 0.0;
+                send_hi.push_back(atom);
+            } else {
+                m_atoms[n_kept++] = atom;
+            }
+        }
+        m_atoms.resize(n_kept);
+
+        /* Exchange the migrating atoms with the neighbour ranks. */
+        m_transport->send(rank_lo, TagMigrateLo + dim, send_lo);
+        m_transport->send(rank_hi, TagMigrateHi + dim, send_hi);
+
+        std::vector<Atom> recv_hi = m_transport->recv(rank_hi, TagMigrateLo + dim);
+        std::vector<Atom> recv_lo = m_transport->recv(rank_lo, TagMigrateHi + dim);
+        m_atoms.insert(m_atoms.end(), recv_hi.begin(), recv_hi.end());
+        m_atoms.insert(m_atoms.end(), recv_lo.begin(), recv_lo.end());
+    }
+
+    m_n_owned = m_atoms.size();
+}
+
+/**
+ * Subdomain::exchange
+ * @brief Replace the halo atoms with copies of the neighbour atoms within
+ * the halo width of each subdomain face, exchanged along x, y and z in turn.
+ */
+void Subdomain::exchange(void)
+{
+    m_atoms.resize(m_n_owned);
+
+    for (size_t dim = 0; dim < 3; ++dim) {
+        const double length = axis(m_domain.length, dim);
+        const double lo = axis(m_lo, dim);
+        const double hi = axis(m_hi, dim);
+        const bool is_first = (axis(m_coord, dim) == 0);
+        const bool is_last = (axis(m_coord, dim) == axis(m_ranks, dim) - 1);
+
+        math::vec3i coord_lo = m_coord;
+        math::vec3i coord_hi = m_coord;
+        axis(coord_lo, dim) -= 1;
+        axis(coord_hi, dim) += 1;
+        const size_t rank_lo = rank_index(coord_lo);
+        const size_t rank_hi = rank_index(coord_hi);
+
+        /*
+         * Copy the atoms near the lower and upper faces, owned atoms and
+         * halo atoms received along the previous directions, shifted by
+         * the domain length across the domain boundary.
+         */
+        std::vector<Atom> send_lo;
+        std::vector<Atom> send_hi;
+        for (auto &atom : m_atoms) {
+            const double pos = axis(atom.pos, dim);
+            if (pos < lo + m_halo) {
+                send_lo.push_back(atom);
+                axis(send_lo.back().pos, dim) += is_first ? length : 0.0;
+            }
+            if (pos >= hi - m_halo) {
+                send_hi.push_back(atom);
+                axis(send_hi.back().pos, dim) -= is_last ? length : 0.0;
+            }
+        }
+
+        /* Exchange the halo atoms with the neighbour ranks. */
+        m_transport->send(rank_lo, TagHaloLo + dim, send_lo);
+        m_transport->send(rank_hi, TagHaloHi + dim, send_hi);
+
+        std::vector<Atom> recv_hi = m_transport->recv(rank_hi, TagHaloLo + dim);
+        std::vector<Atom> recv_lo = m_transport->recv(rank_lo, TagHaloHi + dim);
+        m_atoms.insert(m_atoms.end(), recv_hi.begin(), recv_hi.end());
+        m_atoms.insert(m_atoms.end(), recv_lo.begin(), recv_lo.end());
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * Subdomain::compute_forces
+ * @brief Compute the forces on the owned atoms from the owned and halo atoms
+ * within the cutoff radius, found with a cell list over the subdomain
+ * extended by the halo. Return the number of pair interactions.
+ */
+size_t Subdomain::compute_forces(void)
+{
+    const math::vec3d origin{m_lo.x - m_halo, m_lo.y - m_halo, m_lo.z - m_halo};
+    auto cell = [&] (const math::vec3d &pos) -> math::vec3i {
+        math::vec3i coord;
+        for (size_t dim = 0; dim < 3; ++dim) {
+            int32_t c = (int32_t) std::floor(
+                (axis(pos, dim) - axis(origin, dim)) / axis(m_cell_length, dim));
+            axis(coord, dim) = std::min(std::max(c, 0), axis(m_cells, dim) - 1);
+        }
+        return coord;
+    };
+    auto cell_index = [&] (const math::vec3i &coord) -> size_t {
+        return (coord.x * m_cells.y + coord.y) * m_cells.z + coord.z;
+    };
+
+    /* Insert the owned and halo atoms into the cell list. */
+    const uint32_t empty = m_empty;
+    m_cell_head.assign(m_cells.x * m_cells.y * m_cells.z, empty);
+    m_cell_next.assign(m_atoms.size(), empty);
+    for (uint32_t atom_ix = 0; atom_ix < m_atoms.size(); ++atom_ix) {
+        size_t ix = cell_index(cell(m_atoms[atom_ix].pos));
+        m_cell_next[atom_ix] = m_cell_head[ix];
+        m_cell_head[ix] = atom_ix;
+    }
+
+    /* Accumulate the pair interactions of each owned atom. */
+    size_t n_pairs = 0;
+    for (uint32_t atom_1 = 0; atom_1 < m_n_owned; ++atom_1) {
+        Atom &atom = m_atoms[atom_1];
+        atom.force = math::vec3d{};
+        atom.energy = 0.0;
+        atom.virial = math::mat3d{};
+
+        /* Type pair coefficients of the atom. */
+        const FieldPair *coeff = &m_field.pairs[atom.type * Field::max_types];
+
+        const math::vec3i coord = cell(atom.pos);
+        for (int32_t x = std::max(coord.x - 1, 0); x <= std::min(coord.x + 1, m_cells.x - 1); ++x) {
+        for (int32_t y = std::max(coord.y - 1, 0); y <= std::min(coord.y + 1, m_cells.y - 1); ++y) {
+        for (int32_t z = std::max(coord.z - 1, 0); z <= std::min(coord.z + 1, m_cells.z - 1); ++z) {
+            size_t ix = cell_index(math::vec3i{x, y, z});
+            for (uint32_t atom_2 = m_cell_head[ix];
+                 atom_2 != m_empty;
+                 atom_2 = m_cell_next[atom_2]) {
+                if (atom_1 == atom_2) {
+                    continue;
+                }
+
+                math::vec3d r_12 = atom.pos - m_atoms[atom_2].pos;
+                const FieldPair &coeff_12 = coeff[m_atoms[atom_2].type];
+                if (math::dot(r_12, r_12) < coeff_12.r_cut_sq) {
+                    Pair pair = compute::force_pair(
+                        atom_1, atom_2, r_12, coeff_12, m_field.r_hard);
+                    atom.force  -= pair.gradient;
+                    atom.energy += pair.energy * 0.5;
+                    atom.virial += pair.virial * 0.5;
+                    n_pairs++;
+                }
+            }
+        }
+        }
+        }
+    }
+
+    return n_pairs;
+}
+
+/**
+ * Subdomain::integrate_thermostat
+ * @brief Integrate the thermostat over the specified time step, with the
+ * kinetic temperature reduced over all ranks.
+ */
+void Subdomain::integrate_thermostat(const double t_step)
+{
+    ThermoSums sums = compute::thermo_sums(m_atoms, m_n_owned);
+    m_transport->allreduce(sums);
+
+    double grad_sq;
+    double laplace;
+    compute::temperature_kin(sums, grad_sq, laplace);
+    double force = grad_sq - m_thermostat.temperature * laplace;
+    m_thermostat.deta_dt = force / m_thermostat.mass;
+    m_thermostat.eta += t_step * m_thermostat.deta_dt;
+}
+
+/** ---------------------------------------------------------------------------
+ * Subdomain::execute
+ * @brief Subdomain integration step.
+ */
+void Subdomain::execute(void)
+{
+    const double half_t_step = 0.5 * Params::t_step;
+
+    /*
+     * Begin integration - first half of the integration step.
+     */
+    {
+        double exp_eta = exp(-m_thermostat.eta * half_t_step);
+        for (size_t ix = 0; ix < m_n_owned; ++ix) {
+            Atom &atom = m_atoms[ix];
+            atom.mom += atom.force * half_t_step;
+            atom.mom *= exp_eta;
+
+            atom.pos += atom.mom * atom.rmass * Params::t_step;
+            atom.upos += atom.mom * atom.rmass * Params::t_step;
+        }
+    }
+    integrate_thermostat(half_t_step);
+
+    /*
+     * Migrate the atoms, exchange the halo and compute fluid forces.
+     */
+    migrate();
+    exchange();
+    compute_forces();
+
+    /*
+     * End integration - second half of the integration step.
+     */
+    integrate_thermostat(half_t_step);
+    {
+        double exp_eta = exp(-m_thermostat.eta * half_t_step);
+        for (size_t ix = 0; ix < m_n_owned; ++ix) {
+            Atom &atom = m_atoms[ix];
+            atom.mom *= exp_eta;
+            atom.mom += atom.force * half_t_step;
+        }
+    }
+}
+
+/**
+ * Subdomain::sample
+ * @brief Sample the fluid thermodynamic properties. The thermodynamic sums of
+ * the owned atoms are reduced over all ranks, and every rank adds the same
+ * properties to its sampler.
+ */
+std::string Subdomain::sample(void)
+{
+    ThermoSums sums = compute::thermo_sums(m_atoms, m_n_owned);
+    m_transport->allreduce(sums);
+
+    m_sampler.sample(compute::thermo(sums, m_domain));
+    return m_sampler.log_string();
+}
+
+/**
+ * Subdomain::gather
+ * @brief Send the owned atoms of each rank to rank 0, and return all atoms
+ * in rank order on rank 0 and no atoms on the other ranks.
+ */
+std::vector<Atom> Subdomain::gather(void)
+{
+    std::vector<Atom> owned(m_atoms.begin(), m_atoms.begin() + m_n_owned);
+    m_transport->send(0, TagGather, owned);
+
+    std::vector<Atom> atoms;
+    if (m_transport->rank() == 0) {
+        for (size_t rank = 0; rank < m_transport->size(); ++rank) {
+            std::vector<Atom> recv = m_transport->recv(rank, TagGather);
+            atoms.insert(atoms.end(), recv.begin(), recv.end());
+        }
+    }
+    return atoms;
+}
+
+/** ---------------------------------------------------------------------------
+ * Subdomain::setup
+ * @brief Setup the subdomain of this rank with the domain, force field and
+ * thermostat of a serial engine, and take ownership of its atoms inside the
+ * subdomain. Every rank reads the same serial engine.
+ */
+void Subdomain::setup(Transport *transport, const Engine &engine)
+{
+    core_assert(!engine.m_pme.enabled(),
+        "domain decomposition does not support charged atoms");
+
+    m_transport = transport;
+    m_domain = engine.m_domain;
+    m_field = engine.m_field;
+    m_thermostat = engine.m_thermostat;
+
+    /* Setup the rank grid and the subdomain bounds. */
+    const size_t rank = m_transport->rank();
+    m_ranks = rank_grid(m_transport->size());
+    m_coord = math::vec3i{
+        (int32_t) (rank / (m_ranks.y * m_ranks.z)),
+        (int32_t) ((rank / m_ranks.z) % m_ranks.y),
+        (int32_t) (rank % m_ranks.z)};
+
+    m_halo = m_field.r_cut + m_field.r_skin;
+    for (size_t dim = 0; dim < 3; ++dim) {
+        const double length = axis(m_domain.length, dim) / axis(m_ranks, dim);
+        core_assert(length >= m_halo, "subdomain is smaller than the halo width");
+
+        axis(m_lo, dim) = -axis(m_domain.length_half, dim) + axis(m_coord, dim) * length;
+        axis(m_hi, dim) = axis(m_lo, dim) + length;
+    }
+
+    /* Setup the cell list, with cells no smaller than the cutoff radius. */
+    for (size_t dim = 0; dim < 3; ++dim) {
+        const double length = axis(m_hi, dim) - axis(m_lo, dim) + 2.0 * m_halo;
+        axis(m_cells, dim) = std::max((int32_t) (length / m_field.r_cut), 1);
+        axis(m_cell_length, dim) = length / axis(m_cells, dim);
+    }
+
+    /* Take the atoms inside the subdomain. */
+    m_atoms.clear();
+    for (auto atom : engine.m_atoms) {
+        atom.pos = compute::pbc(atom.pos, m_domain);
+        math::vec3i coord = rank_coord(atom.pos);
+        if (coord.x == m_coord.x && coord.y == m_coord.y && coord.z == m_coord.z) {
+            m_atoms.push_back(atom);
+        }
+    }
+    m_n_owned = m_atoms.size();
+
+    /* Exchange the halo and compute the initial forces. */
+    exchange();
+    compute_forces();
+}
@@ -0,0 +1,115 @@
+/*
+ * subdomain.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef MD_SUBDOMAIN_H_
+#define MD_SUBDOMAIN_H_
+
+#include "atto/opencl/opencl.hpp"
+#include "base.hpp"
+#include "compute.hpp"
+#include "sampler.hpp"
+#include "engine.hpp"
+#include "transport.hpp"
+
+/**
+ * Subdomain
+ * @brief Molecular dynamics engine of one rank of a spatial domain
+ * decomposition.
+ *
+ * The domain is split into a regular grid of ranks, each owning the atoms
+ * inside an axis-aligned subdomain [lo, hi). The atoms of the neighbour
+ * subdomains within a halo of width r_cut + r_skin of its faces are copied
+ * onto the rank as halo atoms, stored after the owned atoms. The halo is
+ * exchanged along x, y and z in turn, forwarding the halo atoms received
+ * along the previous directions, so the edge and corner atoms reach the
+ * diagonal neighbours without a direct exchange. Halo atoms crossing the
+ * domain boundary carry the periodic image of their position, and the
+ * pair interactions use plain distances.
+ *
+ * Atoms crossing a subdomain face migrate to the neighbour rank. An atom
+ * moves less than a halo width in one step, so one exchange along each
+ * direction suffices.
+ *
+ * The thermostat and the sampler properties are reduced over all ranks
+ * with the transport, so every rank holds the same thermostat state.
+ */
+struct Subdomain {
+    /* Message tags of each exchange, offset by the direction index. */
+    enum : size_t {
+        TagMigrateLo = 0,
+        TagMigrateHi = 3,
+        TagHaloLo = 6,
+        TagHaloHi = 9,
+        TagGather = 12
+    };
+
+    /* Cell list empty slot. */
+    static const uint32_t m_empty = 0xffffffff;
+
+    /* Subdomain member variables. */
+    Transport *m_transport = nullptr;   /* rank transport */
+    atto::math::vec3i m_ranks;          /* number of ranks in each direction */
+    atto::math::vec3i m_coord;          /* rank coordinates in the rank grid */
+    atto::math::vec3d m_lo;             /* subdomain lower bound */
+    atto::math::vec3d m_hi;             /* subdomain upper bound */
+    double m_halo;                      /* halo width */
+    size_t m_n_owned;                   /* number of owned atoms */
+    std::vector<Atom> m_atoms;          /* owned atoms followed by halo atoms */
+    Domain m_domain;                    /* fluid domain */
+    Field m_field;                      /* fluid pair force field */
+    Thermostat m_thermostat;            /* fluid thermostat */
+    Sampler m_sampler;                  /* fluid thermodynamic sampler */
+
+    /* Cell list of the owned and halo atoms over the extended subdomain. */
+    atto::math::vec3i m_cells;          /* number of cells in each direction */
+    atto::math::vec3d m_cell_length;    /* cell length in each direction */
+    std::vector<uint32_t> m_cell_head;  /* first atom in each cell */
+    std::vector<uint32_t> m_cell_next;  /* next atom in the same cell */
+
+    /** Return the number of ranks in each direction of the rank grid. */
+    static atto::math::vec3i rank_grid(const size_t n_ranks);
+
+    /** Return the rank index of the specified rank coordinates. */
+    size_t rank_index(atto::math::vec3i coord) const;
+
+    /** Return the rank coordinates of the subdomain holding a position. */
+    atto::math::vec3i rank_coord(const atto::math::vec3d &pos) const;
+
+    /** Migrate the owned atoms that crossed the subdomain faces. */
+    void migrate(void);
+
+    /** Exchange the halo atoms with the neighbour ranks. */
+    void exchange(void);
+
+    /** Compute the forces on the owned atoms. */
+    size_t compute_forces(void);
+
+    /** Integrate the thermostat over the specified time step. */
+    void integrate_thermostat(const double t_step);
+
+    /** Execute one integration step. */
+    void execute(void);
+
+    /** Sample the fluid thermodynamic properties over all ranks. */
+    std::string sample(void);
+
+    /** Gather the owned atoms of all ranks onto rank 0. */
+    std::vector<Atom> gather(void);
+
+    /** Setup the subdomain with the atoms of a serial engine. */
+    void setup(Transport *transport, const Engine &engine);
+
+    /* Constructor/destructor. */
+    Subdomain() = default;
+    ~Subdomain() = default;
+};
+
+#endif /* MD_SUBDOMAIN_H_ */
@@ -0,0 +1,82 @@
+/*
+ * transport.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include "atto/opencl/opencl.hpp"
+#include "transport.hpp"
+using namespace atto;
+
+/** ---------------------------------------------------------------------------
+ * LoopbackTransport::send
+ * @brief Append a copy of the atoms to the queue of the destination rank.
+ */
+void LoopbackTransport::send(
+    const size_t dst,
+    const size_t tag,
+    const std::vector<Atom> &atoms)
+{
+    core_assert(dst < size(), "invalid destination rank");
+    {
+        std::lock_guard<std::mutex> lock(m_loopback.m_mutex);
+        m_loopback.m_messages[Loopback::Key(m_rank, dst, tag)].push_back(atoms);
+    }
+    m_loopback.m_cond.notify_all();
+}
+
+/**
+ * LoopbackTransport::recv
+ * @brief Wait for the first message from the source rank with the specified
+ * tag and remove it from the queue.
+ */
+std::vector<Atom> LoopbackTransport::recv(const size_t src, const size_t tag)
+{
+    core_assert(src < size(), "invalid source rank");
+
+    std::unique_lock<std::mutex> lock(m_loopback.m_mutex);
+    auto &queue = m_loopback.m_messages[Loopback::Key(src, m_rank, tag)];
+    m_loopback.m_cond.wait(lock, [&queue] () { return !queue.empty(); });
+
+    std::vector<Atom> atoms = std::move(queue.front());
+    queue.pop_front();
+    return atoms;
+}
+
+/**
+ * LoopbackTransport::allreduce
+ * @brief Store the contribution of this rank and wait for all ranks. The
+ * last rank to arrive sums the contributions in rank order, so the result
+ * is identical on every rank and independent of the thread arrival order.
+ */
+void LoopbackTransport::allreduce(std::vector<double> &values)
+{
+    std::unique_lock<std::mutex> lock(m_loopback.m_mutex);
+    const size_t generation = m_loopback.m_generation;
+    m_loopback.m_values[m_rank] = values;
+
+    if (++m_loopback.m_n_arrived == m_loopback.m_n_ranks) {
+        m_loopback.m_result.assign(values.size(), 0.0);
+        for (auto &contribution : m_loopback.m_values) {
+            core_assert(contribution.size() == values.size(),
+                "inconsistent reduction size");
+            for (size_t k = 0; k < values.size(); ++k) {
+                m_loopback.m_result[k] += contribution[k];
+            }
+        }
+        m_loopback.m_n_arrived = 0;
+        m_loopback.m_generation++;
+        m_loopback.m_cond.notify_all();
+    } else {
+        m_loopback.m_cond.wait(lock, [&] () {
+            return m_loopback.m_generation != generation;
+        });
+    }
+
+    values = m_loopback.m_result;
+}
@@ -0,0 +1,125 @@
+/*
+ * transport.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef MD_TRANSPORT_H_
+#define MD_TRANSPORT_H_
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include "atto/opencl/opencl.hpp"
+#include "base.hpp"
+
+/**
+ * Transport
+ * @brief Transport exchanges atoms between the ranks of a domain decomposed
+ * engine and reduces values over all ranks.
+ *
+ * Messages are matched by source rank and tag, and messages with the same
+ * source and tag are received in the order they were sent. A send never
+ * blocks, a receive blocks until the matching message arrives. Reductions
+ * are collective, every rank calls them in the same order.
+ */
+struct Transport {
+    /** Return the index of this rank and the number of ranks. */
+    virtual size_t rank(void) const = 0;
+    virtual size_t size(void) const = 0;
+
+    /** Send the atoms to the specified rank. */
+    virtual void send(
+        const size_t dst,
+        const size_t tag,
+        const std::vector<Atom> &atoms) = 0;
+
+    /** Receive the atoms sent by the specified rank. */
+    virtual std::vector<Atom> recv(const size_t src, const size_t tag) = 0;
+
+    /** Sum the values over all ranks in place, in rank order. */
+    virtual void allreduce(std::vector<double> &values) = 0;
+
+    /** Sum the thermodynamic sums over all ranks in place. */
+    void allreduce(ThermoSums &sums) {
+        std::vector<double> values(
+            sums.values, sums.values + ThermoSums::NumSums);
+        allreduce(values);
+        std::copy(values.begin(), values.end(), sums.values);
+    }
+
+    /** Wait for all ranks. */
+    void barrier(void) {
+        std::vector<double> values;
+        allreduce(values);
+    }
+
+    /* Constructor/destructor. */
+    Transport() = default;
+    virtual ~Transport() = default;
+};
+
+/**
+ * Loopback
+ * @brief Loopback is the shared memory state of a collection of ranks running
+ * on the threads of a single process - the message queues of each source,
+ * destination and tag, and the rank contributions to the current reduction.
+ */
+struct Loopback {
+    /* Message queues. */
+    typedef std::tuple<size_t, size_t, size_t> Key;    /* src, dst, tag */
+    std::map<Key, std::deque<std::vector<Atom>>> m_messages;
+
+    /* Reduction state. */
+    size_t m_n_ranks;                   /* number of ranks */
+    size_t m_n_arrived = 0;             /* ranks in the current reduction */
+    size_t m_generation = 0;            /* number of completed reductions */
+    std::vector<std::vector<double>> m_values; /* rank contributions */
+    std::vector<double> m_result;       /* result of the last reduction */
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+
+    /* Constructor/destructor. */
+    explicit Loopback(const size_t n_ranks)
+        : m_n_ranks(n_ranks)
+        , m_values(n_ranks) {}
+    ~Loopback() = default;
+    Loopback(const Loopback &) = delete;
+    Loopback &operator=(const Loopback &) = delete;
+};
+
+/**
+ * LoopbackTransport
+ * @brief Transport of one rank over a shared Loopback state.
+ */
+struct LoopbackTransport : Transport {
+    Loopback &m_loopback;
+    size_t m_rank;
+
+    size_t rank(void) const override { return m_rank; }
+    size_t size(void) const override { return m_loopback.m_n_ranks; }
+
+    void send(
+        const size_t dst,
+        const size_t tag,
+        const std::vector<Atom> &atoms) override;
+    std::vector<Atom> recv(const size_t src, const size_t tag) override;
+    void allreduce(std::vector<double> &values) override;
+
+    /* Constructor/destructor. */
+    LoopbackTransport(Loopback &loopback, const size_t rank)
+        : m_loopback(loopback)
+        , m_rank(rank) {}
+    ~LoopbackTransport() = default;
+};
+
+#endif /* MD_TRANSPORT_H_ */
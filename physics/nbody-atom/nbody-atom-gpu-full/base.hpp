@@ -14,6 +14,42 @@
 
 #include "atto/opencl/opencl.hpp"
 
+/**
+ * @brief Force kernel, the local memory tiled kernel if nonzero, overridden
+ * at compile time, e.g. make MD_FLAGS=-DMD_FORCE_TILED=0.
+ */
+#ifndef MD_FORCE_TILED
+#define MD_FORCE_TILED 1
+#endif
+
+/**
+ * @brief Device precision of the atom data, 0 double, 1 mixed with single
+ * precision pair interactions, or 2 single, overridden at compile time,
+ * e.g. make MD_FLAGS=-DMD_PRECISION=1. The host types below match the
+ * device state and real types defined in data/base.cl.
+ */
+#ifndef MD_PRECISION
+#define MD_PRECISION 0
+#endif
+
+#if MD_PRECISION == 2
+typedef cl_float State;
+typedef cl_float4 State4;
+#else
+typedef cl_double State;
+typedef cl_double4 State4;
+#endif
+
+#if MD_PRECISION == 0
+typedef cl_double Real;
+typedef cl_double4 Real4;
+typedef cl_double16 Real16;
+#else
+typedef cl_float Real;
+typedef cl_float4 Real4;
+typedef cl_float16 Real16;
+#endif
+
 /**
  * @brief Model parameters.
  */
@@ -38,11 +74,19 @@ static const cl_double pair_r_skin = 1.0;       /* skin radius */
 static const cl_double pair_r_hard = 0.01;      /* hard sphere radius */
 static const cl_double thermostat_mass = 10.0;  /* thermostat inertial mass */
 
+/* Species parameters, in units of atom_mass, pair_epsilon and pair_sigma. */
+static const cl_ulong n_types = 1;              /* number of atom types */
+static const cl_double type_fraction[] = {1.0}; /* type number fraction */
+static const cl_double type_mass[] = {1.0};     /* type mass */
+static const cl_double type_epsilon[] = {1.0};  /* type LJ energy */
+static const cl_double type_sigma[] = {1.0};    /* type LJ size */
+
 /* OpenGL parameters */
 static const int window_width = 1024;
 static const int window_height = 1024;
 static const char window_title[] = "md-gpu-full";
 static const cl_double poll_timeout = 0.01;
+static const cl_double frame_rate = 60.0;       /* rendered frames per second */
 
 /* OpenCL parameters */
 static const cl_ulong device_index = 2;         /* gpu device index. */
@@ -50,14 +94,21 @@ static const cl_ulong work_group_size = 256;    /* local workgroup size */
 static const cl_ulong num_work_items = atto::cl::NDRange::Roundup(
     n_atoms, work_group_size);
 static const cl_ulong num_work_groups = num_work_items / work_group_size;
+static const bool force_tiled = MD_FORCE_TILED; /* tiled force kernel */
+static const int precision = MD_PRECISION;     /* device precision */
+static const cl_ulong sampler_items = 34;       /* sampler partial sums */
+static const cl_ulong sampler_work_group_size = 64; /* sampler workgroup size */
+static const cl_ulong sampler_num_work_groups = 64; /* sampler workgroups */
 }
 
 /**
- * @brief Fluid atoms.
+ * @brief Fluid atoms. The host holds the atoms in an array of structures,
+ * the device in a structure of arrays with one buffer per attribute.
  */
 struct Atom {
     cl_double mass;                 /* atom mass */
     cl_double rmass;                /* inverse mass */
+    cl_uint type;                   /* atom type */
     cl_double4 pos;                 /* periodic image in primary cell */
     cl_double4 upos;                /* unfolded position */
     cl_double4 mom;                 /* momentum */
@@ -88,12 +139,25 @@ struct Domain {
 };
 
 /**
- * @brief Field represents the Lennard-Jones force field.
+ * @brief FieldPair holds the Lennard-Jones coefficients of an atom type pair.
  */
-struct Field {
+struct FieldPair {
     cl_double epsilon;              /* LJ pair energy */
     cl_double sigma;                /* LJ pair size */
     cl_double r_cut;                /* LJ cutoff radius */
+    cl_double r_cut_sq;             /* LJ cutoff radius squared */
+};
+
+/**
+ * @brief Field represents the Lennard-Jones force field of a fluid mixture.
+ * The coefficients of each type pair (i,j) are stored in a small row-major
+ * table at index k = i*max_types + j.
+ */
+struct Field {
+    static const cl_ulong max_types = 4;
+    FieldPair pairs[max_types * max_types]; /* type pair coefficients */
+    cl_ulong n_types;               /* number of atom types */
+    cl_double r_cut;                /* Largest LJ cutoff radius */
     cl_double r_skin;               /* Neighbour list skin radius */
     cl_double r_hard;               /* Hard sphere truncation radius */
 };
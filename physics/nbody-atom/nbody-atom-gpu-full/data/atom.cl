@@ -2,11 +2,15 @@
 Pair_t atom_force_pair(
     const ulong atom_1,
     const ulong atom_2,
-    const double4 r_12,
-    const __global Field_t *field);
+    const real4 r_12,
+    const FieldPair_t coeff,
+    const real r_hard);
 
 /** Return the periodic image in primary cell of the fluid domain. */
-double4 atom_pbc(const __global Domain_t *domain, const double4 pos);
+state4 atom_pbc(const __global Domain_t *domain, const state4 pos);
+
+/** Return the minimum image of a pairwise vector. */
+real4 atom_pbc_pair(const real4 length, const real4 length_half, const real4 r_12);
 
 /** ---------------------------------------------------------------------------
  * atom_begin_integrate
@@ -15,22 +19,28 @@ double4 atom_pbc(const __global Domain_t *domain, const double4 pos);
 __kernel void atom_begin_integrate(
     const double t_step,
     const ulong n_atoms,
-    __global Atom_t *atoms,
+    const __global state *rmass,
+    __global state4 *pos,
+    __global state4 *upos,
+    __global state4 *mom,
+    const __global real4 *force,
     const __global Thermostat_t *thermostat)
 {
     const ulong atom_ix = get_global_id(0);
     if (atom_ix < n_atoms) {
-        const double half_t_step = 0.5 * t_step;
+        const state half_t_step = (state) (0.5 * t_step);
 
         /* Integrate momenta half time step */
-        double exp_eta = exp(-thermostat->eta * half_t_step);
-        atoms[atom_ix].mom += atoms[atom_ix].force * half_t_step;
-        atoms[atom_ix].mom *= exp_eta;
+        state exp_eta = (state) exp(-thermostat->eta * 0.5 * t_step);
+        state4 mom_ix = mom[atom_ix];
+        mom_ix += convert_state4(force[atom_ix]) * half_t_step;
+        mom_ix *= exp_eta;
+        mom[atom_ix] = mom_ix;
 
         /* Integrate positions at full time step */
-        double4 vel = atoms[atom_ix].mom * atoms[atom_ix].rmass;
-        atoms[atom_ix].pos += vel * t_step;
-        atoms[atom_ix].upos += vel * t_step;
+        state4 vel = mom_ix * rmass[atom_ix];
+        pos[atom_ix] += vel * (state) t_step;
+        upos[atom_ix] += vel * (state) t_step;
     }
 }
 
@@ -41,17 +51,20 @@ __kernel void atom_begin_integrate(
 __kernel void atom_end_integrate(
     const double t_step,
     const ulong n_atoms,
-    __global Atom_t *atoms,
+    __global state4 *mom,
+    const __global real4 *force,
     const __global Thermostat_t *thermostat)
 {
     const ulong atom_ix = get_global_id(0);
     if (atom_ix < n_atoms) {
-        const double half_t_step = 0.5 * t_step;
+        const state half_t_step = (state) (0.5 * t_step);
 
         /* Integrate momenta half time step */
-        double exp_eta = exp(-thermostat->eta * half_t_step);
-        atoms[atom_ix].mom *= exp_eta;
-        atoms[atom_ix].mom += atoms[atom_ix].force * half_t_step;
+        state exp_eta = (state) exp(-thermostat->eta * 0.5 * t_step);
+        state4 mom_ix = mom[atom_ix];
+        mom_ix *= exp_eta;
+        mom_ix += convert_state4(force[atom_ix]) * half_t_step;
+        mom[atom_ix] = mom_ix;
     }
 }
 
@@ -61,39 +74,50 @@ __kernel void atom_end_integrate(
  */
 __kernel void atom_update(
     const ulong n_atoms,
-    __global Atom_t *atoms,
+    __global state4 *pos,
     const __global Domain_t *domain)
 {
     const ulong atom_ix = get_global_id(0);
     if (atom_ix < n_atoms) {
         /* Apply pbc to the fluid particle positions. */
-        atoms[atom_ix].pos = atom_pbc(domain, atoms[atom_ix].pos);
+        pos[atom_ix] = atom_pbc(domain, pos[atom_ix]);
     }
 }
 
 /** ---------------------------------------------------------------------------
  * atom_force
- * @brief Compute fluid forces.
+ * @brief Compute fluid forces. The pair interactions are computed in the
+ * real precision and summed in the accum precision.
  */
 __kernel void atom_force(
     const ulong n_atoms,
     const ulong n_neighbours,
-    __global Atom_t *atoms,
+    const __global uint *type,
+    const __global state4 *pos,
+    __global real4 *force,
+    __global real *energy,
+    __global real16 *virial,
     const __global Domain_t *domain,
-    const __global Field_t *field)
+    __constant Field_t *field)
 {
     const ulong atom_1 = get_global_id(0);
     if (atom_1 < n_atoms) {
-        const double r_cut_sq = field->r_cut * field->r_cut;
+        /* Type pair coefficients of the atom, held in constant memory. */
+        __constant FieldPair_t *coeff = &field->pairs[type[atom_1] * kMaxTypes];
+
+        const real4 length = convert_real4(domain->length);
+        const real4 length_half = convert_real4(domain->length_half);
+        const real r_hard = (real) field->r_hard;
+        const real4 pos_1 = convert_real4(pos[atom_1]);
 
         /*
          * Loop over the neighbours of the atom cell in the centre.
          * For each neighbour cell, loop over its atoms and compute
          * the pairwise interaction.
          */
-        double4 force = (double4) (0.0);
-        double energy = 0.0;
-        double16 virial = (double16) (0.0);
+        accum4 force_1 = (accum4) (0.0);
+        accum energy_1 = 0.0;
+        accum16 virial_1 = (accum16) (0.0);
 
         const ulong pair_begin = atom_1 * n_neighbours;
         const ulong pair_end = pair_begin + n_neighbours;
@@ -104,32 +128,126 @@ __kernel void atom_force(
                 continue;
             }
 
-            double4 r_12 = atoms[atom_1].pos - atoms[atom_2].pos;
-            r_12 = atom_pbc(domain, r_12);
+            real4 r_12 = pos_1 - convert_real4(pos[atom_2]);
+            r_12 = atom_pbc_pair(length, length_half, r_12);
 
-            if (pair_ix < pair_end && dot(r_12, r_12) < r_cut_sq) {
-                Pair_t pair = atom_force_pair(atom_1, atom_2, r_12, field);
-                force  -= pair.gradient;
-                energy += 0.5 * pair.energy;
-                virial += 0.5 * pair.virial;
+            const FieldPair_t coeff_12 = coeff[type[atom_2]];
+            if (pair_ix < pair_end && dot(r_12, r_12) < (real) coeff_12.r_cut_sq) {
+                Pair_t pair = atom_force_pair(
+                    atom_1, atom_2, r_12, coeff_12, r_hard);
+                force_1  -= convert_accum4(pair.gradient);
+                energy_1 += 0.5f * (accum) pair.energy;
+                virial_1 += 0.5f * convert_accum16(pair.virial);
                 pair_ix++;
             }
         }
 
-        atoms[atom_1].force = force;
-        atoms[atom_1].energy = energy;
-        atoms[atom_1].virial = virial;
+        force[atom_1] = convert_real4(force_1);
+        energy[atom_1] = (real) energy_1;
+        virial[atom_1] = convert_real16(virial_1);
     }
 }
+
+/**
+ * atom_force_tiled
+ * @brief Compute fluid forces, loading the atoms in tiles of one work group
+ * into local memory. Each work item loads one atom of the tile, packed into
+ * a real4 with the position in xyz and the type in w, and the work group
+ * evaluates its atoms against the whole tile from local memory. The pairs
+ * are visited in the same order as atom_force, so both kernels compute the
+ * same forces.
+ */
+__kernel void atom_force_tiled(
+    const ulong n_atoms,
+    const ulong n_neighbours,
+    const __global uint *type,
+    const __global state4 *pos,
+    __global real4 *force,
+    __global real *energy,
+    __global real16 *virial,
+    const __global Domain_t *domain,
+    __constant Field_t *field,
+    __local real4 *tile)
+{
+    const ulong atom_1 = get_global_id(0);
+    const ulong local_ix = get_local_id(0);
+    const ulong tile_size = get_local_size(0);
+    const bool is_valid = (atom_1 < n_atoms);
+
+    /* Position and type pair coefficients of the atom. */
+    const real4 pos_1 = is_valid ? convert_real4(pos[atom_1]) : (real4) (0.0);
+    const uint type_1 = is_valid ? type[atom_1] : 0;
+    __constant FieldPair_t *coeff = &field->pairs[type_1 * kMaxTypes];
+
+    const real4 length = convert_real4(domain->length);
+    const real4 length_half = convert_real4(domain->length_half);
+    const real r_hard = (real) field->r_hard;
+
+    accum4 force_1 = (accum4) (0.0);
+    accum energy_1 = 0.0;
+    accum16 virial_1 = (accum16) (0.0);
+    ulong n_pairs = 0;
+
+    /*
+     * Loop over the tiles. Every work item reaches the barriers, including
+     * the work items past the last atom.
+     */
+    for (ulong tile_begin = 0; tile_begin < n_atoms; tile_begin += tile_size) {
+        /* Load the tile atoms into local memory. */
+        const ulong tile_ix = tile_begin + local_ix;
+        if (tile_ix < n_atoms) {
+            real4 packed = convert_real4(pos[tile_ix]);
+            packed.w = (real) type[tile_ix];
+            tile[local_ix] = packed;
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        /* Compute the interactions with the tile atoms. */
+        const ulong tile_end = min(tile_size, n_atoms - tile_begin);
+        if (is_valid) {
+            #pragma unroll 4
+            for (ulong ix = 0; ix < tile_end; ++ix) {
+                const ulong atom_2 = tile_begin + ix;
+                if (atom_1 == atom_2) {
+                    continue;
+                }
+
+                const real4 packed = tile[ix];
+                real4 r_12 = pos_1 - packed;
+                r_12.w = 0.0;
+                r_12 = atom_pbc_pair(length, length_half, r_12);
+
+                const FieldPair_t coeff_12 = coeff[(uint) packed.w];
+                if (n_pairs < n_neighbours && dot(r_12, r_12) < (real) coeff_12.r_cut_sq) {
+                    Pair_t pair = atom_force_pair(
+                        atom_1, atom_2, r_12, coeff_12, r_hard);
+                    force_1  -= convert_accum4(pair.gradient);
+                    energy_1 += 0.5f * (accum) pair.energy;
+                    virial_1 += 0.5f * convert_accum16(pair.virial);
+                    n_pairs++;
+                }
+            }
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    if (is_valid) {
+        force[atom_1] = convert_real4(force_1);
+        energy[atom_1] = (real) energy_1;
+        virial[atom_1] = convert_real16(virial_1);
+    }
+}
+
 /**
  * atom_force_pair
- * @brief Compute pair interaction.
+ * @brief Compute pair interaction using the coefficients of the atom type pair.
  */
 Pair_t atom_force_pair(
     const ulong atom_1,
     const ulong atom_2,
-    const double4 r_12,
-    const __global Field_t *field)
+    const real4 r_12,
+    const FieldPair_t coeff,
+    const real r_hard)
 {
     /* Compute pair attributes - energy, gradient, laplacian and virial. */
     Pair_t pair;
@@ -139,54 +257,54 @@ Pair_t atom_force_pair(
     pair.r_12 = r_12;
 
     pair.energy = 0.0;
-    pair.gradient = (double4) (0.0);
-    pair.laplace = (double4) (0.0);
-    pair.virial = (double16) (0.0);
+    pair.gradient = (real4) (0.0);
+    pair.laplace = (real4) (0.0);
+    pair.virial = (real16) (0.0);
 
     /* Interaction coefficients. */
-    const double sigma_sq = field->sigma * field->sigma;
-    const double r_hard_sq = field->r_hard * field->r_hard;
+    const real sigma_sq = (real) (coeff.sigma * coeff.sigma);
+    const real r_hard_sq = r_hard * r_hard;
 
     /* Define pair energy and force coefficients */
-    double energy_coeff = 4.0 * field->epsilon;
-    double force_coeff = 24.0 * field->epsilon / sigma_sq;
+    real energy_coeff = (real) (4.0 * coeff.epsilon);
+    real force_coeff = (real) (24.0 * coeff.epsilon) / sigma_sq;
 
     /* Ensure pair distance is larger than the hard sphere radius. */
-    double energy_hard_sphere = 0.0;
-    double r_12_sq = dot(r_12, r_12);
+    real energy_hard_sphere = 0.0;
+    real r_12_sq = dot(r_12, r_12);
     if (r_12_sq < r_hard_sq) {
         /* Compute the hard sphere energy correction. */
-        double r_12_len = sqrt(r_12_sq);
+        real r_12_len = sqrt(r_12_sq);
 
-        double r_hard_2  = sigma_sq / r_hard_sq;
-        double r_hard_4  = r_hard_2 * r_hard_2;
-        double r_hard_6  = r_hard_4 * r_hard_2;
-        double r_hard_12 = r_hard_6 * r_hard_6;
+        real r_hard_2  = sigma_sq / r_hard_sq;
+        real r_hard_4  = r_hard_2 * r_hard_2;
+        real r_hard_6  = r_hard_4 * r_hard_2;
+        real r_hard_12 = r_hard_6 * r_hard_6;
 
-        energy_hard_sphere = -24.0 * field->epsilon * (2.0 * r_hard_12 - r_hard_6);
-        energy_hard_sphere *= (r_12_len - field->r_hard) / r_12_len;
+        energy_hard_sphere = -(real) (24.0 * coeff.epsilon) * (2.0f * r_hard_12 - r_hard_6);
+        energy_hard_sphere *= (r_12_len - r_hard) / r_12_len;
 
         /* Set the pair distance to the hard sphere radius. */
         r_12_sq = r_hard_sq;
     }
 
-    double rr2  = sigma_sq / r_12_sq;
-    double rr4  = rr2 * rr2;
-    double rr6  = rr4 * rr2;
-    double rr8  = rr4 * rr4;
-    double rr12 = rr6 * rr6;
-    double rr14 = rr8 * rr6;
+    real rr2  = sigma_sq / r_12_sq;
+    real rr4  = rr2 * rr2;
+    real rr6  = rr4 * rr2;
+    real rr8  = rr4 * rr4;
+    real rr12 = rr6 * rr6;
+    real rr14 = rr8 * rr6;
 
     /* LJ energy */
     pair.energy = energy_coeff * (rr12 - rr6) + energy_hard_sphere;
 
     /* LJ gradient */
     pair.gradient = r_12;
-    pair.gradient *= (double4) (-force_coeff * (2.0 * rr14 - rr8));
+    pair.gradient *= (real4) (-force_coeff * (2.0f * rr14 - rr8));
 
     /* LJ laplacian */
-    double laplace_c1 = force_coeff * (28.0 * rr14 - 8.0 * rr8) / r_12_sq;
-    double laplace_c2 = force_coeff * (2.0 * rr14 - rr8);
+    real laplace_c1 = force_coeff * (28.0f * rr14 - 8.0f * rr8) / r_12_sq;
+    real laplace_c2 = force_coeff * (2.0f * rr14 - rr8);
 
     pair.laplace.x = laplace_c1 * r_12.x * r_12.x - laplace_c2;
     pair.laplace.y = laplace_c1 * r_12.y * r_12.y - laplace_c2;
@@ -212,32 +330,70 @@ Pair_t atom_force_pair(
  * atom_pbc
  * @brief Return the periodic image in primary cell of the fluid domain.
  */
-double4 atom_pbc(const __global Domain_t *domain, const double4 pos)
+state4 atom_pbc(const __global Domain_t *domain, const state4 pos)
+{
+    state4 image = pos;
+    const state4 length = convert_state4(domain->length);
+    const state4 length_half = convert_state4(domain->length_half);
+
+    /* pbc along x-dimension */
+    if (image.x < -length_half.x) {
+        image.x += length.x;
+    }
+    if (image.x >  length_half.x) {
+        image.x -= length.x;
+    }
+
+    /* pbc along y-dimension */
+    if (image.y < -length_half.y) {
+        image.y += length.y;
+    }
+    if (image.y >  length_half.y) {
+        image.y -= length.y;
+    }
+
+    /* pbc along z-dimension */
+    if (image.z < -length_half.z) {
+        image.z += length.z;
+    }
+    if (image.z >  length_half.z) {
+        image.z -= length.z;
+    }
+
+    return image;
+}
+
+/**
+ * atom_pbc_pair
+ * @brief Return the minimum image of a pairwise vector, with the domain
+ * lengths loaded once by the force kernel in the pair precision.
+ */
+real4 atom_pbc_pair(const real4 length, const real4 length_half, const real4 r_12)
 {
-    double4 image = pos;
+    real4 image = r_12;
 
     /* pbc along x-dimension */
-    if (image.x < -domain->length_half.x) {
-        image.x += domain->length.x;
+    if (image.x < -length_half.x) {
+        image.x += length.x;
     }
-    if (image.x >  domain->length_half.x) {
-        image.x -= domain->length.x;
+    if (image.x >  length_half.x) {
+        image.x -= length.x;
     }
 
     /* pbc along y-dimension */
-    if (image.y < -domain->length_half.y) {
-        image.y += domain->length.y;
+    if (image.y < -length_half.y) {
+        image.y += length.y;
     }
-    if (image.y >  domain->length_half.y) {
-        image.y -= domain->length.y;
+    if (image.y >  length_half.y) {
+        image.y -= length.y;
     }
 
     /* pbc along z-dimension */
-    if (image.z < -domain->length_half.z) {
-        image.z += domain->length.z;
+    if (image.z < -length_half.z) {
+        image.z += length.z;
     }
-    if (image.z >  domain->length_half.z) {
-        image.z -= domain->length.z;
+    if (image.z >  length_half.z) {
+        image.z -= length.z;
     }
 
     return image;
@@ -249,17 +405,17 @@ double4 atom_pbc(const __global Domain_t *domain, const double4 pos)
  */
 __kernel void atom_copy_vertex(
     const ulong n_atoms,
-    __global Atom_t *atoms,
+    const __global state4 *pos,
     __global float *vertex)
 {
     const ulong atom_ix = get_global_id(0);
     if (atom_ix < n_atoms) {
-        vertex[6 * atom_ix + 0] = atoms[atom_ix].pos.x;
-        vertex[6 * atom_ix + 1] = atoms[atom_ix].pos.y;
-        vertex[6 * atom_ix + 2] = atoms[atom_ix].pos.z;
+        const state4 pos_ix = pos[atom_ix];
+        vertex[6 * atom_ix + 0] = pos_ix.x;
+        vertex[6 * atom_ix + 1] = pos_ix.y;
+        vertex[6 * atom_ix + 2] = pos_ix.z;
         vertex[6 * atom_ix + 3] = 1.0;
         vertex[6 * atom_ix + 4] = 0.0;
         vertex[6 * atom_ix + 5] = 0.0;
     }
 }
-
@@ -5,20 +5,71 @@
 #endif
 
 #define kEmpty  0xffffffff
+#define kMaxTypes 4
 
 /** ---------------------------------------------------------------------------
- * @brief Atom data type.
+ * @brief Device precision, set by the host with -DMD_PRECISION:
+ *  0 double - state, pair interactions and sums in double precision.
+ *  1 mixed  - state and sums in double, pair interactions in single precision.
+ *  2 single - state, pair interactions and sums in single precision.
+ * The state type holds the integrated atom attributes, mass, position and
+ * momentum, the real type holds the force, energy and virial, and the accum
+ * type holds the per-atom sums of the pair interactions. The domain, field,
+ * thermostat and sampler data remain in double precision.
+ */
+#ifndef MD_PRECISION
+#define MD_PRECISION 0
+#endif
+
+#if MD_PRECISION == 2
+typedef float state;
+typedef float4 state4;
+#define convert_state4 convert_float4
+#else
+typedef double state;
+typedef double4 state4;
+#define convert_state4 convert_double4
+#endif
+
+#if MD_PRECISION == 0
+typedef double real;
+typedef double4 real4;
+typedef double16 real16;
+#define convert_real4 convert_double4
+#define convert_real16 convert_double16
+#else
+typedef float real;
+typedef float4 real4;
+typedef float16 real16;
+#define convert_real4 convert_float4
+#define convert_real16 convert_float16
+#endif
+
+#if MD_PRECISION == 2
+typedef float accum;
+typedef float4 accum4;
+typedef float16 accum16;
+#define convert_accum4 convert_float4
+#define convert_accum16 convert_float16
+#else
+typedef double accum;
+typedef double4 accum4;
+typedef double16 accum16;
+#define convert_accum4 convert_double4
+#define convert_accum16 convert_double16
+#endif
+
+/** ---------------------------------------------------------------------------
+ * @brief Atom data is stored in a structure of arrays, one buffer for each
+ * atom attribute, so each kernel only reads the attributes it needs:
+ *  state mass, rmass    - atom mass and inverse mass
+ *  uint type            - atom type
+ *  state4 pos, upos     - periodic image in primary cell, unfolded position
+ *  state4 mom           - momentum
+ *  real4 force          - force
+ *  real energy          - energy
+ *  real16 virial        - virial
  */
-typedef struct {
-    double mass;            /* atom mass */
-    double rmass;           /* inverse mass */
-    double4 pos;            /* periodic image in primary cell */
-    double4 upos;           /* unfolded position */
-    double4 mom;            /* momentum */
-    double4 force;          /* force */
-    double energy;          /* energy */
-    double16 virial;        /* virial */
-} Atom_t;
 
 /**
  * @brief Pair data type.
@@ -26,11 +77,11 @@ typedef struct {
 typedef struct {
     ulong atom_1;           /* first atom index */
     ulong atom_2;           /* second atom index */
-    double4 r_12;           /* pairwise vector */
-    double energy;          /* energy */
-    double4 gradient;       /* gradient */
-    double4 laplace;        /* laplace */
-    double16 virial;        /* virial */
+    real4 r_12;             /* pairwise vector */
+    real energy;            /* energy */
+    real4 gradient;         /* gradient */
+    real4 laplace;          /* laplace */
+    real16 virial;          /* virial */
 } Pair_t;
 
 /**
@@ -42,12 +93,22 @@ typedef struct {
 } Domain_t;
 
 /**
- * @brief Field data type.
+ * @brief Field type pair data type.
  */
 typedef struct {
     double epsilon;         /* LJ pair energy */
     double sigma;           /* LJ pair size */
     double r_cut;           /* LJ cutoff radius */
+    double r_cut_sq;        /* LJ cutoff radius squared */
+} FieldPair_t;
+
+/**
+ * @brief Field data type.
+ */
+typedef struct {
+    FieldPair_t pairs[kMaxTypes * kMaxTypes]; /* type pair coefficients */
+    ulong n_types;          /* number of atom types */
+    double r_cut;           /* Largest LJ cutoff radius */
     double r_skin;          /* Neighbour list skin radius */
     double r_hard;          /* Hard sphere truncation radius */
 } Field_t;
@@ -4,7 +4,8 @@
  */
 __kernel void thermostat_force(
     const ulong n_atoms,
-    __global Atom_t *atoms,
+    const __global state *rmass,
+    const __global state4 *mom,
     __global double *therm_group_grad_sq,
     __global double *therm_group_laplace,
     __local double *therm_local_grad_sq,
@@ -20,9 +21,8 @@ __kernel void thermostat_force(
     therm_local_grad_sq[local_id] = 0.0;
     therm_local_laplace[local_id] = 0.0;
     if (global_id < n_atoms) {
-        double4 mom = atoms[global_id].mom;
-        double rmass = atoms[global_id].rmass;
-        therm_local_grad_sq[local_id] = dot(mom, mom) * rmass;
+        const double4 mom_ix = convert_double4(mom[global_id]);
+        therm_local_grad_sq[local_id] = dot(mom_ix, mom_ix) * rmass[global_id];
         therm_local_laplace[local_id] = 3.0;
     }
 
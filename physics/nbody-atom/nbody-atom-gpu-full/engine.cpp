@@ -11,8 +11,89 @@
 
 #include "atto/opencl/opencl.hpp"
 #include "engine.hpp"
+#include "program.hpp"
 using namespace atto;
 
+/** ---------------------------------------------------------------------------
+ * convert
+ * @brief Convert a host atom attribute between double and device precision.
+ */
+static inline cl_float convert(const cl_double &from, cl_float &to)
+{
+    return (to = (cl_float) from);
+}
+
+static inline cl_double convert(const cl_float &from, cl_double &to)
+{
+    return (to = (cl_double) from);
+}
+
+static inline cl_double convert(const cl_double &from, cl_double &to)
+{
+    return (to = from);
+}
+
+static inline cl_uint convert(const cl_uint &from, cl_uint &to)
+{
+    return (to = from);
+}
+
+template<typename To, typename From>
+static inline To convert(const From &from, To &to)
+{
+    const size_t n = sizeof(to.s) / sizeof(to.s[0]);
+    for (size_t k = 0; k < n; ++k) {
+        convert(from.s[k], to.s[k]);
+    }
+    return to;
+}
+
+/**
+ * copy_attribute_to
+ * @brief Gather an attribute of each atom, converted to the device type T,
+ * and copy it to the specified device buffer.
+ */
+template<typename T, typename Attribute>
+static void copy_attribute_to(
+    const cl_command_queue &queue,
+    const cl_mem &buffer,
+    const std::vector<Atom> &atoms,
+    Attribute attribute)
+{
+    std::vector<T> data(atoms.size());
+    for (size_t ix = 0; ix < atoms.size(); ++ix) {
+        convert(attribute(atoms[ix]), data[ix]);
+    }
+    cl::Queue::enqueue_copy_to(
+        queue,
+        buffer,
+        data.size() * sizeof(data[0]),
+        (void *) &data[0]);
+}
+
+/**
+ * copy_attribute_from
+ * @brief Copy the specified device buffer of type T and scatter it onto an
+ * attribute of each atom.
+ */
+template<typename T, typename Attribute>
+static void copy_attribute_from(
+    const cl_command_queue &queue,
+    const cl_mem &buffer,
+    std::vector<Atom> &atoms,
+    Attribute attribute)
+{
+    std::vector<T> data(atoms.size());
+    cl::Queue::enqueue_copy_from(
+        queue,
+        buffer,
+        data.size() * sizeof(data[0]),
+        (void *) &data[0]);
+    for (size_t ix = 0; ix < atoms.size(); ++ix) {
+        convert(data[ix], attribute(atoms[ix]));
+    }
+}
+
 /** ---------------------------------------------------------------------------
  * Engine::setup
  * @brief Setup engine data.
@@ -31,12 +112,34 @@ void Engine::setup(
         m_atoms.resize(Params::n_atoms, Atom{
             .mass = Params::atom_mass,          /* atom mass */
             .rmass = 1.0 / Params::atom_mass,   /* inverse mass */
+            .type = 0,                          /* atom type */
             .pos = cl_double4{},                /* periodic image in primary cell */
             .upos = cl_double4{},               /* unfolded position */
             .mom = cl_double4{},                /* momentum */
             .force = cl_double4{}               /* force */
         });
 
+        /*
+         * Assign the atom types in contiguous blocks with the specified number
+         * fractions. Atoms are kept sorted by type, so the force kernel reads
+         * the same row of the type pair table along each block.
+         */
+        core_assert(Params::n_types <= Field::max_types, "invalid number of types");
+        cl_ulong atom_ix = 0;
+        for (cl_uint type = 0; type < Params::n_types; ++type) {
+            cl_ulong count = (cl_ulong) (Params::type_fraction[type] * Params::n_atoms);
+            if (type + 1 == Params::n_types) {
+                count = Params::n_atoms - atom_ix;
+            }
+
+            cl_double mass = Params::atom_mass * Params::type_mass[type];
+            for (cl_ulong end = atom_ix + count; atom_ix < end; ++atom_ix) {
+                m_atoms[atom_ix].mass = mass;
+                m_atoms[atom_ix].rmass = 1.0 / mass;
+                m_atoms[atom_ix].type = type;
+            }
+        }
+
         /* Create fluid domain. */
         cl_double volume = (cl_double) Params::n_atoms / Params::density;
         cl_double length = std::pow(volume, 1.0 / 3.0);
@@ -44,13 +147,29 @@ void Engine::setup(
             cl_double4{length, length, length, 0.0 /*unused*/},
             cl_double4{0.5*length, 0.5*length, 0.5*length, 0.0 /*unused*/}};
 
-        /* Create fluid force field. */
-        m_field = Field{
-            Params::pair_epsilon,
-            Params::pair_sigma,
-            Params::pair_r_cut * Params::pair_sigma,
-            Params::pair_r_skin * Params::pair_sigma,
-            Params::pair_r_hard * Params::pair_sigma};
+        /*
+         * Create fluid force field. Mix the coefficients of each type pair
+         * using Lorentz-Berthelot rules, with a cutoff radius scaled by the
+         * pair size.
+         */
+        m_field = Field{};
+        m_field.n_types = Params::n_types;
+        m_field.r_cut = 0.0;
+        m_field.r_skin = Params::pair_r_skin * Params::pair_sigma;
+        m_field.r_hard = Params::pair_r_hard * Params::pair_sigma;
+        for (cl_ulong type_1 = 0; type_1 < Params::n_types; ++type_1) {
+            for (cl_ulong type_2 = 0; type_2 < Params::n_types; ++type_2) {
+                cl_double epsilon = Params::pair_epsilon * std::sqrt(
+                    Params::type_epsilon[type_1] * Params::type_epsilon[type_2]);
+                cl_double sigma = Params::pair_sigma * 0.5 * (
+                    Params::type_sigma[type_1] + Params::type_sigma[type_2]);
+                cl_double r_cut = Params::pair_r_cut * sigma;
+
+                m_field.pairs[type_1 * Field::max_types + type_2] = FieldPair{
+                    epsilon, sigma, r_cut, r_cut * r_cut};
+                m_field.r_cut = std::max(m_field.r_cut, r_cut);
+            }
+        }
 
         /* Setup thermostat */
         m_thermostat = Thermostat{
@@ -85,32 +204,86 @@ void Engine::setup(
         m_context = context;
         m_device = device;
         m_queue = queue;
+        m_pipeline.setup(m_queue);
 
         /* Create engine program object. */
         std::string source;
         source.append(cl::Program::load_source_from_file("data/base.cl"));
         source.append(cl::Program::load_source_from_file("data/atom.cl"));
         source.append(cl::Program::load_source_from_file("data/thermostat.cl"));
-        m_program = cl::Program::create_from_source(m_context, source);
-        cl::Program::build(m_program, m_device, "");
-        std::cout << cl::Program::get_source(m_program) << "\n";
+        source.append(cl::Program::load_source_from_file("data/sampler.cl"));
+        std::string options = "-DMD_PRECISION=" + std::to_string(Params::precision);
+        m_program = common::BuildProgram(m_context, m_device, source, options);
+        std::cout << source << "\n";
 
         /* Create engine kernels. */
         m_kernels.resize(NumKernels, NULL);
         m_kernels[KernelAtomBeginIntegrate] = cl::Kernel::create(m_program, "atom_begin_integrate");
         m_kernels[KernelAtomEndIntegrate] = cl::Kernel::create(m_program, "atom_end_integrate");
         m_kernels[KernelAtomUpdate] = cl::Kernel::create(m_program, "atom_update");
-        m_kernels[KernelAtomForce] = cl::Kernel::create(m_program, "atom_force");
+        m_kernels[KernelAtomForce] = cl::Kernel::create(
+            m_program, Params::force_tiled ? "atom_force_tiled" : "atom_force");
         m_kernels[KernelAtomCopyVertex]= cl::Kernel::create(m_program, "atom_copy_vertex");
         m_kernels[KernelThermostatForce] = cl::Kernel::create(m_program, "thermostat_force");
         m_kernels[KernelThermostatIntegrate] = cl::Kernel::create(m_program, "thermostat_integrate");
+        m_kernels[KernelSamplerReduce] = cl::Kernel::create(m_program, "sampler_reduce");
+        m_kernels[KernelSamplerThermo] = cl::Kernel::create(m_program, "sampler_thermo");
 
         /* Create engine device buffer objects. */
         m_buffers.resize(NumBuffers, NULL);
-        m_buffers[BufferAtoms] = cl::Memory::create_buffer(
+        /* Create the atom attribute buffers, a structure of arrays. */
+        m_buffers[BufferAtomMass] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE,
+            Params::n_atoms * sizeof(State),
+            (void *) NULL);
+
+        m_buffers[BufferAtomRmass] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE,
+            Params::n_atoms * sizeof(State),
+            (void *) NULL);
+
+        m_buffers[BufferAtomType] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE,
+            Params::n_atoms * sizeof(cl_uint),
+            (void *) NULL);
+
+        m_buffers[BufferAtomPos] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE,
+            Params::n_atoms * sizeof(State4),
+            (void *) NULL);
+
+        m_buffers[BufferAtomUpos] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE,
+            Params::n_atoms * sizeof(State4),
+            (void *) NULL);
+
+        m_buffers[BufferAtomMom] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE,
+            Params::n_atoms * sizeof(State4),
+            (void *) NULL);
+
+        m_buffers[BufferAtomForce] = cl::Memory::create_buffer(
             m_context,
             CL_MEM_READ_WRITE,
-            Params::n_atoms * sizeof(Atom),
+            Params::n_atoms * sizeof(Real4),
+            (void *) NULL);
+
+        m_buffers[BufferAtomEnergy] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE,
+            Params::n_atoms * sizeof(Real),
+            (void *) NULL);
+
+        m_buffers[BufferAtomVirial] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE,
+            Params::n_atoms * sizeof(Real16),
             (void *) NULL);
 
         m_buffers[BufferField] = cl::Memory::create_buffer(
@@ -142,21 +315,50 @@ void Engine::setup(
             CL_MEM_READ_WRITE,
             Params::num_work_groups * sizeof(cl_double),
             (void *) NULL);
-        m_buffers[BufferGLVertexAtom] = cl::gl::create_from_gl_buffer(
+
+        m_buffers[BufferSamplerSums] = cl::Memory::create_buffer(
             m_context,
-            CL_MEM_WRITE_ONLY,
-            gl_vertex_buffer);
+            CL_MEM_READ_WRITE,
+            Params::sampler_num_work_groups * Params::sampler_items * sizeof(cl_double),
+            (void *) NULL);
+
+        m_buffers[BufferThermo] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE,
+            sizeof(Thermo),
+            (void *) NULL);
+
+        /*
+         * Create the shared OpenGL vertex buffer, the snapshot buffers and
+         * the render queue unless running headless.
+         */
+        if (gl_vertex_buffer != 0) {
+            m_buffers[BufferGLVertexAtom] = cl::gl::create_from_gl_buffer(
+                m_context,
+                CL_MEM_WRITE_ONLY,
+                gl_vertex_buffer);
+
+            m_buffers[BufferSnapshot0] = cl::Memory::create_buffer(
+                m_context,
+                CL_MEM_READ_WRITE,
+                6 * Params::n_atoms * sizeof(cl_float),
+                (void *) NULL);
+
+            m_buffers[BufferSnapshot1] = cl::Memory::create_buffer(
+                m_context,
+                CL_MEM_READ_WRITE,
+                6 * Params::n_atoms * sizeof(cl_float),
+                (void *) NULL);
+
+            m_render_queue = common::CreateQueue(m_context, m_device);
+        }
     }
 
     /*
      * Copy engine data to the device.
      */
     {
-        cl::Queue::enqueue_copy_to(
-            m_queue,
-            m_buffers[BufferAtoms],
-            m_atoms.size() * sizeof(m_atoms[0]),
-            (void *) &m_atoms[0]);
+        copy_atoms_to();
 
         cl::Queue::enqueue_copy_to(
             m_queue,
@@ -176,6 +378,11 @@ void Engine::setup(
             sizeof(m_thermostat),
             (void *) &m_thermostat);
     }
+
+    /*
+     * Bind the kernel arguments.
+     */
+    bind();
 }
 
 /**
@@ -186,6 +393,11 @@ void Engine::teardown(void)
 {
     /* Teardown model data. */
     {
+        /* Collect the pending sample and copy the atoms from the device. */
+        std::cout << sample_collect();
+        m_pipeline.finish();
+        copy_atoms_from();
+
         /* Write xyz snapshot and sampler statistics. */
         core::FileOut fileout;
 
@@ -202,11 +414,23 @@ void Engine::teardown(void)
 
     /* Teardown OpenCL data. */
     {
+        m_pipeline.teardown();
+        for (auto &it : m_snapshot_events) {
+            if (it != NULL) {
+                clReleaseEvent(it);
+                it = NULL;
+            }
+        }
+        if (m_render_queue != NULL) {
+            cl::Queue::release(m_render_queue);
+        }
         for (auto &it : m_images) {
             cl::Memory::release(it);
         }
         for (auto &it : m_buffers) {
-            cl::Memory::release(it);
+            if (it != NULL) {
+                cl::Memory::release(it);
+            }
         }
         for (auto &it : m_kernels) {
             cl::Kernel::release(it);
@@ -216,191 +440,366 @@ void Engine::teardown(void)
 }
 
 /** ---------------------------------------------------------------------------
- * Engine::execute
- * @brief Engine integration step.
+ * Engine::copy_atoms_to
+ * @brief Copy the atoms to the device, one buffer per atom attribute in the
+ * device precision.
  */
-void Engine::execute(void)
+void Engine::copy_atoms_to(void)
+{
+    copy_attribute_to<State>(m_queue, m_buffers[BufferAtomMass], m_atoms,
+        [] (const Atom &atom) { return atom.mass; });
+    copy_attribute_to<State>(m_queue, m_buffers[BufferAtomRmass], m_atoms,
+        [] (const Atom &atom) { return atom.rmass; });
+    copy_attribute_to<cl_uint>(m_queue, m_buffers[BufferAtomType], m_atoms,
+        [] (const Atom &atom) { return atom.type; });
+    copy_attribute_to<State4>(m_queue, m_buffers[BufferAtomPos], m_atoms,
+        [] (const Atom &atom) { return atom.pos; });
+    copy_attribute_to<State4>(m_queue, m_buffers[BufferAtomUpos], m_atoms,
+        [] (const Atom &atom) { return atom.upos; });
+    copy_attribute_to<State4>(m_queue, m_buffers[BufferAtomMom], m_atoms,
+        [] (const Atom &atom) { return atom.mom; });
+    copy_attribute_to<Real4>(m_queue, m_buffers[BufferAtomForce], m_atoms,
+        [] (const Atom &atom) { return atom.force; });
+    copy_attribute_to<Real>(m_queue, m_buffers[BufferAtomEnergy], m_atoms,
+        [] (const Atom &atom) { return atom.energy; });
+    copy_attribute_to<Real16>(m_queue, m_buffers[BufferAtomVirial], m_atoms,
+        [] (const Atom &atom) { return atom.virial; });
+}
+
+/**
+ * Engine::copy_atoms_from
+ * @brief Copy the atom attributes updated by the device kernels back to the
+ * host atoms. The mass and type are only written by the host.
+ */
+void Engine::copy_atoms_from(void)
+{
+    copy_attribute_from<State4>(m_queue, m_buffers[BufferAtomPos], m_atoms,
+        [] (Atom &atom) -> cl_double4 & { return atom.pos; });
+    copy_attribute_from<State4>(m_queue, m_buffers[BufferAtomUpos], m_atoms,
+        [] (Atom &atom) -> cl_double4 & { return atom.upos; });
+    copy_attribute_from<State4>(m_queue, m_buffers[BufferAtomMom], m_atoms,
+        [] (Atom &atom) -> cl_double4 & { return atom.mom; });
+    copy_attribute_from<Real4>(m_queue, m_buffers[BufferAtomForce], m_atoms,
+        [] (Atom &atom) -> cl_double4 & { return atom.force; });
+    copy_attribute_from<Real>(m_queue, m_buffers[BufferAtomEnergy], m_atoms,
+        [] (Atom &atom) -> cl_double & { return atom.energy; });
+    copy_attribute_from<Real16>(m_queue, m_buffers[BufferAtomVirial], m_atoms,
+        [] (Atom &atom) -> cl_double16 & { return atom.virial; });
+}
+
+/** ---------------------------------------------------------------------------
+ * Engine::bind
+ * @brief Bind the kernel arguments. The arguments are the same in every
+ * integration step, so they are set once rather than on every step.
+ */
+void Engine::bind(void)
 {
     const cl_double half_t_step = 0.5 * Params::t_step;
+    const cl_uint n_groups = Params::sampler_num_work_groups;
+
+    cl::Kernel::set_arg(m_kernels[KernelAtomUpdate], 0, sizeof(cl_ulong), &Params::n_atoms);
+    cl::Kernel::set_arg(m_kernels[KernelAtomUpdate], 1, sizeof(cl_mem), &m_buffers[BufferAtomPos]);
+    cl::Kernel::set_arg(m_kernels[KernelAtomUpdate], 2, sizeof(cl_mem), &m_buffers[BufferDomain]);
+    cl::Kernel::set_arg(m_kernels[KernelAtomBeginIntegrate], 0, sizeof(cl_double), (void *) &Params::t_step);
+    cl::Kernel::set_arg(m_kernels[KernelAtomBeginIntegrate], 1, sizeof(cl_ulong), &Params::n_atoms);
+    cl::Kernel::set_arg(m_kernels[KernelAtomBeginIntegrate], 2, sizeof(cl_mem), &m_buffers[BufferAtomRmass]);
+    cl::Kernel::set_arg(m_kernels[KernelAtomBeginIntegrate], 3, sizeof(cl_mem), &m_buffers[BufferAtomPos]);
+    cl::Kernel::set_arg(m_kernels[KernelAtomBeginIntegrate], 4, sizeof(cl_mem), &m_buffers[BufferAtomUpos]);
+    cl::Kernel::set_arg(m_kernels[KernelAtomBeginIntegrate], 5, sizeof(cl_mem), &m_buffers[BufferAtomMom]);
+    cl::Kernel::set_arg(m_kernels[KernelAtomBeginIntegrate], 6, sizeof(cl_mem), &m_buffers[BufferAtomForce]);
+    cl::Kernel::set_arg(m_kernels[KernelAtomBeginIntegrate], 7, sizeof(cl_mem), &m_buffers[BufferThermostat]);
+    cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 0, sizeof(cl_ulong), &Params::n_atoms);
+    cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 1, sizeof(cl_mem), &m_buffers[BufferAtomRmass]);
+    cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 2, sizeof(cl_mem), &m_buffers[BufferAtomMom]);
+    cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 3, sizeof(cl_mem), &m_buffers[BufferThermostatGradSq]);
+    cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 4, sizeof(cl_mem), &m_buffers[BufferThermostatLaplace]);
+    cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 5, Params::work_group_size * sizeof(cl_double), NULL);
+    cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 6, Params::work_group_size * sizeof(cl_double), NULL);
+    cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 0, sizeof(cl_double), (void *) &half_t_step);
+    cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 1, sizeof(cl_mem), &m_buffers[BufferThermostatGradSq]);
+    cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 2, sizeof(cl_mem), &m_buffers[BufferThermostatLaplace]);
+    cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 3, sizeof(cl_mem), &m_buffers[BufferThermostat]);
+    cl::Kernel::set_arg(m_kernels[KernelAtomForce], 0, sizeof(cl_ulong), &Params::n_atoms);
+    cl::Kernel::set_arg(m_kernels[KernelAtomForce], 1, sizeof(cl_ulong), &Params::n_neighbours);
+    cl::Kernel::set_arg(m_kernels[KernelAtomForce], 2, sizeof(cl_mem), &m_buffers[BufferAtomType]);
+    cl::Kernel::set_arg(m_kernels[KernelAtomForce], 3, sizeof(cl_mem), &m_buffers[BufferAtomPos]);
+    cl::Kernel::set_arg(m_kernels[KernelAtomForce], 4, sizeof(cl_mem), &m_buffers[BufferAtomForce]);
+    cl::Kernel::set_arg(m_kernels[KernelAtomForce], 5, sizeof(cl_mem), &m_buffers[BufferAtomEnergy]);
+    cl::Kernel::set_arg(m_kernels[KernelAtomForce], 6, sizeof(cl_mem), &m_buffers[BufferAtomVirial]);
+    cl::Kernel::set_arg(m_kernels[KernelAtomForce], 7, sizeof(cl_mem), &m_buffers[BufferDomain]);
+    cl::Kernel::set_arg(m_kernels[KernelAtomForce], 8, sizeof(cl_mem), &m_buffers[BufferField]);
+    if (Params::force_tiled) {
+        cl::Kernel::set_arg(m_kernels[KernelAtomForce], 9, Params::work_group_size * sizeof(Real4), NULL);
+    }
+    cl::Kernel::set_arg(m_kernels[KernelAtomEndIntegrate], 0, sizeof(cl_double), (void *) &Params::t_step);
+    cl::Kernel::set_arg(m_kernels[KernelAtomEndIntegrate], 1, sizeof(cl_ulong), &Params::n_atoms);
+    cl::Kernel::set_arg(m_kernels[KernelAtomEndIntegrate], 2, sizeof(cl_mem), &m_buffers[BufferAtomMom]);
+    cl::Kernel::set_arg(m_kernels[KernelAtomEndIntegrate], 3, sizeof(cl_mem), &m_buffers[BufferAtomForce]);
+    cl::Kernel::set_arg(m_kernels[KernelAtomEndIntegrate], 4, sizeof(cl_mem), &m_buffers[BufferThermostat]);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerReduce], 0, sizeof(cl_ulong), &Params::n_atoms);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerReduce], 1, sizeof(cl_mem), &m_buffers[BufferAtomMass]);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerReduce], 2, sizeof(cl_mem), &m_buffers[BufferAtomRmass]);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerReduce], 3, sizeof(cl_mem), &m_buffers[BufferAtomPos]);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerReduce], 4, sizeof(cl_mem), &m_buffers[BufferAtomUpos]);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerReduce], 5, sizeof(cl_mem), &m_buffers[BufferAtomMom]);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerReduce], 6, sizeof(cl_mem), &m_buffers[BufferAtomForce]);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerReduce], 7, sizeof(cl_mem), &m_buffers[BufferAtomEnergy]);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerReduce], 8, sizeof(cl_mem), &m_buffers[BufferAtomVirial]);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerReduce], 9, sizeof(cl_mem), &m_buffers[BufferSamplerSums]);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerReduce], 10, Params::sampler_work_group_size * Params::sampler_items * sizeof(cl_double), NULL);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerThermo], 0, sizeof(cl_ulong), &Params::n_atoms);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerThermo], 1, sizeof(cl_uint), &n_groups);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerThermo], 2, sizeof(cl_mem), &m_buffers[BufferSamplerSums]);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerThermo], 3, sizeof(cl_mem), &m_buffers[BufferDomain]);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerThermo], 4, sizeof(cl_mem), &m_buffers[BufferThermo]);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerThermo], 5, Params::sampler_work_group_size * Params::sampler_items * sizeof(cl_double), NULL);
+
+    if (m_buffers[BufferGLVertexAtom] != NULL) {
+        cl::Kernel::set_arg(m_kernels[KernelAtomCopyVertex], 0, sizeof(cl_ulong), &Params::n_atoms);
+        cl::Kernel::set_arg(m_kernels[KernelAtomCopyVertex], 1, sizeof(cl_mem), &m_buffers[BufferAtomPos]);
+    }
+}
 
+/** ---------------------------------------------------------------------------
+ * Engine::execute
+ * @brief Engine integration step. The kernel arguments are bound by
+ * Engine::bind and the kernels are enqueued on the pipeline, each waiting on
+ * the kernels it depends on.
+ */
+void Engine::execute(void)
+{
     /*
      * Update fluid state and associated data structures.
      */
-    {
-        /* Update atom positions and associated data structures. */
-        cl::Kernel::set_arg(m_kernels[KernelAtomUpdate], 0, sizeof(cl_ulong), &Params::n_atoms);
-        cl::Kernel::set_arg(m_kernels[KernelAtomUpdate], 1, sizeof(cl_mem), &m_buffers[BufferAtoms]);
-        cl::Kernel::set_arg(m_kernels[KernelAtomUpdate], 2, sizeof(cl_mem), &m_buffers[BufferDomain]);
-        cl::Queue::enqueue_nd_range_kernel(
-            m_queue,
-            m_kernels[KernelAtomUpdate],
-            cl::NDRange::Null,
-            cl::NDRange::Make(Params::n_atoms, Params::work_group_size),
-            cl::NDRange(Params::work_group_size),
-            NULL,
-            NULL);
-    }
+    cl_event update = m_pipeline.enqueue(
+        m_kernels[KernelAtomUpdate],
+        Params::n_atoms,
+        Params::work_group_size,
+        {m_pipeline.m_frontier});
 
     /*
-     * Begin integration - first half of the integration step.
+     * Begin integration - first half of the integration step. The thermostat
+     * only depends on the atom momenta, so its integration may execute
+     * concurrently with the force computation.
      */
-    {
-        /* Integrate the atoms at half time step. */
-        cl::Kernel::set_arg(m_kernels[KernelAtomBeginIntegrate], 0, sizeof(cl_double), (void *) &Params::t_step);
-        cl::Kernel::set_arg(m_kernels[KernelAtomBeginIntegrate], 1, sizeof(cl_ulong), &Params::n_atoms);
-        cl::Kernel::set_arg(m_kernels[KernelAtomBeginIntegrate], 2, sizeof(cl_mem), &m_buffers[BufferAtoms]);
-        cl::Kernel::set_arg(m_kernels[KernelAtomBeginIntegrate], 3, sizeof(cl_mem), &m_buffers[BufferThermostat]);
-        cl::Queue::enqueue_nd_range_kernel(
-            m_queue,
-            m_kernels[KernelAtomBeginIntegrate],
-            cl::NDRange::Null,
-            cl::NDRange::Make(Params::n_atoms, Params::work_group_size),
-            cl::NDRange(Params::work_group_size),
-            NULL,
-            NULL);
-
-        /* Compute thermostat force using the updated atom momenta. */
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 0, sizeof(cl_ulong), &Params::n_atoms);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 1, sizeof(cl_mem), &m_buffers[BufferAtoms]);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 2, sizeof(cl_mem), &m_buffers[BufferThermostatGradSq]);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 3, sizeof(cl_mem), &m_buffers[BufferThermostatLaplace]);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 4, Params::work_group_size * sizeof(cl_double), NULL);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 5, Params::work_group_size * sizeof(cl_double), NULL);
-        cl::Queue::enqueue_nd_range_kernel(
-            m_queue,
-            m_kernels[KernelThermostatForce],
-            cl::NDRange::Null,
-            cl::NDRange::Make(Params::n_atoms, Params::work_group_size),
-            cl::NDRange(Params::work_group_size),
-            NULL,
-            NULL);
-
-        /* Integrate thermostat using the computed forces. */
-        cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 0, sizeof(cl_double), (void *) &half_t_step);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 1, sizeof(cl_mem), &m_buffers[BufferThermostatGradSq]);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 2, sizeof(cl_mem), &m_buffers[BufferThermostatLaplace]);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 3, sizeof(cl_mem), &m_buffers[BufferThermostat]);
-        cl::Queue::enqueue_nd_range_kernel(
-            m_queue,
-            m_kernels[KernelThermostatIntegrate],
-            cl::NDRange::Null,
-            cl::NDRange::Make(Params::n_atoms, Params::work_group_size),
-            cl::NDRange(Params::work_group_size),
-            NULL,
-            NULL);
-    }
+    cl_event begin_integrate = m_pipeline.enqueue(
+        m_kernels[KernelAtomBeginIntegrate],
+        Params::n_atoms,
+        Params::work_group_size,
+        {update});
+    cl_event begin_thermostat_force = m_pipeline.enqueue(
+        m_kernels[KernelThermostatForce],
+        Params::n_atoms,
+        Params::work_group_size,
+        {begin_integrate});
+    cl_event begin_thermostat = m_pipeline.enqueue(
+        m_kernels[KernelThermostatIntegrate],
+        Params::n_atoms,
+        Params::work_group_size,
+        {begin_thermostat_force});
 
     /*
      * Compute fluid forces.
      */
-    {
-        cl::Kernel::set_arg(m_kernels[KernelAtomForce], 0, sizeof(cl_ulong), &Params::n_atoms);
-        cl::Kernel::set_arg(m_kernels[KernelAtomForce], 1, sizeof(cl_ulong), &Params::n_neighbours);
-        cl::Kernel::set_arg(m_kernels[KernelAtomForce], 2, sizeof(cl_mem), &m_buffers[BufferAtoms]);
-        cl::Kernel::set_arg(m_kernels[KernelAtomForce], 3, sizeof(cl_mem), &m_buffers[BufferDomain]);
-        cl::Kernel::set_arg(m_kernels[KernelAtomForce], 4, sizeof(cl_mem), &m_buffers[BufferField]);
-        cl::Queue::enqueue_nd_range_kernel(
-            m_queue,
-            m_kernels[KernelAtomForce],
-            cl::NDRange::Null,
-            cl::NDRange::Make(Params::n_atoms, Params::work_group_size),
-            cl::NDRange(Params::work_group_size),
-            NULL,
-            NULL);
-    }
+    cl_event force = m_pipeline.enqueue(
+        m_kernels[KernelAtomForce],
+        Params::n_atoms,
+        Params::work_group_size,
+        {begin_integrate});
 
     /*
      * End integration - second half of the integration step.
      */
-    {
-        /* Compute thermostat force using the updated atom momenta. */
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 0, sizeof(cl_ulong), &Params::n_atoms);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 1, sizeof(cl_mem), &m_buffers[BufferAtoms]);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 2, sizeof(cl_mem), &m_buffers[BufferThermostatGradSq]);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 3, sizeof(cl_mem), &m_buffers[BufferThermostatLaplace]);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 4, Params::work_group_size * sizeof(cl_double), NULL);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 5, Params::work_group_size * sizeof(cl_double), NULL);
-        cl::Queue::enqueue_nd_range_kernel(
-            m_queue,
-            m_kernels[KernelThermostatForce],
-            cl::NDRange::Null,
-            cl::NDRange::Make(Params::n_atoms, Params::work_group_size),
-            cl::NDRange(Params::work_group_size),
-            NULL,
-            NULL);
-
-        /* Integrate thermostat using the computed forces. */
-        cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 0, sizeof(cl_double), (void *) &half_t_step);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 1, sizeof(cl_mem), &m_buffers[BufferThermostatGradSq]);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 2, sizeof(cl_mem), &m_buffers[BufferThermostatLaplace]);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 3, sizeof(cl_mem), &m_buffers[BufferThermostat]);
-        cl::Queue::enqueue_nd_range_kernel(
-            m_queue,
-            m_kernels[KernelThermostatIntegrate],
-            cl::NDRange::Null,
-            cl::NDRange::Make(Params::n_atoms, Params::work_group_size),
-            cl::NDRange(Params::work_group_size),
-            NULL,
-            NULL);
-
-        /* Integrate the momenta for half time step. */
-        cl::Kernel::set_arg(m_kernels[KernelAtomEndIntegrate], 0, sizeof(cl_double), (void *) &Params::t_step);
-        cl::Kernel::set_arg(m_kernels[KernelAtomEndIntegrate], 1, sizeof(cl_ulong), &Params::n_atoms);
-        cl::Kernel::set_arg(m_kernels[KernelAtomEndIntegrate], 2, sizeof(cl_mem), &m_buffers[BufferAtoms]);
-        cl::Kernel::set_arg(m_kernels[KernelAtomEndIntegrate], 3, sizeof(cl_mem), &m_buffers[BufferThermostat]);
-        cl::Queue::enqueue_nd_range_kernel(
-            m_queue,
-            m_kernels[KernelAtomEndIntegrate],
-            cl::NDRange::Null,
-            cl::NDRange::Make(Params::n_atoms, Params::work_group_size),
-            cl::NDRange(Params::work_group_size),
-            NULL,
-            NULL);
+    cl_event end_thermostat_force = m_pipeline.enqueue(
+        m_kernels[KernelThermostatForce],
+        Params::n_atoms,
+        Params::work_group_size,
+        {begin_thermostat});
+    cl_event end_thermostat = m_pipeline.enqueue(
+        m_kernels[KernelThermostatIntegrate],
+        Params::n_atoms,
+        Params::work_group_size,
+        {end_thermostat_force});
+    cl_event end_integrate = m_pipeline.enqueue(
+        m_kernels[KernelAtomEndIntegrate],
+        Params::n_atoms,
+        Params::work_group_size,
+        {force, end_thermostat});
+
+    Pipeline::release({
+        update,
+        begin_integrate,
+        begin_thermostat_force,
+        begin_thermostat,
+        force,
+        end_thermostat_force,
+        end_thermostat});
+    m_pipeline.advance(end_integrate);
+}
+
+/**
+ * Engine::execute
+ * @brief Execute the specified number of integration steps back-to-back,
+ * without any host synchronization.
+ */
+void Engine::execute(const cl_ulong n_steps)
+{
+    for (cl_ulong step = 0; step < n_steps; ++step) {
+        execute();
     }
+}
 
-    /*
-     * Copy atom positions onto the shared OpenGL vertex buffer object.
-     */
-    {
-        /* Wait for OpenGL to finish and acquire the gl objects. */
-        cl::gl::enqueue_acquire_gl_objects(m_queue, 1, &m_buffers[BufferGLVertexAtom], NULL, NULL);
-
-        /* Enqueue the OpenCL kernel for execution. */
-        cl::Kernel::set_arg(m_kernels[KernelAtomCopyVertex],
-            0, sizeof(cl_ulong), &Params::n_atoms);
-        cl::Kernel::set_arg(m_kernels[KernelAtomCopyVertex],
-            1, sizeof(cl_mem), &m_buffers[BufferAtoms]);
-        cl::Kernel::set_arg(m_kernels[KernelAtomCopyVertex],
-            2, sizeof(cl_mem), &m_buffers[BufferGLVertexAtom]);
-        cl::Queue::enqueue_nd_range_kernel(
-            m_queue,
-            m_kernels[KernelAtomCopyVertex],
-            cl::NDRange::Null,
-            cl::NDRange::Make(Params::n_atoms, Params::work_group_size),
-            cl::NDRange(Params::work_group_size),
-            NULL,
-            NULL);
-
-        /* Wait for OpenCL to finish and release the gl objects. */
-        cl::gl::enqueue_release_gl_objects(m_queue, 1, &m_buffers[BufferGLVertexAtom], NULL, NULL);
+/** ---------------------------------------------------------------------------
+ * Engine::snapshot
+ * @brief Copy the atom positions into the back snapshot buffer, after the
+ * last enqueued step and before the next one. The snapshot does not involve
+ * the OpenGL objects, so the engine queue never waits on OpenGL. The back
+ * buffer is free, its last present completed before present returned.
+ */
+void Engine::snapshot(void)
+{
+    if (m_buffers[BufferGLVertexAtom] == NULL) {
+        return;
+    }
+
+    /* Copy the atom positions into the back snapshot buffer. */
+    const size_t back = m_snapshot_ix ^ 1;
+    cl::Kernel::set_arg(m_kernels[KernelAtomCopyVertex], 2, sizeof(cl_mem), &m_buffers[BufferSnapshot0 + back]);
+    cl_event copy_vertex = m_pipeline.enqueue(
+        m_kernels[KernelAtomCopyVertex],
+        Params::n_atoms,
+        Params::work_group_size,
+        {m_pipeline.m_frontier});
+    m_pipeline.advance(copy_vertex);
+
+    /* Mark the snapshot completion and swap the snapshot buffers. */
+    if (m_snapshot_events[back] != NULL) {
+        clReleaseEvent(m_snapshot_events[back]);
     }
+    cl_int err = clEnqueueMarkerWithWaitList(
+        m_queue, 0, NULL, &m_snapshot_events[back]);
+    core_assert(err == CL_SUCCESS, "failed to enqueue marker");
+    clFlush(m_queue);
+    m_snapshot_ix = back;
+}
+
+/**
+ * Engine::present
+ * @brief Copy the latest completed snapshot onto the shared OpenGL vertex
+ * buffer on the render queue. If the latest snapshot is still pending behind
+ * the engine steps, the previous snapshot is presented instead, so a frame
+ * only waits on the engine before the first two snapshots complete.
+ */
+void Engine::present(void)
+{
+    size_t front = m_snapshot_ix;
+    if (m_buffers[BufferGLVertexAtom] == NULL ||
+        m_snapshot_events[front] == NULL) {
+        return;
+    }
+
+    cl_int status = CL_COMPLETE;
+    clGetEventInfo(
+        m_snapshot_events[front],
+        CL_EVENT_COMMAND_EXECUTION_STATUS,
+        sizeof(status),
+        &status,
+        NULL);
+    if (status != CL_COMPLETE && m_snapshot_events[front ^ 1] != NULL) {
+        front ^= 1;
+    }
+
+    /* Wait for OpenGL to finish and acquire the gl objects. */
+    glFinish();
+    cl::gl::enqueue_acquire_gl_objects(m_render_queue, 1, &m_buffers[BufferGLVertexAtom], NULL, NULL);
+
+    /* Copy the snapshot after it completes on the engine queue. */
+    cl_int err = clEnqueueCopyBuffer(
+        m_render_queue,
+        m_buffers[BufferSnapshot0 + front],
+        m_buffers[BufferGLVertexAtom],
+        0,
+        0,
+        6 * Params::n_atoms * sizeof(cl_float),
+        1,
+        &m_snapshot_events[front],
+        NULL);
+    core_assert(err == CL_SUCCESS, "failed to enqueue snapshot copy");
+
+    /* Wait for OpenCL to finish and release the gl objects. */
+    cl::gl::enqueue_release_gl_objects(m_render_queue, 1, &m_buffers[BufferGLVertexAtom], NULL, NULL);
+    clFinish(m_render_queue);
 }
 
 /**
  * Engine::sample
- * @brief Sample fluid thermodynamic properties.
+ * @brief Sample fluid thermodynamic properties. The properties are reduced
+ * on the device in two stages, a partial sum over the atoms of each work
+ * group and a final sum over the work groups. Only the reduced properties
+ * are read back to the host, asynchronously, and are collected by the next
+ * call to sample, so sampling does not stall the host.
  */
-std::string Engine::sample(void)
+std::string Engine::sample(const cl_ulong step)
 {
-    cl::Queue::enqueue_copy_from(
+    /* Collect the previous sample. */
+    std::string log = sample_collect();
+
+    /*
+     * Reduce the atom partial sums of each work group, then reduce the work
+     * group partial sums and compute the properties.
+     */
+    cl_event reduce = m_pipeline.enqueue(
+        m_kernels[KernelSamplerReduce],
+        Params::sampler_num_work_groups * Params::sampler_work_group_size,
+        Params::sampler_work_group_size,
+        {m_pipeline.m_frontier});
+    cl_event thermo = m_pipeline.enqueue(
+        m_kernels[KernelSamplerThermo],
+        Params::sampler_work_group_size,
+        Params::sampler_work_group_size,
+        {reduce});
+
+    /* Read the properties back without blocking. */
+    clEnqueueReadBuffer(
         m_queue,
-        m_buffers[BufferAtoms],
-        m_atoms.size() * sizeof(m_atoms[0]),
-        (void *) &m_atoms[0]);
+        m_buffers[BufferThermo],
+        CL_FALSE,
+        0,
+        sizeof(m_thermo),
+        (void *) &m_thermo,
+        thermo != NULL ? 1 : 0,
+        thermo != NULL ? &thermo : NULL,
+        &m_thermo_event);
+    clFlush(m_queue);
+    m_thermo_step = step;
+
+    /* Order the next step after the sampler reads the atoms. */
+    Pipeline::release({reduce});
+    m_pipeline.advance(thermo);
+
+    return log;
+}
 
-    m_sampler.sample(m_atoms, m_domain);
+/**
+ * Engine::sample_collect
+ * @brief Wait for the readback of the pending sample, if any, and add it to
+ * the sampler. Return its serialized properties, or an empty string.
+ */
+std::string Engine::sample_collect(void)
+{
+    if (m_thermo_event == NULL) {
+        return std::string();
+    }
 
-    return m_sampler.log_string();
+    clWaitForEvents(1, &m_thermo_event);
+    clReleaseEvent(m_thermo_event);
+    m_thermo_event = NULL;
+
+    m_sampler.sample(m_thermo);
+
+    std::ostringstream ss;
+    ss << "step " << m_thermo_step << "\n" << m_sampler.log_string() << "\n";
+    return ss.str();
 }
 
 /** ---------------------------------------------------------------------------
@@ -422,6 +821,15 @@ void Engine::generate(void)
             half.s[1],
             half.s[2]);
 
+        /* Shuffle the lattice sites to mix the atom type blocks. */
+        if (Params::n_types > 1) {
+            math::rng::Kiss engine(true);           /* rng engine */
+            math::rng::uniform<uint64_t> rand;      /* rng sampler */
+            for (size_t i = positions.size() - 1; i > 0; --i) {
+                std::swap(positions[i], positions[rand(engine, 0, i + 1)]);
+            }
+        }
+
         cl_ulong ix = 0;
         for (auto &pos : positions) {
             m_atoms[ix].pos = pos;
@@ -452,12 +860,8 @@ void Engine::generate(void)
     /*
      * Copy atom positions and momenta to the device.
      */
-    cl::Queue::enqueue_copy_to(
-        m_queue,
-        m_buffers[BufferAtoms],
-        m_atoms.size() * sizeof(m_atoms[0]),
-        (void *) &m_atoms[0]);
-
+    m_pipeline.finish();
+    copy_atoms_to();
 }
 
 /** ---------------------------------------------------------------------------
@@ -477,13 +881,10 @@ void Engine::reset(const cl_double radius)
      */
     {
         /*
-         * Copy the atoms from the device.
+         * Wait for the pipeline and copy the atoms from the device.
          */
-        cl::Queue::enqueue_copy_from(
-            m_queue,
-            m_buffers[BufferAtoms],
-            m_atoms.size() * sizeof(m_atoms[0]),
-            (void *) &m_atoms[0]);
+        m_pipeline.finish();
+        copy_atoms_from();
 
         /*
          * Reset the CoM positions and momenta.
@@ -525,11 +926,7 @@ void Engine::reset(const cl_double radius)
         /*
          * Copy updated atoms and domain to the device.
          */
-        cl::Queue::enqueue_copy_to(
-            m_queue,
-            m_buffers[BufferAtoms],
-            m_atoms.size() * sizeof(m_atoms[0]),
-            (void *) &m_atoms[0]);
+        copy_atoms_to();
 
         cl::Queue::enqueue_copy_to(
             m_queue,
@@ -553,7 +950,8 @@ void Engine::reset(const cl_double radius)
     }
 
     /*
-     * Reset sampler properties.
+     * Reset sampler properties, discarding any pending sample.
      */
+    sample_collect();
     m_sampler.reset();
 }
@@ -0,0 +1,95 @@
+/*
+ * headless.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include "atto/opencl/opencl.hpp"
+#include "headless.hpp"
+using namespace atto;
+
+/** ---------------------------------------------------------------------------
+ * @brief Create OpenCL context on the device with the specified type and
+ * index, and setup the engine without OpenGL interop.
+ */
+Headless::Headless(const cl_device_type device_type, const cl_ulong device_index)
+{
+    /*
+     * Setup OpenCL context with a command queue on the specified device.
+     */
+    {
+        m_context = cl::Context::create(device_type);
+        m_device = cl::Context::get_device(m_context, device_index);
+        m_queue = Pipeline::create_queue(m_context, m_device);
+        std::cout << cl::Device::get_info_string(m_device) << "\n";
+    }
+
+    /*
+     * Setup engine data without a shared OpenGL vertex buffer.
+     */
+    {
+        /* Store model parameters. */
+        m_step = 0;
+
+        /* Setup engine object. */
+        m_engine.setup(
+            m_context,
+            m_device,
+            m_queue);
+        m_engine.generate();
+        m_engine.reset(0.5 * Params::pair_sigma);
+    }
+}
+
+/**
+ * @brief Destroy the OpenCL context and associated objects.
+ */
+Headless::~Headless()
+{
+    /* Teardown model data. */
+    {
+        m_engine.teardown();
+    }
+
+    /* Teardown OpenCL data. */
+    {
+        cl::Queue::release(m_queue);
+        cl::Device::release(m_device);
+        cl::Context::release(m_context);
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * @brief Execute the model.
+ */
+bool Headless::execute(void)
+{
+    /* Model pre-execution. */
+    if (m_step == Params::n_min_steps) {
+        m_engine.reset(Params::pair_r_hard * Params::pair_sigma);
+    }
+
+    /*
+     * Execute a batch of engine steps up to the next model event, the end of
+     * the minimization stage or the next sample, without host synchronization.
+     */
+    cl_ulong n_steps = Params::sample_frequency - m_step%Params::sample_frequency;
+    if (m_step < Params::n_min_steps) {
+        n_steps = std::min(n_steps, Params::n_min_steps - m_step);
+    }
+    n_steps = std::min(n_steps, Params::n_run_steps - m_step);
+    m_engine.execute(n_steps);
+    m_step += n_steps;
+
+    /* Model post-execution. */
+    if (m_step%Params::sample_frequency == 0) {
+        std::cout << m_engine.sample(m_step);
+    }
+
+    return (m_step < Params::n_run_steps);
+}
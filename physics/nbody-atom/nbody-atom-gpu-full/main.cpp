@@ -11,6 +11,7 @@
 
 #include "atto/opencl/opencl.hpp"
 #include "model.hpp"
+#include "headless.hpp"
 using namespace atto;
 
 /**
@@ -18,6 +19,24 @@ using namespace atto;
  */
 int main(int argc, char const *argv[])
 {
+    /*
+     * Run the engine headless if requested, without an OpenGL context, on
+     * the OpenCL device with the specified type and index:
+     *  md.out headless [gpu|cpu|all] [device index]
+     */
+    if (argc > 1 && std::string(argv[1]) == "headless") {
+        std::string type = argc > 2 ? argv[2] : "all";
+        cl_device_type device_type =
+            type == "gpu" ? CL_DEVICE_TYPE_GPU :
+            type == "cpu" ? CL_DEVICE_TYPE_CPU : CL_DEVICE_TYPE_ALL;
+        cl_ulong device_index = argc > 3
+            ? core::str_cast<cl_ulong>(std::string(argv[3])) : 0;
+
+        Headless headless(device_type, device_index);
+        while (headless.execute());
+        return EXIT_SUCCESS;
+    }
+
     /* Setup renderer OpenGL context and initialize the GLFW library. */
     gl::Renderer::init(
         Params::window_width,
@@ -74,5 +93,5 @@ int main(int argc, char const *argv[])
         }
     }
 
-    exit(EXIT_SUCCESS);
+    return EXIT_SUCCESS;
 }
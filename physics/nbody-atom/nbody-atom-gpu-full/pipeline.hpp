@@ -0,0 +1,78 @@
+/*
+ * pipeline.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef MD_PIPELINE_H_
+#define MD_PIPELINE_H_
+
+#include <initializer_list>
+#include "atto/opencl/opencl.hpp"
+#include "base.hpp"
+#include "profiler.hpp"
+
+/**
+ * Pipeline
+ * @brief Pipeline enqueues the engine kernels back-to-back without any host
+ * synchronization. The kernel arguments are bound once by the engine, so an
+ * integration step only enqueues its kernels.
+ *
+ * On an in-order queue the kernels execute in enqueue order and no events
+ * are created. On an out-of-order queue each kernel waits on the events of
+ * the kernels it depends on, so independent kernels may execute concurrently.
+ * The event of the last kernel in a step is kept as the pipeline frontier,
+ * and the first kernel of the next step waits on it.
+ *
+ * Each enqueued kernel is profiled if profiling is enabled, see
+ * common::Profiler.
+ */
+struct Pipeline {
+    /* Pipeline member variables. */
+    cl_command_queue m_queue = NULL;    /* pipeline command queue */
+    bool m_out_of_order = false;        /* out-of-order execution */
+    cl_event m_frontier = NULL;         /* last command in the pipeline */
+    cl_event m_throttle = NULL;         /* marker of the previous throttle */
+    common::Profiler m_profiler;        /* kernel profiler */
+
+    /** Enqueue a kernel after the specified events and return its event. */
+    cl_event enqueue(
+        const cl_kernel &kernel,
+        const size_t n_items,
+        const size_t work_group_size,
+        std::initializer_list<cl_event> wait_list);
+
+    /** Advance the frontier to the specified event. */
+    void advance(cl_event event);
+
+    /** Order all subsequent commands after all previous commands. */
+    void barrier(void);
+
+    /**
+     * Wait for the commands enqueued before the previous throttle, so the
+     * host runs at most one throttle interval ahead of the device.
+     */
+    void throttle(void);
+
+    /** Wait for all enqueued commands to complete. */
+    void finish(void);
+
+    /** Release the specified events. */
+    static void release(std::initializer_list<cl_event> events);
+
+    /** Create a command queue, out-of-order if the device supports it. */
+    static cl_command_queue create_queue(
+        const cl_context &context,
+        const cl_device_id &device);
+
+    /* Setup/teardown the pipeline on the specified command queue. */
+    void setup(const cl_command_queue &queue);
+    void teardown(void);
+};
+
+#endif /* MD_PIPELINE_H_ */
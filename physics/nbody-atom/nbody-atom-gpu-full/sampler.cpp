@@ -103,28 +103,56 @@ void Sampler::reset(void)
  * @brief Sample sampler properties.
  */
 void Sampler::sample(std::vector<Atom> &atoms, const Domain &domain)
+{
+    Thermo thermo;
+    thermo.com_mass = compute::com_mass(atoms);
+    thermo.com_pos = compute::com_pos(atoms);
+    thermo.com_upos = compute::com_upos(atoms);
+    thermo.com_vel = compute::com_vel(atoms);
+    thermo.com_mom = compute::com_mom(atoms);
+    thermo.com_force = compute::com_force(atoms);
+
+    thermo.density = compute::density(atoms, domain);
+
+    thermo.energy_kin = compute::energy_kin(atoms);
+    thermo.energy_pot = compute::energy_pot(atoms);
+
+    thermo.temp_kinetic = compute::temperature_kin(
+            atoms, thermo.temp_grad_sq, thermo.temp_laplace);
+
+    thermo.pres_kinetic = compute::pressure_kin(atoms, domain);
+    thermo.pres_virial = compute::pressure_vir(atoms, domain);
+
+    sample(thermo);
+}
+
+/**
+ * Sampler::sample
+ * @brief Sample sampler properties from a collection of thermodynamic
+ * properties, e.g. as reduced on the device.
+ */
+void Sampler::sample(const Thermo &thermo)
 {
     /* Sample a new sampler block item */
     {
-        cl_double com_mass = compute::com_mass(atoms);
-        cl_double4 com_pos = compute::com_pos(atoms);
-        cl_double4 com_upos = compute::com_upos(atoms);
-        cl_double4 com_vel = compute::com_vel(atoms);
-        cl_double4 com_mom = compute::com_mom(atoms);
-        cl_double4 com_force = compute::com_force(atoms);
+        cl_double com_mass = thermo.com_mass;
+        cl_double4 com_pos = thermo.com_pos;
+        cl_double4 com_upos = thermo.com_upos;
+        cl_double4 com_vel = thermo.com_vel;
+        cl_double4 com_mom = thermo.com_mom;
+        cl_double4 com_force = thermo.com_force;
 
-        cl_double density = compute::density(atoms, domain);
+        cl_double density = thermo.density;
 
-        cl_double energy_kin = compute::energy_kin(atoms);
-        cl_double energy_pot = compute::energy_pot(atoms);
+        cl_double energy_kin = thermo.energy_kin;
+        cl_double energy_pot = thermo.energy_pot;
 
-        cl_double temp_grad_sq;
-        cl_double temp_laplace;
-        cl_double temperature = compute::temperature_kin(
-                atoms, temp_grad_sq, temp_laplace);
+        cl_double temp_grad_sq = thermo.temp_grad_sq;
+        cl_double temp_laplace = thermo.temp_laplace;
+        cl_double temperature = thermo.temp_kinetic;
 
-        cl_double16 pressure_kin = compute::pressure_kin(atoms, domain);
-        cl_double16 pressure_vir = compute::pressure_vir(atoms, domain);
+        cl_double16 pressure_kin = thermo.pres_kinetic;
+        cl_double16 pressure_vir = thermo.pres_virial;
 
         /* Fluid mass */
         m_item[COM_MASS] = com_mass;
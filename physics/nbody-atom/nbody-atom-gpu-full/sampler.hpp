@@ -105,6 +105,7 @@ struct Sampler {
 
     /* Sample sampler properties. */
     void sample(std::vector<Atom> &atoms, const Domain &domain);
+    void sample(const Thermo &thermo);
 
     /* Compute sampler statistics. */
     void statistics(void);
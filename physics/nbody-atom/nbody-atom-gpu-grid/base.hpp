@@ -30,6 +30,7 @@ static const cl_double density = 0.8;           /* fluid density */
 static const cl_double temperature = 2.0;       /* fluid temperature */
 static const cl_ulong n_atoms = 16384;          /* number of atoms */
 static const cl_ulong n_neighbours = 256;       /* neighbours per atom */
+static const cl_uint grid_sorted = 1;           /* reorder atoms by cell */
 static const cl_double atom_mass = 1.0;         /* atom mass */
 static const cl_double pair_epsilon = 1.0;      /* energy coefficient */
 static const cl_double pair_sigma = 1.0;        /* sigma coefficient */
@@ -38,11 +39,19 @@ static const cl_double pair_r_skin = 1.0;       /* skin radius */
 static const cl_double pair_r_hard = 0.01;      /* hard sphere radius */
 static const cl_double thermostat_mass = 10.0;  /* thermostat inertial mass */
 
+/* Species parameters, in units of atom_mass, pair_epsilon and pair_sigma. */
+static const cl_ulong n_types = 1;              /* number of atom types */
+static const cl_double type_fraction[] = {1.0}; /* type number fraction */
+static const cl_double type_mass[] = {1.0};     /* type mass */
+static const cl_double type_epsilon[] = {1.0};  /* type LJ energy */
+static const cl_double type_sigma[] = {1.0};    /* type LJ size */
+
 /* OpenGL parameters */
 static const int window_width = 1024;
 static const int window_height = 1024;
 static const char window_title[] = "md-gpu-full";
 static const cl_double poll_timeout = 0.01;
+static const cl_double frame_rate = 60.0;       /* rendered frames per second */
 
 /* OpenCL parameters */
 static const cl_ulong device_index = 2;         /* gpu device index. */
@@ -50,6 +59,9 @@ static const cl_ulong work_group_size = 256;    /* local workgroup size */
 static const cl_ulong num_work_items = atto::cl::NDRange::Roundup(
     n_atoms, work_group_size);
 static const cl_ulong num_work_groups = num_work_items / work_group_size;
+static const cl_ulong sampler_items = 34;       /* sampler partial sums */
+static const cl_ulong sampler_work_group_size = 64; /* sampler workgroup size */
+static const cl_ulong sampler_num_work_groups = 64; /* sampler workgroups */
 }
 
 /**
@@ -58,6 +70,7 @@ static const cl_ulong num_work_groups = num_work_items / work_group_size;
 struct Atom {
     cl_double mass;                 /* atom mass */
     cl_double rmass;                /* inverse mass */
+    cl_uint type;                   /* atom type */
     cl_double4 pos;                 /* periodic image in primary cell */
     cl_double4 upos;                /* unfolded position */
     cl_double4 mom;                 /* momentum */
@@ -88,12 +101,25 @@ struct Domain {
 };
 
 /**
- * @brief Field represents the Lennard-Jones force field.
+ * @brief FieldPair holds the Lennard-Jones coefficients of an atom type pair.
  */
-struct Field {
+struct FieldPair {
     cl_double epsilon;              /* LJ pair energy */
     cl_double sigma;                /* LJ pair size */
     cl_double r_cut;                /* LJ cutoff radius */
+    cl_double r_cut_sq;             /* LJ cutoff radius squared */
+};
+
+/**
+ * @brief Field represents the Lennard-Jones force field of a fluid mixture.
+ * The coefficients of each type pair (i,j) are stored in a small row-major
+ * table at index k = i*max_types + j.
+ */
+struct Field {
+    static const cl_ulong max_types = 4;
+    FieldPair pairs[max_types * max_types]; /* type pair coefficients */
+    cl_ulong n_types;               /* number of atom types */
+    cl_double r_cut;                /* Largest LJ cutoff radius */
     cl_double r_skin;               /* Neighbour list skin radius */
     cl_double r_hard;               /* Hard sphere truncation radius */
 };
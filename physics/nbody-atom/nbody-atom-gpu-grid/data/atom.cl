@@ -3,7 +3,8 @@ Pair_t atom_force_pair(
     const ulong atom_1,
     const ulong atom_2,
     const double4 r_12,
-    const __global Field_t *field);
+    const FieldPair_t coeff,
+    const double r_hard);
 
 /** Return the periodic image in primary cell of the fluid domain. */
 double4 atom_pbc(const __global Domain_t *domain, const double4 pos);
@@ -80,21 +81,24 @@ __kernel void atom_force(
     const ulong n_neighbours,
     __global Atom_t *atoms,
     const __global Domain_t *domain,
-    const __global Field_t *field,
+    __constant Field_t *field,
     const double4 length,
     const int4 n_cells,
-    const uint n_items,
-    const uint capacity,
-    const __global Grid_t *grid)
+    const uint sorted,
+    const __global uint *values,
+    const __global uint *cell_begin,
+    const __global uint *cell_end)
 {
     const ulong atom_1 = get_global_id(0);
     if (atom_1 < n_atoms) {
-        const double r_cut_sq = field->r_cut * field->r_cut;
+        /* Type pair coefficients of the atom, held in constant memory. */
+        __constant FieldPair_t *coeff = &field->pairs[atoms[atom_1].type * kMaxTypes];
 
         /*
          * Loop over the neighbours of the atom cell in the centre.
-         * For each neighbour cell, loop over its atoms and compute
-         * the pairwise interaction.
+         * For each neighbour cell, loop over its range of sorted atoms
+         * and compute the pairwise interaction. If the atoms are stored
+         * in sorted order, the range indexes the atoms directly.
          */
         double4 force = (double4) (0.0);
         double energy = 0.0;
@@ -109,11 +113,9 @@ __kernel void atom_force(
             for (int iy = base.y - 1; iy <= base.y + 1; ++iy) {
                 for (int iz = base.z - 1; iz <= base.z + 1; ++iz) {
                     int4 cell = grid_pbc((int4) (ix,iy,iz,0), n_cells);
-                    uint key = grid_hash(cell, n_cells, n_items, capacity);
-                    uint slot = grid_begin(key, capacity, grid);
-                    while (slot != kEmpty) {
-                        ulong atom_2 = grid_get(slot, grid);
-                        slot = grid_next(slot, key, capacity, grid);
+                    uint key = grid_cell_key(cell, n_cells);
+                    for (uint ix_2 = cell_begin[key]; ix_2 < cell_end[key]; ++ix_2) {
+                        ulong atom_2 = sorted ? ix_2 : values[ix_2];
 
                         if (atom_1 ==  atom_2) {
                             continue;
@@ -122,8 +124,10 @@ __kernel void atom_force(
                         double4 r_12 = atoms[atom_1].pos - atoms[atom_2].pos;
                         r_12 = atom_pbc(domain, r_12);
 
-                        if (pair_ix < pair_end && dot(r_12, r_12) < r_cut_sq) {
-                            Pair_t pair = atom_force_pair(atom_1, atom_2, r_12, field);
+                        const FieldPair_t coeff_12 = coeff[atoms[atom_2].type];
+                        if (pair_ix < pair_end && dot(r_12, r_12) < coeff_12.r_cut_sq) {
+                            Pair_t pair = atom_force_pair(
+                                atom_1, atom_2, r_12, coeff_12, field->r_hard);
                             force  -= pair.gradient;
                             energy += 0.5 * pair.energy;
                             virial += 0.5 * pair.virial;
@@ -141,13 +145,14 @@ __kernel void atom_force(
 }
 /**
  * atom_force_pair
- * @brief Compute pair interaction.
+ * @brief Compute pair interaction using the coefficients of the atom type pair.
  */
 Pair_t atom_force_pair(
     const ulong atom_1,
     const ulong atom_2,
     const double4 r_12,
-    const __global Field_t *field)
+    const FieldPair_t coeff,
+    const double r_hard)
 {
     /* Compute pair attributes - energy, gradient, laplacian and virial. */
     Pair_t pair;
@@ -162,12 +167,12 @@ Pair_t atom_force_pair(
     pair.virial = (double16) (0.0);
 
     /* Interaction coefficients. */
-    const double sigma_sq = field->sigma * field->sigma;
-    const double r_hard_sq = field->r_hard * field->r_hard;
+    const double sigma_sq = coeff.sigma * coeff.sigma;
+    const double r_hard_sq = r_hard * r_hard;
 
     /* Define pair energy and force coefficients */
-    double energy_coeff = 4.0 * field->epsilon;
-    double force_coeff = 24.0 * field->epsilon / sigma_sq;
+    double energy_coeff = 4.0 * coeff.epsilon;
+    double force_coeff = 24.0 * coeff.epsilon / sigma_sq;
 
     /* Ensure pair distance is larger than the hard sphere radius. */
     double energy_hard_sphere = 0.0;
@@ -181,8 +186,8 @@ Pair_t atom_force_pair(
         double r_hard_6  = r_hard_4 * r_hard_2;
         double r_hard_12 = r_hard_6 * r_hard_6;
 
-        energy_hard_sphere = -24.0 * field->epsilon * (2.0 * r_hard_12 - r_hard_6);
-        energy_hard_sphere *= (r_12_len - field->r_hard) / r_12_len;
+        energy_hard_sphere = -24.0 * coeff.epsilon * (2.0 * r_hard_12 - r_hard_6);
+        energy_hard_sphere *= (r_12_len - r_hard) / r_12_len;
 
         /* Set the pair distance to the hard sphere radius. */
         r_12_sq = r_hard_sq;
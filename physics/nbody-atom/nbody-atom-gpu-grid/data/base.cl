@@ -5,6 +5,7 @@
 #endif
 
 #define kEmpty  0xffffffff
+#define kMaxTypes 4
 
 /** ---------------------------------------------------------------------------
  * @brief Atom data type.
@@ -12,6 +13,7 @@
 typedef struct {
     double mass;            /* atom mass */
     double rmass;           /* inverse mass */
+    uint type;              /* atom type */
     double4 pos;            /* periodic image in primary cell */
     double4 upos;           /* unfolded position */
     double4 mom;            /* momentum */
@@ -42,12 +44,22 @@ typedef struct {
 } Domain_t;
 
 /**
- * @brief Field data type.
+ * @brief Field type pair data type.
  */
 typedef struct {
     double epsilon;         /* LJ pair energy */
     double sigma;           /* LJ pair size */
     double r_cut;           /* LJ cutoff radius */
+    double r_cut_sq;        /* LJ cutoff radius squared */
+} FieldPair_t;
+
+/**
+ * @brief Field data type.
+ */
+typedef struct {
+    FieldPair_t pairs[kMaxTypes * kMaxTypes]; /* type pair coefficients */
+    ulong n_types;          /* number of atom types */
+    double r_cut;           /* Largest LJ cutoff radius */
     double r_skin;          /* Neighbour list skin radius */
     double r_hard;          /* Hard sphere truncation radius */
 } Field_t;
@@ -81,11 +93,3 @@ typedef struct {
     double16 pres_kinetic;  /* Kinetic pressure */
     double16 pres_virial;   /* Virial pressure */
 } Thermo_t;
-
-/**
- * Grid data type holding a key-value pair.
- */
-typedef struct {
-    uint key;               /* hash key of the atom cell coordinates. */
-    uint value;             /* atom index value */
-} Grid_t;
@@ -1,142 +1,217 @@
+/**
+ * @brief Radix sort parameters, sorting keys in passes of kRadixBits.
+ */
+#define kRadixBits 4
+#define kRadixBins (1 << kRadixBits)
+#define kRadixMask (kRadixBins - 1)
+
 /** ---------------------------------------------------------------------------
- * @brief Return the first slot containing the specified key.
+ * @brief Return the cell coordinates containing the specified position.
  */
-uint grid_begin(
-    const uint key,
-    const uint capacity,
-    const __global Grid_t *grid);
-
-/** Return the next slot containing the specified key. */
-uint grid_next(
-    uint slot,
-    const uint key,
-    const uint capacity,
-    const __global Grid_t *grid);
-
-/** Return the value of the current slot. */
-uint grid_get(uint slot, const __global Grid_t *grid);
-
-/** Return the cell coordinates containing the specified position. */
 int4 grid_cell(const double4 pos, const double4 length, const int4 n_cells);
 
-/** Compute the hash key of the cell coordinates. */
-uint grid_hash(
-    const int4 cell_coord,
-    const int4 n_cells,
-    const uint n_items,
-    const uint capacity);
+/** Return the key of the cell coordinates. */
+uint grid_cell_key(const int4 cell_coord, const int4 n_cells);
 
 /** Return the periodic image of the specfied cell. */
 int4 grid_pbc(const int4 cell_coord, const int4 n_cells);
 
 /** ---------------------------------------------------------------------------
- * grid_clear
- * @brief Clear all key-value pairs in the grid and reset their count.
- */
-__kernel void grid_clear(const uint capacity, __global Grid_t *grid)
-{
-    const uint item_ix = get_global_id(0);
-    if (item_ix < capacity) {
-        grid[item_ix].key = kEmpty;
-        grid[item_ix].value = kEmpty;
-    }
-}
-
-/**
- * grid_insert
- * @brief Insert the atom positions into the grid.
+ * grid_keys
+ * @brief Compute the cell key of each atom, paired with the atom index.
  */
-__kernel void grid_insert(
+__kernel void grid_keys(
     const ulong n_atoms,
-    __global Atom_t *atoms,
+    const __global Atom_t *atoms,
     const double4 length,
     const int4 n_cells,
-    const uint n_items,
-    const uint capacity,
-    __global Grid_t *grid)
+    __global uint *keys,
+    __global uint *values)
 {
     const ulong atom_ix = get_global_id(0);
     if (atom_ix < n_atoms) {
         int4 cell = grid_cell(atoms[atom_ix].pos, length, n_cells);
-        uint key = grid_hash(cell, n_cells, n_items, capacity);
-        uint slot = key % capacity;         // & (capacity - 1)
-        while (true) {
-            uint prev = atomic_cmpxchg(
-                (volatile __global unsigned int *) (&grid[slot].key),
-                kEmpty,
-                key);
-
-            if (prev == kEmpty) {
-                grid[slot].value = atom_ix;
-                return;
-            }
-
-            slot = (slot + 1) % capacity;   // & (capacity - 1);
-        }
-   }
+        keys[atom_ix] = grid_cell_key(cell, n_cells);
+        values[atom_ix] = atom_ix;
+    }
 }
 
-/** ---------------------------------------------------------------------------
- * grid_begin
- * @brief Return the first slot containing the specified key. If no such key
- * exists, return empty signalling no further slots contain the specified key.
+/**
+ * grid_count
+ * @brief Count the keys of each work group in each radix bin, for the digit
+ * at the specified bit shift. The counts are stored in bin-major order, so an
+ * exclusive scan yields the scatter offset of each bin in each work group.
+ * Requires a work group size no smaller than the number of radix bins.
  */
-uint grid_begin(
-    const uint key,
-    const uint capacity,
-    const __global Grid_t *grid)
+__kernel void grid_count(
+    const ulong n_atoms,
+    const uint shift,
+    const __global uint *keys,
+    __global uint *counts,
+    __local uint *local_counts)
 {
-    /* Do nothing if key is empty */
-    if (key == kEmpty) {
-        return kEmpty;
+    const ulong global_id = get_global_id(0);
+    const uint local_id = get_local_id(0);
+    const uint group_id = get_group_id(0);
+    const uint num_groups = get_num_groups(0);
+
+    if (local_id < kRadixBins) {
+        local_counts[local_id] = 0;
     }
+    barrier(CLK_LOCAL_MEM_FENCE);
 
-    /* Loop over the cell data until a slot with the specified key is found. */
-    uint slot = key % capacity;     // & (capacity - 1)
-    while (true) {
-        if (grid[slot].key == key) {
-            return slot;
-        }
+    if (global_id < n_atoms) {
+        uint digit = (keys[global_id] >> shift) & kRadixMask;
+        atomic_inc(&local_counts[digit]);
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    if (local_id < kRadixBins) {
+        counts[local_id * num_groups + group_id] = local_counts[local_id];
+    }
+}
+
+/**
+ * grid_scan
+ * @brief Exclusive prefix sum of the bin counts, executed by a single work
+ * group. Each work item scans a contiguous chunk of the counts, offset by the
+ * scanned sums of the preceding chunks.
+ */
+__kernel void grid_scan(
+    const uint n_counts,
+    __global uint *counts,
+    __local uint *local_sums)
+{
+    const uint local_id = get_local_id(0);
+    const uint local_size = get_local_size(0);
+    const uint chunk = (n_counts + local_size - 1) / local_size;
+    const uint begin = min(local_id * chunk, n_counts);
+    const uint end = min(begin + chunk, n_counts);
 
-        if (grid[slot].key == kEmpty) {
-            return kEmpty;
+    /* Sum the chunk of the work item. */
+    uint sum = 0;
+    for (uint ix = begin; ix < end; ++ix) {
+        sum += counts[ix];
+    }
+    local_sums[local_id] = sum;
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    /* Scan the chunk sums. */
+    if (local_id == 0) {
+        uint offset = 0;
+        for (uint ix = 0; ix < local_size; ++ix) {
+            uint value = local_sums[ix];
+            local_sums[ix] = offset;
+            offset += value;
         }
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
 
-        slot = (slot + 1) % capacity;   // & (capacity - 1)
+    /* Scan the chunk. */
+    uint offset = local_sums[local_id];
+    for (uint ix = begin; ix < end; ++ix) {
+        uint value = counts[ix];
+        counts[ix] = offset;
+        offset += value;
     }
 }
 
 /**
- * grid_next
- * @brief Return the next slot containing the specified key.
- * Return empty if we reached the end of the list.
+ * grid_scatter
+ * @brief Scatter the key-value pairs to their sorted location for the digit
+ * at the specified bit shift. The rank of a key within its work group is the
+ * number of preceding keys with the same digit, keeping the sort stable.
  */
-uint grid_next(
-    uint slot,
-    const uint key,
-    const uint capacity,
-    const __global Grid_t *grid)
+__kernel void grid_scatter(
+    const ulong n_atoms,
+    const uint shift,
+    const __global uint *keys_in,
+    const __global uint *values_in,
+    const __global uint *counts,
+    __global uint *keys_out,
+    __global uint *values_out,
+    __local uint *local_digits)
 {
-    while (true) {
-        slot = (slot + 1) % capacity;   // & (capacity - 1)
+    const ulong global_id = get_global_id(0);
+    const uint local_id = get_local_id(0);
+    const uint group_id = get_group_id(0);
+    const uint num_groups = get_num_groups(0);
 
-        if (grid[slot].key == key) {
-            return slot;
+    uint key = 0;
+    uint digit = kRadixBins;
+    if (global_id < n_atoms) {
+        key = keys_in[global_id];
+        digit = (key >> shift) & kRadixMask;
+    }
+    local_digits[local_id] = digit;
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    if (global_id < n_atoms) {
+        uint rank = 0;
+        for (uint ix = 0; ix < local_id; ++ix) {
+            rank += (local_digits[ix] == digit) ? 1 : 0;
         }
 
-        if (grid[slot].key == kEmpty) {
-            return kEmpty;
+        uint dst = counts[digit * num_groups + group_id] + rank;
+        keys_out[dst] = key;
+        values_out[dst] = values_in[global_id];
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * grid_clear
+ * @brief Clear the cell ranges.
+ */
+__kernel void grid_clear(
+    const uint n_cells,
+    __global uint *cell_begin,
+    __global uint *cell_end)
+{
+    const uint cell_ix = get_global_id(0);
+    if (cell_ix < n_cells) {
+        cell_begin[cell_ix] = 0;
+        cell_end[cell_ix] = 0;
+    }
+}
+
+/**
+ * grid_bounds
+ * @brief Compute the range of each cell in the sorted keys array, where
+ * the key differs from its predecessor or successor.
+ */
+__kernel void grid_bounds(
+    const ulong n_atoms,
+    const __global uint *keys,
+    __global uint *cell_begin,
+    __global uint *cell_end)
+{
+    const ulong ix = get_global_id(0);
+    if (ix < n_atoms) {
+        uint key = keys[ix];
+        if (ix == 0 || keys[ix - 1] != key) {
+            cell_begin[key] = ix;
+        }
+        if (ix == n_atoms - 1 || keys[ix + 1] != key) {
+            cell_end[key] = ix + 1;
         }
     }
 }
 
 /**
- * grid_get
- * @brief Return the value of the current slot.
+ * grid_reorder
+ * @brief Gather the atoms in sorted cell order, so the atoms in each cell
+ * are contiguous in memory.
  */
-uint grid_get(uint slot, const __global Grid_t *grid)
+__kernel void grid_reorder(
+    const ulong n_atoms,
+    const __global uint *values,
+    const __global Atom_t *atoms_in,
+    __global Atom_t *atoms_out)
 {
-    return grid[slot].value;
+    const ulong ix = get_global_id(0);
+    if (ix < n_atoms) {
+        atoms_out[ix] = atoms_in[values[ix]];
+    }
 }
 
 /** ---------------------------------------------------------------------------
@@ -144,38 +219,27 @@ uint grid_get(uint slot, const __global Grid_t *grid)
  * @brief Return the cell coordinates containing the specified position.
  * The position is assumed to be in the range of (-length/2, length/2):
  *  u_pos = 0.5 + (pos / length) and 0 <= u_pos <= 1.
+ * The coordinates are clamped to the grid range.
  */
 int4 grid_cell(const double4 pos, const double4 length, const int4 n_cells)
 {
     /* Get the position in normalized coordinates. */
-    double4 u_pos = double4(0.5) + (pos / length);
-    return int4(u_pos.x * n_cells.x,
-                u_pos.y * n_cells.y,
-                u_pos.z * n_cells.z,
-                0 /*unused*/);
+    double4 u_pos = (double4) (0.5) + (pos / length);
+    int4 cell = (int4) ((int) (u_pos.x * n_cells.x),
+                        (int) (u_pos.y * n_cells.y),
+                        (int) (u_pos.z * n_cells.z),
+                        0 /*unused*/);
+    return clamp(cell, (int4) (0), n_cells - (int4) (1));
 }
 
 /**
- * grid_hash
- * @brief Compute the hash key of the cell coordinates.
- * Return the key if the cell is inside the grid range. Return empty otherwise.
+ * grid_cell_key
+ * @brief Return the key of the cell coordinates, given by the cell index in
+ * row-major order.
  */
-uint grid_hash(
-    const int4 cell_coord,
-    const int4 n_cells,
-    const uint n_items,
-    const uint capacity)
+uint grid_cell_key(const int4 cell_coord, const int4 n_cells)
 {
-    if (cell_coord.x < 0 || cell_coord.x >= n_cells.x ||
-        cell_coord.y < 0 || cell_coord.y >= n_cells.y ||
-        cell_coord.z < 0 || cell_coord.z >= n_cells.z ) {
-        return kEmpty;
-    }
-
-    uint slot = n_items * (cell_coord.x * n_cells.y * n_cells.z +
-                           cell_coord.y * n_cells.z +
-                           cell_coord.z);
-    return slot % capacity;
+    return (cell_coord.x * n_cells.y + cell_coord.y) * n_cells.z + cell_coord.z;
 }
 
 /**
@@ -11,6 +11,7 @@
 
 #include "atto/opencl/opencl.hpp"
 #include "engine.hpp"
+#include "program.hpp"
 using namespace atto;
 
 /** ---------------------------------------------------------------------------
@@ -31,12 +32,34 @@ void Engine::setup(
         m_atoms.resize(Params::n_atoms, Atom{
             .mass = Params::atom_mass,          /* atom mass */
             .rmass = 1.0 / Params::atom_mass,   /* inverse mass */
+            .type = 0,                          /* atom type */
             .pos = cl_double4{},                /* periodic image in primary cell */
             .upos = cl_double4{},               /* unfolded position */
             .mom = cl_double4{},                /* momentum */
             .force = cl_double4{}               /* force */
         });
 
+        /*
+         * Assign the atom types in contiguous blocks with the specified number
+         * fractions. Atoms are kept sorted by type, so the force kernel reads
+         * the same row of the type pair table along each block.
+         */
+        core_assert(Params::n_types <= Field::max_types, "invalid number of types");
+        cl_ulong atom_ix = 0;
+        for (cl_uint type = 0; type < Params::n_types; ++type) {
+            cl_ulong count = (cl_ulong) (Params::type_fraction[type] * Params::n_atoms);
+            if (type + 1 == Params::n_types) {
+                count = Params::n_atoms - atom_ix;
+            }
+
+            cl_double mass = Params::atom_mass * Params::type_mass[type];
+            for (cl_ulong end = atom_ix + count; atom_ix < end; ++atom_ix) {
+                m_atoms[atom_ix].mass = mass;
+                m_atoms[atom_ix].rmass = 1.0 / mass;
+                m_atoms[atom_ix].type = type;
+            }
+        }
+
         /* Create fluid domain. */
         cl_double volume = (cl_double) Params::n_atoms / Params::density;
         cl_double length = std::pow(volume, 1.0 / 3.0);
@@ -44,13 +67,29 @@ void Engine::setup(
             cl_double4{length, length, length, 0.0 /*unused*/},
             cl_double4{0.5*length, 0.5*length, 0.5*length, 0.0 /*unused*/}};
 
-        /* Create fluid force field. */
-        m_field = Field{
-            Params::pair_epsilon,
-            Params::pair_sigma,
-            Params::pair_r_cut * Params::pair_sigma,
-            Params::pair_r_skin * Params::pair_sigma,
-            Params::pair_r_hard * Params::pair_sigma};
+        /*
+         * Create fluid force field. Mix the coefficients of each type pair
+         * using Lorentz-Berthelot rules, with a cutoff radius scaled by the
+         * pair size.
+         */
+        m_field = Field{};
+        m_field.n_types = Params::n_types;
+        m_field.r_cut = 0.0;
+        m_field.r_skin = Params::pair_r_skin * Params::pair_sigma;
+        m_field.r_hard = Params::pair_r_hard * Params::pair_sigma;
+        for (cl_ulong type_1 = 0; type_1 < Params::n_types; ++type_1) {
+            for (cl_ulong type_2 = 0; type_2 < Params::n_types; ++type_2) {
+                cl_double epsilon = Params::pair_epsilon * std::sqrt(
+                    Params::type_epsilon[type_1] * Params::type_epsilon[type_2]);
+                cl_double sigma = Params::pair_sigma * 0.5 * (
+                    Params::type_sigma[type_1] + Params::type_sigma[type_2]);
+                cl_double r_cut = Params::pair_r_cut * sigma;
+
+                m_field.pairs[type_1 * Field::max_types + type_2] = FieldPair{
+                    epsilon, sigma, r_cut, r_cut * r_cut};
+                m_field.r_cut = std::max(m_field.r_cut, r_cut);
+            }
+        }
 
         /* Setup thermostat */
         m_thermostat = Thermostat{
@@ -77,7 +116,7 @@ void Engine::setup(
             .pres_virial = cl_double16{}};   /* Virial pressure */
 
         /* Setup grid spatial data structure */
-        m_grid = Grid(m_domain.length, Params::pair_r_cut, Params::n_neighbours);
+        m_grid = Grid(m_domain.length, m_field.r_cut);
    }
 
     /* ------------------------------------------------------------------------
@@ -88,6 +127,7 @@ void Engine::setup(
         m_context = context;
         m_device = device;
         m_queue = queue;
+        m_pipeline.setup(m_queue);
 
         /* Create engine program object. */
         std::string source;
@@ -95,9 +135,9 @@ void Engine::setup(
         source.append(cl::Program::load_source_from_file("data/grid.cl"));
         source.append(cl::Program::load_source_from_file("data/atom.cl"));
         source.append(cl::Program::load_source_from_file("data/thermostat.cl"));
-        m_program = cl::Program::create_from_source(m_context, source);
-        cl::Program::build(m_program, m_device, "");
-        std::cout << cl::Program::get_source(m_program) << "\n";
+        source.append(cl::Program::load_source_from_file("data/sampler.cl"));
+        m_program = common::BuildProgram(m_context, m_device, source, "");
+        std::cout << source << "\n";
 
         /* Create engine kernels. */
         m_kernels.resize(NumKernels, NULL);
@@ -108,8 +148,15 @@ void Engine::setup(
         m_kernels[KernelAtomCopyVertex]= cl::Kernel::create(m_program, "atom_copy_vertex");
         m_kernels[KernelThermostatForce] = cl::Kernel::create(m_program, "thermostat_force");
         m_kernels[KernelThermostatIntegrate] = cl::Kernel::create(m_program, "thermostat_integrate");
+        m_kernels[KernelSamplerReduce] = cl::Kernel::create(m_program, "sampler_reduce");
+        m_kernels[KernelSamplerThermo] = cl::Kernel::create(m_program, "sampler_thermo");
+        m_kernels[KernelGridKeys] = cl::Kernel::create(m_program, "grid_keys");
+        m_kernels[KernelGridCount] = cl::Kernel::create(m_program, "grid_count");
+        m_kernels[KernelGridScan] = cl::Kernel::create(m_program, "grid_scan");
+        m_kernels[KernelGridScatter] = cl::Kernel::create(m_program, "grid_scatter");
         m_kernels[KernelGridClear] = cl::Kernel::create(m_program, "grid_clear");
-        m_kernels[KernelGridInsert] = cl::Kernel::create(m_program, "grid_insert");
+        m_kernels[KernelGridBounds] = cl::Kernel::create(m_program, "grid_bounds");
+        m_kernels[KernelGridReorder] = cl::Kernel::create(m_program, "grid_reorder");
 
         /* Create engine device buffer objects. */
         m_buffers.resize(NumBuffers, NULL);
@@ -149,16 +196,90 @@ void Engine::setup(
             Params::num_work_groups * sizeof(cl_double),
             (void *) NULL);
 
-        m_buffers[BufferGrid] = cl::Memory::create_buffer(
+        m_buffers[BufferSamplerSums] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE,
+            Params::sampler_num_work_groups * Params::sampler_items * sizeof(cl_double),
+            (void *) NULL);
+
+        m_buffers[BufferThermo] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE,
+            sizeof(Thermo),
+            (void *) NULL);
+
+        m_buffers[BufferAtomsSorted] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE,
+            Params::n_atoms * sizeof(Atom),
+            (void *) NULL);
+
+        m_buffers[BufferGridKeys] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE,
+            Params::n_atoms * sizeof(cl_uint),
+            (void *) NULL);
+
+        m_buffers[BufferGridValues] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE,
+            Params::n_atoms * sizeof(cl_uint),
+            (void *) NULL);
+
+        m_buffers[BufferGridKeysAlt] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE,
+            Params::n_atoms * sizeof(cl_uint),
+            (void *) NULL);
+
+        m_buffers[BufferGridValuesAlt] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE,
+            Params::n_atoms * sizeof(cl_uint),
+            (void *) NULL);
+
+        m_buffers[BufferGridCounts] = cl::Memory::create_buffer(
             m_context,
             CL_MEM_READ_WRITE,
-            m_grid.m_capacity * sizeof(Grid::Item),
+            Grid::m_radix_bins * Params::num_work_groups * sizeof(cl_uint),
             (void *) NULL);
 
-        m_buffers[BufferGLVertexAtom] = cl::gl::create_from_gl_buffer(
+        m_buffers[BufferGridCellBegin] = cl::Memory::create_buffer(
             m_context,
-            CL_MEM_WRITE_ONLY,
-            gl_vertex_buffer);
+            CL_MEM_READ_WRITE,
+            m_grid.m_n_cells * sizeof(cl_uint),
+            (void *) NULL);
+
+        m_buffers[BufferGridCellEnd] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE,
+            m_grid.m_n_cells * sizeof(cl_uint),
+            (void *) NULL);
+
+        /*
+         * Create the shared OpenGL vertex buffer, the snapshot buffers and
+         * the render queue unless running headless.
+         */
+        if (gl_vertex_buffer != 0) {
+            m_buffers[BufferGLVertexAtom] = cl::gl::create_from_gl_buffer(
+                m_context,
+                CL_MEM_WRITE_ONLY,
+                gl_vertex_buffer);
+
+            m_buffers[BufferSnapshot0] = cl::Memory::create_buffer(
+                m_context,
+                CL_MEM_READ_WRITE,
+                6 * Params::n_atoms * sizeof(cl_float),
+                (void *) NULL);
+
+            m_buffers[BufferSnapshot1] = cl::Memory::create_buffer(
+                m_context,
+                CL_MEM_READ_WRITE,
+                6 * Params::n_atoms * sizeof(cl_float),
+                (void *) NULL);
+
+            m_render_queue = common::CreateQueue(m_context, m_device);
+        }
     }
 
     /*
@@ -189,6 +310,11 @@ void Engine::setup(
             sizeof(m_thermostat),
             (void *) &m_thermostat);
     }
+
+    /*
+     * Bind the kernel arguments.
+     */
+    bind();
 }
 
 /**
@@ -199,6 +325,16 @@ void Engine::teardown(void)
 {
     /* Teardown model data. */
     {
+        /* Collect the pending sample and copy the atoms from the device. */
+        std::cout << sample_collect();
+        m_pipeline.finish();
+
+        cl::Queue::enqueue_copy_from(
+            m_queue,
+            m_buffers[BufferAtoms],
+            m_atoms.size() * sizeof(m_atoms[0]),
+            (void *) &m_atoms[0]);
+
         /* Write xyz snapshot and sampler statistics. */
         core::FileOut fileout;
 
@@ -215,11 +351,23 @@ void Engine::teardown(void)
 
     /* Teardown OpenCL data. */
     {
+        m_pipeline.teardown();
+        for (auto &it : m_snapshot_events) {
+            if (it != NULL) {
+                clReleaseEvent(it);
+                it = NULL;
+            }
+        }
+        if (m_render_queue != NULL) {
+            cl::Queue::release(m_render_queue);
+        }
         for (auto &it : m_images) {
             cl::Memory::release(it);
         }
         for (auto &it : m_buffers) {
-            cl::Memory::release(it);
+            if (it != NULL) {
+                cl::Memory::release(it);
+            }
         }
         for (auto &it : m_kernels) {
             cl::Kernel::release(it);
@@ -229,225 +377,428 @@ void Engine::teardown(void)
 }
 
 /** ---------------------------------------------------------------------------
- * Engine::execute
- * @brief Engine integration step.
+ * Engine::bind
+ * @brief Bind the kernel arguments. The arguments are the same in every
+ * integration step, so they are set once rather than on every step.
  */
-void Engine::execute(void)
+void Engine::bind(void)
 {
     const cl_double half_t_step = 0.5 * Params::t_step;
+    const cl_uint n_groups = Params::sampler_num_work_groups;
+    const cl_uint n_counts = Grid::m_radix_bins * Params::num_work_groups;
+
+    /* The sorted keys and values are the output of the last sort pass. */
+    const cl_mem &keys = m_buffers[m_grid.m_n_passes % 2 == 0 ? BufferGridKeys : BufferGridKeysAlt];
+    const cl_mem &values = m_buffers[m_grid.m_n_passes % 2 == 0 ? BufferGridValues : BufferGridValuesAlt];
+
+    cl::Kernel::set_arg(m_kernels[KernelAtomUpdate], 0, sizeof(cl_ulong), &Params::n_atoms);
+    cl::Kernel::set_arg(m_kernels[KernelAtomUpdate], 1, sizeof(cl_mem), &m_buffers[BufferAtoms]);
+    cl::Kernel::set_arg(m_kernels[KernelAtomUpdate], 2, sizeof(cl_mem), &m_buffers[BufferDomain]);
+    cl::Kernel::set_arg(m_kernels[KernelGridKeys], 0, sizeof(cl_ulong), &Params::n_atoms);
+    cl::Kernel::set_arg(m_kernels[KernelGridKeys], 1, sizeof(cl_mem), &m_buffers[BufferAtoms]);
+    cl::Kernel::set_arg(m_kernels[KernelGridKeys], 2, sizeof(cl_double4), &m_grid.m_length);
+    cl::Kernel::set_arg(m_kernels[KernelGridKeys], 3, sizeof(cl_int4), &m_grid.m_cells);
+    cl::Kernel::set_arg(m_kernels[KernelGridKeys], 4, sizeof(cl_mem), &m_buffers[BufferGridKeys]);
+    cl::Kernel::set_arg(m_kernels[KernelGridKeys], 5, sizeof(cl_mem), &m_buffers[BufferGridValues]);
+    cl::Kernel::set_arg(m_kernels[KernelGridCount], 0, sizeof(cl_ulong), &Params::n_atoms);
+    cl::Kernel::set_arg(m_kernels[KernelGridCount], 3, sizeof(cl_mem), &m_buffers[BufferGridCounts]);
+    cl::Kernel::set_arg(m_kernels[KernelGridCount], 4, Grid::m_radix_bins * sizeof(cl_uint), NULL);
+    cl::Kernel::set_arg(m_kernels[KernelGridScan], 0, sizeof(cl_uint), &n_counts);
+    cl::Kernel::set_arg(m_kernels[KernelGridScan], 1, sizeof(cl_mem), &m_buffers[BufferGridCounts]);
+    cl::Kernel::set_arg(m_kernels[KernelGridScan], 2, Params::work_group_size * sizeof(cl_uint), NULL);
+    cl::Kernel::set_arg(m_kernels[KernelGridScatter], 0, sizeof(cl_ulong), &Params::n_atoms);
+    cl::Kernel::set_arg(m_kernels[KernelGridScatter], 4, sizeof(cl_mem), &m_buffers[BufferGridCounts]);
+    cl::Kernel::set_arg(m_kernels[KernelGridScatter], 7, Params::work_group_size * sizeof(cl_uint), NULL);
+    cl::Kernel::set_arg(m_kernels[KernelGridClear], 0, sizeof(cl_uint), &m_grid.m_n_cells);
+    cl::Kernel::set_arg(m_kernels[KernelGridClear], 1, sizeof(cl_mem), &m_buffers[BufferGridCellBegin]);
+    cl::Kernel::set_arg(m_kernels[KernelGridClear], 2, sizeof(cl_mem), &m_buffers[BufferGridCellEnd]);
+    cl::Kernel::set_arg(m_kernels[KernelGridBounds], 0, sizeof(cl_ulong), &Params::n_atoms);
+    cl::Kernel::set_arg(m_kernels[KernelGridBounds], 1, sizeof(cl_mem), &keys);
+    cl::Kernel::set_arg(m_kernels[KernelGridBounds], 2, sizeof(cl_mem), &m_buffers[BufferGridCellBegin]);
+    cl::Kernel::set_arg(m_kernels[KernelGridBounds], 3, sizeof(cl_mem), &m_buffers[BufferGridCellEnd]);
+    cl::Kernel::set_arg(m_kernels[KernelGridReorder], 0, sizeof(cl_ulong), &Params::n_atoms);
+    cl::Kernel::set_arg(m_kernels[KernelGridReorder], 1, sizeof(cl_mem), &values);
+    cl::Kernel::set_arg(m_kernels[KernelGridReorder], 2, sizeof(cl_mem), &m_buffers[BufferAtoms]);
+    cl::Kernel::set_arg(m_kernels[KernelGridReorder], 3, sizeof(cl_mem), &m_buffers[BufferAtomsSorted]);
+    cl::Kernel::set_arg(m_kernels[KernelAtomBeginIntegrate], 0, sizeof(cl_double), (void *) &Params::t_step);
+    cl::Kernel::set_arg(m_kernels[KernelAtomBeginIntegrate], 1, sizeof(cl_ulong), &Params::n_atoms);
+    cl::Kernel::set_arg(m_kernels[KernelAtomBeginIntegrate], 2, sizeof(cl_mem), &m_buffers[BufferAtoms]);
+    cl::Kernel::set_arg(m_kernels[KernelAtomBeginIntegrate], 3, sizeof(cl_mem), &m_buffers[BufferThermostat]);
+    cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 0, sizeof(cl_ulong), &Params::n_atoms);
+    cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 1, sizeof(cl_mem), &m_buffers[BufferAtoms]);
+    cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 2, sizeof(cl_mem), &m_buffers[BufferThermostatGradSq]);
+    cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 3, sizeof(cl_mem), &m_buffers[BufferThermostatLaplace]);
+    cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 4, Params::work_group_size * sizeof(cl_double), NULL);
+    cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 5, Params::work_group_size * sizeof(cl_double), NULL);
+    cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 0, sizeof(cl_double), (void *) &half_t_step);
+    cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 1, sizeof(cl_mem), &m_buffers[BufferThermostatGradSq]);
+    cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 2, sizeof(cl_mem), &m_buffers[BufferThermostatLaplace]);
+    cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 3, sizeof(cl_mem), &m_buffers[BufferThermostat]);
+    cl::Kernel::set_arg(m_kernels[KernelAtomForce], 0, sizeof(cl_ulong), &Params::n_atoms);
+    cl::Kernel::set_arg(m_kernels[KernelAtomForce], 1, sizeof(cl_ulong), &Params::n_neighbours);
+    cl::Kernel::set_arg(m_kernels[KernelAtomForce], 2, sizeof(cl_mem), &m_buffers[BufferAtoms]);
+    cl::Kernel::set_arg(m_kernels[KernelAtomForce], 3, sizeof(cl_mem), &m_buffers[BufferDomain]);
+    cl::Kernel::set_arg(m_kernels[KernelAtomForce], 4, sizeof(cl_mem), &m_buffers[BufferField]);
+    cl::Kernel::set_arg(m_kernels[KernelAtomForce], 5, sizeof(cl_double4), &m_grid.m_length);
+    cl::Kernel::set_arg(m_kernels[KernelAtomForce], 6, sizeof(cl_int4), &m_grid.m_cells);
+    cl::Kernel::set_arg(m_kernels[KernelAtomForce], 7, sizeof(cl_uint), &Params::grid_sorted);
+    cl::Kernel::set_arg(m_kernels[KernelAtomForce], 8, sizeof(cl_mem), &values);
+    cl::Kernel::set_arg(m_kernels[KernelAtomForce], 9, sizeof(cl_mem), &m_buffers[BufferGridCellBegin]);
+    cl::Kernel::set_arg(m_kernels[KernelAtomForce], 10, sizeof(cl_mem), &m_buffers[BufferGridCellEnd]);
+    cl::Kernel::set_arg(m_kernels[KernelAtomEndIntegrate], 0, sizeof(cl_double), (void *) &Params::t_step);
+    cl::Kernel::set_arg(m_kernels[KernelAtomEndIntegrate], 1, sizeof(cl_ulong), &Params::n_atoms);
+    cl::Kernel::set_arg(m_kernels[KernelAtomEndIntegrate], 2, sizeof(cl_mem), &m_buffers[BufferAtoms]);
+    cl::Kernel::set_arg(m_kernels[KernelAtomEndIntegrate], 3, sizeof(cl_mem), &m_buffers[BufferThermostat]);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerReduce], 0, sizeof(cl_ulong), &Params::n_atoms);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerReduce], 1, sizeof(cl_mem), &m_buffers[BufferAtoms]);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerReduce], 2, sizeof(cl_mem), &m_buffers[BufferSamplerSums]);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerReduce], 3, Params::sampler_work_group_size * Params::sampler_items * sizeof(cl_double), NULL);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerThermo], 0, sizeof(cl_ulong), &Params::n_atoms);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerThermo], 1, sizeof(cl_uint), &n_groups);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerThermo], 2, sizeof(cl_mem), &m_buffers[BufferSamplerSums]);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerThermo], 3, sizeof(cl_mem), &m_buffers[BufferDomain]);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerThermo], 4, sizeof(cl_mem), &m_buffers[BufferThermo]);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerThermo], 5, Params::sampler_work_group_size * Params::sampler_items * sizeof(cl_double), NULL);
+
+    if (m_buffers[BufferGLVertexAtom] != NULL) {
+        cl::Kernel::set_arg(m_kernels[KernelAtomCopyVertex], 0, sizeof(cl_ulong), &Params::n_atoms);
+        cl::Kernel::set_arg(m_kernels[KernelAtomCopyVertex], 1, sizeof(cl_mem), &m_buffers[BufferAtoms]);
+    }
+}
 
+/** ---------------------------------------------------------------------------
+ * Engine::execute
+ * @brief Engine integration step. The kernel arguments are bound by
+ * Engine::bind and the kernels are enqueued on the pipeline, each waiting on
+ * the kernels it depends on.
+ */
+void Engine::execute(void)
+{
     /*
      * Update fluid state and associated data structures.
      */
-    {
-        /* Update atom positions and associated data structures. */
-        cl::Kernel::set_arg(m_kernels[KernelAtomUpdate], 0, sizeof(cl_ulong), &Params::n_atoms);
-        cl::Kernel::set_arg(m_kernels[KernelAtomUpdate], 1, sizeof(cl_mem), &m_buffers[BufferAtoms]);
-        cl::Kernel::set_arg(m_kernels[KernelAtomUpdate], 2, sizeof(cl_mem), &m_buffers[BufferDomain]);
-        cl::Queue::enqueue_nd_range_kernel(
-            m_queue,
-            m_kernels[KernelAtomUpdate],
-            cl::NDRange::Null,
-            cl::NDRange::Make(Params::n_atoms, Params::work_group_size),
-            cl::NDRange(Params::work_group_size),
-            NULL,
-            NULL);
-
-        /* Clear all key-value pairs in the grid and reset their count. */
-        cl::Kernel::set_arg(m_kernels[KernelGridClear], 0, sizeof(cl_uint), &m_grid.m_capacity);
-        cl::Kernel::set_arg(m_kernels[KernelGridClear], 1, sizeof(cl_mem), &m_buffers[BufferGrid]);
-        cl::Queue::enqueue_nd_range_kernel(
-            m_queue,
-            m_kernels[KernelGridClear],
-            cl::NDRange::Null,
-            cl::NDRange::Make(m_grid.m_capacity, Params::work_group_size),
-            cl::NDRange(Params::work_group_size),
-            NULL,
-            NULL);
-
-        /* Insert the atom positions into the grid. */
-        cl::Kernel::set_arg(m_kernels[KernelGridInsert], 0, sizeof(cl_ulong), &Params::n_atoms);
-        cl::Kernel::set_arg(m_kernels[KernelGridInsert], 1, sizeof(cl_mem), &m_buffers[BufferAtoms]);
-        cl::Kernel::set_arg(m_kernels[KernelGridInsert], 2, sizeof(cl_double4), &m_grid.m_length);
-        cl::Kernel::set_arg(m_kernels[KernelGridInsert], 3, sizeof(cl_int4), &m_grid.m_cells);
-        cl::Kernel::set_arg(m_kernels[KernelGridInsert], 4, sizeof(cl_uint), &m_grid.m_items);
-        cl::Kernel::set_arg(m_kernels[KernelGridInsert], 5, sizeof(cl_uint), &m_grid.m_capacity);
-        cl::Kernel::set_arg(m_kernels[KernelGridInsert], 6, sizeof(cl_mem), &m_buffers[BufferGrid]);
-        cl::Queue::enqueue_nd_range_kernel(
-            m_queue,
-            m_kernels[KernelGridInsert],
-            cl::NDRange::Null,
-            cl::NDRange::Make(Params::n_atoms, Params::work_group_size),
-            cl::NDRange(Params::work_group_size),
-            NULL,
-            NULL);
+    cl_event update = m_pipeline.enqueue(
+        m_kernels[KernelAtomUpdate],
+        Params::n_atoms,
+        Params::work_group_size,
+        {m_pipeline.m_frontier});
+    cl_event keys = m_pipeline.enqueue(
+        m_kernels[KernelGridKeys],
+        Params::n_atoms,
+        Params::work_group_size,
+        {update});
+
+    /*
+     * Sort the (key, atom) pairs by radix digit, from the least to the
+     * most significant. Each pass counts the digits of each work group,
+     * scans the counts and scatters the pairs into the alternate arrays,
+     * which become the input of the next pass. Only the pass arguments
+     * are set here, the remaining arguments are bound by Engine::bind.
+     */
+    cl_event sorted = keys;
+    for (cl_uint pass = 0; pass < m_grid.m_n_passes; ++pass) {
+        const cl_uint shift = pass * Grid::m_radix_bits;
+        const cl_mem &keys_in = m_buffers[pass % 2 == 0 ? BufferGridKeys : BufferGridKeysAlt];
+        const cl_mem &values_in = m_buffers[pass % 2 == 0 ? BufferGridValues : BufferGridValuesAlt];
+        const cl_mem &keys_out = m_buffers[pass % 2 == 0 ? BufferGridKeysAlt : BufferGridKeys];
+        const cl_mem &values_out = m_buffers[pass % 2 == 0 ? BufferGridValuesAlt : BufferGridValues];
+
+        cl::Kernel::set_arg(m_kernels[KernelGridCount], 1, sizeof(cl_uint), &shift);
+        cl::Kernel::set_arg(m_kernels[KernelGridCount], 2, sizeof(cl_mem), &keys_in);
+        cl_event count = m_pipeline.enqueue(
+            m_kernels[KernelGridCount],
+            Params::n_atoms,
+            Params::work_group_size,
+            {sorted});
+        cl_event scan = m_pipeline.enqueue(
+            m_kernels[KernelGridScan],
+            Params::work_group_size,
+            Params::work_group_size,
+            {count});
+
+        cl::Kernel::set_arg(m_kernels[KernelGridScatter], 1, sizeof(cl_uint), &shift);
+        cl::Kernel::set_arg(m_kernels[KernelGridScatter], 2, sizeof(cl_mem), &keys_in);
+        cl::Kernel::set_arg(m_kernels[KernelGridScatter], 3, sizeof(cl_mem), &values_in);
+        cl::Kernel::set_arg(m_kernels[KernelGridScatter], 5, sizeof(cl_mem), &keys_out);
+        cl::Kernel::set_arg(m_kernels[KernelGridScatter], 6, sizeof(cl_mem), &values_out);
+        cl_event scatter = m_pipeline.enqueue(
+            m_kernels[KernelGridScatter],
+            Params::n_atoms,
+            Params::work_group_size,
+            {scan});
+
+        /* The keys event is released as the input of the first pass. */
+        Pipeline::release({sorted, count, scan});
+        sorted = scatter;
     }
 
+    /* Clear the cell ranges and compute the range of each cell. */
+    cl_event clear = m_pipeline.enqueue(
+        m_kernels[KernelGridClear],
+        m_grid.m_n_cells,
+        Params::work_group_size,
+        {update});
+    cl_event bounds = m_pipeline.enqueue(
+        m_kernels[KernelGridBounds],
+        Params::n_atoms,
+        Params::work_group_size,
+        {sorted, clear});
+
     /*
-     * Begin integration - first half of the integration step.
+     * Reorder the atoms by cell and copy the sorted atoms back, keeping the
+     * atom buffer bound to the kernels.
      */
-    {
-        /* Integrate the atoms at half time step. */
-        cl::Kernel::set_arg(m_kernels[KernelAtomBeginIntegrate], 0, sizeof(cl_double), (void *) &Params::t_step);
-        cl::Kernel::set_arg(m_kernels[KernelAtomBeginIntegrate], 1, sizeof(cl_ulong), &Params::n_atoms);
-        cl::Kernel::set_arg(m_kernels[KernelAtomBeginIntegrate], 2, sizeof(cl_mem), &m_buffers[BufferAtoms]);
-        cl::Kernel::set_arg(m_kernels[KernelAtomBeginIntegrate], 3, sizeof(cl_mem), &m_buffers[BufferThermostat]);
-        cl::Queue::enqueue_nd_range_kernel(
-            m_queue,
-            m_kernels[KernelAtomBeginIntegrate],
-            cl::NDRange::Null,
-            cl::NDRange::Make(Params::n_atoms, Params::work_group_size),
-            cl::NDRange(Params::work_group_size),
-            NULL,
-            NULL);
-
-        /* Compute thermostat force using the updated atom momenta. */
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 0, sizeof(cl_ulong), &Params::n_atoms);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 1, sizeof(cl_mem), &m_buffers[BufferAtoms]);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 2, sizeof(cl_mem), &m_buffers[BufferThermostatGradSq]);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 3, sizeof(cl_mem), &m_buffers[BufferThermostatLaplace]);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 4, Params::work_group_size * sizeof(cl_double), NULL);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 5, Params::work_group_size * sizeof(cl_double), NULL);
-        cl::Queue::enqueue_nd_range_kernel(
-            m_queue,
-            m_kernels[KernelThermostatForce],
-            cl::NDRange::Null,
-            cl::NDRange::Make(Params::n_atoms, Params::work_group_size),
-            cl::NDRange(Params::work_group_size),
-            NULL,
-            NULL);
-
-        /* Integrate thermostat using the computed forces. */
-        cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 0, sizeof(cl_double), (void *) &half_t_step);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 1, sizeof(cl_mem), &m_buffers[BufferThermostatGradSq]);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 2, sizeof(cl_mem), &m_buffers[BufferThermostatLaplace]);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 3, sizeof(cl_mem), &m_buffers[BufferThermostat]);
-        cl::Queue::enqueue_nd_range_kernel(
+    cl_event reorder = NULL;
+    cl_event updated = bounds;
+    if (Params::grid_sorted) {
+        cl_event gather = m_pipeline.enqueue(
+            m_kernels[KernelGridReorder],
+            Params::n_atoms,
+            Params::work_group_size,
+            {bounds});
+
+        cl_int err = clEnqueueCopyBuffer(
             m_queue,
-            m_kernels[KernelThermostatIntegrate],
-            cl::NDRange::Null,
-            cl::NDRange::Make(Params::n_atoms, Params::work_group_size),
-            cl::NDRange(Params::work_group_size),
-            NULL,
-            NULL);
+            m_buffers[BufferAtomsSorted],
+            m_buffers[BufferAtoms],
+            0,
+            0,
+            Params::n_atoms * sizeof(Atom),
+            gather != NULL ? 1 : 0,
+            gather != NULL ? &gather : NULL,
+            m_pipeline.m_out_of_order ? &reorder : NULL);
+        core_assert(err == CL_SUCCESS, "failed to copy sorted atoms");
+        Pipeline::release({gather});
+        updated = reorder;
     }
 
+    /*
+     * Begin integration - first half of the integration step. The thermostat
+     * only depends on the atom momenta, so its integration may execute
+     * concurrently with the force computation.
+     */
+    cl_event begin_integrate = m_pipeline.enqueue(
+        m_kernels[KernelAtomBeginIntegrate],
+        Params::n_atoms,
+        Params::work_group_size,
+        {updated});
+    cl_event begin_thermostat_force = m_pipeline.enqueue(
+        m_kernels[KernelThermostatForce],
+        Params::n_atoms,
+        Params::work_group_size,
+        {begin_integrate});
+    cl_event begin_thermostat = m_pipeline.enqueue(
+        m_kernels[KernelThermostatIntegrate],
+        Params::n_atoms,
+        Params::work_group_size,
+        {begin_thermostat_force});
+
     /*
      * Compute fluid forces.
      */
-    {
-        cl::Kernel::set_arg(m_kernels[KernelAtomForce], 0, sizeof(cl_ulong), &Params::n_atoms);
-        cl::Kernel::set_arg(m_kernels[KernelAtomForce], 1, sizeof(cl_ulong), &Params::n_neighbours);
-        cl::Kernel::set_arg(m_kernels[KernelAtomForce], 2, sizeof(cl_mem), &m_buffers[BufferAtoms]);
-        cl::Kernel::set_arg(m_kernels[KernelAtomForce], 3, sizeof(cl_mem), &m_buffers[BufferDomain]);
-        cl::Kernel::set_arg(m_kernels[KernelAtomForce], 4, sizeof(cl_mem), &m_buffers[BufferField]);
-        cl::Kernel::set_arg(m_kernels[KernelAtomForce], 5, sizeof(cl_double4), &m_grid.m_length);
-        cl::Kernel::set_arg(m_kernels[KernelAtomForce], 6, sizeof(cl_int4), &m_grid.m_cells);
-        cl::Kernel::set_arg(m_kernels[KernelAtomForce], 7, sizeof(cl_uint), &m_grid.m_items);
-        cl::Kernel::set_arg(m_kernels[KernelAtomForce], 8, sizeof(cl_uint), &m_grid.m_capacity);
-        cl::Kernel::set_arg(m_kernels[KernelAtomForce], 9, sizeof(cl_mem), &m_buffers[BufferGrid]);
-        cl::Queue::enqueue_nd_range_kernel(
-            m_queue,
-            m_kernels[KernelAtomForce],
-            cl::NDRange::Null,
-            cl::NDRange::Make(Params::n_atoms, Params::work_group_size),
-            cl::NDRange(Params::work_group_size),
-            NULL,
-            NULL);
-    }
+    cl_event force = m_pipeline.enqueue(
+        m_kernels[KernelAtomForce],
+        Params::n_atoms,
+        Params::work_group_size,
+        {begin_integrate});
 
     /*
      * End integration - second half of the integration step.
      */
-    {
-        /* Compute thermostat force using the updated atom momenta. */
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 0, sizeof(cl_ulong), &Params::n_atoms);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 1, sizeof(cl_mem), &m_buffers[BufferAtoms]);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 2, sizeof(cl_mem), &m_buffers[BufferThermostatGradSq]);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 3, sizeof(cl_mem), &m_buffers[BufferThermostatLaplace]);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 4, Params::work_group_size * sizeof(cl_double), NULL);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 5, Params::work_group_size * sizeof(cl_double), NULL);
-        cl::Queue::enqueue_nd_range_kernel(
-            m_queue,
-            m_kernels[KernelThermostatForce],
-            cl::NDRange::Null,
-            cl::NDRange::Make(Params::n_atoms, Params::work_group_size),
-            cl::NDRange(Params::work_group_size),
-            NULL,
-            NULL);
-
-        /* Integrate thermostat using the computed forces. */
-        cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 0, sizeof(cl_double), (void *) &half_t_step);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 1, sizeof(cl_mem), &m_buffers[BufferThermostatGradSq]);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 2, sizeof(cl_mem), &m_buffers[BufferThermostatLaplace]);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 3, sizeof(cl_mem), &m_buffers[BufferThermostat]);
-        cl::Queue::enqueue_nd_range_kernel(
-            m_queue,
-            m_kernels[KernelThermostatIntegrate],
-            cl::NDRange::Null,
-            cl::NDRange::Make(Params::n_atoms, Params::work_group_size),
-            cl::NDRange(Params::work_group_size),
-            NULL,
-            NULL);
-
-        /* Integrate the momenta for half time step. */
-        cl::Kernel::set_arg(m_kernels[KernelAtomEndIntegrate], 0, sizeof(cl_double), (void *) &Params::t_step);
-        cl::Kernel::set_arg(m_kernels[KernelAtomEndIntegrate], 1, sizeof(cl_ulong), &Params::n_atoms);
-        cl::Kernel::set_arg(m_kernels[KernelAtomEndIntegrate], 2, sizeof(cl_mem), &m_buffers[BufferAtoms]);
-        cl::Kernel::set_arg(m_kernels[KernelAtomEndIntegrate], 3, sizeof(cl_mem), &m_buffers[BufferThermostat]);
-        cl::Queue::enqueue_nd_range_kernel(
-            m_queue,
-            m_kernels[KernelAtomEndIntegrate],
-            cl::NDRange::Null,
-            cl::NDRange::Make(Params::n_atoms, Params::work_group_size),
-            cl::NDRange(Params::work_group_size),
-            NULL,
-            NULL);
+    cl_event end_thermostat_force = m_pipeline.enqueue(
+        m_kernels[KernelThermostatForce],
+        Params::n_atoms,
+        Params::work_group_size,
+        {begin_thermostat});
+    cl_event end_thermostat = m_pipeline.enqueue(
+        m_kernels[KernelThermostatIntegrate],
+        Params::n_atoms,
+        Params::work_group_size,
+        {end_thermostat_force});
+    cl_event end_integrate = m_pipeline.enqueue(
+        m_kernels[KernelAtomEndIntegrate],
+        Params::n_atoms,
+        Params::work_group_size,
+        {force, end_thermostat});
+
+    Pipeline::release({
+        update,
+        sorted,
+        clear,
+        bounds,
+        reorder,
+        begin_integrate,
+        begin_thermostat_force,
+        begin_thermostat,
+        force,
+        end_thermostat_force,
+        end_thermostat});
+    m_pipeline.advance(end_integrate);
+}
+
+/**
+ * Engine::execute
+ * @brief Execute the specified number of integration steps back-to-back,
+ * without any host synchronization.
+ */
+void Engine::execute(const cl_ulong n_steps)
+{
+    for (cl_ulong step = 0; step < n_steps; ++step) {
+        execute();
     }
+}
 
-    /*
-     * Copy atom positions onto the shared OpenGL vertex buffer object.
-     */
-    {
-        /* Wait for OpenGL to finish and acquire the gl objects. */
-        cl::gl::enqueue_acquire_gl_objects(m_queue, 1, &m_buffers[BufferGLVertexAtom], NULL, NULL);
-
-        /* Enqueue the OpenCL kernel for execution. */
-        cl::Kernel::set_arg(m_kernels[KernelAtomCopyVertex],
-            0, sizeof(cl_ulong), &Params::n_atoms);
-        cl::Kernel::set_arg(m_kernels[KernelAtomCopyVertex],
-            1, sizeof(cl_mem), &m_buffers[BufferAtoms]);
-        cl::Kernel::set_arg(m_kernels[KernelAtomCopyVertex],
-            2, sizeof(cl_mem), &m_buffers[BufferGLVertexAtom]);
-        cl::Queue::enqueue_nd_range_kernel(
-            m_queue,
-            m_kernels[KernelAtomCopyVertex],
-            cl::NDRange::Null,
-            cl::NDRange::Make(Params::n_atoms, Params::work_group_size),
-            cl::NDRange(Params::work_group_size),
-            NULL,
-            NULL);
-
-        /* Wait for OpenCL to finish and release the gl objects. */
-        cl::gl::enqueue_release_gl_objects(m_queue, 1, &m_buffers[BufferGLVertexAtom], NULL, NULL);
+/** ---------------------------------------------------------------------------
+ * Engine::snapshot
+ * @brief Copy the atom positions into the back snapshot buffer, after the
+ * last enqueued step and before the next one. The snapshot does not involve
+ * the OpenGL objects, so the engine queue never waits on OpenGL. The back
+ * buffer is free, its last present completed before present returned.
+ */
+void Engine::snapshot(void)
+{
+    if (m_buffers[BufferGLVertexAtom] == NULL) {
+        return;
+    }
+
+    /* Copy the atom positions into the back snapshot buffer. */
+    const size_t back = m_snapshot_ix ^ 1;
+    cl::Kernel::set_arg(m_kernels[KernelAtomCopyVertex], 2, sizeof(cl_mem), &m_buffers[BufferSnapshot0 + back]);
+    cl_event copy_vertex = m_pipeline.enqueue(
+        m_kernels[KernelAtomCopyVertex],
+        Params::n_atoms,
+        Params::work_group_size,
+        {m_pipeline.m_frontier});
+    m_pipeline.advance(copy_vertex);
+
+    /* Mark the snapshot completion and swap the snapshot buffers. */
+    if (m_snapshot_events[back] != NULL) {
+        clReleaseEvent(m_snapshot_events[back]);
+    }
+    cl_int err = clEnqueueMarkerWithWaitList(
+        m_queue, 0, NULL, &m_snapshot_events[back]);
+    core_assert(err == CL_SUCCESS, "failed to enqueue marker");
+    clFlush(m_queue);
+    m_snapshot_ix = back;
+}
+
+/**
+ * Engine::present
+ * @brief Copy the latest completed snapshot onto the shared OpenGL vertex
+ * buffer on the render queue. If the latest snapshot is still pending behind
+ * the engine steps, the previous snapshot is presented instead, so a frame
+ * only waits on the engine before the first two snapshots complete.
+ */
+void Engine::present(void)
+{
+    size_t front = m_snapshot_ix;
+    if (m_buffers[BufferGLVertexAtom] == NULL ||
+        m_snapshot_events[front] == NULL) {
+        return;
+    }
+
+    cl_int status = CL_COMPLETE;
+    clGetEventInfo(
+        m_snapshot_events[front],
+        CL_EVENT_COMMAND_EXECUTION_STATUS,
+        sizeof(status),
+        &status,
+        NULL);
+    if (status != CL_COMPLETE && m_snapshot_events[front ^ 1] != NULL) {
+        front ^= 1;
     }
+
+    /* Wait for OpenGL to finish and acquire the gl objects. */
+    glFinish();
+    cl::gl::enqueue_acquire_gl_objects(m_render_queue, 1, &m_buffers[BufferGLVertexAtom], NULL, NULL);
+
+    /* Copy the snapshot after it completes on the engine queue. */
+    cl_int err = clEnqueueCopyBuffer(
+        m_render_queue,
+        m_buffers[BufferSnapshot0 + front],
+        m_buffers[BufferGLVertexAtom],
+        0,
+        0,
+        6 * Params::n_atoms * sizeof(cl_float),
+        1,
+        &m_snapshot_events[front],
+        NULL);
+    core_assert(err == CL_SUCCESS, "failed to enqueue snapshot copy");
+
+    /* Wait for OpenCL to finish and release the gl objects. */
+    cl::gl::enqueue_release_gl_objects(m_render_queue, 1, &m_buffers[BufferGLVertexAtom], NULL, NULL);
+    clFinish(m_render_queue);
 }
 
 /**
  * Engine::sample
- * @brief Sample fluid thermodynamic properties.
+ * @brief Sample fluid thermodynamic properties. The properties are reduced
+ * on the device in two stages, a partial sum over the atoms of each work
+ * group and a final sum over the work groups. Only the reduced properties
+ * are read back to the host, asynchronously, and are collected by the next
+ * call to sample, so sampling does not stall the host.
  */
-std::string Engine::sample(void)
+std::string Engine::sample(const cl_ulong step)
 {
-    cl::Queue::enqueue_copy_from(
+    /* Collect the previous sample. */
+    std::string log = sample_collect();
+
+    /*
+     * Reduce the atom partial sums of each work group, then reduce the work
+     * group partial sums and compute the properties.
+     */
+    cl_event reduce = m_pipeline.enqueue(
+        m_kernels[KernelSamplerReduce],
+        Params::sampler_num_work_groups * Params::sampler_work_group_size,
+        Params::sampler_work_group_size,
+        {m_pipeline.m_frontier});
+    cl_event thermo = m_pipeline.enqueue(
+        m_kernels[KernelSamplerThermo],
+        Params::sampler_work_group_size,
+        Params::sampler_work_group_size,
+        {reduce});
+
+    /* Read the properties back without blocking. */
+    clEnqueueReadBuffer(
         m_queue,
-        m_buffers[BufferAtoms],
-        m_atoms.size() * sizeof(m_atoms[0]),
-        (void *) &m_atoms[0]);
+        m_buffers[BufferThermo],
+        CL_FALSE,
+        0,
+        sizeof(m_thermo),
+        (void *) &m_thermo,
+        thermo != NULL ? 1 : 0,
+        thermo != NULL ? &thermo : NULL,
+        &m_thermo_event);
+    clFlush(m_queue);
+    m_thermo_step = step;
+
+    /* Order the next step after the sampler reads the atoms. */
+    Pipeline::release({reduce});
+    m_pipeline.advance(thermo);
+
+    return log;
+}
 
-    m_sampler.sample(m_atoms, m_domain);
+/**
+ * Engine::sample_collect
+ * @brief Wait for the readback of the pending sample, if any, and add it to
+ * the sampler. Return its serialized properties, or an empty string.
+ */
+std::string Engine::sample_collect(void)
+{
+    if (m_thermo_event == NULL) {
+        return std::string();
+    }
 
-    return m_sampler.log_string();
+    clWaitForEvents(1, &m_thermo_event);
+    clReleaseEvent(m_thermo_event);
+    m_thermo_event = NULL;
+
+    m_sampler.sample(m_thermo);
+
+    std::ostringstream ss;
+    ss << "step " << m_thermo_step << "\n" << m_sampler.log_string() << "\n";
+    return ss.str();
 }
 
 /** ---------------------------------------------------------------------------
@@ -469,6 +820,15 @@ void Engine::generate(void)
             half.s[1],
             half.s[2]);
 
+        /* Shuffle the lattice sites to mix the atom type blocks. */
+        if (Params::n_types > 1) {
+            math::rng::Kiss engine(true);           /* rng engine */
+            math::rng::uniform<uint64_t> rand;      /* rng sampler */
+            for (size_t i = positions.size() - 1; i > 0; --i) {
+                std::swap(positions[i], positions[rand(engine, 0, i + 1)]);
+            }
+        }
+
         cl_ulong ix = 0;
         for (auto &pos : positions) {
             m_atoms[ix].pos = pos;
@@ -499,6 +859,7 @@ void Engine::generate(void)
     /*
      * Copy atom positions and momenta to the device.
      */
+    m_pipeline.finish();
     cl::Queue::enqueue_copy_to(
         m_queue,
         m_buffers[BufferAtoms],
@@ -524,8 +885,9 @@ void Engine::reset(const cl_double radius)
      */
     {
         /*
-         * Copy the atoms from the device.
+         * Wait for the pipeline and copy the atoms from the device.
          */
+        m_pipeline.finish();
         cl::Queue::enqueue_copy_from(
             m_queue,
             m_buffers[BufferAtoms],
@@ -600,7 +962,8 @@ void Engine::reset(const cl_double radius)
     }
 
     /*
-     * Reset sampler properties.
+     * Reset sampler properties, discarding any pending sample.
      */
+    sample_collect();
     m_sampler.reset();
 }
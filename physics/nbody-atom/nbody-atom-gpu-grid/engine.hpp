@@ -19,6 +19,7 @@
 #include "sampler.hpp"
 #include "generate.hpp"
 #include "io.hpp"
+#include "pipeline.hpp"
 
 /**
  * Engine
@@ -44,6 +45,8 @@ struct Engine {
     Thermostat m_thermostat;            /* fluid thermostat */
     Thermo m_thermo;                    /* fluid thermodynamic properties */
     Sampler m_sampler;                  /* fluid thermodynamic sampler */
+    cl_event m_thermo_event = NULL;     /* thermo readback event */
+    cl_ulong m_thermo_step = 0;         /* step of the pending thermo */
     Grid m_grid;                        /* atom grid spatial data strcture */
 
     /* Engine program. */
@@ -51,6 +54,17 @@ struct Engine {
     cl_device_id m_device = NULL;
     cl_command_queue m_queue = NULL;
     cl_program m_program = NULL;
+    Pipeline m_pipeline;                /* engine step pipeline */
+
+    /*
+     * Engine render snapshots. The atom positions are copied into one of two
+     * device snapshot buffers when a frame is due, and the latest completed
+     * snapshot is copied onto the OpenGL vertex buffer on a separate render
+     * queue, so the engine queue never acquires the OpenGL objects.
+     */
+    cl_command_queue m_render_queue = NULL;     /* render queue */
+    cl_event m_snapshot_events[2] = {NULL, NULL}; /* snapshot completion */
+    size_t m_snapshot_ix = 0;           /* latest snapshot buffer */
 
     /* Engine kernels. */
     enum {
@@ -61,8 +75,15 @@ struct Engine {
         KernelAtomCopyVertex,
         KernelThermostatForce,
         KernelThermostatIntegrate,
+        KernelSamplerReduce,
+        KernelSamplerThermo,
+        KernelGridKeys,
+        KernelGridCount,
+        KernelGridScan,
+        KernelGridScatter,
         KernelGridClear,
-        KernelGridInsert,
+        KernelGridBounds,
+        KernelGridReorder,
         NumKernels
     };
     std::vector<cl_kernel> m_kernels;
@@ -75,8 +96,19 @@ struct Engine {
         BufferThermostat,
         BufferThermostatGradSq,
         BufferThermostatLaplace,
+        BufferSamplerSums,
+        BufferThermo,
         BufferGLVertexAtom,
-        BufferGrid,
+        BufferSnapshot0,
+        BufferSnapshot1,
+        BufferAtomsSorted,
+        BufferGridKeys,
+        BufferGridValues,
+        BufferGridKeysAlt,
+        BufferGridValuesAlt,
+        BufferGridCounts,
+        BufferGridCellBegin,
+        BufferGridCellEnd,
         NumBuffers
     };
     std::vector<cl_mem> m_buffers;
@@ -87,11 +119,30 @@ struct Engine {
     };
     std::vector<cl_mem> m_images;
 
+    /** Bind the kernel arguments that are the same in every step. */
+    void bind(void);
+
     /** Execute one integration step. */
     void execute(void);
 
-    /** Return serialized fluid thermodynamic properties. */
-    std::string sample(void);
+    /** Execute a batch of integration steps without host synchronization. */
+    void execute(const cl_ulong n_steps);
+
+    /** Copy the atom positions into the back snapshot buffer. */
+    void snapshot(void);
+
+    /** Copy the latest completed snapshot onto the OpenGL vertex buffer. */
+    void present(void);
+
+    /**
+     * Sample the fluid thermodynamic properties on the device at the
+     * specified step and return the serialized properties of the previous
+     * sample, whose readback completed in the meantime.
+     */
+    std::string sample(const cl_ulong step);
+
+    /** Collect the pending sample and return its serialized properties. */
+    std::string sample_collect(void);
 
     /** Generate atom positions and momenta. */
     void generate(void);
@@ -99,12 +150,15 @@ struct Engine {
     /** Reset the engine state. */
     void reset(const double radius);
 
-    /** Setup/teardown engine. */
+    /**
+     * Setup/teardown engine. The engine runs headless, without snapshots of
+     * the atom positions for a shared OpenGL buffer, if gl_vertex_buffer is 0.
+     */
     void setup(
         const cl_context &context,
         const cl_device_id &device,
         const cl_command_queue &queue,
-        const GLuint &gl_vertex_buffer);
+        const GLuint &gl_vertex_buffer = 0);
 
     void teardown(void);
 
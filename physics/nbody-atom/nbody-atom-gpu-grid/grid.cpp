@@ -15,27 +15,30 @@ using namespace atto;
 
 /**
  * Grid::Grid
- * @brief Create a grid with a specified length and with a maximum number
- * of items per cell.
+ * @brief Create a grid with a specified length and a minimum cell length.
+ * The number of radix sort passes covers the bits of the largest cell key.
  */
-Grid::Grid(
-    const cl_double4 &grid_length,
-    const double cell_length,
-    const cl_uint cell_items)
+Grid::Grid(const cl_double4 &grid_length, const double cell_length)
 {
     m_length = grid_length;
     m_cells = cl_int3{
-        (cl_int) (grid_length.s[0] / cell_length),
-        (cl_int) (grid_length.s[1] / cell_length),
-        (cl_int) (grid_length.s[2] / cell_length)};
-    m_items = cell_items;
-    m_capacity = m_items * m_cells.s[0] * m_cells.s[1] * m_cells.s[2];
+        std::max((cl_int) (grid_length.s[0] / cell_length), (cl_int) 1),
+        std::max((cl_int) (grid_length.s[1] / cell_length), (cl_int) 1),
+        std::max((cl_int) (grid_length.s[2] / cell_length), (cl_int) 1)};
+    m_n_cells = m_cells.s[0] * m_cells.s[1] * m_cells.s[2];
+
+    cl_uint n_bits = 0;
+    while (n_bits < 32 && ((m_n_cells - 1) >> n_bits) != 0) {
+        n_bits++;
+    }
+    m_n_passes = std::max(
+        (n_bits + m_radix_bits - 1) / m_radix_bits, (cl_uint) 1);
 
     // DEBUG
     std::cout << "grid with m_cells "
               << m_cells.s[0] << " "
               << m_cells.s[1] << " "
               << m_cells.s[2] << " "
-              << "m_items "
-              << m_items << "\n";
+              << "m_n_passes "
+              << m_n_passes << "\n";
 }
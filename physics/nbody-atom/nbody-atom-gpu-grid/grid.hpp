@@ -17,44 +17,31 @@
 
 /**
  * Grid
- * @brief Grid represents a 3-dimensional grid of cells with a load factor
- * corresponding to n atoms per cell.
+ * @brief Grid represents a 3-dimensional grid of cells stored as a cell list
+ * sorted by cell key.
  *
- * The underlying data structure is an array of key-value pairs using open
- * addressing with linear probing to resolve collisions.
- *
- * The key is a hash representation of the cell where the atom belongs to,
- * with a value holding the atom index.
- * Two atoms belonging to the same cell have equal keys. The collision is
- * resolved using linear probing. The table is searched linearly for the
- * closest free location and the new key is inserted there with a value
- * given by the index of the second atom.
+ * The key of an atom is the row-major index of the cell where the atom belongs
+ * to. The (key, atom index) pairs are sorted on the device by a least
+ * significant digit radix sort, processing m_radix_bits of the key in each
+ * pass. The sorted keys then define the contiguous range [begin, end) of each
+ * cell, so two atoms belonging to the same cell are adjacent in the sorted
+ * array. There are no atomic insertions and no probe sequences, and the
+ * atoms can be reordered by cell to coalesce the loads of neighbour cells.
  */
 struct Grid {
-    /* Item data type holding a key-value pair. */
-    struct Item {
-        cl_uint key;
-        cl_uint value;
-    };
-
-    /* Capacity range as a power of two */
-    static const cl_uint m_min_size = 1 << 3;      /* 8 items */
-    static const cl_uint m_max_size = 1 << 31;     /* 2147483648 items */
-
-    /* State flag indicating an empty key. */
-    static const cl_uint m_empty = 0xffffffff;
+    /* Radix sort digit size. Must match the device kRadixBits. */
+    static const cl_uint m_radix_bits = 4;
+    static const cl_uint m_radix_bins = 1 << m_radix_bits;
 
     /* Grid member variables. */
     cl_double4 m_length;        /* grid length in each direction */
     cl_int4 m_cells;            /* number of cells in each direction */
-    cl_uint m_items;            /* max number of items per cell */
-    cl_uint m_capacity;         /* max number of items in the table */
+    cl_uint m_n_cells;          /* total number of cells */
+    cl_uint m_n_passes;         /* number of radix sort passes */
 
     /* Constructor/destructor. */
     Grid() = default;
-    Grid(const cl_double4 &grid_length,
-         const double cell_length,
-         const cl_uint cell_items);
+    Grid(const cl_double4 &grid_length, const double cell_length);
     ~Grid() = default;
 };
 
@@ -147,7 +147,7 @@ Model::Model(void)
         core_assert(Params::device_index < devices.size(), "device index overflow");
         m_device = devices[Params::device_index];
         m_context = cl::Context::create_cl_gl_shared(m_device);
-        m_queue = cl::Queue::create(m_context, m_device);
+        m_queue = common::CreateQueue(m_context, m_device);
         // std::cout << cl::Device::get_info_string(m_device) << "\n";
     }
 
@@ -157,6 +157,7 @@ Model::Model(void)
     {
         /* Store model parameters. */
         m_step = 0;
+        m_frame_time = std::chrono::steady_clock::now();
 
         /* Setup engine object. */
         m_engine.setup(
@@ -290,6 +291,9 @@ void Model::draw(void *data)
     glUseProgram(m_gl.program);
     glBindVertexArray(m_gl.vao);
 
+    /* Copy the latest atom positions snapshot onto the vertex buffer. */
+    m_engine.present();
+
     /* Set uniforms and draw. */
 #if 0
     std::array<GLfloat,2> sizef = gl::Renderer::framebuffer_sizef();
@@ -320,18 +324,41 @@ void Model::draw(void *data)
  */
 bool Model::execute(void)
 {
-    /* Model pre-execution. */
-    if (m_step == Params::n_min_steps) {
-        m_engine.reset(Params::pair_r_hard * Params::pair_sigma);
-    }
+    /*
+     * Execute batches of engine steps until the next frame is due, then take
+     * a snapshot of the atom positions for the frame. The engine is throttled
+     * after each batch, so the number of steps per frame follows the device
+     * throughput instead of the display rate.
+     */
+    const std::chrono::duration<double> frame_interval(1.0 / Params::frame_rate);
+    do {
+        /* Model pre-execution. */
+        if (m_step == Params::n_min_steps) {
+            m_engine.reset(Params::pair_r_hard * Params::pair_sigma);
+        }
 
-    /* Execute an engine step. */
-    m_engine.execute();
+        /*
+         * Execute a batch of engine steps up to the next model event, the end
+         * of the minimization stage or the next sample.
+         */
+        cl_ulong n_steps = Params::sample_frequency - m_step%Params::sample_frequency;
+        if (m_step < Params::n_min_steps) {
+            n_steps = std::min(n_steps, Params::n_min_steps - m_step);
+        }
+        n_steps = std::min(n_steps, Params::n_run_steps - m_step);
+        m_engine.execute(n_steps);
+        m_engine.m_pipeline.throttle();
+        m_step += n_steps;
+
+        /* Model post-execution. */
+        if (m_step%Params::sample_frequency == 0) {
+            std::cout << m_engine.sample(m_step);
+        }
+    } while (m_step < Params::n_run_steps &&
+             std::chrono::steady_clock::now() - m_frame_time < frame_interval);
 
-    /* Model post-execution. */
-    if (++m_step%Params::sample_frequency == 0) {
-        std::cout << "step " << m_step << "\n" << m_engine.sample() << "\n";
-    }
+    m_engine.snapshot();
+    m_frame_time = std::chrono::steady_clock::now();
 
     return (m_step < Params::n_run_steps);
 }
@@ -13,6 +13,7 @@
 #define MD_MODEL_H_
 
 #include <vector>
+#include <chrono>
 #include "atto/opencl/opencl.hpp"
 #include "engine.hpp"
 #include "camera.hpp"
@@ -20,6 +21,7 @@
 struct Model : atto::gl::Drawable {
     /* ---- Model data ----------------------------------------------------- */
     size_t m_step;
+    std::chrono::steady_clock::time_point m_frame_time;
     Engine m_engine;
 
     /* ---- Model OpenCL data ---------------------------------------------- */
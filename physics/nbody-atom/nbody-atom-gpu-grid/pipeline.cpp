@@ -0,0 +1,200 @@
+/*
+ * pipeline.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include <vector>
+#include "atto/opencl/opencl.hpp"
+#include "pipeline.hpp"
+using namespace atto;
+
+/** ---------------------------------------------------------------------------
+ * Pipeline::setup
+ * @brief Setup the pipeline on the specified command queue.
+ */
+void Pipeline::setup(const cl_command_queue &queue)
+{
+    m_queue = queue;
+    m_frontier = NULL;
+
+    cl_command_queue_properties properties = 0;
+    cl_int err = clGetCommandQueueInfo(
+        m_queue,
+        CL_QUEUE_PROPERTIES,
+        sizeof(properties),
+        &properties,
+        NULL);
+    core_assert(err == CL_SUCCESS, "failed to query queue properties");
+    m_out_of_order = (properties & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE) != 0;
+}
+
+/**
+ * Pipeline::teardown
+ * @brief Wait for all enqueued commands, release the pipeline events and
+ * print the kernel profile.
+ */
+void Pipeline::teardown(void)
+{
+    finish();
+    m_profiler.flush();
+}
+
+/** ---------------------------------------------------------------------------
+ * Pipeline::enqueue
+ * @brief Enqueue a kernel over n_items work items after the specified events.
+ * On an in-order queue, the events are ignored and the returned event is NULL.
+ * The caller owns the returned event.
+ */
+cl_event Pipeline::enqueue(
+    const cl_kernel &kernel,
+    const size_t n_items,
+    const size_t work_group_size,
+    std::initializer_list<cl_event> wait_list)
+{
+    const size_t local_ws = work_group_size;
+    const size_t global_ws = cl::NDRange::Roundup(n_items, work_group_size);
+
+    if (!m_out_of_order) {
+        cl_int err = clEnqueueNDRangeKernel(
+            m_queue,
+            kernel,
+            1,
+            NULL,
+            &global_ws,
+            &local_ws,
+            0,
+            NULL,
+            m_profiler.event(kernel));
+        core_assert(err == CL_SUCCESS, "failed to enqueue kernel");
+        return NULL;
+    }
+
+    std::vector<cl_event> events;
+    for (auto &it : wait_list) {
+        if (it != NULL) {
+            events.push_back(it);
+        }
+    }
+
+    cl_event event = NULL;
+    cl_int err = clEnqueueNDRangeKernel(
+        m_queue,
+        kernel,
+        1,
+        NULL,
+        &global_ws,
+        &local_ws,
+        events.size(),
+        events.empty() ? NULL : events.data(),
+        &event);
+    core_assert(err == CL_SUCCESS, "failed to enqueue kernel");
+    m_profiler.record(kernel, event);
+    return event;
+}
+
+/**
+ * Pipeline::advance
+ * @brief Advance the frontier to the specified event, releasing the previous
+ * frontier. The pipeline owns the frontier event.
+ */
+void Pipeline::advance(cl_event event)
+{
+    if (m_frontier != NULL) {
+        clReleaseEvent(m_frontier);
+    }
+    m_frontier = event;
+}
+
+/**
+ * Pipeline::barrier
+ * @brief Enqueue a barrier on an out-of-order queue, so that commands not
+ * tracked by the pipeline, e.g. OpenGL object acquire and release, execute
+ * after all previous commands.
+ */
+void Pipeline::barrier(void)
+{
+    if (m_out_of_order) {
+        cl_int err = clEnqueueBarrierWithWaitList(m_queue, 0, NULL, NULL);
+        core_assert(err == CL_SUCCESS, "failed to enqueue barrier");
+    }
+}
+
+/**
+ * Pipeline::finish
+ * @brief Wait for all enqueued commands to complete and release the frontier.
+ * Blocking host transfers must follow a finish on an out-of-order queue.
+ */
+void Pipeline::finish(void)
+{
+    if (m_queue != NULL) {
+        clFinish(m_queue);
+    }
+    advance(NULL);
+    if (m_throttle != NULL) {
+        clReleaseEvent(m_throttle);
+        m_throttle = NULL;
+    }
+}
+
+/**
+ * Pipeline::throttle
+ * @brief Enqueue a marker after all previous commands and wait for the marker
+ * of the previous throttle. The device keeps the commands of one interval
+ * queued while the host enqueues the next, and a host timer measured across
+ * throttles tracks the device execution rate rather than the enqueue rate.
+ */
+void Pipeline::throttle(void)
+{
+    cl_event marker = NULL;
+    cl_int err = clEnqueueMarkerWithWaitList(m_queue, 0, NULL, &marker);
+    core_assert(err == CL_SUCCESS, "failed to enqueue marker");
+    clFlush(m_queue);
+
+    if (m_throttle != NULL) {
+        clWaitForEvents(1, &m_throttle);
+        clReleaseEvent(m_throttle);
+    }
+    m_throttle = marker;
+}
+
+/**
+ * Pipeline::release
+ * @brief Release the specified events. Events can be released as soon as
+ * the commands waiting on them are enqueued.
+ */
+void Pipeline::release(std::initializer_list<cl_event> events)
+{
+    for (auto &it : events) {
+        if (it != NULL) {
+            clReleaseEvent(it);
+        }
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * Pipeline::create_queue
+ * @brief Create a command queue on the specified device, with out-of-order
+ * execution enabled if the device supports it.
+ */
+cl_command_queue Pipeline::create_queue(
+    const cl_context &context,
+    const cl_device_id &device)
+{
+    cl_command_queue_properties supported = 0;
+    cl_int err = clGetDeviceInfo(
+        device,
+        CL_DEVICE_QUEUE_PROPERTIES,
+        sizeof(supported),
+        &supported,
+        NULL);
+    core_assert(err == CL_SUCCESS, "failed to query device queue properties");
+
+    return common::CreateQueue(
+        context, device, supported & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE);
+}
@@ -1,16 +1,9 @@
-
-/** @brief Return the first node containing the specified key. */
-uint grid_begin(
-    const uint key,
-    const uint capacity,
-    const __global Node_t *grid);
-
-/** @brief Return the next node containing the specified key. */
-uint grid_next(
-    uint node,
-    const uint key,
-    const uint capacity,
-    const __global Node_t *grid);
+/**
+ * @brief Radix sort parameters, sorting keys in passes of kRadixBits.
+ */
+#define kRadixBits 4
+#define kRadixBins (1 << kRadixBits)
+#define kRadixMask (kRadixBins - 1)
 
 /** @brief Return the coordinates of cell containing the specified position. */
 int4 grid_cell_coord(
@@ -18,122 +11,189 @@ int4 grid_cell_coord(
     const double4 length,
     const int4 n_cells);
 
-/** @brief Return the hash key of the cell coordinates. */
-uint grid_coord_hash(
-    const int4 cell,
-    const int4 n_cells,
-    const uint n_nodes);
+/** @brief Return the key of the cell coordinates. */
+uint grid_coord_key(const int4 cell, const int4 n_cells);
 
 /** Return the periodic image of the specified cell. */
 int4 grid_cell_pbc(const int4 cell, const int4 n_cells);
 
 /** ---------------------------------------------------------------------------
- * clear_grid
- * @brief Clear the grid map by setting their node keys to empty.
- */
-__kernel void clear_grid(const uint capacity, __global Node_t *grid)
-{
-    const uint node_ix = get_global_id(0);
-    if (node_ix < capacity) {
-        grid[node_ix].key = kEmpty;
-    }
-}
-
-/**
- * build_grid
- * @brief Build the grid map and store all the atoms in the grid node
- * locations keyed by the atom position.
+ * build_grid_keys
+ * @brief Compute the cell key of each atom, paired with the atom index.
  */
-__kernel void build_grid(
+__kernel void build_grid_keys(
     const uint n_atoms,
     const double4 length,
     const int4 n_cells,
-    const uint n_nodes,
-    const uint capacity,
-    __global Node_t *grid,
+    __global uint *keys,
+    __global uint *values,
     const __global Atom_t *atoms)
 {
-    /*
-     * Compute the coordinates of the cell containing the atom position
-     * and compute the corresponding hash function key in the grid map.
-     * Starting at the first node in the map corresponding to the key,
-     * search linearly for the first empty node and store the atom index.
-     */
     const uint atom_idx = get_global_id(0);
     if (atom_idx < n_atoms) {
         int4 cell = grid_cell_coord(atoms[atom_idx].pos, length, n_cells);
-        uint key = grid_coord_hash(cell, n_cells, n_nodes);
+        keys[atom_idx] = grid_coord_key(cell, n_cells);
+        values[atom_idx] = atom_idx;
+    }
+}
 
-        uint node = key % capacity;         // & (capacity - 1)
-        while (true) {
-            uint prev = atomic_cmpxchg(
-                (volatile __global uint *) (&grid[node].key),
-                kEmpty,
-                key);
+/**
+ * count_grid_keys
+ * @brief Count the keys of each work group in each radix bin, for the digit
+ * at the specified bit shift. The counts are stored in bin-major order, so an
+ * exclusive scan yields the scatter offset of each bin in each work group.
+ * Requires a work group size no smaller than the number of radix bins.
+ */
+__kernel void count_grid_keys(
+    const uint n_atoms,
+    const uint shift,
+    const __global uint *keys,
+    __global uint *counts,
+    __local uint *local_counts)
+{
+    const uint global_id = get_global_id(0);
+    const uint local_id = get_local_id(0);
+    const uint group_id = get_group_id(0);
+    const uint num_groups = get_num_groups(0);
 
-            if (prev == kEmpty) {
-                grid[node].atom = atom_idx;
-                return;
-            }
+    if (local_id < kRadixBins) {
+        local_counts[local_id] = 0;
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
 
-            node = (node + 1) % capacity;   // & (capacity - 1);
-        }
+    if (global_id < n_atoms) {
+        uint digit = (keys[global_id] >> shift) & kRadixMask;
+        atomic_inc(&local_counts[digit]);
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    if (local_id < kRadixBins) {
+        counts[local_id * num_groups + group_id] = local_counts[local_id];
     }
 }
 
-/** ---------------------------------------------------------------------------
- * grid_begin
- * @brief Return the index of the first node in the grid containing the
- * specified key. If no such key exists, then iteration function must
- * end in an empty node and returns empty.
+/**
+ * scan_grid_counts
+ * @brief Exclusive prefix sum of the bin counts, executed by a single work
+ * group. Each work item scans a contiguous chunk of the counts, offset by the
+ * scanned sums of the preceding chunks.
  */
-uint grid_begin(
-    const uint key,
-    const uint capacity,
-    const __global Node_t *grid)
+__kernel void scan_grid_counts(
+    const uint n_counts,
+    __global uint *counts,
+    __local uint *local_sums)
 {
-    if (key == kEmpty) {
-        return kEmpty;
-    }
+    const uint local_id = get_local_id(0);
+    const uint local_size = get_local_size(0);
+    const uint chunk = (n_counts + local_size - 1) / local_size;
+    const uint begin = min(local_id * chunk, n_counts);
+    const uint end = min(begin + chunk, n_counts);
 
-    /*
-     * Loop over the nodes until one with the specified key is found.
-     */
-    uint node = key % capacity;     // & (capacity - 1)
-    while (true) {
-        if (grid[node].key == key) {
-            return node;
-        }
+    /* Sum the chunk of the work item. */
+    uint sum = 0;
+    for (uint ix = begin; ix < end; ++ix) {
+        sum += counts[ix];
+    }
+    local_sums[local_id] = sum;
+    barrier(CLK_LOCAL_MEM_FENCE);
 
-        if (grid[node].key == kEmpty) {
-            return kEmpty;
+    /* Scan the chunk sums. */
+    if (local_id == 0) {
+        uint offset = 0;
+        for (uint ix = 0; ix < local_size; ++ix) {
+            uint value = local_sums[ix];
+            local_sums[ix] = offset;
+            offset += value;
         }
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
 
-        node = (node + 1) % capacity;   // & (capacity - 1)
+    /* Scan the chunk. */
+    uint offset = local_sums[local_id];
+    for (uint ix = begin; ix < end; ++ix) {
+        uint value = counts[ix];
+        counts[ix] = offset;
+        offset += value;
     }
 }
 
 /**
- * grid_next
- * @brief Return the index of next node in the map containing the specified key.
- * If no such key exists, then iteration function must end in an empty node and
- * returns empty.
+ * scatter_grid_keys
+ * @brief Scatter the key-value pairs to their sorted location for the digit
+ * at the specified bit shift. The rank of a key within its work group is the
+ * number of preceding keys with the same digit, keeping the sort stable.
  */
-uint grid_next(
-    uint node,
-    const uint key,
-    const uint capacity,
-    const __global Node_t *grid)
+__kernel void scatter_grid_keys(
+    const uint n_atoms,
+    const uint shift,
+    const __global uint *keys_in,
+    const __global uint *values_in,
+    const __global uint *counts,
+    __global uint *keys_out,
+    __global uint *values_out,
+    __local uint *local_digits)
 {
-    while (true) {
-        node = (node + 1) % capacity;   // & (capacity - 1)
+    const uint global_id = get_global_id(0);
+    const uint local_id = get_local_id(0);
+    const uint group_id = get_group_id(0);
+    const uint num_groups = get_num_groups(0);
 
-        if (grid[node].key == key) {
-            return node;
+    uint key = 0;
+    uint digit = kRadixBins;
+    if (global_id < n_atoms) {
+        key = keys_in[global_id];
+        digit = (key >> shift) & kRadixMask;
+    }
+    local_digits[local_id] = digit;
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    if (global_id < n_atoms) {
+        uint rank = 0;
+        for (uint ix = 0; ix < local_id; ++ix) {
+            rank += (local_digits[ix] == digit) ? 1 : 0;
         }
 
-        if (grid[node].key == kEmpty) {
-            return kEmpty;
+        uint dst = counts[digit * num_groups + group_id] + rank;
+        keys_out[dst] = key;
+        values_out[dst] = values_in[global_id];
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * clear_grid
+ * @brief Clear the grid cell ranges.
+ */
+__kernel void clear_grid(
+    const uint n_cells,
+    __global uint *cell_begin,
+    __global uint *cell_end)
+{
+    const uint cell_idx = get_global_id(0);
+    if (cell_idx < n_cells) {
+        cell_begin[cell_idx] = 0;
+        cell_end[cell_idx] = 0;
+    }
+}
+
+/**
+ * build_grid
+ * @brief Build the grid cell ranges [begin, end) in the sorted keys array,
+ * where the key differs from its predecessor or successor.
+ */
+__kernel void build_grid(
+    const uint n_atoms,
+    const __global uint *keys,
+    __global uint *cell_begin,
+    __global uint *cell_end)
+{
+    const uint idx = get_global_id(0);
+    if (idx < n_atoms) {
+        uint key = keys[idx];
+        if (idx == 0 || keys[idx - 1] != key) {
+            cell_begin[key] = idx;
+        }
+        if (idx == n_atoms - 1 || keys[idx + 1] != key) {
+            cell_end[key] = idx + 1;
         }
     }
 }
@@ -143,6 +203,7 @@ uint grid_next(
  * @brief Return the cell coordinates containing the specified position.
  * The position is assumed to be in the range of (-length/2, length/2):
  *      u_pos = 0.5 + (pos / length),   (0 <= u_pos <= 1)
+ * The coordinates are clamped to the grid range.
  */
 int4 grid_cell_coord(
     const double4 pos,
@@ -150,30 +211,22 @@ int4 grid_cell_coord(
     const int4 n_cells)
 {
     /* Get the position in normalized coordinates. */
-    double4 u_pos = double4(0.5) + (pos / length);
-    return int4(u_pos.x * n_cells.x,
-                u_pos.y * n_cells.y,
-                u_pos.z * n_cells.z,
-                0 /*unused*/);
+    double4 u_pos = (double4) (0.5) + (pos / length);
+    int4 cell = (int4) ((int) (u_pos.x * n_cells.x),
+                        (int) (u_pos.y * n_cells.y),
+                        (int) (u_pos.z * n_cells.z),
+                        0 /*unused*/);
+    return clamp(cell, (int4) (0), n_cells - (int4) (1));
 }
 
 /**
- * grid_coord_hash
- * @brief Compute the hash key of the cell coordinates. If the cell coordinates
- * are outside the map, return empty.
+ * grid_coord_key
+ * @brief Return the key of the cell coordinates, given by the cell index in
+ * row-major order.
  */
-uint grid_coord_hash(
-    const int4 cell,
-    const int4 n_cells,
-    const uint n_nodes)
+uint grid_coord_key(const int4 cell, const int4 n_cells)
 {
-    if (cell.x < 0 || cell.x >= n_cells.x ||
-        cell.y < 0 || cell.y >= n_cells.y ||
-        cell.z < 0 || cell.z >= n_cells.z ) {
-        return kEmpty;
-    }
-
-    return n_nodes * (cell.x*n_cells.y*n_cells.z + cell.y*n_cells.z + cell.z);
+    return (cell.x * n_cells.y + cell.y) * n_cells.z + cell.z;
 }
 
 /**
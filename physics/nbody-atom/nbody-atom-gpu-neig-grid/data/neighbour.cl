@@ -1,10 +1,16 @@
 /** ---------------------------------------------------------------------------
  * clear_nlist
- * @brief Clear the neighbour list.
+ * @brief Clear the neighbour list and its staleness flag.
  */
-__kernel void clear_nlist(const uint capacity, __global uint *list)
+__kernel void clear_nlist(
+    const uint capacity,
+    __global uint *list,
+    __global uint *list_stale)
 {
     const uint neig_idx = get_global_id(0);
+    if (neig_idx == 0) {
+        *list_stale = 0;
+    }
     if (neig_idx < capacity) {
         list[neig_idx] = kEmpty;
     }
@@ -12,7 +18,8 @@ __kernel void clear_nlist(const uint capacity, __global uint *list)
 
 /** ---------------------------------------------------------------------------
  * build_nlist
- * @brief Build the neighbour list using a grid map spatial data structure.
+ * @brief Build the neighbour list using a sorted cell list. The atoms of
+ * each cell are given by the range of the sorted atom indices in the cell.
  */
 __kernel void build_nlist(
     const uint n_atoms,
@@ -21,14 +28,18 @@ __kernel void build_nlist(
     __global uint *list,
     const double4 length,
     const int4 n_cells,
-    const uint n_nodes,
-    const uint capacity,
-    const __global Node_t *grid,
+    const __global uint *values,
+    const __global uint *cell_begin,
+    const __global uint *cell_end,
     const __global Atom_t *atoms,
-    const __global Domain_t *domain)
+    const __global Domain_t *domain,
+    __global double4 *list_pos)
 {
     const uint idx_1 = get_global_id(0);
     if (idx_1 < n_atoms) {
+        /* Cache the atom position at the list update. */
+        list_pos[idx_1] = atoms[idx_1].upos;
+
         double radius_sq = radius * radius;
 
         Atom_t atom_1 = atoms[idx_1];
@@ -44,12 +55,10 @@ __kernel void build_nlist(
                 for (int iz = base.z - 1; iz <= base.z + 1; ++iz) {
 
                     int4 cell = grid_cell_pbc((int4) (ix, iy, iz, 0), n_cells);
-                    uint key = grid_coord_hash(cell, n_cells, n_nodes);
-                    uint node = grid_begin(key, capacity, grid);
+                    uint key = grid_coord_key(cell, n_cells);
 
-                    while (node != kEmpty) {
-                        uint idx_2 = grid[node].atom;
-                        node = grid_next(node, key, capacity, grid);
+                    for (uint node = cell_begin[key]; node < cell_end[key]; ++node) {
+                        uint idx_2 = values[node];
 
                         if (idx_1 == idx_2) {
                             continue;
@@ -69,3 +78,44 @@ __kernel void build_nlist(
         }
     }
 }
+
+/** ---------------------------------------------------------------------------
+ * check_nlist
+ * @brief Check the neighbour list staleness. Each work group reduces the
+ * largest atom displacement since the last list update, extrapolated over the
+ * next time step, and flags the list as stale if it exceeds half the skin.
+ */
+__kernel void check_nlist(
+    const double t_step,
+    const uint n_atoms,
+    const double skin,
+    const __global double4 *list_pos,
+    const __global Atom_t *atoms,
+    __global uint *list_stale,
+    __local double *local_disp)
+{
+    const uint global_id = get_global_id(0);
+    const uint local_size = get_local_size(0);
+    const uint local_id = get_local_id(0);
+
+    /* Setup the local atom displacement, bounded over the next time step. */
+    local_disp[local_id] = 0.0;
+    if (global_id < n_atoms) {
+        double4 r_disp = atoms[global_id].upos - list_pos[global_id];
+        double4 vel = atoms[global_id].mom * atoms[global_id].rmass;
+        local_disp[local_id] = length(r_disp) + 2.0 * t_step * length(vel);
+    }
+
+    /* Reduce the maximum using a divide and conquer algorithm. */
+    for (uint stride = local_size >> 1; stride > 0; stride >>= 1) {
+        barrier(CLK_LOCAL_MEM_FENCE);
+        if (local_id < stride) {
+            local_disp[local_id] = fmax(
+                local_disp[local_id], local_disp[local_id + stride]);
+        }
+    }
+
+    if (local_id == 0 && 2.0 * local_disp[0] > skin) {
+        atomic_or(list_stale, 1);
+    }
+}
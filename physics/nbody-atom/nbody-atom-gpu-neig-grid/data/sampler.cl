@@ -0,0 +1,240 @@
+/**
+ * @brief Sampler partial sums of each atom, reduced over all atoms:
+ *  mass, mass * pos, mass * upos, mom, force,
+ *  mom^2 / mass, degrees of freedom, energy,
+ *  mom (x) mom / mass and virial.
+ */
+#define kSampleMass     0
+#define kSamplePos      1
+#define kSampleUpos     4
+#define kSampleMom      7
+#define kSampleForce    10
+#define kSampleGradSq   13
+#define kSampleLaplace  14
+#define kSampleEnergy   15
+#define kSampleKinetic  16
+#define kSampleVirial   25
+#define kSampleItems    34
+
+/** ---------------------------------------------------------------------------
+ * @brief Sum the partial sums of a work group, stored in item-major order.
+ */
+void sampler_local_sum(
+    __local double *local_sums,
+    const uint local_id,
+    const uint local_size);
+
+/** ---------------------------------------------------------------------------
+ * sampler_reduce
+ * @brief First reduction stage. Each work item accumulates the partial sums
+ * of a strided range of atoms, and each work group sums its work items.
+ */
+__kernel void sampler_reduce(
+    const uint n_atoms,
+    const __global Atom_t *atoms,
+    __global double *group_sums,
+    __local double *local_sums)
+{
+    const uint global_id = get_global_id(0);
+    const uint global_size = get_global_size(0);
+    const uint local_id = get_local_id(0);
+    const uint local_size = get_local_size(0);
+    const uint group_id = get_group_id(0);
+
+    /* Accumulate the partial sums of the work item. */
+    double sums[kSampleItems];
+    for (uint k = 0; k < kSampleItems; ++k) {
+        sums[k] = 0.0;
+    }
+
+    for (uint ix = global_id; ix < n_atoms; ix += global_size) {
+        const double mass = atoms[ix].mass;
+        const double rmass = atoms[ix].rmass;
+        const double4 pos = atoms[ix].pos;
+        const double4 upos = atoms[ix].upos;
+        const double4 mom = atoms[ix].mom;
+        const double4 force = atoms[ix].force;
+        const double16 virial = atoms[ix].virial;
+
+        sums[kSampleMass] += mass;
+
+        sums[kSamplePos + 0] += mass * pos.x;
+        sums[kSamplePos + 1] += mass * pos.y;
+        sums[kSamplePos + 2] += mass * pos.z;
+
+        sums[kSampleUpos + 0] += mass * upos.x;
+        sums[kSampleUpos + 1] += mass * upos.y;
+        sums[kSampleUpos + 2] += mass * upos.z;
+
+        sums[kSampleMom + 0] += mom.x;
+        sums[kSampleMom + 1] += mom.y;
+        sums[kSampleMom + 2] += mom.z;
+
+        sums[kSampleForce + 0] += force.x;
+        sums[kSampleForce + 1] += force.y;
+        sums[kSampleForce + 2] += force.z;
+
+        sums[kSampleGradSq] += dot(mom, mom) * rmass;
+        sums[kSampleLaplace] += 3.0;
+        sums[kSampleEnergy] += atoms[ix].energy;
+
+        sums[kSampleKinetic + 0] += mom.x * mom.x * rmass;
+        sums[kSampleKinetic + 1] += mom.x * mom.y * rmass;
+        sums[kSampleKinetic + 2] += mom.x * mom.z * rmass;
+        sums[kSampleKinetic + 3] += mom.y * mom.x * rmass;
+        sums[kSampleKinetic + 4] += mom.y * mom.y * rmass;
+        sums[kSampleKinetic + 5] += mom.y * mom.z * rmass;
+        sums[kSampleKinetic + 6] += mom.z * mom.x * rmass;
+        sums[kSampleKinetic + 7] += mom.z * mom.y * rmass;
+        sums[kSampleKinetic + 8] += mom.z * mom.z * rmass;
+
+        sums[kSampleVirial + 0] += virial.s0;
+        sums[kSampleVirial + 1] += virial.s1;
+        sums[kSampleVirial + 2] += virial.s2;
+        sums[kSampleVirial + 3] += virial.s3;
+        sums[kSampleVirial + 4] += virial.s4;
+        sums[kSampleVirial + 5] += virial.s5;
+        sums[kSampleVirial + 6] += virial.s6;
+        sums[kSampleVirial + 7] += virial.s7;
+        sums[kSampleVirial + 8] += virial.s8;
+    }
+
+    /* Sum the partial sums of the work group. */
+    for (uint k = 0; k < kSampleItems; ++k) {
+        local_sums[k * local_size + local_id] = sums[k];
+    }
+    sampler_local_sum(local_sums, local_id, local_size);
+
+    for (uint k = local_id; k < kSampleItems; k += local_size) {
+        group_sums[group_id * kSampleItems + k] = local_sums[k * local_size];
+    }
+}
+
+/**
+ * sampler_thermo
+ * @brief Second reduction stage, executed by a single work group. Sum the
+ * partial sums of all work groups and compute the thermodynamic properties.
+ */
+__kernel void sampler_thermo(
+    const uint n_atoms,
+    const uint n_groups,
+    const __global double *group_sums,
+    const __global Domain_t *domain,
+    __global Thermo_t *thermo,
+    __local double *local_sums)
+{
+    const uint local_id = get_local_id(0);
+    const uint local_size = get_local_size(0);
+
+    /* Sum the partial sums of all work groups. */
+    for (uint k = 0; k < kSampleItems; ++k) {
+        double sum = 0.0;
+        for (uint group = local_id; group < n_groups; group += local_size) {
+            sum += group_sums[group * kSampleItems + k];
+        }
+        local_sums[k * local_size + local_id] = sum;
+    }
+    sampler_local_sum(local_sums, local_id, local_size);
+
+    if (local_id == 0) {
+        double sums[kSampleItems];
+        for (uint k = 0; k < kSampleItems; ++k) {
+            sums[k] = local_sums[k * local_size];
+        }
+
+        const double volume = domain->length.x *
+                              domain->length.y *
+                              domain->length.z;
+
+        /* Fluid CoM properties. */
+        const double mass = sums[kSampleMass];
+        const double4 mom = (double4) (
+            sums[kSampleMom + 0],
+            sums[kSampleMom + 1],
+            sums[kSampleMom + 2],
+            0.0);
+
+        thermo->com_mass = mass;
+        thermo->com_pos = (double4) (
+            sums[kSamplePos + 0],
+            sums[kSamplePos + 1],
+            sums[kSamplePos + 2],
+            0.0) / mass;
+        thermo->com_upos = (double4) (
+            sums[kSampleUpos + 0],
+            sums[kSampleUpos + 1],
+            sums[kSampleUpos + 2],
+            0.0) / mass;
+        thermo->com_vel = mom / mass;
+        thermo->com_mom = mom;
+        thermo->com_force = (double4) (
+            sums[kSampleForce + 0],
+            sums[kSampleForce + 1],
+            sums[kSampleForce + 2],
+            0.0);
+
+        /* Fluid density and energy. */
+        thermo->density = mass / volume;
+        thermo->energy_kin = 0.5 * sums[kSampleGradSq];
+        thermo->energy_pot = sums[kSampleEnergy];
+
+        /*
+         * Fluid temperature. If fluid size is more than one atom, remove
+         * the CoM momentum contribution to the total kinetic energy and
+         * account for the correct number of degrees of freedom.
+         */
+        double grad_sq = sums[kSampleGradSq];
+        double laplace = sums[kSampleLaplace];
+        if (n_atoms > 1) {
+            grad_sq -= dot(mom, mom) / mass;
+            laplace -= 3.0;
+        }
+        thermo->temp_grad_sq = grad_sq;
+        thermo->temp_laplace = laplace;
+        thermo->temp_kinetic = laplace > 0.0 ? grad_sq / laplace : 0.0;
+
+        /*
+         * Fluid kinetic pressure relative to the CoM velocity,
+         *  sum_i m_i (v_i - V) (x) (v_i - V) = sum_i p_i (x) p_i / m_i - P (x) P / M,
+         * and virial pressure.
+         */
+        double p[3] = {mom.x, mom.y, mom.z};
+        double pres_kinetic[16];
+        double pres_virial[16];
+        for (uint k = 0; k < 16; ++k) {
+            pres_kinetic[k] = 0.0;
+            pres_virial[k] = 0.0;
+        }
+        for (uint i = 0; i < 3; ++i) {
+            for (uint j = 0; j < 3; ++j) {
+                uint k = i * 3 + j;
+                pres_kinetic[k] = (sums[kSampleKinetic + k] - p[i] * p[j] / mass) / volume;
+                pres_virial[k] = sums[kSampleVirial + k] / volume;
+            }
+        }
+        thermo->pres_kinetic = vload16(0, pres_kinetic);
+        thermo->pres_virial = vload16(0, pres_virial);
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * sampler_local_sum
+ * @brief Sum the partial sums of a work group using a divide and conquer
+ * algorithm. The sum of each item k is stored in local_sums[k * local_size].
+ */
+void sampler_local_sum(
+    __local double *local_sums,
+    const uint local_id,
+    const uint local_size)
+{
+    for (uint stride = local_size >> 1; stride > 0; stride >>= 1) {
+        barrier(CLK_LOCAL_MEM_FENCE);
+        if (local_id < stride) {
+            for (uint k = 0; k < kSampleItems; ++k) {
+                local_sums[k * local_size + local_id] +=
+                    local_sums[k * local_size + local_id + stride];
+            }
+        }
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+}
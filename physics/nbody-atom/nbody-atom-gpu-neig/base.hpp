@@ -21,6 +21,8 @@ namespace Params {
 /* Integration parameters */
 static const cl_ulong n_steps = 1000;          /* number of run steps */
 static const cl_double t_step = 0.005;          /* timestep size */
+static const cl_ulong sample_frequency = 10;    /* sample frequency */
+static const cl_ulong sample_block_size = 10;   /* sampler block size */
 
 /* Fluid parameters */
 static const cl_double density = 0.8;           /* fluid density */
@@ -37,9 +39,15 @@ static const cl_double pair_r_hard = 0.01;      /* hard sphere radius */
 /* Thermostat parameters */
 static const cl_double thermostat_mass = 10.0;  /* thermostat inertial mass */
 
+/* Species parameters, in units of atom_mass, pair_epsilon and pair_sigma. */
+static const cl_ulong n_types = 1;              /* number of atom types */
+static const cl_double type_fraction[] = {1.0}; /* type number fraction */
+static const cl_double type_mass[] = {1.0};     /* type mass */
+static const cl_double type_epsilon[] = {1.0};  /* type LJ energy */
+static const cl_double type_sigma[] = {1.0};    /* type LJ size */
+
 /* Neighbour list parameters */
 static const cl_uint list_empty = 0xffffffff;
-static const cl_uint list_freq = 10;            /* list update frequency */
 static const cl_uint list_scale = 2;            /* scale factor >= 1 */
 static const cl_double list_radius = 3.0;       /* neighbour range radius */
 
@@ -55,6 +63,9 @@ static const cl_ulong work_group_size = 256;    /* local workgroup size */
 static const cl_ulong num_work_items = atto::cl::NDRange::Roundup(
     n_atoms, work_group_size);
 static const cl_ulong num_work_groups = num_work_items / work_group_size;
+static const cl_ulong sampler_items = 34;       /* sampler partial sums */
+static const cl_ulong sampler_work_group_size = 64; /* sampler workgroup size */
+static const cl_ulong sampler_num_work_groups = 64; /* sampler workgroups */
 }
 
 /**
@@ -66,12 +77,25 @@ struct Domain {
 };
 
 /**
- * @brief Field represents the Lennard-Jones force field.
+ * @brief FieldPair holds the Lennard-Jones coefficients of an atom type pair.
  */
-struct Field {
+struct FieldPair {
     cl_double epsilon;          /* LJ pair energy */
     cl_double sigma;            /* LJ pair size */
     cl_double r_cut;            /* LJ cutoff radius */
+    cl_double r_cut_sq;         /* LJ cutoff radius squared */
+};
+
+/**
+ * @brief Field represents the Lennard-Jones force field of a fluid mixture.
+ * The coefficients of each type pair (i,j) are stored in a small row-major
+ * table at index k = i*max_types + j.
+ */
+struct Field {
+    static const cl_ulong max_types = 4;
+    FieldPair pairs[max_types * max_types]; /* type pair coefficients */
+    cl_ulong n_types;           /* number of atom types */
+    cl_double r_cut;            /* Largest LJ cutoff radius */
     cl_double r_hard;           /* LJ hard sphere radius */
 };
 
@@ -81,6 +105,7 @@ struct Field {
 struct Atom {
     cl_double mass;             /* atom mass */
     cl_double rmass;            /* inverse mass */
+    cl_uint type;               /* atom type */
     cl_double4 pos;             /* periodic image in primary cell */
     cl_double4 upos;            /* unfolded position */
     cl_double4 mom;             /* momentum */
@@ -99,6 +124,26 @@ struct Thermostat {
     cl_double temperature;      /* temperature */
 };
 
+/**
+ * @brief Thermo holds a collection of thermodynamic properties.
+ */
+struct Thermo {
+    cl_double com_mass;             /* Total mass of the fluid */
+    cl_double4 com_pos;             /* CoM position of the fluid */
+    cl_double4 com_upos;            /* CoM unfolded position of the fluid */
+    cl_double4 com_vel;             /* CoM velocity of the fluid */
+    cl_double4 com_mom;             /* Total momentum of the fluid */
+    cl_double4 com_force;           /* Total force  of the fluid */
+    cl_double density;              /* Mass density */
+    cl_double energy_kin;           /* Kinetic energy */
+    cl_double energy_pot;           /* Potential energy */
+    cl_double temp_grad_sq;         /* Kinetic energy square gradient */
+    cl_double temp_laplace;         /* Kinetic energy laplacian */
+    cl_double temp_kinetic;         /* Kinetic temperature */
+    cl_double16 pres_kinetic;       /* Kinetic pressure */
+    cl_double16 pres_virial;        /* Virial pressure */
+};
+
 /**
  * @brief Neighbour list parameters.
  */
@@ -107,7 +152,7 @@ struct List {
     cl_double skin;             /* list neighbour skin length */
     cl_uint n_neighbours;       /* neighbours per atom */
     cl_uint capacity;           /* total number of neighbour edges */
-    cl_uint is_stale;
+    cl_uint is_stale;           /* list staleness flag */
 };
 
 /**
@@ -1,6 +1,9 @@
 
 /** @brief Compute pair interaction. */
-Pair_t force_pair(const double4 r_12, const __global Field_t *field);
+Pair_t force_pair(
+    const double4 r_12,
+    const FieldPair_t coeff,
+    const double r_hard);
 
 /** @brief Return the periodic image in primary cell of the fluid domain. */
 double4 compute_pbc(const double4 pos, const __global Domain_t *domain);
@@ -78,14 +81,15 @@ __kernel void compute_forces(
     __global Atom_t *atoms,
     const __global uint *list,
     const __global Domain_t *domain,
-    const __global Field_t *field)
+    __constant Field_t *field)
 {
     /*
      * Loop over the atom neighbours and compute the pair interaction.
      */
     const uint idx_1 = get_global_id(0);
     if (idx_1 < n_atoms) {
-        const double r_cut_sq = field->r_cut * field->r_cut;
+        /* Type pair coefficients of the atom, held in constant memory. */
+        __constant FieldPair_t *coeff = &field->pairs[atoms[idx_1].type * kMaxTypes];
 
         double4 force = (double4) (0.0);
         double energy = 0.0;
@@ -101,8 +105,9 @@ __kernel void compute_forces(
             double4 r_12 = atoms[idx_1].pos - atoms[idx_2].pos;
             r_12 = compute_pbc(r_12, domain);
 
-            if (dot(r_12, r_12) < r_cut_sq) {
-                Pair_t pair = force_pair(r_12, field);
+            const FieldPair_t coeff_12 = coeff[atoms[idx_2].type];
+            if (dot(r_12, r_12) < coeff_12.r_cut_sq) {
+                Pair_t pair = force_pair(r_12, coeff_12, field->r_hard);
                 force  -= pair.gradient;
                 energy += 0.5 * pair.energy;
                 virial += 0.5 * pair.virial;
@@ -140,9 +145,12 @@ __kernel void copy_atom_points(
 
 /** ---------------------------------------------------------------------------
  * force_pair
- * @brief Compute pair interaction.
+ * @brief Compute pair interaction using the coefficients of the atom type pair.
  */
-Pair_t force_pair(const double4 r_12, const __global Field_t *field)
+Pair_t force_pair(
+    const double4 r_12,
+    const FieldPair_t coeff,
+    const double r_hard)
 {
     /* Compute pair attributes - energy, gradient, laplacian and virial. */
     Pair_t pair;
@@ -153,12 +161,12 @@ Pair_t force_pair(const double4 r_12, const __global Field_t *field)
     pair.virial = (double16) (0.0);
 
     /* Interaction coefficients. */
-    const double sigma_sq = field->sigma * field->sigma;
-    const double r_hard_sq = field->r_hard * field->r_hard;
+    const double sigma_sq = coeff.sigma * coeff.sigma;
+    const double r_hard_sq = r_hard * r_hard;
 
     /* Define pair energy and force coefficients. */
-    double energy_coeff = 4.0 * field->epsilon;
-    double force_coeff = 24.0 * field->epsilon / sigma_sq;
+    double energy_coeff = 4.0 * coeff.epsilon;
+    double force_coeff = 24.0 * coeff.epsilon / sigma_sq;
 
     /* Ensure pair distance is larger than the hard sphere radius. */
     double energy_hard_sphere = 0.0;
@@ -172,8 +180,8 @@ Pair_t force_pair(const double4 r_12, const __global Field_t *field)
         double r_hard6  = r_hard4 * r_hard2;
         double r_hard12 = r_hard6 * r_hard6;
 
-        energy_hard_sphere = -24.0*field->epsilon * (2.0*r_hard12 - r_hard6);
-        energy_hard_sphere *= (r_12_len - field->r_hard) / r_12_len;
+        energy_hard_sphere = -24.0*coeff.epsilon * (2.0*r_hard12 - r_hard6);
+        energy_hard_sphere *= (r_12_len - r_hard) / r_12_len;
 
         /* Set the pair distance to the hard sphere radius. */
         r_12_sq = r_hard_sq;
@@ -5,6 +5,7 @@
 #endif
 
 #define kEmpty  0xffffffff
+#define kMaxTypes 4
 
 /**
  * @brief Domain data type.
@@ -20,6 +21,7 @@ typedef struct {
 typedef struct {
     double mass;            /* atom mass */
     double rmass;           /* inverse mass */
+    uint type;              /* atom type */
     double4 pos;            /* periodic image in primary cell */
     double4 upos;           /* unfolded position */
     double4 mom;            /* momentum */
@@ -29,12 +31,22 @@ typedef struct {
 } Atom_t;
 
 /**
- * @brief Field data type.
+ * @brief Field type pair data type.
  */
 typedef struct {
     double epsilon;         /* LJ pair energy */
     double sigma;           /* LJ pair size */
     double r_cut;           /* LJ cutoff radius */
+    double r_cut_sq;        /* LJ cutoff radius squared */
+} FieldPair_t;
+
+/**
+ * @brief Field data type.
+ */
+typedef struct {
+    FieldPair_t pairs[kMaxTypes * kMaxTypes]; /* type pair coefficients */
+    ulong n_types;          /* number of atom types */
+    double r_cut;           /* Largest LJ cutoff radius */
     double r_hard;          /* LJ hard sphere radius */
 } Field_t;
 
@@ -58,3 +70,23 @@ typedef struct {
     double deta_dt;         /* acceleration */
     double temperature;     /* temperature */
 } Thermostat_t;
+
+/**
+ * @brief Thermo data type.
+ */
+typedef struct {
+    double com_mass;        /* Total mass of the fluid */
+    double4 com_pos;        /* CoM position of the fluid */
+    double4 com_upos;       /* CoM unfolded position of the fluid */
+    double4 com_vel;        /* CoM velocity of the fluid */
+    double4 com_mom;        /* Total momentum of the fluid */
+    double4 com_force;      /* Total force  of the fluid */
+    double density;         /* Mass density */
+    double energy_kin;      /* Kinetic energy */
+    double energy_pot;      /* Potential energy */
+    double temp_grad_sq;    /* Kinetic energy square gradient */
+    double temp_laplace;    /* Kinetic energy laplacian */
+    double temp_kinetic;    /* Kinetic temperature */
+    double16 pres_kinetic;  /* Kinetic pressure */
+    double16 pres_virial;   /* Virial pressure */
+} Thermo_t;
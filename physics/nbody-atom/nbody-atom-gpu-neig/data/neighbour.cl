@@ -1,10 +1,16 @@
 /** ---------------------------------------------------------------------------
  * clear_nlist
- * @brief Clear the neighbour list.
+ * @brief Clear the neighbour list and its staleness flag.
  */
-__kernel void clear_nlist(const uint capacity, __global uint *list)
+__kernel void clear_nlist(
+    const uint capacity,
+    __global uint *list,
+    __global uint *list_stale)
 {
     const uint neig_idx = get_global_id(0);
+    if (neig_idx == 0) {
+        *list_stale = 0;
+    }
     if (neig_idx < capacity) {
         list[neig_idx] = kEmpty;
     }
@@ -20,7 +26,8 @@ __kernel void build_nlist(
     const double radius,
     __global uint *list,
     const __global Atom_t *atoms,
-    const __global Domain_t *domain)
+    const __global Domain_t *domain,
+    __global double4 *list_pos)
 {
     /*
      * Loop over all atoms and add the indices of those whose distance
@@ -28,6 +35,9 @@ __kernel void build_nlist(
      */
     const uint idx_1 = get_global_id(0);
     if (idx_1 < n_atoms) {
+        /* Cache the atom position at the list update. */
+        list_pos[idx_1] = atoms[idx_1].upos;
+
         double radius_sq = radius * radius;
 
         const uint begin_idx = idx_1 * n_neighbours;
@@ -49,3 +59,44 @@ __kernel void build_nlist(
         }
     }
 }
+
+/** ---------------------------------------------------------------------------
+ * check_nlist
+ * @brief Check the neighbour list staleness. Each work group reduces the
+ * largest atom displacement since the last list update, extrapolated over the
+ * next time step, and flags the list as stale if it exceeds half the skin.
+ */
+__kernel void check_nlist(
+    const double t_step,
+    const uint n_atoms,
+    const double skin,
+    const __global double4 *list_pos,
+    const __global Atom_t *atoms,
+    __global uint *list_stale,
+    __local double *local_disp)
+{
+    const uint global_id = get_global_id(0);
+    const uint local_size = get_local_size(0);
+    const uint local_id = get_local_id(0);
+
+    /* Setup the local atom displacement, bounded over the next time step. */
+    local_disp[local_id] = 0.0;
+    if (global_id < n_atoms) {
+        double4 r_disp = atoms[global_id].upos - list_pos[global_id];
+        double4 vel = atoms[global_id].mom * atoms[global_id].rmass;
+        local_disp[local_id] = length(r_disp) + 2.0 * t_step * length(vel);
+    }
+
+    /* Reduce the maximum using a divide and conquer algorithm. */
+    for (uint stride = local_size >> 1; stride > 0; stride >>= 1) {
+        barrier(CLK_LOCAL_MEM_FENCE);
+        if (local_id < stride) {
+            local_disp[local_id] = fmax(
+                local_disp[local_id], local_disp[local_id + stride]);
+        }
+    }
+
+    if (local_id == 0 && 2.0 * local_disp[0] > skin) {
+        atomic_or(list_stale, 1);
+    }
+}
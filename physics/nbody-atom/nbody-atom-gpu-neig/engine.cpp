@@ -11,6 +11,7 @@
 
 #include "atto/opencl/opencl.hpp"
 #include "engine.hpp"
+#include "program.hpp"
 using namespace atto;
 
 /** ---------------------------------------------------------------------------
@@ -29,6 +30,7 @@ void Engine::setup(
     {
         /* Reset integration step. */
         m_step = 0;
+        m_list_updates = 0;
     }
 
     {
@@ -44,13 +46,28 @@ void Engine::setup(
     }
 
     {
-        /* Create fluid field */
-        m_field = Field{
-            .epsilon = Params::pair_epsilon,
-            .sigma = Params::pair_sigma,
-            .r_cut = Params::pair_r_cut,
-            .r_hard = Params::pair_r_hard
-        };
+        /*
+         * Create fluid force field. Mix the coefficients of each type pair
+         * using Lorentz-Berthelot rules, with a cutoff radius scaled by the
+         * pair size.
+         */
+        m_field = Field{};
+        m_field.n_types = Params::n_types;
+        m_field.r_cut = 0.0;
+        m_field.r_hard = Params::pair_r_hard * Params::pair_sigma;
+        for (cl_ulong type_1 = 0; type_1 < Params::n_types; ++type_1) {
+            for (cl_ulong type_2 = 0; type_2 < Params::n_types; ++type_2) {
+                cl_double epsilon = Params::pair_epsilon * std::sqrt(
+                    Params::type_epsilon[type_1] * Params::type_epsilon[type_2]);
+                cl_double sigma = Params::pair_sigma * 0.5 * (
+                    Params::type_sigma[type_1] + Params::type_sigma[type_2]);
+                cl_double r_cut = Params::pair_r_cut * sigma;
+
+                m_field.pairs[type_1 * Field::max_types + type_2] = FieldPair{
+                    epsilon, sigma, r_cut, r_cut * r_cut};
+                m_field.r_cut = std::max(m_field.r_cut, r_cut);
+            }
+        }
     }
 
     {
@@ -69,6 +86,7 @@ void Engine::setup(
         Atom atom = Atom{
             .mass = Params::atom_mass,
             .rmass = 1.0 / Params::atom_mass,
+            .type = 0,
             .pos = cl_double4{},
             .upos = cl_double4{},
             .mom = cl_double4{},
@@ -78,6 +96,27 @@ void Engine::setup(
         };
         m_atoms.resize(Params::n_atoms, atom);
 
+        /*
+         * Assign the atom types in contiguous blocks with the specified number
+         * fractions. Atoms are kept sorted by type, so the force kernel reads
+         * the same row of the type pair table along each block.
+         */
+        core_assert(Params::n_types <= Field::max_types, "invalid number of types");
+        cl_ulong atom_ix = 0;
+        for (cl_uint type = 0; type < Params::n_types; ++type) {
+            cl_ulong count = (cl_ulong) (Params::type_fraction[type] * Params::n_atoms);
+            if (type + 1 == Params::n_types) {
+                count = Params::n_atoms - atom_ix;
+            }
+
+            cl_double mass = Params::atom_mass * Params::type_mass[type];
+            for (cl_ulong end = atom_ix + count; atom_ix < end; ++atom_ix) {
+                m_atoms[atom_ix].mass = mass;
+                m_atoms[atom_ix].rmass = 1.0 / mass;
+                m_atoms[atom_ix].type = type;
+            }
+        }
+
         /* Generate atom positions at the specified density. */
         const cl_double epsilon = 0.9;  /* <= 1.0 */
         const cl_double4 half = m_domain.length_half * epsilon;
@@ -90,6 +129,15 @@ void Engine::setup(
              half.s[1],
              half.s[2]);
 
+        /* Shuffle the lattice sites to mix the atom type blocks. */
+        if (Params::n_types > 1) {
+            math::rng::Kiss engine(true);           /* rng engine */
+            math::rng::uniform<uint64_t> rand;      /* rng sampler */
+            for (size_t i = positions.size() - 1; i > 0; --i) {
+                std::swap(positions[i], positions[rand(engine, 0, i + 1)]);
+            }
+        }
+
         cl_uint idx = 0;
         for (auto &atom : m_atoms) {
             atom.pos = positions[idx];
@@ -126,7 +174,7 @@ void Engine::setup(
     {
         /* Setup neighbour list parameters. */
         cl_double radius = Params::list_radius;
-        cl_double skin = Params::list_radius - Params::pair_r_cut;
+        cl_double skin = Params::list_radius - m_field.r_cut;
         cl_double volume = 4.0 * M_PI * radius * radius * radius / 3.0;
 
         cl_uint n_neighbours = (cl_uint) (Params::density * volume);
@@ -138,6 +186,7 @@ void Engine::setup(
             .skin = skin,
             .n_neighbours = n_neighbours,
             .capacity = capacity,
+            .is_stale = 1,
         };
         std::cout << "m_list.radius " << m_list.radius << "\n"
                   << "m_list.skin " << m_list.skin << "\n"
@@ -149,13 +198,13 @@ void Engine::setup(
         /* Setup grid map parameters. */
         cl_double4 length = m_domain.length;
         cl_uint4 n_cells = cl_uint4{
-            (cl_uint) (length.s[0] / Params::pair_r_cut),
-            (cl_uint) (length.s[1] / Params::pair_r_cut),
-            (cl_uint) (length.s[2] / Params::pair_r_cut),
+            (cl_uint) (length.s[0] / m_field.r_cut),
+            (cl_uint) (length.s[1] / m_field.r_cut),
+            (cl_uint) (length.s[2] / m_field.r_cut),
             0 /* unused */
         };
 
-        cl_double cell_length = Params::pair_r_cut;
+        cl_double cell_length = m_field.r_cut;
         cl_double cell_volume = cell_length * cell_length * cell_length;
         cl_uint n_nodes = (cl_uint) (Params::density * cell_volume);
         n_nodes *= Params::list_scale;
@@ -187,6 +236,7 @@ void Engine::setup(
         m_context = context;
         m_device = device;
         m_queue = queue;
+        m_pipeline.setup(m_queue);
 
         /* Create engine program object. */
         std::string source;
@@ -194,10 +244,10 @@ void Engine::setup(
         source.append(cl::Program::load_source_from_file("data/atom.cl"));
         source.append(cl::Program::load_source_from_file("data/neighbour.cl"));
         source.append(cl::Program::load_source_from_file("data/thermostat.cl"));
+        source.append(cl::Program::load_source_from_file("data/sampler.cl"));
 
-        m_program = cl::Program::create_from_source(m_context, source);
-        cl::Program::build(m_program, m_device, "");
-        // std::cout << cl::Program::get_source(m_program) << "\n";
+        m_program = common::BuildProgram(m_context, m_device, source, "");
+        // std::cout << source << "\n";
 
         /* Create engine kernels. */
         m_kernels.resize(NumKernels, NULL);
@@ -209,8 +259,11 @@ void Engine::setup(
         m_kernels[KernelCopyAtomPoints] =  cl::Kernel::create(m_program, "copy_atom_points");
         m_kernels[KernelThermostatForce] =  cl::Kernel::create(m_program, "thermostat_force");
         m_kernels[KernelThermostatIntegrate] =  cl::Kernel::create(m_program, "thermostat_integrate");
+        m_kernels[KernelSamplerReduce] =  cl::Kernel::create(m_program, "sampler_reduce");
+        m_kernels[KernelSamplerThermo] =  cl::Kernel::create(m_program, "sampler_thermo");
         m_kernels[KernelClearNList] =  cl::Kernel::create(m_program, "clear_nlist");
         m_kernels[KernelBuildNList] =  cl::Kernel::create(m_program, "build_nlist");
+        m_kernels[KernelCheckNList] =  cl::Kernel::create(m_program, "check_nlist");
 
         /* Create engine device buffer objects. */
         m_buffers.resize(NumBuffers, NULL);
@@ -251,16 +304,43 @@ void Engine::setup(
             Params::num_work_groups * sizeof(cl_double),
             (void *) NULL);
 
+        m_buffers[BufferSamplerSums] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE,
+            Params::sampler_num_work_groups * Params::sampler_items * sizeof(cl_double),
+            (void *) NULL);
+
+        m_buffers[BufferThermo] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE,
+            sizeof(Thermo),
+            (void *) NULL);
+
         m_buffers[BufferNList] = cl::Memory::create_buffer(
             m_context,
             CL_MEM_READ_WRITE,
             m_list.capacity * sizeof(cl_uint),
             (void *) NULL);
 
-        m_buffers[BufferGLPointVbo] = cl::gl::create_from_gl_buffer(
+        m_buffers[BufferNListPos] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE,
+            m_atoms.size() * sizeof(cl_double4),
+            (void *) NULL);
+
+        m_buffers[BufferNListStale] = cl::Memory::create_buffer(
             m_context,
-            CL_MEM_WRITE_ONLY,
-            gl_vertex_buffer);
+            CL_MEM_READ_WRITE,
+            sizeof(cl_uint),
+            (void *) NULL);
+
+        /* Create the shared OpenGL vertex buffer unless running headless. */
+        if (gl_vertex_buffer != 0) {
+            m_buffers[BufferGLPointVbo] = cl::gl::create_from_gl_buffer(
+                m_context,
+                CL_MEM_WRITE_ONLY,
+                gl_vertex_buffer);
+        }
     }
 
     /*
@@ -291,6 +371,11 @@ void Engine::setup(
             sizeof(m_thermostat),
             (void *) &m_thermostat);
     }
+
+    /*
+     * Bind the kernel arguments.
+     */
+    bind();
 }
 
 /**
@@ -300,15 +385,35 @@ void Engine::setup(
 void Engine::teardown(void)
 {
     /* Teardown model data. */
-    {}
+    {
+        if (m_list_event != NULL) {
+            clWaitForEvents(1, &m_list_event);
+            clReleaseEvent(m_list_event);
+            m_list_event = NULL;
+        }
+        std::cout << "m_list_updates " << m_list_updates << "\n";
+
+        /* Collect the pending sample and write the sampler statistics. */
+        std::cout << sample_collect();
+
+        m_sampler.statistics();
+        core::FileOut fileout;
+        fileout.open("/tmp/out.sampler");
+        fileout.writeline(m_sampler.to_string());
+        fileout.close();
+        std::cout << m_sampler.to_string() << "\n";
+    }
 
     /* Teardown OpenCL data. */
     {
+        m_pipeline.teardown();
         for (auto &it : m_images) {
             cl::Memory::release(it);
         }
         for (auto &it : m_buffers) {
-            cl::Memory::release(it);
+            if (it != NULL) {
+                cl::Memory::release(it);
+            }
         }
         for (auto &it : m_kernels) {
             cl::Kernel::release(it);
@@ -318,216 +423,316 @@ void Engine::teardown(void)
 }
 
 /** ---------------------------------------------------------------------------
- * Engine::execute
- * @brief Engine integration step.
+ * Engine::bind
+ * @brief Bind the kernel arguments. The arguments are the same in every
+ * integration step, so they are set once rather than on every step.
  */
-void Engine::execute(void)
+void Engine::bind(void)
 {
     const cl_double t_step = Params::t_step;
     const cl_double half_t_step = 0.5 * Params::t_step;
+    const cl_uint n_groups = Params::sampler_num_work_groups;
+
+    cl::Kernel::set_arg(m_kernels[KernelUpdateAtoms], 0, sizeof(cl_uint), (void *) &Params::n_atoms);
+    cl::Kernel::set_arg(m_kernels[KernelUpdateAtoms], 1, sizeof(cl_mem), &m_buffers[BufferAtoms]);
+    cl::Kernel::set_arg(m_kernels[KernelUpdateAtoms], 2, sizeof(cl_mem), &m_buffers[BufferDomain]);
+    cl::Kernel::set_arg(m_kernels[KernelClearNList], 0, sizeof(cl_uint), &m_list.capacity);
+    cl::Kernel::set_arg(m_kernels[KernelClearNList], 1, sizeof(cl_mem), &m_buffers[BufferNList]);
+    cl::Kernel::set_arg(m_kernels[KernelClearNList], 2, sizeof(cl_mem), &m_buffers[BufferNListStale]);
+    cl::Kernel::set_arg(m_kernels[KernelBuildNList], 0, sizeof(cl_uint), (void *) &Params::n_atoms);
+    cl::Kernel::set_arg(m_kernels[KernelBuildNList], 1, sizeof(cl_uint), (void *) &m_list.n_neighbours);
+    cl::Kernel::set_arg(m_kernels[KernelBuildNList], 2, sizeof(cl_double), (void *) &m_list.radius);
+    cl::Kernel::set_arg(m_kernels[KernelBuildNList], 3, sizeof(cl_mem), &m_buffers[BufferNList]);
+    cl::Kernel::set_arg(m_kernels[KernelBuildNList], 4, sizeof(cl_mem), &m_buffers[BufferAtoms]);
+    cl::Kernel::set_arg(m_kernels[KernelBuildNList], 5, sizeof(cl_mem), &m_buffers[BufferDomain]);
+    cl::Kernel::set_arg(m_kernels[KernelBuildNList], 6, sizeof(cl_mem), &m_buffers[BufferNListPos]);
+    cl::Kernel::set_arg(m_kernels[KernelBeginIntegrate], 0, sizeof(cl_double), (void *) &t_step);
+    cl::Kernel::set_arg(m_kernels[KernelBeginIntegrate], 1, sizeof(cl_uint), (void *) &Params::n_atoms);
+    cl::Kernel::set_arg(m_kernels[KernelBeginIntegrate], 2, sizeof(cl_mem), &m_buffers[BufferAtoms]);
+    cl::Kernel::set_arg(m_kernels[KernelBeginIntegrate], 3, sizeof(cl_mem), &m_buffers[BufferThermostat]);
+    cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 0, sizeof(cl_uint), (void *) &Params::n_atoms);
+    cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 1, sizeof(cl_mem), &m_buffers[BufferAtoms]);
+    cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 2, sizeof(cl_mem), &m_buffers[BufferThermostatGradSq]);
+    cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 3, sizeof(cl_mem), &m_buffers[BufferThermostatLaplace]);
+    cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 4, Params::work_group_size * sizeof(cl_double), NULL);
+    cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 5, Params::work_group_size * sizeof(cl_double), NULL);
+    cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 0, sizeof(cl_double), (void *) &half_t_step);
+    cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 1, sizeof(cl_mem), &m_buffers[BufferThermostatGradSq]);
+    cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 2, sizeof(cl_mem), &m_buffers[BufferThermostatLaplace]);
+    cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 3, sizeof(cl_mem), &m_buffers[BufferThermostat]);
+    cl::Kernel::set_arg(m_kernels[KernelComputeForces], 0, sizeof(cl_uint), (void *) &Params::n_atoms);
+    cl::Kernel::set_arg(m_kernels[KernelComputeForces], 1, sizeof(cl_uint), (void *) &m_list.n_neighbours);
+    cl::Kernel::set_arg(m_kernels[KernelComputeForces], 2, sizeof(cl_mem), &m_buffers[BufferAtoms]);
+    cl::Kernel::set_arg(m_kernels[KernelComputeForces], 3, sizeof(cl_mem), &m_buffers[BufferNList]);
+    cl::Kernel::set_arg(m_kernels[KernelComputeForces], 4, sizeof(cl_mem), &m_buffers[BufferDomain]);
+    cl::Kernel::set_arg(m_kernels[KernelComputeForces], 5, sizeof(cl_mem), &m_buffers[BufferField]);
+    cl::Kernel::set_arg(m_kernels[KernelEndIntegrate], 0, sizeof(cl_double), (void *) &t_step);
+    cl::Kernel::set_arg(m_kernels[KernelEndIntegrate], 1, sizeof(cl_uint), (void *) &Params::n_atoms);
+    cl::Kernel::set_arg(m_kernels[KernelEndIntegrate], 2, sizeof(cl_mem), &m_buffers[BufferAtoms]);
+    cl::Kernel::set_arg(m_kernels[KernelEndIntegrate], 3, sizeof(cl_mem), &m_buffers[BufferThermostat]);
+    cl::Kernel::set_arg(m_kernels[KernelCheckNList], 0, sizeof(cl_double), (void *) &t_step);
+    cl::Kernel::set_arg(m_kernels[KernelCheckNList], 1, sizeof(cl_uint), (void *) &Params::n_atoms);
+    cl::Kernel::set_arg(m_kernels[KernelCheckNList], 2, sizeof(cl_double), (void *) &m_list.skin);
+    cl::Kernel::set_arg(m_kernels[KernelCheckNList], 3, sizeof(cl_mem), &m_buffers[BufferNListPos]);
+    cl::Kernel::set_arg(m_kernels[KernelCheckNList], 4, sizeof(cl_mem), &m_buffers[BufferAtoms]);
+    cl::Kernel::set_arg(m_kernels[KernelCheckNList], 5, sizeof(cl_mem), &m_buffers[BufferNListStale]);
+    cl::Kernel::set_arg(m_kernels[KernelCheckNList], 6, Params::work_group_size * sizeof(cl_double), NULL);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerReduce], 0, sizeof(cl_uint), (void *) &Params::n_atoms);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerReduce], 1, sizeof(cl_mem), &m_buffers[BufferAtoms]);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerReduce], 2, sizeof(cl_mem), &m_buffers[BufferSamplerSums]);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerReduce], 3, Params::sampler_work_group_size * Params::sampler_items * sizeof(cl_double), NULL);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerThermo], 0, sizeof(cl_uint), (void *) &Params::n_atoms);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerThermo], 1, sizeof(cl_uint), &n_groups);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerThermo], 2, sizeof(cl_mem), &m_buffers[BufferSamplerSums]);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerThermo], 3, sizeof(cl_mem), &m_buffers[BufferDomain]);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerThermo], 4, sizeof(cl_mem), &m_buffers[BufferThermo]);
+    cl::Kernel::set_arg(m_kernels[KernelSamplerThermo], 5, Params::sampler_work_group_size * Params::sampler_items * sizeof(cl_double), NULL);
+
+    if (m_buffers[BufferGLPointVbo] != NULL) {
+        cl::Kernel::set_arg(m_kernels[KernelCopyAtomPoints], 0, sizeof(cl_uint), (void *) &Params::n_atoms);
+        cl::Kernel::set_arg(m_kernels[KernelCopyAtomPoints], 1, sizeof(cl_mem), &m_buffers[BufferGLPointVbo]);
+        cl::Kernel::set_arg(m_kernels[KernelCopyAtomPoints], 2, sizeof(cl_mem), &m_buffers[BufferAtoms]);
+    }
+}
 
+/** ---------------------------------------------------------------------------
+ * Engine::execute
+ * @brief Engine integration step. The kernel arguments are bound by
+ * Engine::bind and the kernels are enqueued on the pipeline, each waiting on
+ * the kernels it depends on. The list update is decided on the host from the
+ * staleness flag of the previous step, so steps are not batched.
+ */
+void Engine::execute(void)
+{
     /*
      * Update atom positions and apply periodic boundary conditions.
      */
-    {
-        /* Update atom positions and associated data structures. */
-        cl::Kernel::set_arg(m_kernels[KernelUpdateAtoms], 0, sizeof(cl_uint), (void *) &Params::n_atoms);
-        cl::Kernel::set_arg(m_kernels[KernelUpdateAtoms], 1, sizeof(cl_mem), &m_buffers[BufferAtoms]);
-        cl::Kernel::set_arg(m_kernels[KernelUpdateAtoms], 2, sizeof(cl_mem), &m_buffers[BufferDomain]);
-        cl::Queue::enqueue_nd_range_kernel(
-            m_queue,
-            m_kernels[KernelUpdateAtoms],
-            cl::NDRange::Null,
-            cl::NDRange::Make(Params::n_atoms, Params::work_group_size),
-            cl::NDRange(Params::work_group_size),
-            NULL,
-            NULL);
+    cl_event update = m_pipeline.enqueue(
+        m_kernels[KernelUpdateAtoms],
+        Params::n_atoms,
+        Params::work_group_size,
+        {m_pipeline.m_frontier});
+
+    /*
+     * Wait for the staleness flag of the previous step check.
+     */
+    if (m_list_event != NULL) {
+        cl_int err = clWaitForEvents(1, &m_list_event);
+        core_assert(err == CL_SUCCESS, "failed to wait for list staleness flag");
+        clReleaseEvent(m_list_event);
+        m_list_event = NULL;
     }
 
     /*
-     * Update the neigbour list.
+     * Update the neigbour list if stale.
      */
-    if (m_step % Params::list_freq == 0)
+    cl_event listed = update;
+    if (m_list.is_stale)
     {
-        /* Clear the neighbour list. */
-        cl::Kernel::set_arg(m_kernels[KernelClearNList], 0, sizeof(cl_uint), &m_list.capacity);
-        cl::Kernel::set_arg(m_kernels[KernelClearNList], 1, sizeof(cl_mem), &m_buffers[BufferNList]);
-        cl::Queue::enqueue_nd_range_kernel(
-            m_queue,
+        m_list_updates++;
+
+        /* Clear and build the neighbour list. */
+        cl_event clear_list = m_pipeline.enqueue(
             m_kernels[KernelClearNList],
-            cl::NDRange::Null,
-            cl::NDRange::Make(m_list.capacity, Params::work_group_size),
-            cl::NDRange(Params::work_group_size),
-            NULL,
-            NULL);
-
-        /* Build the neighbour list. */
-        cl::Kernel::set_arg(m_kernels[KernelBuildNList], 0, sizeof(cl_uint), (void *) &Params::n_atoms);
-        cl::Kernel::set_arg(m_kernels[KernelBuildNList], 1, sizeof(cl_uint), (void *) &m_list.n_neighbours);
-        cl::Kernel::set_arg(m_kernels[KernelBuildNList], 2, sizeof(cl_double), (void *) &m_list.radius);
-        cl::Kernel::set_arg(m_kernels[KernelBuildNList], 3, sizeof(cl_mem), &m_buffers[BufferNList]);
-        cl::Kernel::set_arg(m_kernels[KernelBuildNList], 4, sizeof(cl_mem), &m_buffers[BufferAtoms]);
-        cl::Kernel::set_arg(m_kernels[KernelBuildNList], 5, sizeof(cl_mem), &m_buffers[BufferDomain]);
-        cl::Queue::enqueue_nd_range_kernel(
-            m_queue,
+            m_list.capacity,
+            Params::work_group_size,
+            {update});
+        cl_event build_list = m_pipeline.enqueue(
             m_kernels[KernelBuildNList],
-            cl::NDRange::Null,
-            cl::NDRange::Make(Params::n_atoms, Params::work_group_size),
-            cl::NDRange(Params::work_group_size),
-            NULL,
-            NULL);
+            Params::n_atoms,
+            Params::work_group_size,
+            {clear_list});
+
+        Pipeline::release({update, clear_list});
+        listed = build_list;
     }
 
     /*
-     * Begin integration - first half of the integration step.
+     * Begin integration - first half of the integration step. The thermostat
+     * only depends on the atom momenta, so its integration may execute
+     * concurrently with the force computation.
      */
-    {
-        /* Integrate the atoms at half time step. */
-        cl::Kernel::set_arg(m_kernels[KernelBeginIntegrate], 0, sizeof(cl_double), (void *) &t_step);
-        cl::Kernel::set_arg(m_kernels[KernelBeginIntegrate], 1, sizeof(cl_uint), (void *) &Params::n_atoms);
-        cl::Kernel::set_arg(m_kernels[KernelBeginIntegrate], 2, sizeof(cl_mem), &m_buffers[BufferAtoms]);
-        cl::Kernel::set_arg(m_kernels[KernelBeginIntegrate], 3, sizeof(cl_mem), &m_buffers[BufferThermostat]);
-        cl::Queue::enqueue_nd_range_kernel(
-            m_queue,
-            m_kernels[KernelBeginIntegrate],
-            cl::NDRange::Null,
-            cl::NDRange::Make(Params::n_atoms, Params::work_group_size),
-            cl::NDRange(Params::work_group_size),
-            NULL,
-            NULL);
-
-        /* Compute thermostat force using the updated atom momenta. */
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 0, sizeof(cl_uint), (void *) &Params::n_atoms);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 1, sizeof(cl_mem), &m_buffers[BufferAtoms]);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 2, sizeof(cl_mem), &m_buffers[BufferThermostatGradSq]);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 3, sizeof(cl_mem), &m_buffers[BufferThermostatLaplace]);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 4, Params::work_group_size * sizeof(cl_double), NULL);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 5, Params::work_group_size * sizeof(cl_double), NULL);
-        cl::Queue::enqueue_nd_range_kernel(
-            m_queue,
-            m_kernels[KernelThermostatForce],
-            cl::NDRange::Null,
-            cl::NDRange::Make(Params::n_atoms, Params::work_group_size),
-            cl::NDRange(Params::work_group_size),
-            NULL,
-            NULL);
-
-        /* Integrate thermostat using the computed forces. */
-        cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 0, sizeof(cl_double), (void *) &half_t_step);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 1, sizeof(cl_mem), &m_buffers[BufferThermostatGradSq]);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 2, sizeof(cl_mem), &m_buffers[BufferThermostatLaplace]);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 3, sizeof(cl_mem), &m_buffers[BufferThermostat]);
-        cl::Queue::enqueue_nd_range_kernel(
-            m_queue,
-            m_kernels[KernelThermostatIntegrate],
-            cl::NDRange::Null,
-            cl::NDRange::Make(Params::n_atoms, Params::work_group_size),
-            cl::NDRange(Params::work_group_size),
-            NULL,
-            NULL);
-    }
+    cl_event begin_integrate = m_pipeline.enqueue(
+        m_kernels[KernelBeginIntegrate],
+        Params::n_atoms,
+        Params::work_group_size,
+        {listed});
+    cl_event begin_thermostat_force = m_pipeline.enqueue(
+        m_kernels[KernelThermostatForce],
+        Params::n_atoms,
+        Params::work_group_size,
+        {begin_integrate});
+    cl_event begin_thermostat = m_pipeline.enqueue(
+        m_kernels[KernelThermostatIntegrate],
+        Params::n_atoms,
+        Params::work_group_size,
+        {begin_thermostat_force});
 
     /*
      * Compute fluid forces.
      */
-    {
-        cl::Kernel::set_arg(m_kernels[KernelComputeForces], 0, sizeof(cl_uint), (void *) &Params::n_atoms);
-        cl::Kernel::set_arg(m_kernels[KernelComputeForces], 1, sizeof(cl_uint), (void *) &m_list.n_neighbours);
-        cl::Kernel::set_arg(m_kernels[KernelComputeForces], 2, sizeof(cl_mem), &m_buffers[BufferAtoms]);
-        cl::Kernel::set_arg(m_kernels[KernelComputeForces], 3, sizeof(cl_mem), &m_buffers[BufferNList]);
-        cl::Kernel::set_arg(m_kernels[KernelComputeForces], 4, sizeof(cl_mem), &m_buffers[BufferDomain]);
-        cl::Kernel::set_arg(m_kernels[KernelComputeForces], 5, sizeof(cl_mem), &m_buffers[BufferField]);
-        cl::Queue::enqueue_nd_range_kernel(
-            m_queue,
-            m_kernels[KernelComputeForces],
-            cl::NDRange::Null,
-            cl::NDRange::Make(Params::n_atoms, Params::work_group_size),
-            cl::NDRange(Params::work_group_size),
-            NULL,
-            NULL);
-    }
+    cl_event force = m_pipeline.enqueue(
+        m_kernels[KernelComputeForces],
+        Params::n_atoms,
+        Params::work_group_size,
+        {begin_integrate});
 
     /*
      * End integration - second half of the integration step.
      */
+    cl_event end_thermostat_force = m_pipeline.enqueue(
+        m_kernels[KernelThermostatForce],
+        Params::n_atoms,
+        Params::work_group_size,
+        {begin_thermostat});
+    cl_event end_thermostat = m_pipeline.enqueue(
+        m_kernels[KernelThermostatIntegrate],
+        Params::n_atoms,
+        Params::work_group_size,
+        {end_thermostat_force});
+    cl_event end_integrate = m_pipeline.enqueue(
+        m_kernels[KernelEndIntegrate],
+        Params::n_atoms,
+        Params::work_group_size,
+        {force, end_thermostat});
+
+    /*
+     * Check the neighbour list staleness and read the flag asynchronously,
+     * to decide on the list update at the beginning of the next step.
+     */
+    cl_event check = m_pipeline.enqueue(
+        m_kernels[KernelCheckNList],
+        Params::n_atoms,
+        Params::work_group_size,
+        {end_integrate});
     {
-        /* Compute thermostat force using the updated atom momenta. */
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 0, sizeof(cl_uint), (void *) &Params::n_atoms);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 1, sizeof(cl_mem), &m_buffers[BufferAtoms]);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 2, sizeof(cl_mem), &m_buffers[BufferThermostatGradSq]);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 3, sizeof(cl_mem), &m_buffers[BufferThermostatLaplace]);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 4, Params::work_group_size * sizeof(cl_double), NULL);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatForce], 5, Params::work_group_size * sizeof(cl_double), NULL);
-        cl::Queue::enqueue_nd_range_kernel(
-            m_queue,
-            m_kernels[KernelThermostatForce],
-            cl::NDRange::Null,
-            cl::NDRange::Make(Params::n_atoms, Params::work_group_size),
-            cl::NDRange(Params::work_group_size),
-            NULL,
-            NULL);
-
-        /* Integrate thermostat using the computed forces. */
-        cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 0, sizeof(cl_double), (void *) &half_t_step);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 1, sizeof(cl_mem), &m_buffers[BufferThermostatGradSq]);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 2, sizeof(cl_mem), &m_buffers[BufferThermostatLaplace]);
-        cl::Kernel::set_arg(m_kernels[KernelThermostatIntegrate], 3, sizeof(cl_mem), &m_buffers[BufferThermostat]);
-        cl::Queue::enqueue_nd_range_kernel(
-            m_queue,
-            m_kernels[KernelThermostatIntegrate],
-            cl::NDRange::Null,
-            cl::NDRange::Make(Params::n_atoms, Params::work_group_size),
-            cl::NDRange(Params::work_group_size),
-            NULL,
-            NULL);
-
-        /* Integrate the momenta for half time step. */
-        cl::Kernel::set_arg(m_kernels[KernelEndIntegrate], 0, sizeof(cl_double), (void *) &t_step);
-        cl::Kernel::set_arg(m_kernels[KernelEndIntegrate], 1, sizeof(cl_uint), (void *) &Params::n_atoms);
-        cl::Kernel::set_arg(m_kernels[KernelEndIntegrate], 2, sizeof(cl_mem), &m_buffers[BufferAtoms]);
-        cl::Kernel::set_arg(m_kernels[KernelEndIntegrate], 3, sizeof(cl_mem), &m_buffers[BufferThermostat]);
-        cl::Queue::enqueue_nd_range_kernel(
+        cl_int err = clEnqueueReadBuffer(
             m_queue,
-            m_kernels[KernelEndIntegrate],
-            cl::NDRange::Null,
-            cl::NDRange::Make(Params::n_atoms, Params::work_group_size),
-            cl::NDRange(Params::work_group_size),
-            NULL,
-            NULL);
+            m_buffers[BufferNListStale],
+            CL_FALSE,
+            0,
+            sizeof(cl_uint),
+            (void *) &m_list.is_stale,
+            check != NULL ? 1 : 0,
+            check != NULL ? &check : NULL,
+            &m_list_event);
+        core_assert(err == CL_SUCCESS, "failed to read list staleness flag");
+        clFlush(m_queue);
     }
 
+    Pipeline::release({
+        listed,
+        begin_integrate,
+        begin_thermostat_force,
+        begin_thermostat,
+        force,
+        end_thermostat_force,
+        end_thermostat,
+        end_integrate});
+    m_pipeline.advance(check);
 
     /*
-     * Copy atom positions onto the shared OpenGL vertex buffer object.
+     * Copy atom positions onto the shared OpenGL vertex buffer object,
+     * skipped if the engine is running headless.
      */
-    {
+    if (m_buffers[BufferGLPointVbo] != NULL) {
         /* Wait for OpenGL to finish and acquire the gl objects. */
+        m_pipeline.barrier();
         cl::gl::enqueue_acquire_gl_objects(
             m_queue, 1, &m_buffers[BufferGLPointVbo], NULL, NULL);
 
         /* Enqueue the OpenCL kernel for execution. */
-        cl::Kernel::set_arg(m_kernels[KernelCopyAtomPoints], 0, sizeof(cl_uint), (void *) &Params::n_atoms);
-        cl::Kernel::set_arg(m_kernels[KernelCopyAtomPoints], 1, sizeof(cl_mem), &m_buffers[BufferGLPointVbo]);
-        cl::Kernel::set_arg(m_kernels[KernelCopyAtomPoints], 2, sizeof(cl_mem), &m_buffers[BufferAtoms]);
-        cl::Queue::enqueue_nd_range_kernel(
-            m_queue,
+        cl_event copy_points = m_pipeline.enqueue(
             m_kernels[KernelCopyAtomPoints],
-            cl::NDRange::Null,
-            cl::NDRange::Make(Params::n_atoms, Params::work_group_size),
-            cl::NDRange(Params::work_group_size),
-            NULL,
-            NULL);
+            Params::n_atoms,
+            Params::work_group_size,
+            {m_pipeline.m_frontier});
 
         /* Wait for OpenCL to finish and release the gl objects. */
         cl::gl::enqueue_release_gl_objects(
             m_queue, 1, &m_buffers[BufferGLPointVbo], NULL, NULL);
+        m_pipeline.barrier();
+        Pipeline::release({copy_points});
     }
 
     /*
      * Next time step.
      */
     {
-        // std::cout << m_step << "\n";
         m_step++;
+        if (m_step % Params::sample_frequency == 0) {
+            std::cout << sample(m_step);
+        }
+    }
+}
+
+/**
+ * Engine::sample
+ * @brief Sample fluid thermodynamic properties. The properties are reduced
+ * on the device in two stages, a partial sum over the atoms of each work
+ * group and a final sum over the work groups. Only the reduced properties
+ * are read back to the host, asynchronously, and are collected by the next
+ * call to sample, so sampling does not stall the host.
+ */
+std::string Engine::sample(const cl_ulong step)
+{
+    /* Collect the previous sample. */
+    std::string log = sample_collect();
+
+    /*
+     * Reduce the atom partial sums of each work group, then reduce the work
+     * group partial sums and compute the properties.
+     */
+    cl_event reduce = m_pipeline.enqueue(
+        m_kernels[KernelSamplerReduce],
+        Params::sampler_num_work_groups * Params::sampler_work_group_size,
+        Params::sampler_work_group_size,
+        {m_pipeline.m_frontier});
+    cl_event thermo = m_pipeline.enqueue(
+        m_kernels[KernelSamplerThermo],
+        Params::sampler_work_group_size,
+        Params::sampler_work_group_size,
+        {reduce});
+
+    /* Read the properties back without blocking. */
+    clEnqueueReadBuffer(
+        m_queue,
+        m_buffers[BufferThermo],
+        CL_FALSE,
+        0,
+        sizeof(m_thermo),
+        (void *) &m_thermo,
+        thermo != NULL ? 1 : 0,
+        thermo != NULL ? &thermo : NULL,
+        &m_thermo_event);
+    clFlush(m_queue);
+    m_thermo_step = step;
+
+    /* Order the next step after the sampler reads the atoms. */
+    Pipeline::release({reduce});
+    m_pipeline.advance(thermo);
+
+    return log;
+}
+
+/**
+ * Engine::sample_collect
+ * @brief Wait for the readback of the pending sample, if any, and add it to
+ * the sampler. Return its serialized properties, or an empty string.
+ */
+std::string Engine::sample_collect(void)
+{
+    if (m_thermo_event == NULL) {
+        return std::string();
     }
+
+    clWaitForEvents(1, &m_thermo_event);
+    clReleaseEvent(m_thermo_event);
+    m_thermo_event = NULL;
+
+    m_sampler.sample(m_thermo);
+
+    std::ostringstream ss;
+    ss << "step " << m_thermo_step << "\n" << m_sampler.log_string() << "\n";
+    return ss.str();
 }
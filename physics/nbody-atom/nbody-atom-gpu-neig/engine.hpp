@@ -15,8 +15,10 @@
 #include "atto/opencl/opencl.hpp"
 #include "base.hpp"
 #include "compute.hpp"
+#include "sampler.hpp"
 #include "generate.hpp"
 #include "io.hpp"
+#include "pipeline.hpp"
 
 /**
  * Engine
@@ -41,7 +43,13 @@ struct Engine {
     Field m_field;                      /* fluid force field */
     Thermostat m_thermostat;            /* fluid thermostat */
     std::vector<Atom> m_atoms;          /* fluid atoms */
+    Thermo m_thermo;                    /* fluid thermodynamic properties */
+    Sampler m_sampler;                  /* fluid thermodynamic sampler */
+    cl_event m_thermo_event = NULL;     /* thermo readback event */
+    cl_ulong m_thermo_step = 0;         /* step of the pending thermo */
     List m_list;                        /* neighbour list parameters */
+    cl_ulong m_list_updates;            /* number of list updates */
+    cl_event m_list_event = NULL;       /* list staleness read event */
     Grid m_grid;                        /* grid map parameters */
 
     /* Engine program. */
@@ -49,6 +57,7 @@ struct Engine {
     cl_device_id m_device = NULL;
     cl_command_queue m_queue = NULL;
     cl_program m_program = NULL;
+    Pipeline m_pipeline;                /* engine step pipeline */
 
     /* Engine kernels. */
     enum {
@@ -59,6 +68,8 @@ struct Engine {
         KernelCopyAtomPoints,
         KernelThermostatForce,
         KernelThermostatIntegrate,
+        KernelSamplerReduce,
+        KernelSamplerThermo,
         KernelClearNList,
         KernelBuildNList,
         KernelCheckNList,
@@ -74,7 +85,11 @@ struct Engine {
         BufferThermostat,
         BufferThermostatGradSq,
         BufferThermostatLaplace,
+        BufferSamplerSums,
+        BufferThermo,
         BufferNList,
+        BufferNListPos,
+        BufferNListStale,
         BufferGLPointVbo,
         NumBuffers
     };
@@ -86,18 +101,34 @@ struct Engine {
     };
     std::vector<cl_mem> m_images;
 
+    /** Bind the kernel arguments that are the same in every step. */
+    void bind(void);
+
     /** Execute one integration step. */
     void execute(void);
 
+    /**
+     * Sample the fluid thermodynamic properties on the device at the
+     * specified step and return the serialized properties of the previous
+     * sample, whose readback completed in the meantime.
+     */
+    std::string sample(const cl_ulong step);
+
+    /** Collect the pending sample and return its serialized properties. */
+    std::string sample_collect(void);
+
     /** Has the integration finished? */
     bool finished(void) const { return m_step < Params::n_steps; }
 
-    /** Setup/teardown engine. */
+    /**
+     * Setup/teardown engine. The engine runs headless, without copying the
+     * atom positions onto a shared OpenGL buffer, if gl_vertex_buffer is 0.
+     */
     void setup(
         const cl_context &context,
         const cl_device_id &device,
         const cl_command_queue &queue,
-        const GLuint &gl_vertex_buffer);
+        const GLuint &gl_vertex_buffer = 0);
 
     void teardown(void);
 
@@ -0,0 +1,41 @@
+/*
+ * headless.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef MD_HEADLESS_H_
+#define MD_HEADLESS_H_
+
+#include "atto/opencl/opencl.hpp"
+#include "engine.hpp"
+
+/**
+ * Headless
+ * @brief Headless model executing the engine on any OpenCL device, including
+ * CPU runtimes, without an OpenGL context or shared OpenGL buffers.
+ */
+struct Headless {
+    /* ---- Headless data -------------------------------------------------- */
+    Engine m_engine;
+
+    /* ---- Headless OpenCL data ------------------------------------------- */
+    cl_context m_context = NULL;
+    cl_device_id m_device = NULL;
+    cl_command_queue m_queue = NULL;
+
+    /* ---- Headless member functions -------------------------------------- */
+    bool execute(void);
+
+    Headless(const cl_device_type device_type, const cl_ulong device_index);
+    ~Headless();
+    Headless(const Headless &) = delete;
+    Headless &operator=(const Headless &) = delete;
+};
+
+#endif /* MD_HEADLESS_H_ */
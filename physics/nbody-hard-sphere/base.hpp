@@ -0,0 +1,101 @@
+/*
+ * base.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef HS_BASE_H_
+#define HS_BASE_H_
+
+#include "atto/opencl/opencl.hpp"
+
+/**
+ * @brief Number of fcc unit cells along each direction, 4 n^3 spheres,
+ * overridden at compile time, e.g. make HS_FLAGS=-DHS_N_LATTICE=63 for
+ * 10^6 spheres.
+ */
+#ifndef HS_N_LATTICE
+#define HS_N_LATTICE 16
+#endif
+
+/**
+ * @brief Sphere packing fraction, overridden at compile time, e.g.
+ * make HS_FLAGS=-DHS_PACKING=0.45.
+ */
+#ifndef HS_PACKING
+#define HS_PACKING 0.3
+#endif
+
+/**
+ * @brief Model parameters.
+ */
+namespace Params {
+/* Simulation parameters. */
+static const double t_run = 100.0;              /* run time */
+static const double t_sample = 1.0;             /* sample time interval */
+static const size_t sample_block_size = 10;     /* sampler block size */
+
+/* Engine parameters. */
+static const size_t n_lattice = HS_N_LATTICE;   /* fcc unit cells per side */
+static const size_t n_spheres = 4 * n_lattice * n_lattice * n_lattice;
+static const double packing = HS_PACKING;       /* sphere packing fraction */
+static const double temperature = 1.0;          /* fluid temperature */
+static const double sphere_mass = 1.0;          /* sphere mass */
+static const double sphere_sigma = 1.0;         /* sphere diameter */
+}
+
+/**
+ * @brief Fluid spheres. The state of a sphere is stored at the time of its
+ * last event, and its position at a later time t is pos + vel * (t - time).
+ * A sphere is only brought up to date when an event involves it.
+ */
+struct Sphere {
+    atto::math::vec3d pos;          /* position at the sphere time */
+    atto::math::vec3d vel;          /* velocity */
+    double time;                    /* time of the last sphere update */
+    uint32_t cell;                  /* cell index */
+    uint32_t count;                 /* number of sphere collisions */
+};
+
+/**
+ * @brief Sphere events. An event is a collision of two spheres, or the
+ * crossing of a cell face by one sphere, with the partner index replaced
+ * by the crossing direction. The event of a sphere is replaced whenever the
+ * sphere changes course. A collision holds the collision count of the
+ * partner when it was predicted, and it is valid only while it matches the
+ * partner count, so stale collisions are discarded when they reach the queue
+ * top.
+ */
+struct Event {
+    enum : uint32_t {
+        CrossX = 0xfffffffc,
+        CrossY = 0xfffffffd,
+        CrossZ = 0xfffffffe,
+    };
+
+    double time;                    /* event time */
+    uint32_t sphere_1;              /* first sphere index */
+    uint32_t sphere_2;              /* second sphere index or crossing */
+    uint32_t count_2;               /* second sphere count at prediction */
+
+    /** Is the event a cell crossing? */
+    bool is_crossing(void) const { return sphere_2 >= CrossX; }
+
+    /** Order events by time. */
+    bool operator<(const Event &other) const { return time < other.time; }
+};
+
+/**
+ * @brief Fluid domain.
+ */
+struct Domain {
+    atto::math::vec3d length;       /* domain period length*/
+    atto::math::vec3d length_half;  /* domain half length */
+};
+
+#endif /* HS_BASE_H_ */
@@ -0,0 +1,592 @@
+/*
+ * engine.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include "atto/opencl/opencl.hpp"
+#include "engine.hpp"
+using namespace atto;
+
+/** ---------------------------------------------------------------------------
+ * axis
+ * @brief Return the component of a vector along the specified direction.
+ */
+static double &axis(math::vec3d &v, const size_t dim)
+{
+    return dim == 0 ? v.x : (dim == 1 ? v.y : v.z);
+}
+
+static double axis(const math::vec3d &v, const size_t dim)
+{
+    return dim == 0 ? v.x : (dim == 1 ? v.y : v.z);
+}
+
+static int32_t axis(const math::vec3i &v, const size_t dim)
+{
+    return dim == 0 ? v.x : (dim == 1 ? v.y : v.z);
+}
+
+/**
+ * pbc
+ * @brief Return the minimum image of a pair vector in the fluid domain.
+ */
+static math::vec3d pbc(const math::vec3d &r, const Domain &domain)
+{
+    math::vec3d image(r);
+    for (size_t dim = 0; dim < 3; ++dim) {
+        double &x = axis(image, dim);
+        if (x < -axis(domain.length_half, dim)) {
+            x += axis(domain.length, dim);
+        }
+        if (x >  axis(domain.length_half, dim)) {
+            x -= axis(domain.length, dim);
+        }
+    }
+    return image;
+}
+
+/** ---------------------------------------------------------------------------
+ * Engine::setup
+ * @brief Setup the fluid domain and the cell list.
+ */
+void Engine::setup(void)
+{
+    /* Setup the fluid domain at the specified packing fraction. */
+    {
+        const double sigma = Params::sphere_sigma;
+        double density = 6.0 * Params::packing / (M_PI * sigma * sigma * sigma);
+        double volume = (double) Params::n_spheres / density;
+        double length = std::pow(volume, 1.0 / 3.0);
+        m_domain = Domain{
+            math::vec3d{length, length, length},
+            math::vec3d{0.5*length, 0.5*length, 0.5*length}};
+    }
+
+    /* Setup the cell list, with cells no smaller than the sphere diameter. */
+    {
+        int32_t n_cells = (int32_t) (m_domain.length.x / Params::sphere_sigma);
+        core_assert(n_cells >= 3, "domain is too small for the cell list");
+        m_cells = math::vec3i{n_cells, n_cells, n_cells};
+        m_cell_length = math::vec3d{
+            m_domain.length.x / n_cells,
+            m_domain.length.y / n_cells,
+            m_domain.length.z / n_cells};
+        m_cell_head.resize(n_cells * n_cells * n_cells);
+        m_cell_next.resize(Params::n_spheres);
+        m_cell_prev.resize(Params::n_spheres);
+    }
+
+    m_spheres.resize(Params::n_spheres);
+}
+
+/**
+ * Engine::teardown
+ * @brief Write the sphere positions and the sampler statistics.
+ */
+void Engine::teardown(void)
+{
+    synchronize();
+
+    core::FileOut fileout;
+    std::string buffer;
+
+    fileout.open("/tmp/out.xyz");
+    buffer = core::str_format("%lu\nmodel\n", m_spheres.size());
+    core_assert(fileout.writeline(buffer), "failed to write header");
+    for (auto &sphere : m_spheres) {
+        buffer = core::str_format(
+            "C %lf %lf %lf\n", sphere.pos.x, sphere.pos.y, sphere.pos.z);
+        core_assert(fileout.writeline(buffer), "failed to write sphere");
+    }
+    fileout.close();
+
+    m_sampler.statistics();
+    fileout.open("/tmp/out.sampler");
+    fileout.writeline(m_sampler.to_string());
+    fileout.close();
+
+    std::cout << m_sampler.to_string() << "\n";
+}
+
+/** ---------------------------------------------------------------------------
+ * Engine::generate
+ * @brief Generate sphere positions on an fcc lattice and sphere velocities
+ * from a Maxwell-Boltzmann distribution at the specified temperature.
+ */
+void Engine::generate(void)
+{
+    /* Generate sphere positions on the sites of an fcc lattice. */
+    {
+        const math::vec3d basis[4] = {
+            math::vec3d{0.25, 0.25, 0.25},
+            math::vec3d{0.75, 0.75, 0.25},
+            math::vec3d{0.75, 0.25, 0.75},
+            math::vec3d{0.25, 0.75, 0.75}};
+        const double spacing = m_domain.length.x / Params::n_lattice;
+        core_assert(spacing > std::sqrt(2.0) * Params::sphere_sigma,
+            "packing fraction is too high for the fcc lattice");
+
+        size_t ix = 0;
+        for (size_t i = 0; i < Params::n_lattice; ++i) {
+            for (size_t j = 0; j < Params::n_lattice; ++j) {
+                for (size_t k = 0; k < Params::n_lattice; ++k) {
+                    for (auto &site : basis) {
+                        m_spheres[ix++].pos = math::vec3d{
+                            spacing * (i + site.x) - m_domain.length_half.x,
+                            spacing * (j + site.y) - m_domain.length_half.y,
+                            spacing * (k + site.z) - m_domain.length_half.z};
+                    }
+                }
+            }
+        }
+    }
+
+    /*
+     * Generate sphere velocities from a Maxwell-Boltzmann distribution, and
+     * remove the mean velocity and rescale to the specified temperature.
+     */
+    {
+        math::rng::Kiss engine(true);       /* rng engine */
+        math::rng::gauss<double> rand;      /* rng sampler */
+
+        double sdev = std::sqrt(Params::temperature / Params::sphere_mass);
+        math::vec3d vel_mean{};
+        for (auto &sphere : m_spheres) {
+            sphere.vel = math::vec3d{
+                rand(engine, 0.0, sdev),
+                rand(engine, 0.0, sdev),
+                rand(engine, 0.0, sdev)};
+            vel_mean += sphere.vel;
+        }
+        vel_mean /= (double) m_spheres.size();
+
+        double vel_sq = 0.0;
+        for (auto &sphere : m_spheres) {
+            sphere.vel -= vel_mean;
+            vel_sq += math::dot(sphere.vel, sphere.vel);
+        }
+
+        double n_dof = 3.0 * (m_spheres.size() - 1);
+        double scale = std::sqrt(
+            Params::temperature * n_dof / (Params::sphere_mass * vel_sq));
+        for (auto &sphere : m_spheres) {
+            sphere.vel *= scale;
+        }
+    }
+}
+
+/**
+ * Engine::reset
+ * @brief Reset the engine time, rebuild the cell list and predict the first
+ * event of every sphere.
+ */
+void Engine::reset(void)
+{
+    m_time = 0.0;
+    m_queue.clear(m_spheres.size());
+
+    /* Rebuild the cell list and renumber the spheres in cell order. */
+    std::fill(m_cell_head.begin(), m_cell_head.end(), (uint32_t) m_empty);
+    for (uint32_t ix = 0; ix < m_spheres.size(); ++ix) {
+        Sphere &sphere = m_spheres[ix];
+        sphere.time = 0.0;
+        sphere.count = 0;
+        cell_insert(ix, cell_index(cell_coord(sphere.pos)));
+    }
+    sort();
+
+    /* Predict the first event of every sphere. */
+    for (uint32_t ix = 0; ix < m_spheres.size(); ++ix) {
+        predict(ix);
+    }
+
+    /* Reset the sampler and the event counters. */
+    m_sampler.reset();
+    m_sample_time = m_time;
+    m_virial = 0.0;
+    m_n_collisions = 0;
+    m_n_crossings = 0;
+    m_n_stale = 0;
+}
+
+/** ---------------------------------------------------------------------------
+ * Engine::execute
+ * @brief Process all the events up to the specified time and return the
+ * number of valid events. Every processed event is replaced in the queue by
+ * the next event of its spheres.
+ */
+size_t Engine::execute(const double t_end)
+{
+    size_t n_events = 0;
+    while (!m_queue.empty() && m_queue.top().time <= t_end) {
+        const Event event = m_queue.top();
+        m_time = event.time;
+
+        if (event.is_crossing()) {
+            cross(event.sphere_1, event.sphere_2 - Event::CrossX);
+        } else if (event.count_2 != m_spheres[event.sphere_2].count) {
+            /* The partner has moved on, predict a new event. */
+            m_n_stale++;
+            predict(event.sphere_1);
+            continue;
+        } else {
+            collide(event.sphere_1, event.sphere_2);
+        }
+        n_events++;
+    }
+    m_time = t_end;
+
+    return n_events;
+}
+
+/**
+ * Engine::sort
+ * @brief Renumber the spheres in cell order, so the spheres of neighbour
+ * cells are close in memory when their events are predicted. The sphere
+ * trajectories are unchanged, so the events in the queue remain valid and
+ * only their sphere indices are renumbered. The cells move slowly, and the
+ * order is restored once per sample interval.
+ */
+void Engine::sort(void)
+{
+    /* Sphere order along the cell lists, and the rank of each sphere. */
+    std::vector<uint32_t> order;
+    order.reserve(m_spheres.size());
+    for (size_t cell = 0; cell < m_cell_head.size(); ++cell) {
+        for (uint32_t ix = m_cell_head[cell]; ix != m_empty; ix = m_cell_next[ix]) {
+            order.push_back(ix);
+        }
+    }
+    core_assert(order.size() == m_spheres.size(), "invalid cell list");
+
+    std::vector<uint32_t> rank(m_spheres.size());
+    std::vector<Sphere> spheres(m_spheres.size());
+    for (uint32_t ix = 0; ix < order.size(); ++ix) {
+        rank[order[ix]] = ix;
+        spheres[ix] = m_spheres[order[ix]];
+    }
+    m_spheres.swap(spheres);
+
+    /* Rebuild the cell lists, inserting at the head in reverse order. */
+    std::fill(m_cell_head.begin(), m_cell_head.end(), (uint32_t) m_empty);
+    for (uint32_t ix = m_spheres.size(); ix-- > 0;) {
+        cell_insert(ix, m_spheres[ix].cell);
+    }
+
+    m_queue.renumber(rank);
+}
+
+/**
+ * Engine::synchronize
+ * @brief Bring all spheres up to the current time. The sphere trajectories
+ * are unchanged, so the events in the queue remain valid.
+ */
+void Engine::synchronize(void)
+{
+    for (uint32_t ix = 0; ix < m_spheres.size(); ++ix) {
+        advance(ix);
+    }
+}
+
+/**
+ * Engine::sample
+ * @brief Sample the fluid thermodynamic properties. The pressure is computed
+ * from the collision virial accumulated since the last sample,
+ *  P = rho kT + (1 / 3 V dt) sum_collisions m r_12.dv_12,
+ * and compared with the Carnahan-Starling equation of state.
+ */
+std::string Engine::sample(void)
+{
+    synchronize();
+
+    const double n_spheres = (double) m_spheres.size();
+    const double volume = m_domain.length.x *
+                          m_domain.length.y *
+                          m_domain.length.z;
+    const double density = n_spheres / volume;
+    const double t_elapsed = m_time - m_sample_time;
+    core_assert(t_elapsed > 0.0, "invalid sample time interval");
+
+    /* Kinetic temperature, with the CoM momentum removed. */
+    math::vec3d vel_sum{};
+    double vel_sq = 0.0;
+    for (auto &sphere : m_spheres) {
+        vel_sum += sphere.vel;
+        vel_sq += math::dot(sphere.vel, sphere.vel);
+    }
+    vel_sq -= math::dot(vel_sum, vel_sum) / n_spheres;
+    double temperature = Params::sphere_mass * vel_sq / (3.0 * (n_spheres - 1.0));
+
+    /* Collision virial pressure and Carnahan-Starling reference. */
+    double pressure = density * temperature + m_virial / (3.0 * volume * t_elapsed);
+    double eta = Params::packing;
+    double compressibility_cs = (1.0 + eta + eta * eta - eta * eta * eta) /
+        ((1.0 - eta) * (1.0 - eta) * (1.0 - eta));
+
+    Sampler::Item item;
+    item[Sampler::TEMPERATURE] = temperature;
+    item[Sampler::PRESSURE] = pressure;
+    item[Sampler::COMPRESSIBILITY] = pressure / (density * temperature);
+    item[Sampler::COMPRESSIBILITY_CS] = compressibility_cs;
+    item[Sampler::COLLISION_RATE] = 2.0 * m_n_collisions / (n_spheres * t_elapsed);
+    m_sampler.sample(item);
+
+    /* Reset the event counters for the next sample interval. */
+    m_sample_time = m_time;
+    m_virial = 0.0;
+    m_n_collisions = 0;
+    m_n_crossings = 0;
+    m_n_stale = 0;
+
+    return m_sampler.log_string();
+}
+
+/** ---------------------------------------------------------------------------
+ * Engine::cell_coord
+ * @brief Return the coordinates of the cell holding a position.
+ */
+math::vec3i Engine::cell_coord(const math::vec3d &pos) const
+{
+    auto coord = [&] (size_t dim) -> int32_t {
+        int32_t c = (int32_t) std::floor(
+            (axis(pos, dim) + axis(m_domain.length_half, dim)) /
+             axis(m_cell_length, dim));
+        return std::min(std::max(c, 0), axis(m_cells, dim) - 1);
+    };
+    return math::vec3i{coord(0), coord(1), coord(2)};
+}
+
+/**
+ * Engine::cell_index
+ * @brief Return the index of a cell, wrapped around the periodic domain.
+ */
+uint32_t Engine::cell_index(const math::vec3i &coord) const
+{
+    int32_t x = (coord.x + m_cells.x) % m_cells.x;
+    int32_t y = (coord.y + m_cells.y) % m_cells.y;
+    int32_t z = (coord.z + m_cells.z) % m_cells.z;
+    return (x * m_cells.y + y) * m_cells.z + z;
+}
+
+/**
+ * Engine::cell_insert
+ * @brief Insert a sphere at the head of a cell.
+ */
+void Engine::cell_insert(const uint32_t sphere_ix, const uint32_t cell)
+{
+    uint32_t head = m_cell_head[cell];
+    m_cell_next[sphere_ix] = head;
+    m_cell_prev[sphere_ix] = m_empty;
+    if (head != m_empty) {
+        m_cell_prev[head] = sphere_ix;
+    }
+    m_cell_head[cell] = sphere_ix;
+    m_spheres[sphere_ix].cell = cell;
+}
+
+/**
+ * Engine::cell_remove
+ * @brief Remove a sphere from its cell.
+ */
+void Engine::cell_remove(const uint32_t sphere_ix)
+{
+    uint32_t next = m_cell_next[sphere_ix];
+    uint32_t prev = m_cell_prev[sphere_ix];
+    if (prev != m_empty) {
+        m_cell_next[prev] = next;
+    } else {
+        m_cell_head[m_spheres[sphere_ix].cell] = next;
+    }
+    if (next != m_empty) {
+        m_cell_prev[next] = prev;
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * Engine::advance
+ * @brief Bring a sphere up to the current time.
+ */
+void Engine::advance(const uint32_t sphere_ix)
+{
+    Sphere &sphere = m_spheres[sphere_ix];
+    sphere.pos += sphere.vel * (m_time - sphere.time);
+    sphere.time = m_time;
+}
+
+/**
+ * Engine::predict
+ * @brief Predict the earliest event of a sphere, the first of its cell face
+ * crossings and its collisions with the spheres in the neighbour cells, and
+ * replace the sphere event in the queue.
+ */
+void Engine::predict(const uint32_t sphere_ix)
+{
+    const Sphere &sphere = m_spheres[sphere_ix];
+    const uint32_t n_yz = m_cells.y * m_cells.z;
+    const math::vec3i coord{
+        (int32_t) (sphere.cell / n_yz),
+        (int32_t) ((sphere.cell / m_cells.z) % m_cells.y),
+        (int32_t) (sphere.cell % m_cells.z)};
+
+    Event event{std::numeric_limits<double>::max(),
+        sphere_ix, Event::CrossX, 0};
+
+    /* Cell face crossings. */
+    for (size_t dim = 0; dim < 3; ++dim) {
+        double vel = axis(sphere.vel, dim);
+        if (vel == 0.0) {
+            continue;
+        }
+
+        double face = -axis(m_domain.length_half, dim) +
+            (axis(coord, dim) + (vel > 0.0 ? 1 : 0)) * axis(m_cell_length, dim);
+        double time = sphere.time + (face - axis(sphere.pos, dim)) / vel;
+        time = std::max(time, m_time);
+        if (time < event.time) {
+            event.time = time;
+            event.sphere_2 = Event::CrossX + dim;
+        }
+    }
+
+    /*
+     * Collisions with the spheres in the neighbour cells. The neighbour cell
+     * coordinates are wrapped around the periodic domain once per direction,
+     * and the periodic image of a cell across the domain boundary is a shift
+     * of the sphere positions by the domain length.
+     */
+    int32_t wrap[3][3];
+    double shift[3][3];
+    for (size_t dim = 0; dim < 3; ++dim) {
+        const int32_t n_cells = axis(m_cells, dim);
+        const double length = axis(m_domain.length, dim);
+        for (int32_t k = 0; k < 3; ++k) {
+            int32_t c = axis(coord, dim) + k - 1;
+            wrap[dim][k] = c < 0 ? c + n_cells : (c >= n_cells ? c - n_cells : c);
+            shift[dim][k] = c < 0 ? -length : (c >= n_cells ? length : 0.0);
+        }
+    }
+
+    const double sigma_sq = Params::sphere_sigma * Params::sphere_sigma;
+    const math::vec3d pos_1 = sphere.pos + sphere.vel * (m_time - sphere.time);
+    for (int32_t x = 0; x < 3; ++x) {
+    for (int32_t y = 0; y < 3; ++y) {
+    for (int32_t z = 0; z < 3; ++z) {
+        uint32_t cell = (wrap[0][x] * m_cells.y + wrap[1][y]) * m_cells.z + wrap[2][z];
+        const math::vec3d pos_shift =
+            math::vec3d{shift[0][x], shift[1][y], shift[2][z]} - pos_1;
+        for (uint32_t other_ix = m_cell_head[cell];
+             other_ix != m_empty;
+             other_ix = m_cell_next[other_ix]) {
+            if (other_ix == sphere_ix) {
+                continue;
+            }
+
+            /* Pair vector and velocity at the current time. */
+            const Sphere &other = m_spheres[other_ix];
+            math::vec3d r_12 = other.pos + other.vel * (m_time - other.time);
+            r_12 += pos_shift;
+            math::vec3d v_12 = other.vel - sphere.vel;
+
+            /*
+             * The spheres collide if they approach, b = r.v < 0, and the
+             * discriminant of |r + v t|^2 = sigma^2 is positive. The root
+             * is written in the form stable for small overlaps. The root is
+             * evaluated for every pair and selected with the collision test,
+             * since the test outcome is unpredictable and a branch on it
+             * costs more than the root.
+             */
+            double b = math::dot(r_12, v_12);
+            double v_sq = math::dot(v_12, v_12);
+            double c = math::dot(r_12, r_12) - sigma_sq;
+            double discr = b * b - v_sq * c;
+            bool hit = (b < 0.0) & (discr > 0.0);
+
+            double root = -b + std::sqrt(std::max(discr, 0.0));
+            double time = m_time + std::max(c / (hit ? root : 1.0), 0.0);
+            if (hit & (time < event.time)) {
+                event.time = time;
+                event.sphere_2 = other_ix;
+                event.count_2 = other.count;
+            }
+        }
+    }
+    }
+    }
+
+    m_queue.update(event);
+}
+
+/**
+ * Engine::collide
+ * @brief Process an elastic collision of two equal mass spheres, exchanging
+ * the velocity components along the line of centres, and predict their
+ * next events.
+ */
+void Engine::collide(const uint32_t sphere_1, const uint32_t sphere_2)
+{
+    advance(sphere_1);
+    advance(sphere_2);
+
+    Sphere &s_1 = m_spheres[sphere_1];
+    Sphere &s_2 = m_spheres[sphere_2];
+    math::vec3d r_12 = pbc(s_2.pos - s_1.pos, m_domain);
+    math::vec3d v_12 = s_2.vel - s_1.vel;
+    double b = math::dot(r_12, v_12);
+
+    math::vec3d dv = r_12 * (b / math::dot(r_12, r_12));
+    s_1.vel += dv;
+    s_2.vel -= dv;
+
+    /* Collision virial, (r_1 - r_2).(m dv_1). */
+    m_virial -= Params::sphere_mass * b;
+    m_n_collisions++;
+
+    s_1.count++;
+    s_2.count++;
+    predict(sphere_1);
+    predict(sphere_2);
+}
+
+/**
+ * Engine::cross
+ * @brief Move a sphere across a cell face into the neighbour cell, wrapping
+ * around the periodic domain, and predict its next event. The sphere is
+ * placed exactly on the shared face to keep its position and cell consistent.
+ * The sphere course is unchanged, so its collision count is kept and the
+ * collisions predicted with it by other spheres remain valid.
+ */
+void Engine::cross(const uint32_t sphere_ix, const uint32_t dim)
+{
+    advance(sphere_ix);
+
+    Sphere &sphere = m_spheres[sphere_ix];
+    const uint32_t n_yz = m_cells.y * m_cells.z;
+    math::vec3i coord{
+        (int32_t) (sphere.cell / n_yz),
+        (int32_t) ((sphere.cell / m_cells.z) % m_cells.y),
+        (int32_t) (sphere.cell % m_cells.z)};
+
+    const int32_t n_cells = axis(m_cells, dim);
+    int32_t *c = dim == 0 ? &coord.x : (dim == 1 ? &coord.y : &coord.z);
+    if (axis(sphere.vel, dim) > 0.0) {
+        *c = (*c + 1) % n_cells;
+        axis(sphere.pos, dim) = -axis(m_domain.length_half, dim) +
+            (*c) * axis(m_cell_length, dim);
+    } else {
+        *c = (*c - 1 + n_cells) % n_cells;
+        axis(sphere.pos, dim) = -axis(m_domain.length_half, dim) +
+            (*c + 1) * axis(m_cell_length, dim);
+    }
+
+    cell_remove(sphere_ix);
+    cell_insert(sphere_ix, cell_index(coord));
+    m_n_crossings++;
+
+    predict(sphere_ix);
+}
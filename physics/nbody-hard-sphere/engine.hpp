@@ -0,0 +1,105 @@
+/*
+ * engine.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef HS_ENGINE_H_
+#define HS_ENGINE_H_
+
+#include "atto/opencl/opencl.hpp"
+#include "base.hpp"
+#include "queue.hpp"
+#include "sampler.hpp"
+
+/**
+ * Engine
+ * @brief Event driven hard sphere engine.
+ *
+ * Spheres move on straight lines between events, and the engine jumps from
+ * one event to the next in time order. Each sphere holds a single predicted
+ * event in the queue, the earliest of its collisions with the spheres in the
+ * neighbour cells and of its cell face crossings. Cells are no smaller than
+ * the sphere diameter, so a sphere can only collide with spheres in its 27
+ * neighbour cells, and it re-predicts its events when it enters a new cell.
+ *
+ * The queue holds exactly one event per sphere, replaced in place whenever
+ * the sphere changes course. Collisions are invalidated lazily with the
+ * sphere collision counts. A collision whose partner has changed course is
+ * discarded when it reaches the queue top, and its first sphere predicts a
+ * new event. Cell crossings leave the sphere course unchanged, so they keep
+ * the collisions predicted by the other spheres valid.
+ *
+ * The spheres are renumbered in cell order every sample interval, so the
+ * neighbour cell scan of a prediction reads nearby memory.
+ */
+struct Engine {
+    /* Cell list empty slot. */
+    static const uint32_t m_empty = 0xffffffff;
+
+    /* Engine member variables. */
+    std::vector<Sphere> m_spheres;      /* fluid spheres */
+    Domain m_domain;                    /* fluid domain */
+    Queue m_queue;                      /* sphere event queue */
+    Sampler m_sampler;                  /* fluid thermodynamic sampler */
+    double m_time;                      /* time of the current event */
+
+    /* Cell list with doubly linked cells for constant time removal. */
+    atto::math::vec3i m_cells;          /* number of cells in each direction */
+    atto::math::vec3d m_cell_length;    /* cell length in each direction */
+    std::vector<uint32_t> m_cell_head;  /* first sphere in each cell */
+    std::vector<uint32_t> m_cell_next;  /* next sphere in the same cell */
+    std::vector<uint32_t> m_cell_prev;  /* previous sphere in the same cell */
+
+    /* Event counters and collision virial since the last sample. */
+    double m_sample_time;               /* time of the last sample */
+    double m_virial;                    /* sum of m r_12.dv_12 */
+    size_t m_n_collisions;              /* number of collisions */
+    size_t m_n_crossings;               /* number of cell crossings */
+    size_t m_n_stale;                   /* number of stale events */
+
+    /* Setup/teardown the engine. */
+    void setup(void);
+    void teardown(void);
+
+    /* Generate sphere positions and velocities. */
+    void generate(void);
+
+    /* Reset the engine time, cell list and event queue. */
+    void reset(void);
+
+    /* Process all the events up to the specified time. */
+    size_t execute(const double t_end);
+
+    /* Renumber the spheres in cell order. */
+    void sort(void);
+
+    /* Bring all spheres up to the current time. */
+    void synchronize(void);
+
+    /* Sample the fluid thermodynamic properties. */
+    std::string sample(void);
+
+    /* Cell list functions. */
+    atto::math::vec3i cell_coord(const atto::math::vec3d &pos) const;
+    uint32_t cell_index(const atto::math::vec3i &coord) const;
+    void cell_insert(const uint32_t sphere_ix, const uint32_t cell);
+    void cell_remove(const uint32_t sphere_ix);
+
+    /* Event functions. */
+    void advance(const uint32_t sphere_ix);
+    void predict(const uint32_t sphere_ix);
+    void collide(const uint32_t sphere_1, const uint32_t sphere_2);
+    void cross(const uint32_t sphere_ix, const uint32_t dim);
+
+    /* Constructor/destructor. */
+    Engine() = default;
+    ~Engine() = default;
+};
+
+#endif /* HS_ENGINE_H_ */
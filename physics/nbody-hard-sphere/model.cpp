@@ -0,0 +1,66 @@
+/*
+ * model.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include <chrono>
+#include "atto/opencl/opencl.hpp"
+#include "model.hpp"
+using namespace atto;
+
+/** ---------------------------------------------------------------------------
+ * @brief Create the hard sphere fluid.
+ */
+Model::Model()
+{
+    /* Initialize time. */
+    m_time = 0.0;
+
+    /* Setup engine object. */
+    m_engine.setup();
+    m_engine.generate();
+    m_engine.reset();
+}
+
+/**
+ * @brief Write the engine results.
+ */
+Model::~Model()
+{
+    /* Teardown engine. */
+    m_engine.teardown();
+}
+
+/** ---------------------------------------------------------------------------
+ * @brief Execute the model over one sample interval, log the event rate and
+ * renumber the spheres in cell order for the next interval.
+ */
+bool Model::execute(void)
+{
+    /* Process the events of the sample interval. */
+    auto begin = std::chrono::steady_clock::now();
+    size_t n_events = m_engine.execute(m_time + Params::t_sample);
+    auto end = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(end - begin).count();
+    m_time += Params::t_sample;
+
+    /* Model post-execution. */
+    std::cout << core::str_format(
+        "time %lf events %lu events/s %lf collisions %lu crossings %lu stale %lu\n",
+        m_time,
+        n_events,
+        (double) n_events / elapsed,
+        m_engine.m_n_collisions,
+        m_engine.m_n_crossings,
+        m_engine.m_n_stale);
+    std::cout << m_engine.sample() << "\n";
+    m_engine.sort();
+
+    return (m_time < Params::t_run);
+}
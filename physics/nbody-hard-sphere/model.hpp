@@ -0,0 +1,38 @@
+/*
+ * model.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef HS_MODEL_H_
+#define HS_MODEL_H_
+
+#include "atto/opencl/opencl.hpp"
+#include "base.hpp"
+#include "engine.hpp"
+
+/**
+ * Model
+ * @brief Hard sphere fluid model, run over sample time intervals.
+ */
+struct Model {
+    /* Model data. */
+    double m_time;
+    Engine m_engine;
+
+    /** Execute the model over one sample interval. */
+    bool execute(void);
+
+    /** Constructor/destructor. */
+    Model();
+    ~Model();
+    Model(const Model &) = delete;
+    Model &operator=(const Model &) = delete;
+};
+
+#endif /* HS_MODEL_H_ */
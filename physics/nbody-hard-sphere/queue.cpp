@@ -0,0 +1,106 @@
+/*
+ * queue.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include "atto/opencl/opencl.hpp"
+#include "queue.hpp"
+using namespace atto;
+
+/**
+ * Queue::update
+ * @brief Insert the event of its first sphere at the bottom of the heap, or
+ * replace the existing sphere event, and sift it into place.
+ */
+void Queue::update(const Event &event)
+{
+    uint32_t node = m_node[event.sphere_1];
+    if (node == m_none) {
+        m_heap.push_back(event);
+        sift_up(m_heap.size() - 1, event);
+    } else if (event < m_heap[node]) {
+        sift_up(node, event);
+    } else {
+        sift_down(node, event);
+    }
+}
+
+/**
+ * Queue::renumber
+ * @brief Renumber the spheres of the events. The event times are unchanged,
+ * so the heap order is kept and only the heap node index is rebuilt.
+ */
+void Queue::renumber(const std::vector<uint32_t> &rank)
+{
+    for (uint32_t node = 0; node < m_heap.size(); ++node) {
+        Event &event = m_heap[node];
+        event.sphere_1 = rank[event.sphere_1];
+        if (!event.is_crossing()) {
+            event.sphere_2 = rank[event.sphere_2];
+        }
+        m_node[event.sphere_1] = node;
+    }
+}
+
+/**
+ * Queue::clear
+ * @brief Remove all events of the specified number of spheres.
+ */
+void Queue::clear(const size_t n_spheres)
+{
+    m_heap.clear();
+    m_node.assign(n_spheres, (uint32_t) m_none);
+}
+
+/** ---------------------------------------------------------------------------
+ * Queue::sift_up
+ * @brief Move an event up from a heap node, moving the later parents down
+ * instead of swapping, and store it with its heap node index.
+ */
+void Queue::sift_up(uint32_t node, const Event &event)
+{
+    while (node > 0) {
+        uint32_t parent = (node - 1) / 2;
+        if (!(event < m_heap[parent])) {
+            break;
+        }
+        m_heap[node] = m_heap[parent];
+        m_node[m_heap[node].sphere_1] = node;
+        node = parent;
+    }
+    m_heap[node] = event;
+    m_node[event.sphere_1] = node;
+}
+
+/**
+ * Queue::sift_down
+ * @brief Move an event down from a heap node, moving the earlier children up
+ * instead of swapping, and store it with its heap node index.
+ */
+void Queue::sift_down(uint32_t node, const Event &event)
+{
+    const uint32_t size = m_heap.size();
+    while (true) {
+        uint32_t child = 2 * node + 1;
+        if (child >= size) {
+            break;
+        }
+        if (child + 1 < size && m_heap[child + 1] < m_heap[child]) {
+            child++;
+        }
+        if (!(m_heap[child] < event)) {
+            break;
+        }
+        m_heap[node] = m_heap[child];
+        m_node[m_heap[node].sphere_1] = node;
+        node = child;
+    }
+    m_heap[node] = event;
+    m_node[event.sphere_1] = node;
+}
@@ -0,0 +1,60 @@
+/*
+ * queue.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef HS_QUEUE_H_
+#define HS_QUEUE_H_
+
+#include "atto/opencl/opencl.hpp"
+#include "base.hpp"
+
+/**
+ * Queue
+ * @brief Priority queue of sphere events, stored as a binary min-heap in an
+ * array ordered by event time. The children of node k are 2k+1 and 2k+2.
+ * The queue holds one event per sphere, and the heap node of each sphere
+ * event is indexed, so a new prediction replaces the sphere event in place
+ * and the heap never holds more events than spheres.
+ */
+struct Queue {
+    /* Heap node of a sphere without an event. */
+    static const uint32_t m_none = 0xffffffff;
+
+    std::vector<Event> m_heap;          /* heap of sphere events */
+    std::vector<uint32_t> m_node;       /* heap node of each sphere event */
+
+    /** Is the queue empty? */
+    bool empty(void) const { return m_heap.empty(); }
+
+    /** Return the number of events in the queue. */
+    size_t size(void) const { return m_heap.size(); }
+
+    /** Return the earliest event. */
+    const Event &top(void) const { return m_heap.front(); }
+
+    /** Insert the event of its first sphere, or replace the existing one. */
+    void update(const Event &event);
+
+    /** Renumber the spheres of the events, sphere ix becoming rank[ix]. */
+    void renumber(const std::vector<uint32_t> &rank);
+
+    /** Remove all events of the specified number of spheres. */
+    void clear(const size_t n_spheres);
+
+    /** Move an event up or down from a heap node and store it. */
+    void sift_up(uint32_t node, const Event &event);
+    void sift_down(uint32_t node, const Event &event);
+
+    /* Constructor/destructor. */
+    Queue() = default;
+    ~Queue() = default;
+};
+
+#endif /* HS_QUEUE_H_ */
@@ -0,0 +1,38 @@
+#! /bin/bash
+
+#
+# run.sh
+#
+# Copyright (c) 2020 Carlos Braga
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the MIT License.
+#
+# See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+#
+
+# -----------------------------------------------------------------------------
+# die with message
+#
+die() {
+    echo >&2 "$@"
+    exit 1
+}
+
+#
+# run command and check exit code
+#
+run() {
+    echo "$@" && "$@"
+    code=$?
+    [[ $code -ne 0 ]] && die "[$@] failed with error code $code"
+    return 0
+}
+
+# -----------------------------------------------------------------------------
+# Run hs
+#
+run make -f Makefile clean
+run make -f Makefile -j32 all
+run ./hs.out
+run make -f Makefile clean
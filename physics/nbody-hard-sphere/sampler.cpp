@@ -0,0 +1,159 @@
+/*
+ * sampler.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include "atto/opencl/opencl.hpp"
+#include "sampler.hpp"
+using namespace atto;
+
+/**
+ * Sampler::Sampler
+ * @brief Create a thermodynamic sampler object with a specified block size.
+ */
+Sampler::Sampler()
+    : m_block_size(Params::sample_block_size)
+{
+    m_sample_name = {
+        "temperature",
+        "pressure",
+        "compressibility",
+        "compressibility_cs",
+        "collision_rate",
+    };
+
+    /* Reset sampler properties */
+    reset();
+}
+
+/**
+ * Sampler::reset
+ * @brief Reset sampler properties.
+ */
+void Sampler::reset(void)
+{
+    m_block_data.clear();
+    m_block_average.clear();
+    for (size_t prop = 0; prop < NUM_PROPERTIES; ++prop) {
+        m_sample_zero[prop] = 0.0;
+        m_sample_avrg[prop] = 0.0;
+        m_sample_sdev[prop] = 0.0;
+    }
+    m_item = Item{};
+}
+
+/**
+ * Sampler::sample
+ * @brief Sample a sampler item.
+ */
+void Sampler::sample(const Item &item)
+{
+    m_item = item;
+    m_block_data.push_back(m_item);
+
+    /*
+     * If the number of items reaches the block segment size
+     * store the block average for later processing and clear.
+     */
+    if (m_block_data.size() == m_block_size) {
+        double block_data_size = static_cast<double>(m_block_data.size());
+
+        /* Compute the block average. */
+        Item avrg = m_sample_zero;
+        for (auto &it : m_block_data) {
+            for (size_t prop = 0; prop < NUM_PROPERTIES; ++prop) {
+                avrg[prop] += it[prop];
+            }
+        }
+
+        for (size_t prop = 0; prop < NUM_PROPERTIES; ++prop) {
+            avrg[prop] /= block_data_size;
+        }
+
+        m_block_average.push_back(avrg);
+
+        /* Clear the block data for the next segment. */
+        m_block_data.clear();
+    }
+}
+
+/**
+ * Sampler::statistics
+ * @brief Compute sampler statistics.
+ */
+void Sampler::statistics(void)
+{
+    /* Statistics are undefined if we have less than two block segments. */
+    if (m_block_average.size() < 2) {
+        return;
+    }
+    double m_block_avrg_size = static_cast<double>(m_block_average.size());
+
+    /*
+     * Compute sampler average.
+     */
+    m_sample_avrg = m_sample_zero;
+    for (auto &item : m_block_average) {
+        for (size_t prop = 0; prop < NUM_PROPERTIES; ++prop) {
+            m_sample_avrg[prop] += item[prop];
+        }
+    }
+
+    for (size_t prop = 0; prop < NUM_PROPERTIES; ++prop) {
+        m_sample_avrg[prop] /= m_block_avrg_size;
+    }
+
+    /*
+     * Compute sampler variance.
+     */
+    m_sample_sdev = m_sample_zero;
+    for (auto &item : m_block_average) {
+        for (size_t prop = 0; prop < NUM_PROPERTIES; ++prop) {
+            double res = item[prop] - m_sample_avrg[prop];
+            m_sample_sdev[prop] += res * res;
+        }
+    }
+
+    for (size_t prop = 0; prop < NUM_PROPERTIES; ++prop) {
+        m_sample_sdev[prop] /= m_block_avrg_size * (m_block_avrg_size - 1.0);
+        m_sample_sdev[prop]  = std::sqrt(m_sample_sdev[prop]);
+    }
+}
+
+/**
+ * Sampler::to_string
+ * @brief Serialize the sampler statistics.
+ */
+std::string Sampler::to_string(void) const
+{
+    std::ostringstream ss;
+    for (size_t prop = 0; prop < NUM_PROPERTIES; ++prop) {
+        ss << core::str_format(
+            "%20s %lf %lf\n",
+            m_sample_name[prop].c_str(),
+            m_sample_avrg[prop],
+            m_sample_sdev[prop]);
+    }
+    return ss.str();
+}
+
+/**
+ * Sampler::log_string
+ * @brief Return a serialized version of the latest sample item.
+ */
+std::string Sampler::log_string(void) const
+{
+    /* Return the a string of the last sample item. */
+    std::ostringstream ss;
+    for (size_t prop = 0; prop < NUM_PROPERTIES; ++prop) {
+        ss << core::str_format(
+            "%20s %lf\n", m_sample_name[prop].c_str(), m_item[prop]);
+    }
+    return ss.str();
+}
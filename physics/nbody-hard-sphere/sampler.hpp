@@ -0,0 +1,71 @@
+/*
+ * sampler.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef HS_SAMPLER_H_
+#define HS_SAMPLER_H_
+
+#include "atto/opencl/opencl.hpp"
+#include "base.hpp"
+
+/**
+ * Sampler
+ * @brief Thermodynamic sampler with block averages.
+ */
+struct Sampler {
+    /* Item enumerated type */
+    enum {
+        /* Fluid temperature */
+        TEMPERATURE = 0,
+        /* Fluid pressure from the collision virial */
+        PRESSURE,
+        /* Fluid compressibility factor, P / (rho kT) */
+        COMPRESSIBILITY,
+        /* Carnahan-Starling compressibility factor */
+        COMPRESSIBILITY_CS,
+        /* Collisions per sphere per unit time */
+        COLLISION_RATE,
+        NUM_PROPERTIES
+    };
+    typedef std::array<std::string, NUM_PROPERTIES> ItemName;
+    typedef std::array<double, NUM_PROPERTIES> Item;
+
+    /* Sampler sample item. */
+    const size_t m_block_size;
+    std::vector<Item> m_block_data;
+    std::vector<Item> m_block_average;
+
+    ItemName m_sample_name;
+    Item m_sample_zero;
+    Item m_sample_avrg;
+    Item m_sample_sdev;
+    Item m_item;
+
+    /* Reset sampler properties. */
+    void reset(void);
+
+    /* Sample a sampler item. */
+    void sample(const Item &item);
+
+    /* Compute sampler statistics. */
+    void statistics(void);
+
+    /* Serialize the sampler statistics. */
+    std::string to_string(void) const;
+
+    /* Return a serialized version of the latest sample item. */
+    std::string log_string(void) const;
+
+    /* Constructor/destructor. */
+    Sampler();
+    ~Sampler() = default;
+}; /* Sampler */
+
+#endif /* HS_SAMPLER_H_ */
@@ -10,6 +10,7 @@
  */
 
 #include "model.hpp"
+#include "program.hpp"
 using namespace atto;
 
 /** ---------------------------------------------------------------------------
@@ -104,16 +105,15 @@ Model::Model(void)
         core_assert(Params::device_index < devices.size(), "device index overflow");
         m_device = devices[Params::device_index];
         m_context = cl::Context::create_cl_gl_shared(m_device);
-        m_queue = cl::Queue::create(m_context, m_device);
+        m_queue = common::CreateQueue(m_context, m_device);
 
         /* Create OpenCL program. */
         std::string source;
         source.append(cl::Program::load_source_from_file("data/base.cl"));
         source.append(cl::Program::load_source_from_file("data/nosehoover.cl"));
 
-        m_program = cl::Program::create_from_source(m_context, source);
-        cl::Program::build(m_program, m_device, "");
-        std::cout << cl::Program::get_source(m_program) << "\n";
+        m_program = common::BuildProgram(m_context, m_device, source, "");
+        std::cout << source << "\n";
 
         /* Create OpenCL kernel. */
         m_kernels.resize(NumKernels, NULL);
@@ -184,6 +184,7 @@ Model::~Model()
 
     /* Teardown OpenCL data. */
     {
+        m_profiler.flush();
         for (auto &it : m_images) {
             cl::Memory::release(it);
         }
@@ -271,7 +272,9 @@ void Model::execute(void)
             m_kernels[KernelIntegrate],
             cl::NDRange::Null,
             global_ws,
-            local_ws);
+            local_ws,
+            NULL,
+            m_profiler.event(m_kernels[KernelIntegrate]));
 
         cl::Queue::enqueue_copy_from(
             m_queue,
@@ -298,7 +301,9 @@ void Model::execute(void)
             m_kernels[KernelResetCanvas],
             cl::NDRange::Null,
             global_ws,
-            local_ws);
+            local_ws,
+            NULL,
+            m_profiler.event(m_kernels[KernelResetCanvas]));
     }
 
     /* Compute the thermostats depth test. */
@@ -320,7 +325,9 @@ void Model::execute(void)
             m_kernels[KernelDepthCanvas],
             cl::NDRange::Null,
             global_ws,
-            local_ws);
+            local_ws,
+            NULL,
+            m_profiler.event(m_kernels[KernelDepthCanvas]));
     }
 
     /* Use the canvas indices to draw. */
@@ -347,7 +354,9 @@ void Model::execute(void)
             m_kernels[KernelDrawCanvas],
             cl::NDRange::Null,
             global_ws,
-            local_ws);
+            local_ws,
+            NULL,
+            m_profiler.event(m_kernels[KernelDrawCanvas]));
 
         /* Wait for OpenCL to finish and release the gl objects. */
         cl::gl::enqueue_release_gl_objects(m_queue, 1, &m_images[ImageCanvas]);